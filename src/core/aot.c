@@ -0,0 +1,40 @@
+#include "aot.h"
+
+bool aot_load(chip8_t *chip8, const aot_program_t *program) {
+    return chip8_set_variant(chip8, program->variant) &&
+           chip8_load_program(chip8, program->rom, program->size);
+}
+
+uint32_t aot_run(chip8_t *chip8, const aot_program_t *program, uint32_t cycles, chip8_state_t *state) {
+    chip8_state_t combined = {.status = CHIP8_OK};
+    uint32_t      run      = 0;
+
+    while (run < cycles) {
+        chip8_state_t result   = {.status = CHIP8_OK};
+        uint32_t      executed = 0;
+
+        uint32_t offset = (uint32_t)chip8->pc - PROGRAM_START;
+        if (chip8->pc >= PROGRAM_START && offset < program->size && program->blocks[offset] &&
+            program->lengths[offset] <= cycles - run) {
+            executed = program->blocks[offset](chip8, &result);
+            chip8->cycles += executed;
+        }
+        if (executed == 0) {
+            result   = chip8_run_cycle(chip8);
+            executed = 1;
+        }
+
+        run += executed;
+        combined.opcode = result.opcode;
+        combined.frame_buffer_dirty |= result.frame_buffer_dirty;
+        combined.sound_timer_set |= result.sound_timer_set;
+        combined.audio_pattern_set |= result.audio_pattern_set;
+        if (result.status != CHIP8_OK) {
+            combined.status = result.status;
+            break;
+        }
+    }
+
+    *state = combined;
+    return run;
+}
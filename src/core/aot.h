@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "chip8.h"
+#include "variant.h"
+
+/**
+ * A basic block of a ROM, recompiled ahead of time into native code.
+ *
+ * Blocks verify that the memory they were compiled from is unchanged before
+ * executing anything, so that self-modified code is never run stale.
+ *
+ * @param chip8 - The CHIP-8 to execute the block on
+ * @param result - The state to record the effects of the block into
+ * @returns The number of executed instructions, or 0 if the block is stale
+ */
+typedef uint32_t (*aot_block_t)(chip8_t *chip8, chip8_state_t *result);
+
+typedef struct {
+    const char        *name;     // Name of the recompiled ROM
+    variant_type_t     variant;  // Variant the ROM was recompiled for
+    const uint8_t     *rom;      // Contents of the ROM
+    uint16_t           size;     // Size of the ROM in bytes
+    const aot_block_t *blocks;   // Block starting at each ROM offset, if any
+    const uint16_t    *lengths;  // Instructions in the block at each ROM offset
+} aot_program_t;
+
+/**
+ * Loads a recompiled program into the CHIP-8.
+ *
+ * @param chip8 - The initialized CHIP-8 to load the program into
+ * @param program - The recompiled program to load
+ * @returns If the program was loaded successfully
+ */
+bool aot_load(chip8_t *chip8, const aot_program_t *program);
+
+/**
+ * Runs a recompiled program for a number of instruction cycles.
+ *
+ * Recompiled blocks are executed whenever PC is at the start of one that fits
+ * within the remaining cycles, so that exactly as many instructions run as
+ * with `chip8_run_cycle`. Everything else, such as indirect jumps, stale
+ * self-modified blocks, or code that was not recovered, falls back to the
+ * interpreter one instruction at a time.
+ *
+ * Running stops early once an instruction fails, in which case the status of
+ * the failure is reported like `chip8_run_cycle` does.
+ *
+ * @param chip8 - The CHIP-8 to run
+ * @param program - The recompiled program loaded into the CHIP-8
+ * @param cycles - The number of instruction cycles to run
+ * @param state - The combined emulator state after running the cycles
+ * @returns The number of instruction cycles that were run
+ */
+uint32_t aot_run(chip8_t *chip8, const aot_program_t *program, uint32_t cycles, chip8_state_t *state);
@@ -1,3 +1,5 @@
+#pragma once
+
 // 16-bit bitmasks with respect to the CHIP-8 architecture
 #define MASK_N1 0xF000 // First nibble - instruction group
 #define MASK_N2 0x0F00 // Second nibble - register lookup
@@ -0,0 +1,78 @@
+#include "blitter.h"
+
+#if defined(ENABLE_SSE) && defined(__SSE2__)
+#include <emmintrin.h>
+#define BLITTER_SSE
+#endif
+
+bool blitter_draw_sprite(uint64_t *rows, uint8_t stride, uint8_t words, uint8_t x, const uint64_t *sprite, uint8_t count) {
+    // Clipping is resolved once for the entire sprite; the overflow into the
+    // next word is only drawn if that word is still part of the visible row
+    uint8_t word  = x / BLITTER_WORD_BITS;
+    uint8_t shift = x % BLITTER_WORD_BITS;
+
+    uint64_t hit;
+    if (shift && word + 1 < words) {
+        hit = blitter_draw_straddling(&rows[word], stride, shift, sprite, count);
+    } else {
+        hit = blitter_draw_aligned(&rows[word], stride, shift, sprite, count);
+    }
+    return hit != 0;
+}
+
+static uint64_t blitter_draw_aligned(uint64_t *rows, uint8_t stride, uint8_t shift, const uint64_t *sprite, uint8_t count) {
+    uint64_t hit = 0;
+    uint8_t  j   = 0;
+
+#ifdef BLITTER_SSE
+    // Adjacent rows are adjacent words, so two rows are drawn at once
+    if (stride == 1) {
+        __m128i hits = _mm_setzero_si128();
+        for (; j + 1 < count; j += 2) {
+            __m128i *row  = (__m128i *)&rows[j];
+            __m128i  bits = _mm_set_epi64x((long long)(sprite[j + 1] >> shift), (long long)(sprite[j] >> shift));
+            __m128i  dst  = _mm_loadu_si128(row);
+            hits          = _mm_or_si128(hits, _mm_and_si128(dst, bits));
+            _mm_storeu_si128(row, _mm_xor_si128(dst, bits));
+        }
+        hit = (uint64_t)_mm_cvtsi128_si64(_mm_or_si128(hits, _mm_unpackhi_epi64(hits, hits)));
+    }
+#endif
+
+    for (; j < count; ++j) {
+        uint64_t bits = sprite[j] >> shift;
+        hit |= rows[j * stride] & bits;
+        rows[j * stride] ^= bits;
+    }
+
+    return hit;
+}
+
+static uint64_t blitter_draw_straddling(uint64_t *rows, uint8_t stride, uint8_t shift, const uint64_t *sprite, uint8_t count) {
+    uint8_t  back = BLITTER_WORD_BITS - shift;
+    uint64_t hit  = 0;
+
+#ifdef BLITTER_SSE
+    // Both halves of a row are adjacent words, so a row is drawn at once
+    __m128i hits = _mm_setzero_si128();
+    for (uint8_t j = 0; j < count; ++j) {
+        __m128i *row  = (__m128i *)&rows[j * stride];
+        __m128i  bits = _mm_set_epi64x((long long)(sprite[j] << back), (long long)(sprite[j] >> shift));
+        __m128i  dst  = _mm_loadu_si128(row);
+        hits          = _mm_or_si128(hits, _mm_and_si128(dst, bits));
+        _mm_storeu_si128(row, _mm_xor_si128(dst, bits));
+    }
+    hit = (uint64_t)_mm_cvtsi128_si64(_mm_or_si128(hits, _mm_unpackhi_epi64(hits, hits)));
+#else
+    for (uint8_t j = 0; j < count; ++j) {
+        uint64_t *row   = &rows[j * stride];
+        uint64_t  left  = sprite[j] >> shift;
+        uint64_t  right = sprite[j] << back;
+        hit |= (row[0] & left) | (row[1] & right);
+        row[0] ^= left;
+        row[1] ^= right;
+    }
+#endif
+
+    return hit;
+}
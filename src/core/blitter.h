@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BLITTER_WORD_BITS 64 // Pixels packed into a single display word
+
+/**
+ * XORs a sprite into packed display rows.
+ *
+ * Each sprite row must be left-aligned within its 64-bit word, allowing rows
+ * of both 8 and 16 pixels to be drawn using the same shifts. Horizontal
+ * clipping is resolved once for the entire sprite, so the caller only has to
+ * limit the number of rows to those that are visible.
+ *
+ * When built with `ENABLE_SSE` on a target supporting SSE2, multiple display
+ * words are drawn at once where the display layout allows it.
+ *
+ * @param rows - The first word of the first display row to draw into
+ * @param stride - The number of words between the starts of adjacent rows
+ * @param words - The number of words making up the visible part of a row
+ * @param x - The horizontal position to draw the sprite at
+ * @param sprite - The left-aligned pixels of each sprite row
+ * @param count - The number of sprite rows to draw
+ * @returns If any pixel was turned off by drawing the sprite
+ */
+bool blitter_draw_sprite(uint64_t *rows, uint8_t stride, uint8_t words, uint8_t x, const uint64_t *sprite, uint8_t count);
+
+/**
+ * Draws a sprite which fits within a single word of every row.
+ *
+ * @param rows - The display word of the first row to draw into
+ * @param stride - The number of words between the starts of adjacent rows
+ * @param shift - The offset of the sprite within the word
+ * @param sprite - The left-aligned pixels of each sprite row
+ * @param count - The number of sprite rows to draw
+ * @returns The pixels that were turned off by drawing the sprite
+ */
+static uint64_t blitter_draw_aligned(uint64_t *rows, uint8_t stride, uint8_t shift, const uint64_t *sprite, uint8_t count);
+
+/**
+ * Draws a sprite which overflows into the next word of every row.
+ *
+ * @param rows - The first display word of the first row to draw into
+ * @param stride - The number of words between the starts of adjacent rows
+ * @param shift - The offset of the sprite within the first word
+ * @param sprite - The left-aligned pixels of each sprite row
+ * @param count - The number of sprite rows to draw
+ * @returns The pixels that were turned off by drawing the sprite
+ */
+static uint64_t blitter_draw_straddling(uint64_t *rows, uint8_t stride, uint8_t shift, const uint64_t *sprite, uint8_t count);
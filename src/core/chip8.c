@@ -1,20 +1,277 @@
 #include "chip8.h"
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "bitmask.h"
+#include "blitter.h"
 #include "font.h"
 #include "log.h"
+#include "opcodes.h"
+#include "variant.h"
 
-static uint8_t (*generate_random_number)(void);
+// Calls a hook if installed, or compiles away entirely without ENABLE_HOOKS
+#ifdef ENABLE_HOOKS
+#define CHIP8_HOOK(chip8, name, ...)                                                         \
+    do {                                                                                     \
+        if ((chip8)->hooks.name) (chip8)->hooks.name((chip8)->hooks.context, ##__VA_ARGS__); \
+    } while (0)
+#else
+#define CHIP8_HOOK(chip8, name, ...) \
+    do {                             \
+    } while (0)
+#endif
 
-void chip8_init(chip8_t *chip8, uint8_t (*generator)(void)) {
+bool chip8_init(chip8_t *chip8) {
     memset(chip8, 0, sizeof(chip8_t));
-    chip8->pc            = PROGRAM_START;
-    chip8->stack_pointer = -1;
-    chip8_load_font(chip8, DEFAULT_FONT);
-    generate_random_number = generator;
+    chip8->font   = DEFAULT_FONT;
+    chip8->quirks = DEFAULT_QUIRKS;
+    chip8->rng    = DEFAULT_RNG_SEED;
+    return chip8_set_variant(chip8, VARIANT_CHIP8);
+}
+
+void chip8_free(chip8_t *chip8) {
+    free(chip8->memory);
+    free(chip8->display);
+    chip8->memory  = NULL;
+    chip8->display = NULL;
+    chip8_clear_breakpoints(chip8);
+#ifdef ENABLE_COVERAGE
+    // Both bitmaps share a single allocation
+    free(chip8->executed);
+    chip8->executed = NULL;
+    chip8->written  = NULL;
+#endif
+}
+
+bool chip8_clone(chip8_t *clone, const chip8_t *chip8) {
+    size_t    display_size = sizeof(uint64_t) * chip8->plane_size * chip8->display_planes;
+    uint8_t  *memory       = malloc(chip8->memory_size);
+    uint64_t *display      = malloc(display_size);
+    if (!memory || !display) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to allocate memory for clone.");
+        free(memory);
+        free(display);
+        return false;
+    }
+
+#ifdef ENABLE_COVERAGE
+    size_t    coverage_words = 2 * chip8->memory_size / COVERAGE_WORD_BITS;
+    uint64_t *coverage       = malloc(sizeof(uint64_t) * coverage_words);
+    if (!coverage) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to allocate coverage for clone.");
+        free(memory);
+        free(display);
+        return false;
+    }
+#endif
+
+    memcpy(clone, chip8, sizeof(chip8_t));
+    memcpy(memory, chip8->memory, chip8->memory_size);
+    memcpy(display, chip8->display, display_size);
+    clone->memory  = memory;
+    clone->display = display;
+    // Breakpoints belong to the debugged emulator only
+    clone->breakpoints      = NULL;
+    clone->watch_reads      = NULL;
+    clone->watch_writes     = NULL;
+    clone->breakpoint_count = 0;
+    clone->watchpoint_count = 0;
+#ifdef ENABLE_HOOKS
+    memset(&clone->hooks, 0, sizeof(clone->hooks));
+#endif
+#ifdef ENABLE_COVERAGE
+    memcpy(coverage, chip8->executed, sizeof(uint64_t) * coverage_words);
+    clone->executed = coverage;
+    clone->written  = &coverage[coverage_words / 2];
+#endif
+    return true;
+}
+
+bool chip8_capture(chip8_t *baseline, chip8_t *chip8) {
+    if (!chip8_clone(baseline, chip8)) return false;
+    memset(chip8->dirty_pages, 0, sizeof(chip8->dirty_pages));
+    chip8->dirty_rows = 0;
+    return true;
+}
+
+bool chip8_restore(chip8_t *chip8, const chip8_t *baseline) {
+    if (chip8->variant != baseline->variant) {
+        LOG_ERROR(LOG_SUBSYS_SYSTEM, "Attempted to restore baseline of another variant.");
+        return false;
+    }
+
+    // Consecutive dirty pages and rows are copied back in a single run
+    for (uint8_t w = 0; w < DIRTY_PAGE_WORDS; ++w) {
+        uint64_t pages = chip8->dirty_pages[w];
+        while (pages) {
+            uint8_t  first  = __builtin_ctzll(pages);
+            uint8_t  count  = chip8_run_length(pages >> first);
+            uint32_t offset = (w * 64 + first) * DIRTY_PAGE_SIZE;
+            memcpy(&chip8->memory[offset], &baseline->memory[offset], count * DIRTY_PAGE_SIZE);
+            pages &= count + first < 64 ? ~0ULL << (first + count) : 0;
+        }
+    }
+    // Rows are tracked for the largest display mode, which may be shorter
+    // than the bitmap
+    uint32_t height = chip8->plane_size / chip8->display_stride;
+    uint64_t rows   = chip8->dirty_rows & (height < 64 ? (1ULL << height) - 1 : ~0ULL);
+    while (rows) {
+        uint8_t  first  = __builtin_ctzll(rows);
+        uint8_t  count  = chip8_run_length(rows >> first);
+        uint32_t offset = first * chip8->display_stride;
+        for (uint8_t p = 0; p < chip8->display_planes; ++p) {
+            uint32_t word = p * chip8->plane_size + offset;
+            memcpy(&chip8->display[word], &baseline->display[word], sizeof(uint64_t) * chip8->display_stride * count);
+        }
+        rows &= count + first < 64 ? ~0ULL << (first + count) : 0;
+    }
+
+    // Registers are copied wholesale, keeping the buffers of the CHIP-8
+    chip8_t own = *chip8;
+    *chip8      = *baseline;
+
+    chip8->memory           = own.memory;
+    chip8->display          = own.display;
+    chip8->breakpoints      = own.breakpoints;
+    chip8->watch_reads      = own.watch_reads;
+    chip8->watch_writes     = own.watch_writes;
+    chip8->breakpoint_count = own.breakpoint_count;
+    chip8->watchpoint_count = own.watchpoint_count;
+    chip8->drawn_rows       = own.drawn_rows | own.dirty_rows;
+#ifdef ENABLE_HOOKS
+    chip8->hooks = own.hooks;
+#endif
+#ifdef ENABLE_COVERAGE
+    chip8->executed    = own.executed;
+    chip8->written     = own.written;
+    chip8->smc_writes  = own.smc_writes;
+    chip8->smc_address = own.smc_address;
+#endif
+    memset(chip8->dirty_pages, 0, sizeof(chip8->dirty_pages));
+    chip8->dirty_rows = 0;
+    return true;
+}
+
+bool chip8_patch_memory(chip8_t *chip8, uint32_t address, const uint8_t *data, uint32_t size) {
+    if (address > chip8->memory_size || chip8->memory_size - address < size) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Attempted to patch memory out of bounds.");
+        return false;
+    }
+    if (size == 0) return true;
+
+#ifdef ENABLE_STATE_HASH
+    for (uint32_t offset = 0; offset < size; ++offset) {
+        chip8->memory_hash ^= chip8_zobrist(HASH_KEY_MEMORY + address + offset, chip8->memory[address + offset]) ^
+                              chip8_zobrist(HASH_KEY_MEMORY + address + offset, data[offset]);
+    }
+#endif
+    memcpy(&chip8->memory[address], data, size);
+    for (uint32_t page = address / DIRTY_PAGE_SIZE; page <= (address + size - 1) / DIRTY_PAGE_SIZE; ++page) {
+        chip8->dirty_pages[page / 64] |= 1ULL << (page % 64);
+    }
+    return true;
+}
+
+uint64_t chip8_hash(const chip8_t *chip8) {
+#ifdef ENABLE_STATE_HASH
+    return chip8->memory_hash ^ chip8->display_hash ^ chip8_hash_registers(chip8);
+#else
+    uint32_t display_words = chip8->plane_size * chip8->display_planes;
+    return chip8_hash_memory(chip8) ^ chip8_hash_display(chip8, 0, display_words) ^ chip8_hash_registers(chip8);
+#endif
+}
+
+void chip8_rehash(chip8_t *chip8) {
+#ifdef ENABLE_STATE_HASH
+    chip8->memory_hash  = chip8_hash_memory(chip8);
+    chip8->display_hash = chip8_hash_display(chip8, 0, chip8->plane_size * chip8->display_planes);
+#else
+    (void)chip8;
+#endif
+}
+
+bool chip8_set_variant(chip8_t *chip8, variant_type_t variant) {
+    variant_data_t data = variant_get(variant);
+    if (!data.name) {
+        LOG_ERROR(LOG_SUBSYS_SYSTEM, "Attempted to switch to invalid variant.");
+        return false;
+    }
+
+    uint8_t   stride     = data.display_width / DISPLAY_ROW_BITS;
+    uint16_t  plane_size = stride * data.display_height;
+    uint8_t  *memory     = malloc(data.memory_size);
+    uint64_t *display    = malloc(sizeof(uint64_t) * plane_size * data.display_planes);
+    if (!memory || !display) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to allocate memory for variant.");
+        free(memory);
+        free(display);
+        return false;
+    }
+
+#ifdef ENABLE_COVERAGE
+    uint64_t *coverage = malloc(sizeof(uint64_t) * 2 * data.memory_size / COVERAGE_WORD_BITS);
+    if (!coverage) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to allocate coverage for variant.");
+        free(memory);
+        free(display);
+        return false;
+    }
+#endif
+
+    chip8_free(chip8);
+#ifdef ENABLE_COVERAGE
+    chip8->executed = coverage;
+    chip8->written  = &coverage[data.memory_size / COVERAGE_WORD_BITS];
+#endif
+    chip8->memory         = memory;
+    chip8->display        = display;
+    chip8->variant        = variant;
+    chip8->memory_size    = data.memory_size;
+    chip8->address_mask   = data.memory_size - 1;
+    chip8->display_stride = stride;
+    chip8->plane_size     = plane_size;
+    chip8->display_planes = data.display_planes;
+    chip8_reset(chip8);
+    return true;
+}
+
+void chip8_set_quirks(chip8_t *chip8, uint8_t quirks) {
+    chip8->quirks = quirks & QUIRK_ALL;
+}
+
+void chip8_seed_rng(chip8_t *chip8, uint64_t seed) {
+    // A xorshift generator never leaves the all-zero state
+    chip8->rng = seed ? seed : DEFAULT_RNG_SEED;
+}
+
+void chip8_set_rng(chip8_t *chip8, uint8_t (*generator)(void)) {
+    chip8->generator = generator;
+}
+
+void chip8_set_keypad(chip8_t *chip8, uint16_t keys) {
+    __atomic_store_n(&chip8->keypad, keys, __ATOMIC_RELEASE);
+}
+
+void chip8_set_keypad_source(chip8_t *chip8, uint16_t (*source)(void)) {
+    chip8->keypad_source = source;
+}
+
+bool chip8_set_hooks(chip8_t *chip8, const chip8_hooks_t *hooks) {
+#ifdef ENABLE_HOOKS
+    if (hooks) {
+        chip8->hooks = *hooks;
+    } else {
+        memset(&chip8->hooks, 0, sizeof(chip8->hooks));
+    }
+    return true;
+#else
+    (void)chip8;
+    (void)hooks;
+    LOG_ERROR(LOG_SUBSYS_SYSTEM, "Hooks require building with ENABLE_HOOKS.");
+    return false;
+#endif
 }
 
 bool chip8_load_font(chip8_t *chip8, font_type_t type) {
@@ -27,13 +284,14 @@ bool chip8_load_font(chip8_t *chip8, font_type_t type) {
     if (!font.data) {
         LOG_ERROR(LOG_SUBSYS_MEMORY, "Attempted to load empty font.");
         return false;
-    } else if (MEMORY_SIZE - FONT_START < font.size) {
+    } else if (chip8->memory_size - FONT_START < font.size) {
         LOG_ERROR(LOG_SUBSYS_MEMORY, "Attempted to load oversized font.");
         return false;
     }
 
     memcpy(&chip8->memory[FONT_START], font.data, font.size);
     chip8->font = type;
+    chip8_rehash(chip8);
     return true;
 }
 
@@ -41,18 +299,53 @@ bool chip8_load_program(chip8_t *chip8, const uint8_t *program, uint16_t size) {
     if (!program) {
         LOG_WARN(LOG_SUBSYS_MEMORY, "Attempted to load empty program.");
         return false;
-    } else if (MEMORY_SIZE - PROGRAM_START < size) {
+    } else if (chip8->memory_size - PROGRAM_START < size) {
         LOG_ERROR(LOG_SUBSYS_MEMORY, "Attempted to load oversized program.");
         return false;
     }
 
-    font_type_t existing_font = chip8->font;
-    chip8_init(chip8, generate_random_number);
-    chip8_load_font(chip8, existing_font);
+    chip8_reset(chip8);
     memcpy(&chip8->memory[PROGRAM_START], program, size);
+    chip8_rehash(chip8);
     return true;
 }
 
+uint8_t chip8_get_pixel(const chip8_t *chip8, uint8_t x, uint8_t y) {
+    if (x >= chip8->display_width || y >= chip8->display_height) return 0;
+
+    const uint64_t *word  = &chip8->display[y * chip8->display_stride + x / DISPLAY_ROW_BITS];
+    uint64_t        mask  = 0x8000000000000000ULL >> (x % DISPLAY_ROW_BITS);
+    uint8_t         pixel = 0;
+    for (uint8_t p = 0; p < chip8->display_planes; ++p) {
+        if (word[p * chip8->plane_size] & mask) pixel |= 1 << p;
+    }
+    return pixel;
+}
+
+void chip8_render_display(const chip8_t *chip8, uint8_t *buffer) {
+    uint8_t width  = chip8->display_width;
+    uint8_t height = chip8->display_height;
+    memset(buffer, 0, width * height);
+
+    for (uint8_t p = 0; p < chip8->display_planes; ++p) {
+        const uint64_t *plane = &chip8->display[p * chip8->plane_size];
+        for (uint8_t y = 0; y < height; ++y) {
+            const uint64_t *row = &plane[y * chip8->display_stride];
+            uint8_t        *out = &buffer[y * width];
+            for (uint8_t x = 0; x < width; ++x) {
+                uint64_t word = row[x / DISPLAY_ROW_BITS];
+                out[x] |= ((word >> (DISPLAY_ROW_BITS - 1 - x % DISPLAY_ROW_BITS)) & 0x1) << p;
+            }
+        }
+    }
+}
+
+uint64_t chip8_take_drawn_rows(chip8_t *chip8) {
+    uint64_t rows     = chip8->drawn_rows;
+    chip8->drawn_rows = 0;
+    return rows;
+}
+
 chip8_state_t chip8_run_cycle(chip8_t *chip8) {
     chip8_state_t result = {
         .status             = CHIP8_OK,
@@ -64,269 +357,849 @@ chip8_state_t chip8_run_cycle(chip8_t *chip8) {
     if (!fetch_success) return result;
 
     bool execute_success = chip8_execute_instruction(chip8, &result);
+    chip8->cycles += 1;
     if (!execute_success) return result;
 
     return result;
 }
 
-static bool chip8_fetch_instruction(chip8_t *chip8, chip8_state_t *result) {
-    uint8_t bytes[2];
-    memcpy(&bytes, &chip8->memory[chip8->pc], sizeof(bytes));
-    result->opcode = (bytes[0] << 8) | bytes[1];
-    chip8->pc += 2;
+uint32_t chip8_run_cycles(chip8_t *chip8, uint32_t cycles, chip8_state_t *state) {
+    // Handlers only ever raise the flags, so every cycle can share the result
+    chip8_state_t result = {.status = CHIP8_OK};
+    uint32_t      run    = 0;
+    while (run < cycles && result.status == CHIP8_OK) {
+        chip8_fetch_instruction(chip8, &result);
+        uint32_t executed = chip8_execute_fused(chip8, &result, cycles - run > 1);
+        chip8->cycles += executed;
+        run += executed;
+    }
+
+    *state = result;
+    return run;
+}
+
+uint32_t chip8_run_until(chip8_t *chip8, uint32_t limit, chip8_stop_t *stop) {
+    stop->reason  = CHIP8_STOP_LIMIT;
+    stop->address = 0;
+
+    uint32_t run = 0;
+    if (chip8->breakpoint_count == 0 && chip8->watchpoint_count == 0) {
+        run = chip8_run_cycles(chip8, limit, &stop->state);
+    } else {
+        // Instructions are not fused, as either one of a pair may be stopped at
+        chip8_state_t result = {.status = CHIP8_OK};
+        while (run < limit && result.status == CHIP8_OK) {
+            // Each instruction is decoded once, for both checking and dispatching it
+            uint16_t      opcode = (chip8_read_memory(chip8, chip8->pc) << 8) | chip8_read_memory(chip8, chip8->pc + 1);
+            opcode_type_t type   = opcode_decode(opcode, chip8->variant);
+            if (run > 0 && chip8_should_stop(chip8, type, opcode, stop)) break;
+            chip8_fetch_instruction(chip8, &result);
+            chip8_dispatch_instruction(chip8, type, &result);
+            chip8->cycles += 1;
+            ++run;
+        }
+        stop->state = result;
+    }
+
+    if (stop->state.status != CHIP8_OK) stop->reason = CHIP8_STOP_FAILED;
+    return run;
+}
+
+bool chip8_set_breakpoint(chip8_t *chip8, uint32_t address, bool enabled) {
+    if (address >= chip8->memory_size) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Attempted to set a breakpoint out of bounds.");
+        return false;
+    }
+    if (!chip8_allocate_breakpoints(chip8)) return false;
+
+    if (chip8_toggle_bit(chip8->breakpoints, address, enabled)) chip8->breakpoint_count += enabled ? 1 : -1;
     return true;
 }
 
-static bool chip8_execute_instruction(chip8_t *chip8, chip8_state_t *result) {
-    switch (N1(result->opcode)) {
-        case 0x0: // System Call
-            return chip8_execute_system_instruction(chip8, result);
-        case 0x1: // Jump to Address
-            chip8->pc = MA(result->opcode);
-            return true;
-        case 0x2: // Execute Subroutine
-            if (chip8->stack_pointer < STACK_SIZE - 1) {
-                chip8->stack[++chip8->stack_pointer] = chip8->pc;
-                chip8->pc                            = MA(result->opcode);
-                return true;
-            } else {
-                result->status = CHIP8_STACK_FULL;
-                return false;
-            }
-        case 0x3: // Skip if Variable Equals
-            if (chip8->v[N2(result->opcode)] == B2(result->opcode)) {
-                chip8->pc += 2;
-            }
-            return true;
-        case 0x4: // Skip if Variable Not Equals
-            if (chip8->v[N2(result->opcode)] != B2(result->opcode)) {
-                chip8->pc += 2;
-            }
-            return true;
-        case 0x5: // Skip if Variables Equal
-            if (chip8->v[N2(result->opcode)] == chip8->v[N3(result->opcode)]) {
-                chip8->pc += 2;
-            }
-            // N4 is unused and can contain any value
-            return true;
-        case 0x6: // Set Variable
-            chip8->v[N2(result->opcode)] = B2(result->opcode);
-            return true;
-        case 0x7: // Add to Variable
-            chip8->v[N2(result->opcode)] += B2(result->opcode);
-            return true;
-        case 0x8: // Arithmetic & Logic
-            return chip8_execute_arithmetic_instruction(chip8, result);
-        case 0x9: // Skip if Variables Not Equal
-            if (chip8->v[N2(result->opcode)] != chip8->v[N3(result->opcode)]) {
-                chip8->pc += 2;
+bool chip8_set_watchpoint(chip8_t *chip8, uint32_t address, uint8_t access, bool enabled) {
+    if (address >= chip8->memory_size) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Attempted to set a watchpoint out of bounds.");
+        return false;
+    }
+    if (!chip8_allocate_breakpoints(chip8)) return false;
+
+    if ((access & CHIP8_WATCH_READ) && chip8_toggle_bit(chip8->watch_reads, address, enabled)) {
+        chip8->watchpoint_count += enabled ? 1 : -1;
+    }
+    if ((access & CHIP8_WATCH_WRITE) && chip8_toggle_bit(chip8->watch_writes, address, enabled)) {
+        chip8->watchpoint_count += enabled ? 1 : -1;
+    }
+    return true;
+}
+
+void chip8_clear_breakpoints(chip8_t *chip8) {
+    // All bitmaps share a single allocation
+    free(chip8->breakpoints);
+    chip8->breakpoints      = NULL;
+    chip8->watch_reads      = NULL;
+    chip8->watch_writes     = NULL;
+    chip8->breakpoint_count = 0;
+    chip8->watchpoint_count = 0;
+}
+
+uint32_t chip8_access_length(const chip8_t *chip8, uint16_t opcode) {
+    return chip8_access_length_of(chip8, opcode_decode(opcode, chip8->variant), opcode);
+}
+
+bool chip8_execute_opcode(chip8_t *chip8, uint16_t opcode, chip8_state_t *result) {
+    result->opcode = opcode;
+    return chip8_execute_instruction(chip8, result);
+}
+
+void chip8_update_timers(chip8_t *chip8) {
+    if (chip8->delay_timer > 0) chip8->delay_timer -= 1;
+    if (chip8->sound_timer > 0) {
+        chip8->sound_timer -= 1;
+        if (chip8->sound_timer == 0) CHIP8_HOOK(chip8, on_sound_stop);
+    }
+}
+
+static void chip8_reset(chip8_t *chip8) {
+    memset(chip8->memory, 0, chip8->memory_size);
+    memset(chip8->display, 0, sizeof(uint64_t) * chip8->plane_size * chip8->display_planes);
+    memset(chip8->v, 0, sizeof(chip8->v));
+    memset(chip8->stack, 0, sizeof(chip8->stack));
+    memset(chip8->audio_pattern, 0, sizeof(chip8->audio_pattern));
+    chip8->pc             = PROGRAM_START;
+    chip8->i              = 0;
+    chip8->stack_pointer  = -1;
+    chip8->delay_timer    = 0;
+    chip8->sound_timer    = 0;
+    chip8->planes         = 0x1;
+    chip8->pitch          = DEFAULT_PITCH;
+    chip8->hires          = false;
+    chip8->display_width  = DISPLAY_WIDTH;
+    chip8->display_height = DISPLAY_HEIGHT;
+    chip8->playing_sound  = false;
+    memset(chip8->fusions, 0, sizeof(chip8->fusions));
+    memset(chip8->dirty_pages, 0, sizeof(chip8->dirty_pages));
+    chip8->dirty_rows = 0;
+    chip8->drawn_rows = ~0ULL;
+    chip8->key_wait   = 0;
+    chip8->cycles     = 0;
+    chip8->keys_seen  = 0;
+    memset(chip8->key_pressed_at, 0, sizeof(chip8->key_pressed_at));
+    memset(chip8->key_released_at, 0, sizeof(chip8->key_released_at));
+#ifdef ENABLE_COVERAGE
+    memset(chip8->executed, 0, sizeof(uint64_t) * 2 * chip8->memory_size / COVERAGE_WORD_BITS);
+    chip8->smc_writes  = 0;
+    chip8->smc_address = 0;
+#endif
+    chip8_load_font(chip8, chip8->font);
+}
+
+static bool chip8_allocate_breakpoints(chip8_t *chip8) {
+    if (chip8->breakpoints) return true;
+
+    size_t    words   = chip8->memory_size / 64;
+    uint64_t *bitmaps = calloc(3 * words, sizeof(uint64_t));
+    if (!bitmaps) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to allocate breakpoints.");
+        return false;
+    }
+    chip8->breakpoints  = bitmaps;
+    chip8->watch_reads  = &bitmaps[words];
+    chip8->watch_writes = &bitmaps[2 * words];
+    return true;
+}
+
+static bool chip8_toggle_bit(uint64_t *bitmap, uint32_t address, bool enabled) {
+    uint64_t bit      = 1ULL << (address % 64);
+    bool     previous = bitmap[address / 64] & bit;
+    if (enabled) {
+        bitmap[address / 64] |= bit;
+    } else {
+        bitmap[address / 64] &= ~bit;
+    }
+    return previous != enabled;
+}
+
+static uint32_t chip8_access_length_of(const chip8_t *chip8, opcode_type_t type, uint16_t opcode) {
+    bool extended = chip8->variant == VARIANT_XOCHIP;
+
+    switch (type) {
+        case OPCODE_SAVE:
+        case OPCODE_LOAD:
+            return (N2(opcode) < N3(opcode) ? N3(opcode) - N2(opcode) : N2(opcode) - N3(opcode)) + 1;
+        case OPCODE_DRW: {
+            uint32_t planes = 0;
+            for (uint8_t p = 0; p < chip8->display_planes; ++p) {
+                if (chip8->planes & (1 << p)) planes++;
             }
-            // N4 is unused and can contain any value
-            return true;
-        case 0xA: // Set Index to Address
-            chip8->i = MA(result->opcode);
+            return planes * (N4(opcode) == 0 && extended ? 32 : N4(opcode));
+        }
+        case OPCODE_LD_BCD:
+            return 3;
+        case OPCODE_LD_STORE:
+        case OPCODE_LD_LOAD:
+            return N2(opcode) + 1;
+        case OPCODE_AUDIO:
+            return AUDIO_PATTERN_SIZE;
+        default:
+            return 0;
+    }
+}
+
+static bool chip8_should_stop(const chip8_t *chip8, opcode_type_t type, uint16_t opcode, chip8_stop_t *stop) {
+    if ((chip8->breakpoints[chip8->pc / 64] >> (chip8->pc % 64)) & 0x1) {
+        stop->reason  = CHIP8_STOP_BREAKPOINT;
+        stop->address = chip8->pc;
+        return true;
+    }
+    if (chip8->watchpoint_count == 0) return false;
+
+    uint32_t length = chip8_access_length_of(chip8, type, opcode);
+    if (length == 0) return false;
+
+    uint8_t         flags   = opcode_get(type).flags;
+    const uint64_t *watched = flags & OPCODE_WRITES_MEMORY ? chip8->watch_writes : chip8->watch_reads;
+    for (uint32_t j = 0; j < length; ++j) {
+        uint32_t address = (chip8->i + j) & chip8->address_mask;
+        if ((watched[address / 64] >> (address % 64)) & 0x1) {
+            stop->reason  = flags & OPCODE_WRITES_MEMORY ? CHIP8_STOP_WRITE : CHIP8_STOP_READ;
+            stop->address = address;
             return true;
-        case 0xB: // Jump with Offset
-            // clang-format off
-            // TODO: Make this behavior configurable at runtime.
-#ifdef LEGACY_OFFSET_JUMP_BEHAVIOR
-            chip8->pc = MA(result->opcode) + chip8->v[0];
+        }
+    }
+    return false;
+}
+
+static inline uint8_t chip8_read_memory(const chip8_t *chip8, uint32_t address) {
+    return chip8->memory[address & chip8->address_mask];
+}
+
+static inline void chip8_write_memory(chip8_t *chip8, uint32_t address, uint8_t value) {
+    address &= chip8->address_mask;
+#ifdef ENABLE_STATE_HASH
+    uint8_t previous = chip8->memory[address];
+    chip8->memory_hash ^= chip8_zobrist(HASH_KEY_MEMORY + address, previous) ^
+                          chip8_zobrist(HASH_KEY_MEMORY + address, value);
+#endif
+    chip8->memory[address] = value;
+    chip8->dirty_pages[address / DIRTY_PAGE_SIZE / 64] |= 1ULL << (address / DIRTY_PAGE_SIZE % 64);
+    CHIP8_HOOK(chip8, on_memory_write, address, value);
+#ifdef ENABLE_COVERAGE
+    uint64_t bit = 1ULL << (address % COVERAGE_WORD_BITS);
+    chip8->written[address / COVERAGE_WORD_BITS] |= bit;
+    if (chip8->executed[address / COVERAGE_WORD_BITS] & bit) {
+        if (chip8->smc_writes++ == 0) chip8->smc_address = address;
+    }
+#endif
+}
+
+static inline uint8_t chip8_run_length(uint64_t bits) {
+    return ~bits ? __builtin_ctzll(~bits) : 64;
+}
+
+static inline void chip8_mark_rows(chip8_t *chip8, uint8_t first, uint8_t count) {
+    uint64_t rows = count == 0 ? ~0ULL : ((1ULL << count) - 1) << first;
+    chip8->dirty_rows |= rows;
+    chip8->drawn_rows |= rows;
+    // Sprites report their own region, as they only cover part of their rows
+    if (count == 0) CHIP8_HOOK(chip8, on_draw, 0, 0, chip8->display_width, chip8->display_height);
+#ifdef ENABLE_STATE_HASH
+    // Instructions changing the whole display cost as much as hashing it
+    if (count == 0) chip8->display_hash = chip8_hash_display(chip8, 0, chip8->plane_size * chip8->display_planes);
+#endif
+}
+
+static inline uint64_t chip8_zobrist(uint32_t key, uint64_t value) {
+    if (value == 0) return 0;
+
+    // Mixes the key and value with the finalizer of MurmurHash3
+    uint64_t term = (uint64_t)key * 0x9E3779B97F4A7C15ULL ^ value * 0xC2B2AE3D27D4EB4FULL;
+    term ^= term >> 33;
+    term *= 0xFF51AFD7ED558CCDULL;
+    term ^= term >> 33;
+    term *= 0xC4CEB9FE1A85EC53ULL;
+    return term ^ term >> 33;
+}
+
+static uint64_t chip8_hash_display(const chip8_t *chip8, uint32_t first, uint32_t count) {
+    uint64_t hash = 0;
+    for (uint32_t w = first; w < first + count; ++w) hash ^= chip8_zobrist(HASH_KEY_DISPLAY + w, chip8->display[w]);
+    return hash;
+}
+
+static uint64_t chip8_hash_memory(const chip8_t *chip8) {
+    uint64_t hash = 0;
+    for (uint32_t a = 0; a < chip8->memory_size; ++a) hash ^= chip8_zobrist(HASH_KEY_MEMORY + a, chip8->memory[a]);
+    return hash;
+}
+
+static uint64_t chip8_hash_registers(const chip8_t *chip8) {
+    // Packs the registers into words, each of which is a single term
+    uint64_t words[11] = {0};
+    memcpy(&words[0], chip8->v, sizeof(chip8->v));
+    memcpy(&words[2], chip8->stack, sizeof(chip8->stack));
+    memcpy(&words[6], chip8->audio_pattern, sizeof(chip8->audio_pattern));
+    words[8]  = chip8->rng;
+    words[9]  = (uint64_t)chip8->pc | (uint64_t)chip8->i << 16 | (uint64_t)(uint8_t)chip8->stack_pointer << 32 |
+               (uint64_t)chip8->delay_timer << 40 | (uint64_t)chip8->sound_timer << 48;
+    words[10] = (uint64_t)chip8->planes | (uint64_t)chip8->pitch << 8 | (uint64_t)chip8->hires << 16 |
+               (uint64_t)chip8->key_wait << 24;
+
+    uint64_t hash = 0;
+    for (uint8_t w = 0; w < 11; ++w) hash ^= chip8_zobrist(HASH_KEY_REGISTERS + w, words[w]);
+    return hash;
+}
+
+static inline void chip8_cover_execution(chip8_t *chip8, uint32_t address) {
+#ifdef ENABLE_COVERAGE
+    uint32_t second = (address + 1) & chip8->address_mask;
+    chip8->executed[address / COVERAGE_WORD_BITS] |= 1ULL << (address % COVERAGE_WORD_BITS);
+    chip8->executed[second / COVERAGE_WORD_BITS] |= 1ULL << (second % COVERAGE_WORD_BITS);
 #else
-            chip8->pc = MA(result->opcode) + chip8->v[N2(result->opcode)];
+    (void)chip8;
+    (void)address;
 #endif
-            return true;
-            // clang-format on
-        case 0xC: // RNG
-            chip8->v[N2(result->opcode)] = generate_random_number() & B2(result->opcode);
-            return true;
-        case 0xD: // Draw
-            return chip8_execute_draw_instruction(chip8, result);
-        case 0xE: // Skip if Key
-            return chip8_execute_keypress_instruction(chip8, result);
-        case 0xF: // Miscellaneous
-            return chip8_execute_misc_instruction(chip8, result);
+}
+
+static inline uint8_t chip8_random(chip8_t *chip8) {
+    chip8->rng ^= chip8->rng >> 12;
+    chip8->rng ^= chip8->rng << 25;
+    chip8->rng ^= chip8->rng >> 27;
+    return (uint8_t)((chip8->rng * 0x2545F4914F6CDD1DULL) >> 56);
+}
+
+static uint16_t chip8_read_keypad(chip8_t *chip8) {
+    uint16_t keys = chip8->keypad_source ? chip8->keypad_source() : __atomic_load_n(&chip8->keypad, __ATOMIC_ACQUIRE);
+    for (uint16_t changed = keys ^ chip8->keys_seen; changed; changed &= changed - 1) {
+        uint8_t key = __builtin_ctz(changed);
+        if (keys & (1 << key)) {
+            chip8->key_pressed_at[key] = chip8->cycles;
+        } else {
+            chip8->key_released_at[key] = chip8->cycles;
+        }
+    }
+    chip8->keys_seen = keys;
+    return keys;
+}
+
+static void chip8_skip_instruction(chip8_t *chip8) {
+    uint16_t next = (chip8_read_memory(chip8, chip8->pc) << 8) | chip8_read_memory(chip8, chip8->pc + 1);
+    chip8->pc     = (chip8->pc + opcode_size(next, chip8->variant)) & chip8->address_mask;
+}
+
+static bool chip8_fetch_instruction(chip8_t *chip8, chip8_state_t *result) {
+    chip8_cover_execution(chip8, chip8->pc);
+    result->opcode = (chip8_read_memory(chip8, chip8->pc) << 8) | chip8_read_memory(chip8, chip8->pc + 1);
+    chip8->pc      = (chip8->pc + 2) & chip8->address_mask;
+    return true;
+}
+
+#define CHIP8_DISPATCH(name, ...) \
+    case OPCODE_##name:           \
+        return chip8_op_##name(chip8, result);
+#define CHIP8_DECODE(name, pattern, mask, mnemonic, operands, flags, variants) \
+    OPCODE_SWITCH_CASE_##mask(pattern, mask, variants, return chip8_op_##name(chip8, result))
+
+static bool chip8_execute_instruction(chip8_t *chip8, chip8_state_t *result) {
+    // Decoding straight into the handlers spares the switch on the type
+    uint16_t       opcode  = result->opcode;
+    variant_type_t variant = chip8->variant;
+    OPCODE_SWITCH(CHIP8_DECODE)
+    return chip8_dispatch_instruction(chip8, OPCODE_COUNT, result);
+}
+
+static bool chip8_dispatch_instruction(chip8_t *chip8, opcode_type_t type, chip8_state_t *result) {
+    // The switch is generated from the opcode table, and allows the compiler
+    // to inline every handler into a single jump table
+    switch (type) {
+        CHIP8_OPCODES(CHIP8_DISPATCH, OPCODE_NO_GROUP)
         default:
-            // Should be unreachable, but added for completion sake
+            // Remaining instructions do not resolve
             result->status = CHIP8_INSTRUCTION_INVALID;
+            CHIP8_HOOK(chip8, on_invalid_opcode, (chip8->pc - 2) & chip8->address_mask, result->opcode);
             return false;
     }
+}
 
-    return true;
+// Patterns of every instruction by name, for matching the second of a pair
+#define CHIP8_PATTERN(name, pattern, mask, ...) PATTERN_##name = pattern, MASK_##name = mask,
+enum { CHIP8_OPCODES(CHIP8_PATTERN, OPCODE_NO_GROUP) };
+
+#define CHIP8_FUSE(name, first, second)                                                                       \
+    case OPCODE_##first: {                                                                                    \
+        uint16_t next = (chip8_read_memory(chip8, chip8->pc) << 8) | chip8_read_memory(chip8, chip8->pc + 1); \
+        if ((next & MASK_##second) != PATTERN_##second) break;                                                \
+        if (!chip8_op_##first(chip8, result)) return 1;                                                       \
+        chip8_cover_execution(chip8, chip8->pc);                                                              \
+        result->opcode = next;                                                                                \
+        chip8->pc      = (chip8->pc + 2) & chip8->address_mask;                                               \
+        chip8->fusions[FUSION_##name] += 1;                                                                   \
+        chip8_op_##second(chip8, result);                                                                     \
+        return 2;                                                                                             \
+    }
+
+static uint32_t chip8_execute_fused(chip8_t *chip8, chip8_state_t *result, bool fuse) {
+    opcode_type_t type = opcode_decode(result->opcode, chip8->variant);
+    if (fuse) {
+        switch (type) {
+            CHIP8_FUSIONS(CHIP8_FUSE)
+            default:
+                break;
+        }
+    }
+    chip8_dispatch_instruction(chip8, type, result);
+    return 1;
 }
 
-static bool chip8_execute_system_instruction(chip8_t *chip8, chip8_state_t *result) {
-    switch (result->opcode) {
-        case 0x00E0: // Clear Screen
-            memset(chip8->display, 0, DISPLAY_WIDTH * DISPLAY_HEIGHT);
-            result->frame_buffer_dirty = true;
-            return true;
-        case 0x00EE: // Return from Subroutine
-            if (chip8->stack_pointer >= 0) {
-                chip8->pc = chip8->stack[chip8->stack_pointer--];
-                return true;
+static void chip8_scroll_vertical(chip8_t *chip8, int8_t rows) {
+    uint8_t height = chip8->display_height;
+    uint8_t stride = chip8->display_stride;
+    uint8_t n      = rows < 0 ? -rows : rows;
+
+    for (uint8_t p = 0; p < chip8->display_planes; ++p) {
+        if (!(chip8->planes & (1 << p))) continue;
+        uint64_t *plane = &chip8->display[p * chip8->plane_size];
+
+        if (rows > 0) { // Scroll Down
+            memmove(&plane[n * stride], plane, sizeof(uint64_t) * stride * (height - n));
+            memset(plane, 0, sizeof(uint64_t) * stride * n);
+        } else { // Scroll Up
+            memmove(plane, &plane[n * stride], sizeof(uint64_t) * stride * (height - n));
+            memset(&plane[(height - n) * stride], 0, sizeof(uint64_t) * stride * n);
+        }
+    }
+}
+
+static void chip8_scroll_horizontal(chip8_t *chip8, bool right) {
+    uint8_t height = chip8->display_height;
+    uint8_t words  = chip8->display_width / DISPLAY_ROW_BITS;
+    uint8_t stride = chip8->display_stride;
+
+    for (uint8_t p = 0; p < chip8->display_planes; ++p) {
+        if (!(chip8->planes & (1 << p))) continue;
+        uint64_t *plane = &chip8->display[p * chip8->plane_size];
+
+        for (uint8_t y = 0; y < height; ++y) {
+            uint64_t *row = &plane[y * stride];
+            if (right) {
+                for (uint8_t w = words; w-- > 1;) {
+                    row[w] = (row[w] >> 4) | (row[w - 1] << 60);
+                }
+                row[0] >>= 4;
             } else {
-                result->status = CHIP8_STACK_EMPTY;
-                return false;
+                for (uint8_t w = 0; w + 1 < words; ++w) {
+                    row[w] = (row[w] << 4) | (row[w + 1] >> 60);
+                }
+                row[words - 1] <<= 4;
             }
-        default:
-            // All other opcodes execute native machine code at address 0xNNN
-            result->status = CHIP8_INSTRUCTION_NOT_IMPLEMENTED;
-            return false;
+        }
+    }
+}
+
+static bool chip8_op_CLS(chip8_t *chip8, chip8_state_t *result) {
+    for (uint8_t p = 0; p < chip8->display_planes; ++p) {
+        if (!(chip8->planes & (1 << p))) continue;
+        memset(&chip8->display[p * chip8->plane_size], 0, sizeof(uint64_t) * chip8->plane_size);
+    }
+    chip8_mark_rows(chip8, 0, 0);
+    result->frame_buffer_dirty = true;
+    return true;
+}
+
+static bool chip8_op_RET(chip8_t *chip8, chip8_state_t *result) {
+    if (chip8->stack_pointer < 0) {
+        result->status = CHIP8_STACK_EMPTY;
+        return false;
+    }
+    chip8->pc = chip8->stack[chip8->stack_pointer--];
+    return true;
+}
+
+static bool chip8_op_SCD(chip8_t *chip8, chip8_state_t *result) {
+    chip8_scroll_vertical(chip8, N4(result->opcode));
+    chip8_mark_rows(chip8, 0, 0);
+    result->frame_buffer_dirty = true;
+    return true;
+}
+
+static bool chip8_op_SCU(chip8_t *chip8, chip8_state_t *result) {
+    chip8_scroll_vertical(chip8, -N4(result->opcode));
+    chip8_mark_rows(chip8, 0, 0);
+    result->frame_buffer_dirty = true;
+    return true;
+}
+
+static bool chip8_op_SCR(chip8_t *chip8, chip8_state_t *result) {
+    chip8_scroll_horizontal(chip8, true);
+    chip8_mark_rows(chip8, 0, 0);
+    result->frame_buffer_dirty = true;
+    return true;
+}
+
+static bool chip8_op_SCL(chip8_t *chip8, chip8_state_t *result) {
+    chip8_scroll_horizontal(chip8, false);
+    chip8_mark_rows(chip8, 0, 0);
+    result->frame_buffer_dirty = true;
+    return true;
+}
+
+static bool chip8_op_LOW(chip8_t *chip8, chip8_state_t *result) {
+    chip8->hires          = false;
+    chip8->display_width  = DISPLAY_WIDTH;
+    chip8->display_height = DISPLAY_HEIGHT;
+    memset(chip8->display, 0, sizeof(uint64_t) * chip8->plane_size * chip8->display_planes);
+    chip8_mark_rows(chip8, 0, 0);
+    result->frame_buffer_dirty = true;
+    return true;
+}
+
+static bool chip8_op_HIGH(chip8_t *chip8, chip8_state_t *result) {
+    chip8->hires          = true;
+    chip8->display_width  = HIRES_DISPLAY_WIDTH;
+    chip8->display_height = HIRES_DISPLAY_HEIGHT;
+    memset(chip8->display, 0, sizeof(uint64_t) * chip8->plane_size * chip8->display_planes);
+    chip8_mark_rows(chip8, 0, 0);
+    result->frame_buffer_dirty = true;
+    return true;
+}
+
+static bool chip8_op_SYS(chip8_t *chip8, chip8_state_t *result) {
+    (void)chip8;
+    // Executes native machine code at address 0xNNN
+    result->status = CHIP8_INSTRUCTION_NOT_IMPLEMENTED;
+    return false;
+}
+
+static bool chip8_op_JP(chip8_t *chip8, chip8_state_t *result) {
+    chip8->pc = MA(result->opcode);
+    return true;
+}
+
+static bool chip8_op_CALL(chip8_t *chip8, chip8_state_t *result) {
+    if (chip8->stack_pointer >= STACK_SIZE - 1) {
+        result->status = CHIP8_STACK_FULL;
+        return false;
     }
+    chip8->stack[++chip8->stack_pointer] = chip8->pc;
+    chip8->pc                            = MA(result->opcode);
+    return true;
 }
 
-static bool chip8_execute_arithmetic_instruction(chip8_t *chip8, chip8_state_t *result) {
+static bool chip8_op_SE_BYTE(chip8_t *chip8, chip8_state_t *result) {
+    if (chip8->v[N2(result->opcode)] == B2(result->opcode)) {
+        chip8_skip_instruction(chip8);
+    }
+    return true;
+}
+
+static bool chip8_op_SNE_BYTE(chip8_t *chip8, chip8_state_t *result) {
+    if (chip8->v[N2(result->opcode)] != B2(result->opcode)) {
+        chip8_skip_instruction(chip8);
+    }
+    return true;
+}
+
+static bool chip8_op_SAVE(chip8_t *chip8, chip8_state_t *result) {
+    // Variables are saved in the order that they were provided in
+    uint8_t x        = N2(result->opcode);
+    uint8_t y        = N3(result->opcode);
+    uint8_t distance = x < y ? y - x : x - y;
+    for (uint8_t j = 0; j <= distance; ++j) {
+        chip8_write_memory(chip8, chip8->i + j, chip8->v[x < y ? x + j : x - j]);
+    }
+    return true;
+}
+
+static bool chip8_op_LOAD(chip8_t *chip8, chip8_state_t *result) {
+    // Variables are loaded in the order that they were provided in
+    uint8_t x        = N2(result->opcode);
+    uint8_t y        = N3(result->opcode);
+    uint8_t distance = x < y ? y - x : x - y;
+    for (uint8_t j = 0; j <= distance; ++j) {
+        chip8->v[x < y ? x + j : x - j] = chip8_read_memory(chip8, chip8->i + j);
+    }
+    return true;
+}
+
+static bool chip8_op_SE_REG(chip8_t *chip8, chip8_state_t *result) {
+    // N4 is unused and can contain any value
+    if (chip8->v[N2(result->opcode)] == chip8->v[N3(result->opcode)]) {
+        chip8_skip_instruction(chip8);
+    }
+    return true;
+}
+
+static bool chip8_op_SE_REG_XO(chip8_t *chip8, chip8_state_t *result) {
+    // XO-CHIP uses N4 to select the instruction, and only skips when it is 0
+    return chip8_op_SE_REG(chip8, result);
+}
+
+static bool chip8_op_LD_BYTE(chip8_t *chip8, chip8_state_t *result) {
+    chip8->v[N2(result->opcode)] = B2(result->opcode);
+    return true;
+}
+
+static bool chip8_op_ADD_BYTE(chip8_t *chip8, chip8_state_t *result) {
+    chip8->v[N2(result->opcode)] += B2(result->opcode);
+    return true;
+}
+
+static bool chip8_op_LD_REG(chip8_t *chip8, chip8_state_t *result) {
+    chip8->v[N2(result->opcode)] = chip8->v[N3(result->opcode)];
+    return true;
+}
+
+static bool chip8_op_OR(chip8_t *chip8, chip8_state_t *result) {
+    chip8->v[N2(result->opcode)] |= chip8->v[N3(result->opcode)];
+    return true;
+}
+
+static bool chip8_op_AND(chip8_t *chip8, chip8_state_t *result) {
+    chip8->v[N2(result->opcode)] &= chip8->v[N3(result->opcode)];
+    return true;
+}
+
+static bool chip8_op_XOR(chip8_t *chip8, chip8_state_t *result) {
+    chip8->v[N2(result->opcode)] ^= chip8->v[N3(result->opcode)];
+    return true;
+}
+
+static bool chip8_op_ADD_REG(chip8_t *chip8, chip8_state_t *result) {
     uint8_t *x = &chip8->v[N2(result->opcode)];
     uint8_t *y = &chip8->v[N3(result->opcode)];
-    uint8_t *f = &chip8->v[0xF];
+    if (*x > UINT8_MAX - *y) chip8->v[0xF] = 0x1;
+    *x += *y;
+    return true;
+}
 
-    switch (N4(result->opcode)) {
-        case 0x0: // Set
-            *x = *y;
-            return true;
-        case 0x1: // Bitwise OR
-            *x |= *y;
-            return true;
-        case 0x2: // Bitwise AND
-            *x &= *y;
-            return true;
-        case 0x3: // Bitwise XOR
-            *x ^= *y;
-            return true;
-        case 0x4: // Add with Carry
-            if (*x > UINT8_MAX - *y) *f = 0x1;
-            *x += *y;
-            return true;
-        case 0x5: // Subtract X from Y
-            if (*x > *y) *f = 0x1;
-            *x = *x - *y;
-            return true;
-        case 0x6: // Shift Right
-            // clang-format off
-            // TODO: Make this behavior configurable at runtime.
-#ifdef LEGACY_SHIFT_BEHAVIOR
-            *x = *y;
-#endif
-            *f = (*x) & 0x1;
-            *x >>= 0x1;
-            return true;
-            // clang-format on
-        case 0x7: // Subtract Y from X
-            if (*y > *x) *f = 0x1;
-            *x = *y - *x;
-            return true;
-        case 0xE: // Shift Left
-            // clang-format off
-            // TODO: Make this behavior configurable at runtime.
-#ifdef LEGACY_SHIFT_BEHAVIOR
-            *x = *y;
-#endif
-            *f = (*x >> 7) & 0x1;
-            *x <<= 0x1;
-            return true;
-            // clang-format on
-        default:
-            // Remaining instructions do not resolve
-            result->status = CHIP8_INSTRUCTION_INVALID;
-            return false;
+static bool chip8_op_SUB(chip8_t *chip8, chip8_state_t *result) {
+    uint8_t *x = &chip8->v[N2(result->opcode)];
+    uint8_t *y = &chip8->v[N3(result->opcode)];
+    if (*x > *y) chip8->v[0xF] = 0x1;
+    *x = *x - *y;
+    return true;
+}
+
+static bool chip8_op_SHR(chip8_t *chip8, chip8_state_t *result) {
+    uint8_t *x = &chip8->v[N2(result->opcode)];
+    if (chip8->quirks & QUIRK_SHIFT) *x = chip8->v[N3(result->opcode)];
+    chip8->v[0xF] = (*x) & 0x1;
+    *x >>= 0x1;
+    return true;
+}
+
+static bool chip8_op_SUBN(chip8_t *chip8, chip8_state_t *result) {
+    uint8_t *x = &chip8->v[N2(result->opcode)];
+    uint8_t *y = &chip8->v[N3(result->opcode)];
+    if (*y > *x) chip8->v[0xF] = 0x1;
+    *x = *y - *x;
+    return true;
+}
+
+static bool chip8_op_SHL(chip8_t *chip8, chip8_state_t *result) {
+    uint8_t *x = &chip8->v[N2(result->opcode)];
+    if (chip8->quirks & QUIRK_SHIFT) *x = chip8->v[N3(result->opcode)];
+    chip8->v[0xF] = (*x >> 7) & 0x1;
+    *x <<= 0x1;
+    return true;
+}
+
+static bool chip8_op_SNE_REG(chip8_t *chip8, chip8_state_t *result) {
+    // N4 is unused and can contain any value
+    if (chip8->v[N2(result->opcode)] != chip8->v[N3(result->opcode)]) {
+        chip8_skip_instruction(chip8);
     }
+    return true;
+}
+
+static bool chip8_op_LD_I(chip8_t *chip8, chip8_state_t *result) {
+    chip8->i = MA(result->opcode);
+    return true;
+}
+
+static bool chip8_op_JP_OFFSET(chip8_t *chip8, chip8_state_t *result) {
+    uint8_t offset = chip8->quirks & QUIRK_OFFSET_JUMP ? chip8->v[0] : chip8->v[N2(result->opcode)];
+    chip8->pc      = (MA(result->opcode) + offset) & chip8->address_mask;
+    return true;
+}
+
+static bool chip8_op_RND(chip8_t *chip8, chip8_state_t *result) {
+    uint8_t random               = chip8->generator ? chip8->generator() : chip8_random(chip8);
+    chip8->v[N2(result->opcode)] = random & B2(result->opcode);
+    return true;
 }
 
-static bool chip8_execute_draw_instruction(chip8_t *chip8, chip8_state_t *result) {
+static bool chip8_op_DRW(chip8_t *chip8, chip8_state_t *result) {
+    uint8_t width  = chip8->display_width;
+    uint8_t height = chip8->display_height;
+    uint8_t words  = width / DISPLAY_ROW_BITS;
+
     // Starting positions for drawing, which wrap across the screen
-    uint8_t x = chip8->v[N2(result->opcode)] & (DISPLAY_WIDTH - 1);
-    uint8_t y = chip8->v[N3(result->opcode)] & (DISPLAY_HEIGHT - 1);
-
-    // Data for drawing the actual sprite
-    uint8_t  h      = N4(result->opcode);
-    uint8_t *sprite = &chip8->memory[chip8->i];
-    uint8_t *f      = &chip8->v[0xF]; // Flag gets set if a pixel turns off
-
-    // Iterate sprite byte-by-byte
-    for (uint8_t j = 0; j < h; ++j) {
-        uint8_t row = sprite[j];
-        // Iterate pixels bit-by-bit
-        for (uint8_t i = 0; i < 8; ++i) {
-            // Sprites do not wrap across the screen
-            if (x + i >= DISPLAY_WIDTH || y + j >= DISPLAY_HEIGHT) continue;
-            // Draw left-to-right (as opposed to 1 << i)
-            bool  p   = row & (0x80 >> i);
-            bool *old = &chip8->display[(y + j) * DISPLAY_WIDTH + (x + i)];
-            if (*old && p) *f = 0x1;
-            *old ^= p;
+    uint8_t x = chip8->v[N2(result->opcode)] & (width - 1);
+    uint8_t y = chip8->v[N3(result->opcode)] & (height - 1);
+
+    // Data for drawing the actual sprite; XO-CHIP draws 16x16 sprites for N = 0
+    uint8_t  h         = N4(result->opcode);
+    bool     wide      = h == 0 && chip8->variant == VARIANT_XOCHIP;
+    uint8_t  rows      = wide ? 16 : h;
+    uint8_t  row_bytes = wide ? 2 : 1;
+    uint32_t sprite    = chip8->i;
+    bool     collision = false;
+
+    // Sprites do not wrap across the screen
+    uint8_t visible = y + rows > height ? height - y : rows;
+
+    // Each selected plane consumes its own sprite, stored back-to-back
+    for (uint8_t p = 0; p < chip8->display_planes; ++p) {
+        if (!(chip8->planes & (1 << p))) continue;
+        uint64_t *plane = &chip8->display[p * chip8->plane_size];
+
+        uint64_t bits[16];
+        for (uint8_t j = 0; j < visible; ++j) {
+            uint32_t address = sprite + j * row_bytes;
+            bits[j]          = (uint64_t)chip8_read_memory(chip8, address) << 56;
+            if (wide) bits[j] |= (uint64_t)chip8_read_memory(chip8, address + 1) << 48;
         }
+
+        if (visible) chip8_mark_rows(chip8, y, visible);
+        uint64_t *start = &plane[y * chip8->display_stride];
+#ifdef ENABLE_STATE_HASH
+        uint32_t first = p * chip8->plane_size + y * chip8->display_stride;
+        uint32_t count = visible * chip8->display_stride;
+        uint64_t previous[16 * HIRES_DISPLAY_WIDTH / DISPLAY_ROW_BITS];
+        memcpy(previous, start, sizeof(uint64_t) * count);
+#endif
+        collision |= blitter_draw_sprite(start, chip8->display_stride, words, x, bits, visible);
+#ifdef ENABLE_STATE_HASH
+        for (uint32_t w = 0; w < count; ++w) {
+            if (previous[w] == start[w]) continue;
+            chip8->display_hash ^= chip8_zobrist(HASH_KEY_DISPLAY + first + w, previous[w]) ^
+                                   chip8_zobrist(HASH_KEY_DISPLAY + first + w, start[w]);
+        }
+#endif
+
+        sprite += rows * row_bytes;
     }
 
+    // Flag gets set if a pixel turns off
+    if (collision) chip8->v[0xF] = 0x1;
+#ifdef ENABLE_HOOKS
+    uint8_t columns = x + 8 * row_bytes > width ? width - x : 8 * row_bytes;
+    if (visible && (chip8->planes & ((1 << chip8->display_planes) - 1))) CHIP8_HOOK(chip8, on_draw, x, y, columns, visible);
+#endif
     result->frame_buffer_dirty = true;
     return true;
 }
 
-static bool chip8_execute_keypress_instruction(chip8_t *chip8, chip8_state_t *result) {
-    uint8_t *x = &chip8->v[N2(result->opcode)];
+static bool chip8_op_SKP(chip8_t *chip8, chip8_state_t *result) {
+    if (chip8_read_keypad(chip8) & (1 << (chip8->v[N2(result->opcode)] & 0xF))) {
+        chip8_skip_instruction(chip8);
+    }
+    return true;
+}
 
-    switch (B2(result->opcode)) {
-        case 0x9E:
-        case 0xA1:
-            // TODO: Implement when keypress handling has been added
-            result->status = CHIP8_INSTRUCTION_NOT_IMPLEMENTED;
-            return false;
-        default:
-            // Remaining instructions do not resolve
-            result->status = CHIP8_INSTRUCTION_INVALID;
-            return false;
+static bool chip8_op_SKNP(chip8_t *chip8, chip8_state_t *result) {
+    if (!(chip8_read_keypad(chip8) & (1 << (chip8->v[N2(result->opcode)] & 0xF)))) {
+        chip8_skip_instruction(chip8);
     }
+    return true;
 }
 
-static bool chip8_execute_misc_instruction(chip8_t *chip8, chip8_state_t *result) {
-    uint8_t *x = &chip8->v[N2(result->opcode)];
+static bool chip8_op_LD_I_LONG(chip8_t *chip8, chip8_state_t *result) {
+    (void)result;
+    chip8_cover_execution(chip8, chip8->pc);
+    chip8->i  = (chip8_read_memory(chip8, chip8->pc) << 8) | chip8_read_memory(chip8, chip8->pc + 1);
+    chip8->pc = (chip8->pc + 2) & chip8->address_mask;
+    return true;
+}
 
-    switch (B2(result->opcode)) {
-        case 0x07: // Set to Delay Timer
-            *x = chip8->delay_timer;
-            return true;
-        case 0x0A: // Get Key
-            // TODO: Implement when keypress handling has been added
-            result->status = CHIP8_INSTRUCTION_NOT_IMPLEMENTED;
-            return false;
-        case 0x15: // Set Delay Timer
-            chip8->delay_timer = *x;
-            return true;
-        case 0x18: // Set Sound Timer
-            chip8->sound_timer = *x;
-            if (*x > 0) result->sound_timer_set = true;
-            return true;
-        case 0x1E: // Add to Index
-            chip8->i += *x;
-            return true;
-        case 0x29: // Get Character
-            chip8->i = FONT_START + 5 * ((*x) & 0xF);
-            return true;
-        case 0x33: // Decimal Conversion
-            chip8->memory[chip8->i + 0] = *x / 100 % 10;
-            chip8->memory[chip8->i + 1] = *x / 10 % 10;
-            chip8->memory[chip8->i + 2] = *x / 1 % 10;
-            return true;
-        case 0x55: // Store Memory
-            for (uint8_t j = 0; j <= N2(result->opcode); ++j) {
-                chip8->memory[chip8->i + j] = chip8->v[j];
-            }
-            // TODO: Make this configurable at runtime
-#ifdef LEGACY_MEMORY_BEHAVIOR
-            chip8->i += N2(result->opcode) + 1;
+static bool chip8_op_PLANE(chip8_t *chip8, chip8_state_t *result) {
+    chip8->planes = N2(result->opcode);
+    return true;
+}
+
+static bool chip8_op_AUDIO(chip8_t *chip8, chip8_state_t *result) {
+    for (uint8_t j = 0; j < AUDIO_PATTERN_SIZE; ++j) {
+        chip8->audio_pattern[j] = chip8_read_memory(chip8, chip8->i + j);
+    }
+    result->audio_pattern_set = true;
+    return true;
+}
+
+static bool chip8_op_LD_DT_READ(chip8_t *chip8, chip8_state_t *result) {
+    chip8->v[N2(result->opcode)] = chip8->delay_timer;
+    return true;
+}
+
+static bool chip8_op_LD_KEY(chip8_t *chip8, chip8_state_t *result) {
+    // Like the COSMAC VIP, a key only counts once it is released, so the
+    // instruction runs again until any key pressed during the wait is
+    uint16_t keys     = chip8_read_keypad(chip8);
+    uint16_t released = chip8->key_wait & ~keys;
+    if (released) {
+        chip8->v[N2(result->opcode)] = __builtin_ctz(released);
+        chip8->key_wait              = 0;
+        return true;
+    }
+    chip8->key_wait |= keys;
+    chip8->pc = (chip8->pc - 2) & chip8->address_mask;
+    CHIP8_HOOK(chip8, on_key_wait, N2(result->opcode));
+    return true;
+}
+
+static bool chip8_op_LD_DT(chip8_t *chip8, chip8_state_t *result) {
+    chip8->delay_timer = chip8->v[N2(result->opcode)];
+    return true;
+}
+
+static bool chip8_op_LD_ST(chip8_t *chip8, chip8_state_t *result) {
+#ifdef ENABLE_HOOKS
+    bool sounding = chip8->sound_timer > 0;
 #endif
-            return true;
-        case 0x65: // Load Memory
-            for (uint8_t j = 0; j <= N2(result->opcode); ++j) {
-                chip8->v[j] = chip8->memory[chip8->i + j];
-            }
-            // TODO: Make this configurable at runtime
-#ifdef LEGACY_MEMORY_BEHAVIOR
-            chip8->i += N2(result->opcode) + 1;
+    chip8->sound_timer = chip8->v[N2(result->opcode)];
+    if (chip8->sound_timer > 0) result->sound_timer_set = true;
+#ifdef ENABLE_HOOKS
+    if (!sounding && chip8->sound_timer > 0) CHIP8_HOOK(chip8, on_sound_start);
+    if (sounding && chip8->sound_timer == 0) CHIP8_HOOK(chip8, on_sound_stop);
 #endif
-            return true;
-        default:
-            // Remaining instructions do not resolve
-            result->status = CHIP8_INSTRUCTION_INVALID;
-            return false;
+    return true;
+}
+
+static bool chip8_op_ADD_I(chip8_t *chip8, chip8_state_t *result) {
+    chip8->i += chip8->v[N2(result->opcode)];
+    return true;
+}
+
+static bool chip8_op_LD_FONT(chip8_t *chip8, chip8_state_t *result) {
+    chip8->i = FONT_START + 5 * (chip8->v[N2(result->opcode)] & 0xF);
+    return true;
+}
+
+static bool chip8_op_LD_BCD(chip8_t *chip8, chip8_state_t *result) {
+    uint8_t x = chip8->v[N2(result->opcode)];
+    chip8_write_memory(chip8, chip8->i + 0, x / 100 % 10);
+    chip8_write_memory(chip8, chip8->i + 1, x / 10 % 10);
+    chip8_write_memory(chip8, chip8->i + 2, x / 1 % 10);
+    return true;
+}
+
+static bool chip8_op_PITCH(chip8_t *chip8, chip8_state_t *result) {
+    chip8->pitch              = chip8->v[N2(result->opcode)];
+    result->audio_pattern_set = true;
+    return true;
+}
+
+static bool chip8_op_LD_STORE(chip8_t *chip8, chip8_state_t *result) {
+    for (uint8_t j = 0; j <= N2(result->opcode); ++j) {
+        chip8_write_memory(chip8, chip8->i + j, chip8->v[j]);
+    }
+    if (chip8->quirks & QUIRK_MEMORY) chip8->i += N2(result->opcode) + 1;
+    return true;
+}
+
+static bool chip8_op_LD_LOAD(chip8_t *chip8, chip8_state_t *result) {
+    for (uint8_t j = 0; j <= N2(result->opcode); ++j) {
+        chip8->v[j] = chip8_read_memory(chip8, chip8->i + j);
     }
+    if (chip8->quirks & QUIRK_MEMORY) chip8->i += N2(result->opcode) + 1;
+    return true;
 }
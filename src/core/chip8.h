@@ -4,14 +4,65 @@
 #include <stdint.h>
 
 #include "font.h"
+#include "opcodes.h"
+#include "variant.h"
 
-#define MEMORY_SIZE       (4 * 1024) // 4KB; per specification
-#define STACK_SIZE        16         // Arbitrary value
-#define ADDRESS_SIZE      0xFFF      // 12-bits; per specification
-#define PROGRAM_START     0x200      // Per specification
-#define DISPLAY_WIDTH     64         // Per specification; scaled by driver
-#define DISPLAY_HEIGHT    32         // Per specification; scaled by driver
-#define FRAMES_PER_SECOND 60         // Per specification
+#define MEMORY_SIZE          (4 * 1024)  // 4KB; per specification
+#define XOCHIP_MEMORY_SIZE   (64 * 1024) // 64KB; per XO-CHIP specification
+#define STACK_SIZE           16          // Arbitrary value
+#define ADDRESS_SIZE         0xFFF       // 12-bits; per specification
+#define XOCHIP_ADDRESS_SIZE  0xFFFF      // 16-bits; per XO-CHIP specification
+#define PROGRAM_START        0x200       // Per specification
+#define DISPLAY_WIDTH        64          // Per specification; scaled by driver
+#define DISPLAY_HEIGHT       32          // Per specification; scaled by driver
+#define HIRES_DISPLAY_WIDTH  128         // Per XO-CHIP specification
+#define HIRES_DISPLAY_HEIGHT 64          // Per XO-CHIP specification
+#define DISPLAY_ROW_BITS     64          // Pixels packed into a single display word
+#define AUDIO_PATTERN_SIZE   16          // Per XO-CHIP specification
+#define DEFAULT_PITCH        64          // Per XO-CHIP specification; 4000Hz playback
+#define FRAMES_PER_SECOND    60          // Per specification
+
+// Granularity of the memory tracked for `chip8_restore`
+#define DIRTY_PAGE_SIZE  256
+#define DIRTY_PAGE_WORDS (XOCHIP_MEMORY_SIZE / DIRTY_PAGE_SIZE / 64)
+
+// Keys of the Zobrist terms of each part of the state
+#define HASH_KEY_MEMORY    0x00000
+#define HASH_KEY_DISPLAY   0x10000
+#define HASH_KEY_REGISTERS 0x20000
+
+// Bits in a single word of the coverage bitmaps
+#define COVERAGE_WORD_BITS 64
+
+// Seed of the built-in random number generator until seeded at runtime
+#define DEFAULT_RNG_SEED 0x9E3779B97F4A7C15
+
+// Quirks enabled by the build configuration, used until overridden at runtime
+#ifdef LEGACY_OFFSET_JUMP_BEHAVIOR
+#define DEFAULT_QUIRK_OFFSET_JUMP QUIRK_OFFSET_JUMP
+#else
+#define DEFAULT_QUIRK_OFFSET_JUMP 0
+#endif
+#ifdef LEGACY_MEMORY_BEHAVIOR
+#define DEFAULT_QUIRK_MEMORY QUIRK_MEMORY
+#else
+#define DEFAULT_QUIRK_MEMORY 0
+#endif
+#ifdef LEGACY_SHIFT_BEHAVIOR
+#define DEFAULT_QUIRK_SHIFT QUIRK_SHIFT
+#else
+#define DEFAULT_QUIRK_SHIFT 0
+#endif
+#define DEFAULT_QUIRKS (DEFAULT_QUIRK_OFFSET_JUMP | DEFAULT_QUIRK_MEMORY | DEFAULT_QUIRK_SHIFT)
+
+// Legacy (COSMAC VIP) behaviors that can be toggled per program
+typedef enum {
+    QUIRK_NONE        = 0,
+    QUIRK_OFFSET_JUMP = 1 << 0, // 0xBNNN jumps to NNN + V0 instead of XNN + VX
+    QUIRK_MEMORY      = 1 << 1, // 0xFX55 / 0xFX65 increment I past the last register
+    QUIRK_SHIFT       = 1 << 2, // 0x8XY6 / 0x8XYE shift VY into VX
+    QUIRK_ALL         = QUIRK_OFFSET_JUMP | QUIRK_MEMORY | QUIRK_SHIFT,
+} chip8_quirk_t;
 
 typedef enum {
     CHIP8_OK = 0,
@@ -22,27 +73,129 @@ typedef enum {
     CHIP8_STACK_FULL,
 } chip8_status_t;
 
+// Accesses of memory which a watchpoint stops before
+typedef enum {
+    CHIP8_WATCH_READ  = 1 << 0,
+    CHIP8_WATCH_WRITE = 1 << 1,
+} chip8_watch_t;
+
+// Reasons for `chip8_run_until` to stop running
+typedef enum {
+    CHIP8_STOP_LIMIT = 0,  // Ran every cycle of the limit
+    CHIP8_STOP_BREAKPOINT, // About to execute an address with a breakpoint
+    CHIP8_STOP_READ,       // About to read an address with a read watchpoint
+    CHIP8_STOP_WRITE,      // About to write an address with a write watchpoint
+    CHIP8_STOP_FAILED,     // An instruction failed, as reported by the state
+} chip8_stop_reason_t;
+
 typedef struct {
     chip8_status_t status;             // Latest emulator status
     uint16_t       opcode;             // Last processed opcode
     bool           frame_buffer_dirty; // If the display changed and must redraw
     bool           sound_timer_set;    // If the sound timer was enabled
+    bool           audio_pattern_set;  // If the audio pattern or pitch changed
 } chip8_state_t;
 
+typedef struct {
+    chip8_stop_reason_t reason;  // Why the run stopped
+    uint16_t            address; // Address of the breakpoint, or the first watched address accessed
+    chip8_state_t       state;   // Emulator state of the cycles run, like `chip8_run_cycles`
+} chip8_stop_t;
+
+// Observers which the interpreter calls as events happen, see `chip8_set_hooks`
+typedef struct {
+    void *context;                                                                       // Passed to every hook
+    void (*on_draw)(void *context, uint8_t x, uint8_t y, uint8_t width, uint8_t height); // The display changed within a region
+    void (*on_sound_start)(void *context);                                               // The sound timer was set while expired
+    void (*on_sound_stop)(void *context);                                                // The sound timer expired or was cleared
+    void (*on_key_wait)(void *context, uint8_t x);                                       // 0xFX0A is waiting for a key to store into VX
+    void (*on_invalid_opcode)(void *context, uint16_t address, uint16_t opcode);         // An instruction at an address failed to decode
+    void (*on_memory_write)(void *context, uint16_t address, uint8_t value);             // An instruction wrote a byte into memory
+} chip8_hooks_t;
+
+/**
+ * Pairs of instructions which `chip8_run_cycles` executes with one dispatch,
+ * defined as `FUSE(name, first, second)` using the names of `CHIP8_OPCODES`.
+ *
+ * The first instruction of each pair must be unique among the pairs, and must
+ * neither branch nor write memory, so the second instruction always follows it
+ * unchanged. The second instruction must be supported by every variant.
+ */
+#define CHIP8_FUSIONS(FUSE)           \
+    FUSE(SPRITE, LD_I, DRW)           \
+    FUSE(LOAD_PAIR, LD_BYTE, LD_BYTE) \
+    FUSE(DELAY, LD_DT, LD_DT_READ)    \
+    FUSE(COUNTER, ADD_BYTE, SE_BYTE)
+
+#define CHIP8_FUSION_ENUM(name, ...) FUSION_##name,
+
+typedef enum {
+    CHIP8_FUSIONS(CHIP8_FUSION_ENUM)
+    FUSION_COUNT
+} chip8_fusion_t;
+
 typedef struct {
     // Core emulator state
-    uint8_t  memory[MEMORY_SIZE];                     // Available memory
-    uint16_t pc;                                      // Current memory address
-    uint16_t i;                                       // Arbitrary address within memory
-    uint8_t  v[16];                                   // Arbitrary variable registers
-    uint16_t stack[16];                               // Subroutine return addresses
-    int8_t   stack_pointer;                           // Current position within stack
-    uint8_t  delay_timer;                             // Value of delay timer
-    uint8_t  sound_timer;                             // Value of sound timer
-    bool     display[DISPLAY_WIDTH * DISPLAY_HEIGHT]; // Active frame buffer
+    uint8_t  *memory;        // Available memory; sized per variant
+    uint16_t  pc;            // Current memory address
+    uint16_t  i;             // Arbitrary address within memory
+    uint8_t   v[16];         // Arbitrary variable registers
+    uint16_t  stack[16];     // Subroutine return addresses
+    int8_t    stack_pointer; // Current position within stack
+    uint8_t   delay_timer;   // Value of delay timer
+    uint8_t   sound_timer;   // Value of sound timer
+    uint64_t *display;       // Active frame buffer; packed rows of pixels per plane
+    // Extended (XO-CHIP) state
+    uint8_t planes;                            // Bitmask of planes selected for drawing
+    uint8_t pitch;                             // Playback rate of the audio pattern
+    uint8_t audio_pattern[AUDIO_PATTERN_SIZE]; // 1-bit audio samples
+    bool    hires;                             // If the high resolution mode is active
     // Meta-state for debugging and configuration
-    font_type_t font;          // Active font
-    bool        playing_sound; // If sound is currently being played
+    variant_type_t variant;        // Active platform variant
+    uint8_t        quirks;         // Bitmask of enabled quirks
+    uint32_t       memory_size;    // Size of the allocated memory
+    uint16_t       address_mask;   // Wraps any address into the allocated memory
+    uint8_t        display_width;  // Width of the active display mode
+    uint8_t        display_height; // Height of the active display mode
+    uint8_t        display_stride; // Number of words making up a single row
+    uint16_t       plane_size;     // Number of words making up a single plane
+    uint8_t        display_planes; // Number of allocated planes
+    font_type_t    font;           // Active font
+    bool           playing_sound;  // If sound is currently being played
+    uint64_t       rng;            // State of the built-in random number generator
+    uint8_t (*generator)(void);    // Optional override of the built-in generator
+    uint16_t keypad;                 // Pressed keys, bit N for key N; accessed atomically
+    uint16_t (*keypad_source)(void); // Optional source of the keypad, read instead of `keypad`
+    uint16_t key_wait;               // Keys pressed while waiting in 0xFX0A
+    uint32_t fusions[FUSION_COUNT]; // Pairs executed by each fusion since loading
+    uint64_t dirty_pages[DIRTY_PAGE_WORDS]; // Bitmap of memory pages written since the last reset
+    uint64_t dirty_rows;                    // Bitmap of display rows changed since the last reset
+    uint64_t drawn_rows;                    // Bitmap of display rows changed since last taken
+    uint64_t cycles;                        // Instruction cycles run since loading
+    uint16_t keys_seen;                     // Keypad as last read by an instruction
+    uint64_t key_pressed_at[16];            // Cycle at which instructions first saw each key pressed
+    uint64_t key_released_at[16];           // Cycle at which instructions first saw each key released
+    // Debugger state, allocated once the first breakpoint or watchpoint is set
+    uint64_t *breakpoints;      // Bitmap of addresses to stop at before executing
+    uint64_t *watch_reads;      // Bitmap of addresses to stop at before reading
+    uint64_t *watch_writes;     // Bitmap of addresses to stop at before writing
+    uint32_t  breakpoint_count; // Number of addresses with a breakpoint
+    uint32_t  watchpoint_count; // Number of addresses with a watchpoint of either kind
+#ifdef ENABLE_HOOKS
+    chip8_hooks_t hooks; // Observers of events, see `chip8_set_hooks`
+#endif
+#ifdef ENABLE_STATE_HASH
+    // Zobrist terms maintained on every write, see `chip8_hash`
+    uint64_t memory_hash;  // XOR of the terms of memory
+    uint64_t display_hash; // XOR of the terms of the display
+#endif
+#ifdef ENABLE_COVERAGE
+    // Instrumentation of the interpreter since loading
+    uint64_t *executed;    // Bitmap of addresses fetched as instructions
+    uint64_t *written;     // Bitmap of addresses written by instructions
+    uint32_t  smc_writes;  // Number of writes into previously executed addresses
+    uint16_t  smc_address; // Address of the first write into executed code
+#endif
 } chip8_t;
 
 /**
@@ -50,13 +203,217 @@ typedef struct {
  *
  * In addition to allocating memory for the emulator, this function also
  * ensures that the emulator is correctly reset to its default state,
- * loads the configured `DEFAULT_FONT` into memory, and stores the provided
- * random number generator callback.
+ * loads the configured `DEFAULT_FONT` into memory, and seeds the built-in
+ * random number generator with `DEFAULT_RNG_SEED`.
+ *
+ * The emulator is initialized as the classic CHIP-8 variant, and must be
+ * released using `chip8_free` once it is no longer needed.
  *
  * @param chip8 - The CHIP-8 to initialize
- * @param generator - A callback that generates a random number
+ * @returns If the emulator could be allocated
+ */
+bool chip8_init(chip8_t *chip8);
+
+/**
+ * Releases the memory allocated for the CHIP-8.
+ *
+ * @param chip8 - The CHIP-8 to release
+ */
+void chip8_free(chip8_t *chip8);
+
+/**
+ * Creates an independent copy of the CHIP-8.
+ *
+ * The copy receives its own memory and display, so it can be run alongside
+ * the original without affecting it. Like the original, the copy must be
+ * released using `chip8_free`.
+ *
+ * @param clone - The CHIP-8 to copy into; must not be initialized
+ * @param chip8 - The CHIP-8 to copy
+ * @returns If the copy could be allocated
+ */
+bool chip8_clone(chip8_t *clone, const chip8_t *chip8);
+
+/**
+ * Captures the state of the CHIP-8 as a baseline for `chip8_restore`.
+ *
+ * The baseline is an independent copy like one made by `chip8_clone`, and
+ * must be released using `chip8_free`. Tracking of the memory and display
+ * changed by the CHIP-8 starts over from the captured state.
+ *
+ * @param baseline - The CHIP-8 to capture into; must not be initialized
+ * @param chip8 - The CHIP-8 to capture
+ * @returns If the baseline could be allocated
+ */
+bool chip8_capture(chip8_t *baseline, chip8_t *chip8);
+
+/**
+ * Resets the CHIP-8 to a baseline captured by `chip8_capture`.
+ *
+ * Only the pages of memory and the rows of the display changed since the
+ * baseline was captured or last restored are copied back, which makes this
+ * far cheaper than loading the program again when little has changed. Memory
+ * changed outside of instructions is only restored if written through
+ * `chip8_patch_memory`. Coverage keeps accumulating across restores.
+ *
+ * @param chip8 - The CHIP-8 to reset
+ * @param baseline - The baseline captured from the CHIP-8
+ * @returns If the CHIP-8 was reset; fails if the variants differ
+ */
+bool chip8_restore(chip8_t *chip8, const chip8_t *baseline);
+
+/**
+ * Writes a block of data into memory, tracking it for `chip8_restore`.
+ *
+ * @param chip8 - The CHIP-8 to write into
+ * @param address - The address to write the data at
+ * @param data - The data to write
+ * @param size - The size of the data, which must fit in memory past the address
+ * @returns If the data was written
+ */
+bool chip8_patch_memory(chip8_t *chip8, uint32_t address, const uint8_t *data, uint32_t size);
+
+/**
+ * Hashes the state of the CHIP-8 which affects its future execution.
+ *
+ * Statistics and instrumentation, such as fusion counts or coverage, are not
+ * hashed, so that emulators which ran through different execution engines
+ * hash equal whenever they would continue to behave the same.
+ *
+ * The hash is the XOR of a Zobrist term for every byte of memory, word of the
+ * display and register. With ENABLE_STATE_HASH, the terms of memory and the
+ * display are maintained as instructions write them, so that hashing costs
+ * the same regardless of the size of memory; otherwise they are computed on
+ * every call. Both produce the same hash.
+ *
+ * @param chip8 - The CHIP-8 to hash
+ * @returns The hash of the state
  */
-void chip8_init(chip8_t *chip8, uint8_t (*generator)(void));
+uint64_t chip8_hash(const chip8_t *chip8);
+
+/**
+ * Recomputes the maintained hash after memory or the display were modified
+ * directly, rather than through instructions or `chip8_patch_memory`.
+ *
+ * Does nothing unless built with ENABLE_STATE_HASH.
+ *
+ * @param chip8 - The CHIP-8 to rehash
+ */
+void chip8_rehash(chip8_t *chip8);
+
+/**
+ * Switches the CHIP-8 to a different platform variant.
+ *
+ * Memory and the display are reallocated to the size required by the variant,
+ * so classic instances keep their small footprint. Switching variants resets
+ * the emulator to its initial state, preserving only the active font.
+ *
+ * @param chip8 - The CHIP-8 to switch
+ * @param variant - The variant to switch to
+ * @returns If the variant was switched successfully
+ */
+bool chip8_set_variant(chip8_t *chip8, variant_type_t variant);
+
+/**
+ * Sets the quirks that the CHIP-8 should emulate.
+ *
+ * Quirks are initialized from the build configuration, but can be changed at
+ * any time to match the expectations of the loaded program.
+ *
+ * @param chip8 - The CHIP-8 to configure
+ * @param quirks - A bitmask of `chip8_quirk_t` values to enable
+ */
+void chip8_set_quirks(chip8_t *chip8, uint8_t quirks);
+
+/**
+ * Seeds the built-in random number generator of the CHIP-8.
+ *
+ * Every emulator owns its generator, so emulators seeded with the same value
+ * produce the same sequence regardless of any other emulators in the process.
+ *
+ * @param chip8 - The CHIP-8 to seed
+ * @param seed - The seed to use; zero is replaced with `DEFAULT_RNG_SEED`
+ */
+void chip8_seed_rng(chip8_t *chip8, uint64_t seed);
+
+/**
+ * Overrides the built-in random number generator of the CHIP-8.
+ *
+ * The callback is shared by every emulator it is installed into, and must
+ * therefore be thread-safe if those emulators run in parallel.
+ *
+ * @param chip8 - The CHIP-8 to configure
+ * @param generator - A callback that generates a random number, or `NULL` to
+ * restore the built-in generator
+ */
+void chip8_set_rng(chip8_t *chip8, uint8_t (*generator)(void));
+
+/**
+ * Publishes the state of the keypad to the CHIP-8.
+ *
+ * The keypad is stored atomically, and read by `0xEX9E`, `0xEXA1` and `0xFX0A`
+ * as they execute, so it may be published from any thread at any time, such
+ * as from the event path of the platform, rather than only between frames.
+ *
+ * @param chip8 - The CHIP-8 to publish to
+ * @param keys - The pressed keys, with bit N set while key N is pressed
+ */
+void chip8_set_keypad(chip8_t *chip8, uint16_t keys);
+
+/**
+ * Overrides the keypad of the CHIP-8 with a callback, which is called every
+ * time an instruction reads the keypad.
+ *
+ * The callback is called on the thread running the emulator, so it must be
+ * lock-free and thread-safe to not stall emulation, such as an atomic load
+ * of a keypad published by another thread.
+ *
+ * @param chip8 - The CHIP-8 to configure
+ * @param source - A callback returning the pressed keys like `chip8_set_keypad`,
+ * or `NULL` to read the keypad published through `chip8_set_keypad`
+ */
+void chip8_set_keypad_source(chip8_t *chip8, uint16_t (*source)(void));
+
+/**
+ * Installs hooks which the interpreter calls as events happen, so that callers
+ * can run long batches of cycles without inspecting the state after each one.
+ *
+ * Hooks are called on the thread running the emulator, in the middle of the
+ * instruction causing the event, so they must not run or modify the CHIP-8.
+ * `on_draw` reports the region of each sprite drawn, clipped to the display,
+ * and the whole display for instructions changing all of it. `on_key_wait` is
+ * called every time `0xFX0A` runs without a key to store. The sound hooks
+ * follow the sound timer as it is set by `0xFX18` and expires through
+ * `chip8_update_timers`.
+ *
+ * Hooks are only called when built with `ENABLE_HOOKS`; otherwise every call
+ * is compiled away, so that running instructions costs nothing extra. Hooks
+ * are kept when loading programs, switching variants or restoring baselines,
+ * but belong to the emulator they were installed into, and are not copied by
+ * `chip8_clone`.
+ *
+ * @param chip8 - The CHIP-8 to observe
+ * @param hooks - The hooks to call, any of which may be `NULL`, or `NULL` to
+ * remove every hook
+ * @returns If the hooks were installed; fails unless built with `ENABLE_HOOKS`
+ */
+bool chip8_set_hooks(chip8_t *chip8, const chip8_hooks_t *hooks);
+
+/**
+ * Checks if an address is set in a coverage bitmap.
+ *
+ * Coverage is only collected when built with `ENABLE_COVERAGE`, in which case
+ * `chip8_t` holds an `executed` and a `written` bitmap with one bit per
+ * address of memory, which are cleared whenever a program is loaded.
+ * Recompiled code does not contribute to coverage.
+ *
+ * @param bitmap - The bitmap to check
+ * @param address - The address to check; must be within memory
+ * @returns If the address is set
+ */
+static inline bool chip8_covered(const uint64_t *bitmap, uint32_t address) {
+    return (bitmap[address / COVERAGE_WORD_BITS] >> (address % COVERAGE_WORD_BITS)) & 0x1;
+}
 
 /**
  * Loads the requested font into memory.
@@ -77,6 +434,38 @@ bool chip8_load_font(chip8_t *chip8, font_type_t type);
  */
 bool chip8_load_program(chip8_t *chip8, const uint8_t *program, uint16_t size);
 
+/**
+ * Gets the value of a single pixel of the active display mode.
+ *
+ * @param chip8 - The CHIP-8 to read the display of
+ * @param x - The horizontal position of the pixel
+ * @param y - The vertical position of the pixel
+ * @returns A bitmask of the planes in which the pixel is set
+ */
+uint8_t chip8_get_pixel(const chip8_t *chip8, uint8_t x, uint8_t y);
+
+/**
+ * Unpacks the active display mode into one byte per pixel.
+ *
+ * Each byte holds the bitmask of planes the pixel is set in, which serves as
+ * an index into a palette of up to 16 colors. The buffer must be able to hold
+ * `display_width * display_height` bytes.
+ *
+ * @param chip8 - The CHIP-8 to read the display of
+ * @param buffer - The buffer to write the pixels into
+ */
+void chip8_render_display(const chip8_t *chip8, uint8_t *buffer);
+
+/**
+ * Takes the display rows changed since they were last taken, for hosts which
+ * only redraw the rows that changed, leaving `dirty_rows` to restoring a
+ * baseline.
+ *
+ * @param chip8 - The CHIP-8 to take the changed rows of
+ * @returns The bitmap of display rows changed since the previous call
+ */
+uint64_t chip8_take_drawn_rows(chip8_t *chip8);
+
 /**
  * Runs a single instruction cycle.
  *
@@ -93,6 +482,116 @@ bool chip8_load_program(chip8_t *chip8, const uint8_t *program, uint16_t size);
  */
 chip8_state_t chip8_run_cycle(chip8_t *chip8);
 
+/**
+ * Runs a number of instruction cycles.
+ *
+ * Behaves like calling `chip8_run_cycle` once per cycle, except that pairs of
+ * instructions defined in `CHIP8_FUSIONS` are executed by a single dispatch
+ * when both fit within the remaining cycles. Pairs are matched against memory
+ * as it is executed, so jumps onto the second instruction of a pair and
+ * modified code are handled like in the interpreter.
+ *
+ * Running stops early once an instruction fails, in which case the status of
+ * the failure is reported like `chip8_run_cycle` does.
+ *
+ * @param chip8 - The CHIP-8 to run
+ * @param cycles - The number of instruction cycles to run
+ * @param state - The combined emulator state after running the cycles
+ * @returns The number of instruction cycles that were run
+ */
+uint32_t chip8_run_cycles(chip8_t *chip8, uint32_t cycles, chip8_state_t *state);
+
+/**
+ * Runs a number of instruction cycles, stopping early at breakpoints and
+ * watchpoints.
+ *
+ * Without any breakpoints or watchpoints set, this runs `chip8_run_cycles`
+ * unchanged. Otherwise instructions run one at a time, each costing a single
+ * bit test against the breakpoints, plus a test of the bytes it accesses
+ * relative to I against the watchpoints if any are set.
+ *
+ * Runs stop before the instruction which would hit a breakpoint or access a
+ * watched address, so that the state can be inspected before it changes. The
+ * first instruction of a run is never stopped at, so calling this again
+ * resumes a stopped run.
+ *
+ * @param chip8 - The CHIP-8 to run
+ * @param limit - The most instruction cycles to run
+ * @param stop - Why and where the run stopped, and the combined emulator state
+ * @returns The number of instruction cycles that were run
+ */
+uint32_t chip8_run_until(chip8_t *chip8, uint32_t limit, chip8_stop_t *stop);
+
+/**
+ * Sets or clears a breakpoint, at which `chip8_run_until` stops before
+ * executing the instruction at the address.
+ *
+ * Breakpoints and watchpoints are cleared when switching variants, and are
+ * not copied into clones.
+ *
+ * @param chip8 - The CHIP-8 to configure
+ * @param address - The address of the instruction
+ * @param enabled - If the breakpoint is set rather than cleared
+ * @returns If the breakpoint was changed; fails for addresses out of memory
+ */
+bool chip8_set_breakpoint(chip8_t *chip8, uint32_t address, bool enabled);
+
+/**
+ * Sets or clears a watchpoint, at which `chip8_run_until` stops before an
+ * instruction reads or writes the address relative to I.
+ *
+ * @param chip8 - The CHIP-8 to configure
+ * @param address - The address of memory to watch
+ * @param access - A bitmask of `chip8_watch_t` accesses to change
+ * @param enabled - If the watchpoint is set rather than cleared
+ * @returns If the watchpoint was changed; fails for addresses out of memory
+ */
+bool chip8_set_watchpoint(chip8_t *chip8, uint32_t address, uint8_t access, bool enabled);
+
+/**
+ * Clears every breakpoint and watchpoint, returning `chip8_run_until` to the
+ * unchecked loop.
+ *
+ * @param chip8 - The CHIP-8 to configure
+ */
+void chip8_clear_breakpoints(chip8_t *chip8);
+
+/**
+ * Gets the number of bytes an instruction accesses relative to I.
+ *
+ * @param chip8 - The CHIP-8 about to execute the instruction
+ * @param opcode - The instruction to inspect
+ * @returns The number of accessed bytes, or 0 if memory is not accessed
+ */
+uint32_t chip8_access_length(const chip8_t *chip8, uint16_t opcode);
+
+/**
+ * Executes an opcode which was already fetched.
+ *
+ * Behaves like the execute step of `chip8_run_cycle`, with PC expected to
+ * already point past the opcode. This allows alternative execution engines,
+ * such as recompiled code, to share the behavior of the interpreter for
+ * instructions they do not implement themselves.
+ *
+ * @param chip8 - The CHIP-8 to execute the opcode on
+ * @param opcode - The opcode to execute
+ * @param result - The state to record the effects of the opcode into, which
+ * must default to a successful state
+ * @returns If the opcode was successfully executed
+ */
+bool chip8_execute_opcode(chip8_t *chip8, uint16_t opcode, chip8_state_t *result);
+
+/**
+ * Decrements the delay and sound timers.
+ *
+ * The timers count down at a fixed rate independent of the instruction
+ * cycle, so this function should be called `FRAMES_PER_SECOND` times per
+ * second.
+ *
+ * @param chip8 - The CHIP-8 to update the timers of
+ */
+void chip8_update_timers(chip8_t *chip8);
+
 /**
  * Fetches the next instruction from RAM.
  *
@@ -114,6 +613,9 @@ static bool chip8_fetch_instruction(chip8_t *cpu, chip8_state_t *result);
 /**
  * Decodes and executes a single opcode.
  *
+ * The opcode is decoded by the switch generated through `OPCODE_SWITCH`,
+ * which calls the handler of the decoded instruction directly.
+ *
  * The provided result variable must default to a successful state with a valid
  * opcode, which will be read to execute the instruction. The return value
  * indicates if the execution succeeded, which is to be used as a signal for
@@ -126,61 +628,235 @@ static bool chip8_fetch_instruction(chip8_t *cpu, chip8_state_t *result);
 static bool chip8_execute_instruction(chip8_t *chip8, chip8_state_t *result);
 
 /**
- * Processes system (0x0xxx) instructions.
- *
- * Behaves in the same way as `chip8_execute_instruction`, except it only
- * handles the instructions whose first digit is 0.
+ * Executes an already decoded instruction by its generated handler.
  *
  * @param chip8 - The CHIP-8 to execute the instruction
+ * @param type - The decoded type of the instruction
  * @param result - The end result of running the entire instruction cycle
  * @returns If the opcode was successfully executed
  */
-static bool chip8_execute_system_instruction(chip8_t *chip8, chip8_state_t *result);
+static bool chip8_dispatch_instruction(chip8_t *chip8, opcode_type_t type, chip8_state_t *result);
 
 /**
- * Processes arithmetic (0x8xxx) instructions.
+ * Decodes and executes a single opcode, fusing it with the next instruction
+ * if the pair is defined in `CHIP8_FUSIONS`.
  *
- * Behaves in the same way as `chip8_execute_instruction`, except it only
- * handles the instructions whose first digit is 8.
+ * The execution status is written into the result like in
+ * `chip8_execute_instruction`, with the opcode of the last executed
+ * instruction.
  *
  * @param chip8 - The CHIP-8 to execute the instruction
  * @param result - The end result of running the entire instruction cycle
- * @returns If the opcode was successfully executed
+ * @param fuse - If the next instruction may be executed as well
+ * @returns The number of executed instructions
  */
-static bool chip8_execute_arithmetic_instruction(chip8_t *chip8, chip8_state_t *result);
+static uint32_t chip8_execute_fused(chip8_t *chip8, chip8_state_t *result, bool fuse);
 
 /**
- * Processes drawing (0xDxxx) instructions.
+ * Resets the CHIP-8 to its initial state.
  *
- * Behaves in the same way as `chip8_execute_instruction`, except it only
- * handles the instructions whose first digit is D.
+ * Clears all registers, memory and the display without reallocating them,
+ * then reloads the active font.
  *
- * @param chip8 - The CHIP-8 to execute the instruction
- * @param result - The end result of running the entire instruction cycle
- * @returns If the opcode was successfully executed
+ * @param chip8 - The CHIP-8 to reset
  */
-static bool chip8_execute_draw_instruction(chip8_t *chip8, chip8_state_t *result);
+static void chip8_reset(chip8_t *chip8);
 
 /**
- * Processes keypress (0xExxx) instructions.
+ * Allocates the bitmaps of breakpoints and watchpoints, if not yet allocated.
  *
- * Behaves in the same way as `chip8_execute_instruction`, except it only
- * handles the instructions whose first digit is E.
+ * @param chip8 - The CHIP-8 to allocate the bitmaps for
+ * @returns If the bitmaps are allocated
+ */
+static bool chip8_allocate_breakpoints(chip8_t *chip8);
+
+/**
+ * Sets or clears an address in a bitmap of breakpoints or watchpoints.
  *
- * @param chip8 - The CHIP-8 to execute the instruction
- * @param result - The end result of running the entire instruction cycle
- * @returns If the opcode was successfully executed
+ * @param bitmap - The bitmap to change
+ * @param address - The address to change; must be within memory
+ * @param enabled - If the address is set rather than cleared
+ * @returns If the bit changed
+ */
+static bool chip8_toggle_bit(uint64_t *bitmap, uint32_t address, bool enabled);
+
+/**
+ * Gets the number of bytes an already decoded instruction accesses relative
+ * to I, like `chip8_access_length`.
+ *
+ * @param chip8 - The CHIP-8 about to execute the instruction
+ * @param type - The decoded type of the instruction
+ * @param opcode - The opcode of the instruction
+ * @returns The number of accessed bytes, or 0 if memory is not accessed
+ */
+static uint32_t chip8_access_length_of(const chip8_t *chip8, opcode_type_t type, uint16_t opcode);
+
+/**
+ * Checks if the next instruction hits a breakpoint or accesses a watched
+ * address, recording the reason in the stop.
+ *
+ * @param chip8 - The CHIP-8 about to execute the instruction
+ * @param type - The decoded type of the instruction
+ * @param opcode - The opcode of the instruction
+ * @param stop - The stop to record the reason and address into
+ * @returns If the run must stop before the instruction
+ */
+static bool chip8_should_stop(const chip8_t *chip8, opcode_type_t type, uint16_t opcode, chip8_stop_t *stop);
+
+/**
+ * Reads a byte from memory.
+ *
+ * Addresses wrap around the end of memory, as memory is sized to a power of
+ * two, which keeps every access in bounds without a branch.
+ *
+ * @param chip8 - The CHIP-8 to read from
+ * @param address - The address to read, which may exceed the memory size
+ * @returns The byte at the wrapped address
+ */
+static inline uint8_t chip8_read_memory(const chip8_t *chip8, uint32_t address);
+
+/**
+ * Writes a byte to memory.
+ *
+ * Addresses wrap around the end of memory like in `chip8_read_memory`.
+ *
+ * @param chip8 - The CHIP-8 to write to
+ * @param address - The address to write, which may exceed the memory size
+ * @param value - The byte to write
+ */
+static inline void chip8_write_memory(chip8_t *chip8, uint32_t address, uint8_t value);
+
+/**
+ * Counts the set bits at the bottom of a bitmap, up to the first clear one.
+ *
+ * @param bits - The bitmap to count
+ * @returns The length of the run of set bits starting at bit 0
+ */
+static inline uint8_t chip8_run_length(uint64_t bits);
+
+/**
+ * Marks rows of the display as changed for `chip8_restore`.
+ *
+ * Marking every row rehashes the display with ENABLE_STATE_HASH, so it must
+ * happen after the display changed.
+ *
+ * @param chip8 - The CHIP-8 whose display changed
+ * @param first - The first changed row
+ * @param count - The number of changed rows, or 0 for every row
+ */
+static inline void chip8_mark_rows(chip8_t *chip8, uint8_t first, uint8_t count);
+
+/**
+ * Computes the Zobrist term of a single element of the state.
+ *
+ * Elements holding zero have no term, so that cleared memory and display do
+ * not contribute to the hash.
+ *
+ * @param key - The element, unique across memory, the display and registers
+ * @param value - The value held by the element
+ * @returns The term to XOR into the hash
+ */
+static inline uint64_t chip8_zobrist(uint32_t key, uint64_t value);
+
+/**
+ * Computes the terms of a range of words of the display.
+ *
+ * @param chip8 - The CHIP-8 whose display to hash
+ * @param first - The first word of the range, counting across planes
+ * @param count - The number of words in the range
+ * @returns The XOR of the terms of the words
+ */
+static uint64_t chip8_hash_display(const chip8_t *chip8, uint32_t first, uint32_t count);
+
+/**
+ * Computes the terms of every byte of memory.
+ *
+ * @param chip8 - The CHIP-8 whose memory to hash
+ * @returns The XOR of the terms of memory
+ */
+static uint64_t chip8_hash_memory(const chip8_t *chip8);
+
+/**
+ * Computes the terms of the registers and the extended state.
+ *
+ * @param chip8 - The CHIP-8 whose registers to hash
+ * @returns The XOR of the terms of the registers
+ */
+static uint64_t chip8_hash_registers(const chip8_t *chip8);
+
+/**
+ * Records that an instruction was fetched from an address.
+ *
+ * Both bytes of the opcode are marked, so that modifying the operand of an
+ * executed instruction is detected as self-modifying code. Compiles to nothing
+ * unless built with `ENABLE_COVERAGE`.
+ *
+ * @param chip8 - The CHIP-8 executing the instruction
+ * @param address - The address of the opcode
+ */
+static inline void chip8_cover_execution(chip8_t *chip8, uint32_t address);
+
+/**
+ * Generates a random number using the built-in generator.
+ *
+ * The generator is a 64-bit xorshift with a multiplicative output scrambler,
+ * from which the highest quality top byte is returned.
+ *
+ * @param chip8 - The CHIP-8 owning the generator state
+ * @returns A random number
+ */
+static inline uint8_t chip8_random(chip8_t *chip8);
+
+/**
+ * Reads the keypad for an instruction.
+ *
+ * Keys which changed since the previous read have their edge stamped with
+ * the number of cycles run before the reading instruction, which measures
+ * when the program could first react to the input.
+ *
+ * @param chip8 - The CHIP-8 reading the keypad
+ * @returns The pressed keys, with bit N set while key N is pressed
+ */
+static uint16_t chip8_read_keypad(chip8_t *chip8);
+
+/**
+ * Skips over the next instruction.
+ *
+ * On XO-CHIP, the long `0xF000 0xNNNN` instruction spans 4 bytes, so skipping
+ * must account for it to not land in the middle of the instruction.
+ *
+ * @param chip8 - The CHIP-8 to skip the instruction on
+ */
+static void chip8_skip_instruction(chip8_t *chip8);
+
+/**
+ * Scrolls the selected planes of the display vertically.
+ *
+ * @param chip8 - The CHIP-8 to scroll the display of
+ * @param rows - The number of rows to scroll; positive scrolls down
+ */
+static void chip8_scroll_vertical(chip8_t *chip8, int8_t rows);
+
+/**
+ * Scrolls the selected planes of the display horizontally by 4 pixels.
+ *
+ * @param chip8 - The CHIP-8 to scroll the display of
+ * @param right - If the display scrolls right rather than left
  */
-static bool chip8_execute_keypress_instruction(chip8_t *chip8, chip8_state_t *result);
+static void chip8_scroll_horizontal(chip8_t *chip8, bool right);
 
 /**
- * Processes miscellaneous (0xFxxx) instructions.
+ * Executes a single instruction, with one handler per instruction defined in
+ * `CHIP8_OPCODES`, named after the instruction, such as `chip8_op_CLS`.
  *
- * Behaves in the same way as `chip8_execute_instruction`, except it only
- * handles the instructions whose first digit is F.
+ * Handlers are only called for opcodes that decoded into their instruction,
+ * so they do not need to validate the opcode. Otherwise they behave in the
+ * same way as `chip8_execute_instruction`.
  *
  * @param chip8 - The CHIP-8 to execute the instruction
  * @param result - The end result of running the entire instruction cycle
  * @returns If the opcode was successfully executed
  */
-static bool chip8_execute_misc_instruction(chip8_t *chip8, chip8_state_t *result);
+#define CHIP8_HANDLER_PROTOTYPE(name, ...) \
+    static bool chip8_op_##name(chip8_t *chip8, chip8_state_t *result);
+CHIP8_OPCODES(CHIP8_HANDLER_PROTOTYPE, OPCODE_NO_GROUP)
@@ -0,0 +1,229 @@
+#include "lockstep.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "opcodes.h"
+
+#define LOCKSTEP_ENGINE_ENTRY(name, run) {name, run},
+
+static const struct {
+    const char       *name;
+    lockstep_engine_t run;
+} ENGINES[] = {LOCKSTEP_ENGINES(LOCKSTEP_ENGINE_ENTRY)};
+
+uint32_t lockstep_run_reference(chip8_t *chip8, uint32_t cycles, chip8_state_t *state) {
+    chip8_state_t result = {.status = CHIP8_OK};
+    uint32_t      run    = 0;
+    while (run < cycles) {
+        result = chip8_run_cycle(chip8);
+        ++run;
+        if (result.status != CHIP8_OK) break;
+    }
+
+    *state = result;
+    return run;
+}
+
+lockstep_engine_t lockstep_engine_by_name(const char *name) {
+    for (size_t e = 0; e < sizeof(ENGINES) / sizeof(ENGINES[0]); ++e) {
+        if (strcmp(ENGINES[e].name, name) == 0) return ENGINES[e].run;
+    }
+    return NULL;
+}
+
+bool lockstep_compare(lockstep_result_t *result, const chip8_t *initial, lockstep_engine_t a,
+                      lockstep_engine_t b, uint64_t cycles, uint32_t interval) {
+    memset(result, 0, sizeof(lockstep_result_t));
+
+    // The checkpoint holds the latest state both engines agreed on
+    chip8_t runs[2], checkpoint;
+    if (!chip8_clone(&checkpoint, initial)) return false;
+    if (!chip8_clone(&runs[0], initial)) {
+        chip8_free(&checkpoint);
+        return false;
+    }
+    if (!chip8_clone(&runs[1], initial)) {
+        chip8_free(&checkpoint);
+        chip8_free(&runs[0]);
+        return false;
+    }
+
+    bool     ok   = true;
+    uint64_t step = 0;
+    while (result->cycles < cycles) {
+        step = cycles - result->cycles < interval ? cycles - result->cycles : interval;
+
+        uint64_t ran      = lockstep_advance(&runs[0], a, result->cycles, step);
+        bool     diverged = lockstep_advance(&runs[1], b, result->cycles, step) != ran;
+        result->hashes[0] = chip8_hash(&runs[0]);
+        result->hashes[1] = chip8_hash(&runs[1]);
+        if (diverged || result->hashes[0] != result->hashes[1]) {
+            result->diverged = true;
+            break;
+        }
+
+        result->cycles += ran;
+        if (ran < step) break; // Both engines failed on the same instruction
+
+        chip8_free(&checkpoint);
+        if (!chip8_clone(&checkpoint, &runs[0])) {
+            ok = false;
+            break;
+        }
+    }
+    chip8_free(&runs[0]);
+    chip8_free(&runs[1]);
+    if (!ok) return false;
+    if (!result->diverged) {
+        chip8_free(&checkpoint);
+        return true;
+    }
+
+    // The first diverging cycle after the checkpoint, where the engines still
+    // agreed after `agreed` cycles and disagreed after `first`
+    uint64_t agreed = 0;
+    uint64_t first  = step;
+    while (first - agreed > 1) {
+        uint64_t middle = agreed + (first - agreed) / 2;
+        if (lockstep_diverges(&checkpoint, a, b, result->cycles, middle, NULL)) {
+            first = middle;
+        } else {
+            agreed = middle;
+        }
+    }
+
+    // Take the shortest window leading into the divergence which still
+    // diverges on its own, as engines may need several cycles to disagree
+    result->repro  = checkpoint;
+    result->length = first;
+    for (uint32_t window = 1; window <= LOCKSTEP_WINDOW && window < first; ++window) {
+        chip8_t start;
+        if (!chip8_clone(&start, &checkpoint)) break;
+        lockstep_advance(&start, a, result->cycles, first - window);
+        if (lockstep_diverges(&start, a, b, result->cycles + first - window, window, NULL)) {
+            chip8_free(&checkpoint);
+            result->repro  = start;
+            result->length = window;
+            result->cycles += first - window;
+            break;
+        }
+        chip8_free(&start);
+    }
+
+    lockstep_minimize(result, a, b, result->cycles);
+    chip8_rehash(&result->repro);
+    lockstep_diverges(&result->repro, a, b, result->cycles, result->length, result->hashes);
+    return true;
+}
+
+void lockstep_free(lockstep_result_t *result) {
+    if (result->diverged) chip8_free(&result->repro);
+    result->diverged = false;
+}
+
+void lockstep_random_program(uint8_t *buffer, size_t size, variant_type_t variant, uint64_t *seed) {
+    for (size_t offset = 0; offset + 1 < size; offset += 2) {
+        // Returns without calls are mostly rerolled, as they fail on an empty stack
+        opcode_type_t type;
+        opcode_data_t data;
+        do {
+            type = (opcode_type_t)(lockstep_random(seed) % OPCODE_COUNT);
+            data = opcode_get(type);
+        } while (!(data.variants & (1 << variant)) || (data.flags & OPCODE_WAITS) || type == OPCODE_SYS ||
+                 (type == OPCODE_RET && lockstep_random(seed) % 4));
+
+        uint16_t opcode = data.pattern | ((uint16_t)lockstep_random(seed) & ~data.mask);
+        if (type == OPCODE_JP || type == OPCODE_CALL || type == OPCODE_LD_I || type == OPCODE_JP_OFFSET) {
+            opcode = data.pattern | ((PROGRAM_START + lockstep_random(seed) % size) & 0x0FFE);
+        }
+        buffer[offset]     = opcode >> 8;
+        buffer[offset + 1] = opcode & 0xFF;
+    }
+    if (size % 2) buffer[size - 1] = (uint8_t)lockstep_random(seed);
+
+    // Loops back to the start instead of running into empty memory
+    if (size >= 2) {
+        buffer[size - 2] = 0x10 | PROGRAM_START >> 8;
+        buffer[size - 1] = PROGRAM_START & 0xFF;
+    }
+}
+
+static uint64_t lockstep_random(uint64_t *seed) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+    return *seed;
+}
+
+static uint64_t lockstep_advance(chip8_t *chip8, lockstep_engine_t engine, uint64_t start, uint64_t cycles) {
+    uint32_t cycles_per_frame = INSTRUCTIONS_PER_SECOND / FRAMES_PER_SECOND;
+    uint64_t run              = 0;
+    while (run < cycles) {
+        // Runs up to the next frame, so that timers tick at the same cycle
+        // regardless of how the run was split
+        uint64_t chunk = cycles_per_frame - (start + run) % cycles_per_frame;
+        if (chunk > cycles - run) chunk = cycles - run;
+
+        chip8_state_t state;
+        uint32_t      ran = engine(chip8, (uint32_t)chunk, &state);
+        run += ran;
+        if (ran < chunk || state.status != CHIP8_OK) break;
+        if ((start + run) % cycles_per_frame == 0) chip8_update_timers(chip8);
+    }
+    return run;
+}
+
+static bool lockstep_diverges(const chip8_t *state, lockstep_engine_t a, lockstep_engine_t b, uint64_t start,
+                              uint64_t cycles, uint64_t *hashes) {
+    chip8_t runs[2];
+    if (!chip8_clone(&runs[0], state)) return false;
+    if (!chip8_clone(&runs[1], state)) {
+        chip8_free(&runs[0]);
+        return false;
+    }
+
+    bool     diverged = lockstep_advance(&runs[0], a, start, cycles) != lockstep_advance(&runs[1], b, start, cycles);
+    uint64_t hash_a   = chip8_hash(&runs[0]);
+    uint64_t hash_b   = chip8_hash(&runs[1]);
+    if (hashes) {
+        hashes[0] = hash_a;
+        hashes[1] = hash_b;
+    }
+
+    chip8_free(&runs[0]);
+    chip8_free(&runs[1]);
+    return diverged || hash_a != hash_b;
+}
+
+static void lockstep_minimize(lockstep_result_t *result, lockstep_engine_t a, lockstep_engine_t b, uint64_t start) {
+    chip8_t *repro        = &result->repro;
+    size_t   display_size = sizeof(uint64_t) * repro->plane_size * repro->display_planes;
+
+    // Reductions are kept only while the engines still diverge
+    static const uint8_t EMPTY[DIRTY_PAGE_SIZE] = {0};
+    uint8_t              page[DIRTY_PAGE_SIZE];
+    for (uint32_t offset = 0; offset < repro->memory_size; offset += DIRTY_PAGE_SIZE) {
+        memcpy(page, &repro->memory[offset], DIRTY_PAGE_SIZE);
+        if (memcmp(page, EMPTY, DIRTY_PAGE_SIZE) == 0) continue;
+
+        memset(&repro->memory[offset], 0, DIRTY_PAGE_SIZE);
+        if (lockstep_diverges(repro, a, b, start, result->length, NULL)) {
+            result->minimized = true;
+        } else {
+            memcpy(&repro->memory[offset], page, DIRTY_PAGE_SIZE);
+        }
+    }
+
+    uint64_t *display = malloc(display_size);
+    if (!display) return;
+    memcpy(display, repro->display, display_size);
+    memset(repro->display, 0, display_size);
+    bool cleared = memcmp(display, repro->display, display_size) != 0;
+    if (cleared && lockstep_diverges(repro, a, b, start, result->length, NULL)) {
+        result->minimized = true;
+    } else {
+        memcpy(repro->display, display, display_size);
+    }
+    free(display);
+}
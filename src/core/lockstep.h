@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chip8.h"
+#include "variant.h"
+
+#define LOCKSTEP_WINDOW 8 // Most instructions a minimized divergence may span
+
+/**
+ * Runs a CHIP-8 for a number of instruction cycles through some engine.
+ *
+ * Every engine must run exactly as many instructions as it reports, and must
+ * leave the emulator in the same state as `chip8_run_cycle` does when run for
+ * that many cycles. Running stops early once an instruction fails.
+ *
+ * @param chip8 - The CHIP-8 to run
+ * @param cycles - The number of instruction cycles to run
+ * @param state - The emulator state after the last cycle
+ * @returns The number of instruction cycles that were run
+ */
+typedef uint32_t (*lockstep_engine_t)(chip8_t *chip8, uint32_t cycles, chip8_state_t *state);
+
+// Engines which can be selected by name, defined as `ENGINE(name, run)`
+#define LOCKSTEP_ENGINES(ENGINE)                \
+    ENGINE("reference", lockstep_run_reference) \
+    ENGINE("fused", chip8_run_cycles)
+
+typedef struct {
+    bool     diverged;  // If the engines disagreed at any point
+    uint64_t cycles;    // Cycles run in agreement; up to the repro if diverged
+    uint64_t hashes[2]; // State of each engine once stopped or diverged
+    uint32_t length;    // Cycles from the repro to the divergence
+    chip8_t  repro;     // State which runs into the divergence; owned if diverged
+    bool     minimized; // If memory or the display were cleared from the repro
+} lockstep_result_t;
+
+/**
+ * Runs the reference interpreter for a number of instruction cycles.
+ *
+ * @param chip8 - The CHIP-8 to run
+ * @param cycles - The number of instruction cycles to run
+ * @param state - The emulator state after the last cycle
+ * @returns The number of instruction cycles that were run
+ */
+uint32_t lockstep_run_reference(chip8_t *chip8, uint32_t cycles, chip8_state_t *state);
+
+/**
+ * Looks up an engine by its name in `LOCKSTEP_ENGINES`.
+ *
+ * @param name - The name of the engine
+ * @returns The engine, or NULL if unknown
+ */
+lockstep_engine_t lockstep_engine_by_name(const char *name);
+
+/**
+ * Runs two engines side by side from the same state, and reports the first
+ * instruction where they disagree.
+ *
+ * Both engines run in steps of `interval` cycles, with timers ticking at
+ * the rate of the emulator, and compare their state hashes after each step.
+ * Once the hashes differ, the step is bisected down to the first cycle at
+ * which they differ. The repro is then taken from the reference a few cycles
+ * earlier if an engine needs them to diverge, such as for fused pairs, and
+ * is reduced by clearing the display and every memory page which it does
+ * not need to still diverge.
+ *
+ * @param result - The result of the comparison, released by `lockstep_free`
+ * @param initial - The state to run both engines from; left unchanged
+ * @param a - The engine to compare against, usually the reference
+ * @param b - The engine to compare
+ * @param cycles - The most instruction cycles to run
+ * @param interval - The number of cycles between comparisons
+ * @returns If both engines could be run; false on allocation failure
+ */
+bool lockstep_compare(lockstep_result_t *result, const chip8_t *initial, lockstep_engine_t a,
+                      lockstep_engine_t b, uint64_t cycles, uint32_t interval);
+
+/**
+ * Releases the repro held by a lockstep result.
+ *
+ * @param result - The result to release
+ */
+void lockstep_free(lockstep_result_t *result);
+
+/**
+ * Fills a buffer with a random program of valid instructions.
+ *
+ * Jumps, calls and addresses loaded into I point back into the program, which
+ * ends by jumping back to its start, so that streams keep running, and modify
+ * themselves, for longer.
+ *
+ * @param buffer - The buffer to fill, which is loaded at `PROGRAM_START`
+ * @param size - The size of the buffer in bytes
+ * @param variant - The variant to draw instructions from
+ * @param seed - State of the random number generator, advanced by the call
+ */
+void lockstep_random_program(uint8_t *buffer, size_t size, variant_type_t variant, uint64_t *seed);
+
+/**
+ * Advances a xorshift random number generator.
+ *
+ * @param seed - State of the generator
+ * @returns The next random number
+ */
+static uint64_t lockstep_random(uint64_t *seed);
+
+/**
+ * Runs an engine for a number of cycles from a given point of the run.
+ *
+ * @param chip8 - The CHIP-8 to run
+ * @param engine - The engine to run the CHIP-8 with
+ * @param start - The cycles run before, which decide when timers tick
+ * @param cycles - The number of cycles to run
+ * @returns The number of cycles that were run before any failure
+ */
+static uint64_t lockstep_advance(chip8_t *chip8, lockstep_engine_t engine, uint64_t start, uint64_t cycles);
+
+/**
+ * Checks if two engines diverge when run for a number of cycles.
+ *
+ * @param state - The state to run both engines from; left unchanged
+ * @param a - The first engine
+ * @param b - The second engine
+ * @param start - The cycles run before the state, which decide when timers tick
+ * @param cycles - The number of cycles to run
+ * @param hashes - The hashes of both engines after running, if not NULL
+ * @returns If the engines diverged, or false on allocation failure
+ */
+static bool lockstep_diverges(const chip8_t *state, lockstep_engine_t a, lockstep_engine_t b, uint64_t start,
+                              uint64_t cycles, uint64_t *hashes);
+
+/**
+ * Reduces a repro to the memory pages and display it needs to diverge.
+ *
+ * @param result - The result holding the repro to reduce
+ * @param a - The first engine
+ * @param b - The second engine
+ * @param start - The cycles run before the repro
+ */
+static void lockstep_minimize(lockstep_result_t *result, lockstep_engine_t a, lockstep_engine_t b, uint64_t start);
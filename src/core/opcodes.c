@@ -0,0 +1,83 @@
+#include "opcodes.h"
+
+#include <stdio.h>
+
+#include "bitmask.h"
+#include "chip8.h"
+
+#define OPCODE_DATA(name, pattern, mask, mnemonic, operands, flags, variants) \
+    [OPCODE_##name] = {pattern, mask, mnemonic, operands, flags, variants},
+
+#define OPCODE_DECODE(name, pattern, mask, mnemonic, operands, flags, variants) \
+    OPCODE_SWITCH_CASE_##mask(pattern, mask, variants, return OPCODE_##name)
+
+static const opcode_data_t OPCODE_TABLE[OPCODE_COUNT] = {
+    CHIP8_OPCODES(OPCODE_DATA, OPCODE_NO_GROUP)
+};
+
+opcode_data_t opcode_get(opcode_type_t type) {
+    if (type >= OPCODE_COUNT) {
+        opcode_data_t invalid = {0, 0, NULL, NULL, 0, 0};
+        return invalid;
+    }
+    return OPCODE_TABLE[type];
+}
+
+opcode_type_t opcode_decode(uint16_t opcode, variant_type_t variant) {
+    OPCODE_SWITCH(OPCODE_DECODE)
+    return OPCODE_COUNT;
+}
+
+uint8_t opcode_size(uint16_t opcode, variant_type_t variant) {
+    opcode_type_t type = opcode_decode(opcode, variant);
+    return type < OPCODE_COUNT && (OPCODE_TABLE[type].flags & OPCODE_LONG) ? 4 : 2;
+}
+
+size_t opcode_disassemble(
+    char *buffer, size_t size, uint16_t opcode, uint16_t operand, variant_type_t variant, uint8_t quirks
+) {
+    opcode_type_t type = opcode_decode(opcode, variant);
+    if (type >= OPCODE_COUNT) {
+        int length = snprintf(buffer, size, "DW 0x%04X", opcode);
+        return length < 0 ? 0 : (size_t)length;
+    }
+
+    const opcode_data_t *data     = &OPCODE_TABLE[type];
+    const char          *operands = data->operands;
+    size_t               length   = opcode_append(buffer, size, 0, data->mnemonic);
+    char                 part[16];
+
+    // Without the quirk, the register is taken from the address instead
+    if (type == OPCODE_JP_OFFSET && !(quirks & QUIRK_OFFSET_JUMP)) operands = "VX, NNN";
+
+    if (*operands) length = opcode_append(buffer, size, length, " ");
+
+    for (const char *c = operands; *c;) {
+        if (*c == 'X' || *c == 'Y') {
+            snprintf(part, sizeof(part), "%X", *c == 'X' ? N2(opcode) : N3(opcode));
+            c++;
+        } else if (*c == 'N') {
+            uint8_t nibbles = 0;
+            while (*c == 'N' && nibbles < 4) {
+                nibbles++;
+                c++;
+            }
+            uint16_t value = nibbles == 4 ? operand : opcode & ((1 << (4 * nibbles)) - 1);
+            snprintf(part, sizeof(part), "0x%0*X", nibbles, value);
+        } else {
+            part[0] = *c++;
+            part[1] = '\0';
+        }
+        length = opcode_append(buffer, size, length, part);
+    }
+
+    if (size) buffer[length < size ? length : size - 1] = '\0';
+    return length;
+}
+
+static size_t opcode_append(char *buffer, size_t size, size_t length, const char *text) {
+    for (; *text; ++text, ++length) {
+        if (length + 1 < size) buffer[length] = *text;
+    }
+    return length;
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bitmask.h"
+#include "variant.h"
+
+// Side effects of an instruction, for engines that need to reason about them
+#define OPCODE_READS_MEMORY  (1 << 0) // Reads memory relative to I
+#define OPCODE_WRITES_MEMORY (1 << 1) // Writes memory relative to I
+#define OPCODE_DRAWS         (1 << 2) // Changes the display
+#define OPCODE_BRANCHES      (1 << 3) // May continue anywhere but the next instruction
+#define OPCODE_WAITS         (1 << 4) // Depends on the state of the keypad
+#define OPCODE_LONG          (1 << 5) // Followed by a 16-bit operand
+
+// Variants supporting an instruction, as a bitmask of `variant_type_t`
+#define OPCODE_VARIANT_ALL    ((1 << VARIANT_COUNT) - 1)
+#define OPCODE_VARIANT_CHIP8  (1 << VARIANT_CHIP8)
+#define OPCODE_VARIANT_XOCHIP (1 << VARIANT_XOCHIP)
+
+/**
+ * The single definition of every instruction, from which the interpreter
+ * dispatch, the disassembler and the instruction metadata are generated.
+ *
+ * Each instruction is defined as:
+ * `OP(name, pattern, mask, mnemonic, operands, flags, variants)`
+ *
+ * An opcode matches an instruction if `opcode & mask == pattern`. Operands are
+ * a template, in which `X` and `Y` are replaced by their register nibbles and
+ * runs of `N` by a hexadecimal number of as many nibbles. The 16-bit operand of
+ * `OPCODE_LONG` instructions is written as `NNNN`.
+ *
+ * Instructions are grouped by their first nibble, with every group preceded
+ * by `GROUP(nibble)`, and more specific patterns listed before more generic
+ * ones within the same group. Masks are limited to the forms understood by
+ * the decoder, which selects an instruction by the first nibble and the low
+ * byte of the opcode: `0xF000`, `0xF00F`, `0xF0FF`, `0xFFF0` and `0xFFFF`.
+ * Each group has at most one instruction masked with `0xF000`, listed last,
+ * which decodes the opcodes that no other instruction of the group matches.
+ */
+// clang-format off
+#define CHIP8_OPCODES(OP, GROUP)                                                                        \
+    GROUP(0)                                                                                            \
+    OP(CLS, 0x00E0, 0xFFFF, "CLS", "", OPCODE_DRAWS, OPCODE_VARIANT_ALL)                                \
+    OP(RET, 0x00EE, 0xFFFF, "RET", "", OPCODE_BRANCHES, OPCODE_VARIANT_ALL)                             \
+    OP(SCD, 0x00C0, 0xFFF0, "SCD", "N", OPCODE_DRAWS, OPCODE_VARIANT_XOCHIP)                            \
+    OP(SCU, 0x00D0, 0xFFF0, "SCU", "N", OPCODE_DRAWS, OPCODE_VARIANT_XOCHIP)                            \
+    OP(SCR, 0x00FB, 0xFFFF, "SCR", "", OPCODE_DRAWS, OPCODE_VARIANT_XOCHIP)                             \
+    OP(SCL, 0x00FC, 0xFFFF, "SCL", "", OPCODE_DRAWS, OPCODE_VARIANT_XOCHIP)                             \
+    OP(LOW, 0x00FE, 0xFFFF, "LOW", "", OPCODE_DRAWS, OPCODE_VARIANT_XOCHIP)                             \
+    OP(HIGH, 0x00FF, 0xFFFF, "HIGH", "", OPCODE_DRAWS, OPCODE_VARIANT_XOCHIP)                           \
+    OP(SYS, 0x0000, 0xF000, "SYS", "NNN", OPCODE_BRANCHES, OPCODE_VARIANT_ALL)                          \
+    GROUP(1)                                                                                            \
+    OP(JP, 0x1000, 0xF000, "JP", "NNN", OPCODE_BRANCHES, OPCODE_VARIANT_ALL)                            \
+    GROUP(2)                                                                                            \
+    OP(CALL, 0x2000, 0xF000, "CALL", "NNN", OPCODE_BRANCHES, OPCODE_VARIANT_ALL)                        \
+    GROUP(3)                                                                                            \
+    OP(SE_BYTE, 0x3000, 0xF000, "SE", "VX, NN", OPCODE_BRANCHES, OPCODE_VARIANT_ALL)                    \
+    GROUP(4)                                                                                            \
+    OP(SNE_BYTE, 0x4000, 0xF000, "SNE", "VX, NN", OPCODE_BRANCHES, OPCODE_VARIANT_ALL)                  \
+    GROUP(5)                                                                                            \
+    OP(SAVE, 0x5002, 0xF00F, "SAVE", "VX - VY", OPCODE_WRITES_MEMORY, OPCODE_VARIANT_XOCHIP)            \
+    OP(LOAD, 0x5003, 0xF00F, "LOAD", "VX - VY", OPCODE_READS_MEMORY, OPCODE_VARIANT_XOCHIP)             \
+    OP(SE_REG_XO, 0x5000, 0xF00F, "SE", "VX, VY", OPCODE_BRANCHES, OPCODE_VARIANT_XOCHIP)               \
+    OP(SE_REG, 0x5000, 0xF000, "SE", "VX, VY", OPCODE_BRANCHES, OPCODE_VARIANT_CHIP8)                   \
+    GROUP(6)                                                                                            \
+    OP(LD_BYTE, 0x6000, 0xF000, "LD", "VX, NN", 0, OPCODE_VARIANT_ALL)                                  \
+    GROUP(7)                                                                                            \
+    OP(ADD_BYTE, 0x7000, 0xF000, "ADD", "VX, NN", 0, OPCODE_VARIANT_ALL)                                \
+    GROUP(8)                                                                                            \
+    OP(LD_REG, 0x8000, 0xF00F, "LD", "VX, VY", 0, OPCODE_VARIANT_ALL)                                   \
+    OP(OR, 0x8001, 0xF00F, "OR", "VX, VY", 0, OPCODE_VARIANT_ALL)                                       \
+    OP(AND, 0x8002, 0xF00F, "AND", "VX, VY", 0, OPCODE_VARIANT_ALL)                                     \
+    OP(XOR, 0x8003, 0xF00F, "XOR", "VX, VY", 0, OPCODE_VARIANT_ALL)                                     \
+    OP(ADD_REG, 0x8004, 0xF00F, "ADD", "VX, VY", 0, OPCODE_VARIANT_ALL)                                 \
+    OP(SUB, 0x8005, 0xF00F, "SUB", "VX, VY", 0, OPCODE_VARIANT_ALL)                                     \
+    OP(SHR, 0x8006, 0xF00F, "SHR", "VX, VY", 0, OPCODE_VARIANT_ALL)                                     \
+    OP(SUBN, 0x8007, 0xF00F, "SUBN", "VX, VY", 0, OPCODE_VARIANT_ALL)                                   \
+    OP(SHL, 0x800E, 0xF00F, "SHL", "VX, VY", 0, OPCODE_VARIANT_ALL)                                     \
+    GROUP(9)                                                                                            \
+    OP(SNE_REG, 0x9000, 0xF000, "SNE", "VX, VY", OPCODE_BRANCHES, OPCODE_VARIANT_ALL)                   \
+    GROUP(A)                                                                                            \
+    OP(LD_I, 0xA000, 0xF000, "LD", "I, NNN", 0, OPCODE_VARIANT_ALL)                                     \
+    GROUP(B)                                                                                            \
+    OP(JP_OFFSET, 0xB000, 0xF000, "JP", "V0, NNN", OPCODE_BRANCHES, OPCODE_VARIANT_ALL)                 \
+    GROUP(C)                                                                                            \
+    OP(RND, 0xC000, 0xF000, "RND", "VX, NN", 0, OPCODE_VARIANT_ALL)                                     \
+    GROUP(D)                                                                                            \
+    OP(DRW, 0xD000, 0xF000, "DRW", "VX, VY, N", OPCODE_READS_MEMORY | OPCODE_DRAWS, OPCODE_VARIANT_ALL) \
+    GROUP(E)                                                                                            \
+    OP(SKP, 0xE09E, 0xF0FF, "SKP", "VX", OPCODE_BRANCHES | OPCODE_WAITS, OPCODE_VARIANT_ALL)            \
+    OP(SKNP, 0xE0A1, 0xF0FF, "SKNP", "VX", OPCODE_BRANCHES | OPCODE_WAITS, OPCODE_VARIANT_ALL)          \
+    GROUP(F)                                                                                            \
+    OP(LD_I_LONG, 0xF000, 0xFFFF, "LD", "I, NNNN", OPCODE_LONG, OPCODE_VARIANT_XOCHIP)                  \
+    OP(PLANE, 0xF001, 0xF0FF, "PLANE", "X", 0, OPCODE_VARIANT_XOCHIP)                                   \
+    OP(AUDIO, 0xF002, 0xFFFF, "AUDIO", "", OPCODE_READS_MEMORY, OPCODE_VARIANT_XOCHIP)                  \
+    OP(LD_DT_READ, 0xF007, 0xF0FF, "LD", "VX, DT", 0, OPCODE_VARIANT_ALL)                               \
+    OP(LD_KEY, 0xF00A, 0xF0FF, "LD", "VX, K", OPCODE_WAITS, OPCODE_VARIANT_ALL)                         \
+    OP(LD_DT, 0xF015, 0xF0FF, "LD", "DT, VX", 0, OPCODE_VARIANT_ALL)                                    \
+    OP(LD_ST, 0xF018, 0xF0FF, "LD", "ST, VX", 0, OPCODE_VARIANT_ALL)                                    \
+    OP(ADD_I, 0xF01E, 0xF0FF, "ADD", "I, VX", 0, OPCODE_VARIANT_ALL)                                    \
+    OP(LD_FONT, 0xF029, 0xF0FF, "LD", "F, VX", 0, OPCODE_VARIANT_ALL)                                   \
+    OP(LD_BCD, 0xF033, 0xF0FF, "LD", "B, VX", OPCODE_WRITES_MEMORY, OPCODE_VARIANT_ALL)                 \
+    OP(PITCH, 0xF03A, 0xF0FF, "PITCH", "VX", 0, OPCODE_VARIANT_XOCHIP)                                  \
+    OP(LD_STORE, 0xF055, 0xF0FF, "LD", "[I], VX", OPCODE_WRITES_MEMORY, OPCODE_VARIANT_ALL)             \
+    OP(LD_LOAD, 0xF065, 0xF0FF, "LD", "VX, [I]", OPCODE_READS_MEMORY, OPCODE_VARIANT_ALL)
+// clang-format on
+
+/**
+ * Generates a switch which decodes `opcode` on `variant`, both of which must be
+ * in scope, from the table expanded with `OP`.
+ *
+ * Every instruction is expanded by `OP` into `OPCODE_SWITCH_CASE_<mask>` with
+ * the statement to execute when the instruction matches, which must leave the
+ * switch, such as by returning. Opcodes which do not decode continue after the
+ * switch.
+ *
+ * Every group becomes a case of a switch on the first nibble, containing a
+ * switch on the low byte, so that the compiler can jump straight to the only
+ * instruction which could match besides the fallback masked with `0xF000`.
+ * The first group closes the block opened by the default case, and the brace
+ * after the table closes the switch or block of the last group.
+ */
+#define OPCODE_SWITCH(OP)                          \
+    switch (N1(opcode)) {                          \
+        default: {                                 \
+            CHIP8_OPCODES(OP, OPCODE_SWITCH_GROUP) \
+        }                                          \
+    }
+#define OPCODE_SWITCH_GROUP(nibble) \
+    }                               \
+    break;                          \
+    case 0x##nibble:                \
+        switch (B2(opcode)) {
+#define OPCODE_SWITCH_MATCHES(pattern, mask, variants) \
+    ((opcode & (mask)) == (pattern) && ((variants) == OPCODE_VARIANT_ALL || ((variants) & (1 << variant))))
+
+// Cases of an instruction by its mask, of which the fallback closes the switch
+// of the group, so that it is also tried when another instruction does not match
+// clang-format off
+#define OPCODE_SWITCH_CASE_0xF000(pattern, mask, variants, action)  \
+    default:                                                        \
+        break;                                                      \
+        }                                                           \
+        if (OPCODE_SWITCH_MATCHES(pattern, mask, variants)) action; \
+        {
+#define OPCODE_SWITCH_CASE_0xF0FF(pattern, mask, variants, action)  \
+    case (pattern) & 0xFF:                                          \
+        if (OPCODE_SWITCH_MATCHES(pattern, mask, variants)) action; \
+        break;
+#define OPCODE_SWITCH_CASE_0xFFFF(pattern, mask, variants, action) OPCODE_SWITCH_CASE_0xF0FF(pattern, mask, variants, action)
+#define OPCODE_SWITCH_CASE_0xFFF0(pattern, mask, variants, action)  \
+    case (pattern) & 0xF0 ... ((pattern) & 0xF0) + 0xF:             \
+        if (OPCODE_SWITCH_MATCHES(pattern, mask, variants)) action; \
+        break;
+#define OPCODE_SWITCH_CASE_0xF00F(pattern, mask, variants, action)  \
+    case 0x00 | ((pattern) & 0xF): case 0x10 | ((pattern) & 0xF):   \
+    case 0x20 | ((pattern) & 0xF): case 0x30 | ((pattern) & 0xF):   \
+    case 0x40 | ((pattern) & 0xF): case 0x50 | ((pattern) & 0xF):   \
+    case 0x60 | ((pattern) & 0xF): case 0x70 | ((pattern) & 0xF):   \
+    case 0x80 | ((pattern) & 0xF): case 0x90 | ((pattern) & 0xF):   \
+    case 0xA0 | ((pattern) & 0xF): case 0xB0 | ((pattern) & 0xF):   \
+    case 0xC0 | ((pattern) & 0xF): case 0xD0 | ((pattern) & 0xF):   \
+    case 0xE0 | ((pattern) & 0xF): case 0xF0 | ((pattern) & 0xF):   \
+        if (OPCODE_SWITCH_MATCHES(pattern, mask, variants)) action; \
+        break;
+// clang-format on
+
+#define OPCODE_NO_GROUP(nibble) // Omits group markers when expanding the table
+#define OPCODE_ENUM(name, ...)  OPCODE_##name,
+
+typedef enum {
+    CHIP8_OPCODES(OPCODE_ENUM, OPCODE_NO_GROUP)
+    OPCODE_COUNT
+} opcode_type_t;
+
+typedef struct {
+    uint16_t    pattern;  // Bits which must be set in a matching opcode
+    uint16_t    mask;     // Bits of the opcode which identify the instruction
+    const char *mnemonic; // Name of the instruction in assembly
+    const char *operands; // Template of the operands in assembly
+    uint8_t     flags;    // Bitmask of side effects of the instruction
+    uint8_t     variants; // Bitmask of variants supporting the instruction
+} opcode_data_t;
+
+/**
+ * Get the data for a specific instruction.
+ *
+ * @param type - The type of the instruction to retrieve data for
+ * @returns The data for the requested instruction or an empty object if invalid
+ */
+opcode_data_t opcode_get(opcode_type_t type);
+
+/**
+ * Decodes an opcode into the instruction it executes.
+ *
+ * @param opcode - The opcode to decode
+ * @param variant - The variant executing the opcode
+ * @returns The type of the instruction, or OPCODE_COUNT if invalid
+ */
+opcode_type_t opcode_decode(uint16_t opcode, variant_type_t variant);
+
+/**
+ * Gets the size of the instruction starting with the opcode.
+ *
+ * @param opcode - The opcode to measure
+ * @param variant - The variant executing the opcode
+ * @returns The size of the instruction in bytes
+ */
+uint8_t opcode_size(uint16_t opcode, variant_type_t variant);
+
+/**
+ * Disassembles an instruction into its assembly representation.
+ *
+ * Opcodes which do not decode are written as a data word, such as
+ * `DW 0x1234`, so that the output always covers every byte of the program.
+ *
+ * @param buffer - The buffer to write the assembly into
+ * @param size - The size of the buffer
+ * @param opcode - The opcode to disassemble
+ * @param operand - The word following the opcode, used by `OPCODE_LONG`
+ * @param variant - The variant executing the opcode
+ * @param quirks - The `chip8_quirk_t` flags executing the opcode, as the jump
+ * with offset adds V0 or VX depending on them
+ * @returns The length of the assembly, which is truncated to fit the buffer
+ */
+size_t opcode_disassemble(
+    char *buffer, size_t size, uint16_t opcode, uint16_t operand, variant_type_t variant, uint8_t quirks
+);
+
+/**
+ * Appends text to a disassembly buffer.
+ *
+ * Text past the end of the buffer is dropped, but still counted, so that the
+ * full length of the assembly can be reported like `snprintf` does.
+ *
+ * @param buffer - The buffer to append to
+ * @param size - The size of the buffer
+ * @param length - The length of the assembly written so far
+ * @param text - The text to append
+ * @returns The length of the assembly including the appended text
+ */
+static size_t opcode_append(char *buffer, size_t size, size_t length, const char *text);
@@ -0,0 +1,29 @@
+#include "variant.h"
+
+#include <stddef.h>
+#include <strings.h>
+
+static const variant_data_t VARIANT_TABLE[VARIANT_COUNT] = {
+    [VARIANT_CHIP8]  = {"CHIP-8", 4 * 1024, 64, 32, 1},
+    [VARIANT_XOCHIP] = {"XO-CHIP", 64 * 1024, 128, 64, 4},
+};
+
+variant_data_t variant_get(variant_type_t type) {
+    if (type >= VARIANT_COUNT) {
+        variant_data_t invalid = {NULL, 0, 0, 0, 0};
+        return invalid;
+    }
+    return VARIANT_TABLE[type];
+}
+
+variant_type_t variant_by_name(const char *name) {
+    if (name == NULL) return VARIANT_COUNT;
+
+    for (uint8_t i = 0; i < VARIANT_COUNT; ++i) {
+        if (strcasecmp(name, VARIANT_TABLE[i].name) == 0) {
+            return (variant_type_t)i;
+        }
+    }
+
+    return VARIANT_COUNT;
+}
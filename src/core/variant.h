@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef enum {
+    VARIANT_CHIP8,
+    VARIANT_XOCHIP,
+    VARIANT_COUNT
+} variant_type_t;
+
+typedef struct {
+    const char *name;
+    uint32_t    memory_size;    // Size of the addressable memory in bytes
+    uint8_t     display_width;  // Widest supported display mode in pixels
+    uint8_t     display_height; // Tallest supported display mode in pixels
+    uint8_t     display_planes; // Number of bitplanes making up the display
+} variant_data_t;
+
+/**
+ * Get the data for a specific platform variant.
+ *
+ * @param type - The type of the variant to retrieve data for
+ * @returns The data for the requested variant or an empty object if invalid
+ */
+variant_data_t variant_get(variant_type_t type);
+
+/**
+ * Gets the type of variant by its case insensitive name.
+ *
+ * @param name - The name of the variant to search for
+ * @returns The type of the variant, or VARIANT_COUNT if invalid
+ */
+variant_type_t variant_by_name(const char *name);
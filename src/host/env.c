@@ -0,0 +1,221 @@
+#include "env.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+
+bool env_init(env_t *env, const env_config_t *config) {
+    memset(env, 0, sizeof(env_t));
+    env->config     = *config;
+    env->config.rom = NULL;
+    if (!chip8_init(&env->chip8)) return false;
+
+    if (!chip8_set_variant(&env->chip8, config->variant) ||
+        !chip8_load_program(&env->chip8, config->rom, config->rom_size)) {
+        chip8_free(&env->chip8);
+        return false;
+    }
+    chip8_set_quirks(&env->chip8, config->quirks);
+
+    // Episodes restart from the loaded program rather than loading it again
+    if (!chip8_capture(&env->baseline, &env->chip8)) {
+        chip8_free(&env->chip8);
+        return false;
+    }
+    env_reset(env, NULL);
+    return true;
+}
+
+void env_free(env_t *env) {
+    chip8_free(&env->chip8);
+    chip8_free(&env->baseline);
+}
+
+size_t env_observation_words(const env_t *env) {
+    return (size_t)env->chip8.plane_size * env->chip8.display_planes;
+}
+
+void env_reset(env_t *env, uint64_t *observation) {
+    chip8_restore(&env->chip8, &env->baseline);
+    chip8_seed_rng(&env->chip8, env->config.seed + env->episodes);
+    env->episodes += 1;
+    env->frames = 0;
+    for (uint8_t r = 0; r < ENV_MAX_REWARDS; ++r) {
+        env->scores[r] = env_read_term(&env->chip8, &env->config.rewards[r]);
+    }
+    if (observation) env_observe(env, observation);
+}
+
+bool env_step(env_t *env, uint16_t action, uint32_t frameskip, uint64_t *observation, float *reward) {
+    uint32_t cycles_per_frame = INSTRUCTIONS_PER_SECOND / FRAMES_PER_SECOND;
+    bool     done             = false;
+
+    chip8_set_keypad(&env->chip8, action);
+    for (uint32_t f = 0; f < frameskip && !done; ++f) {
+        chip8_state_t state;
+        chip8_run_cycles(&env->chip8, cycles_per_frame, &state);
+        chip8_update_timers(&env->chip8);
+        env->frames += 1;
+
+        done = state.status != CHIP8_OK || (env->config.max_frames && env->frames >= env->config.max_frames) ||
+               (env->config.done.size && env_read_term(&env->chip8, &env->config.done) == env->config.done_value);
+    }
+
+    *reward = 0.0f;
+    for (uint8_t r = 0; r < ENV_MAX_REWARDS; ++r) {
+        const env_term_t *term  = &env->config.rewards[r];
+        uint32_t          score = env_read_term(&env->chip8, term);
+        *reward += term->weight * ((float)score - (float)env->scores[r]);
+        env->scores[r] = score;
+    }
+    env_observe(env, observation);
+    return done;
+}
+
+bool env_vec_init(env_vec_t *vec, const env_config_t *config, uint32_t count, uint32_t threads) {
+    memset(vec, 0, sizeof(env_vec_t));
+    if (count == 0) {
+        LOG_ERROR(LOG_SUBSYS_SYSTEM, "Attempted to create no environments.");
+        return false;
+    }
+
+    vec->envs    = malloc(sizeof(env_t) * count);
+    vec->workers = malloc(sizeof(pthread_t) * count);
+    if (!vec->envs || !vec->workers) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to allocate environments.");
+        free(vec->envs);
+        free(vec->workers);
+        return false;
+    }
+    pthread_mutex_init(&vec->lock, NULL);
+    pthread_cond_init(&vec->wake, NULL);
+    pthread_cond_init(&vec->idle, NULL);
+
+    // Every environment plays a different sequence of episodes
+    env_config_t own = *config;
+    vec->threads     = 1;
+    for (; vec->count < count; ++vec->count) {
+        own.seed = config->seed + vec->count * 0x9E3779B97F4A7C15ULL;
+        if (!env_init(&vec->envs[vec->count], &own)) {
+            env_vec_free(vec);
+            return false;
+        }
+    }
+    // Observations are sized by the variant, alike for every environment
+    vec->words = env_observation_words(&vec->envs[0]);
+
+    uint32_t target = threads == 0 ? 1 : threads > count ? count : threads;
+    for (; vec->threads < target; ++vec->threads) {
+        if (pthread_create(&vec->workers[vec->threads], NULL, env_vec_worker, vec) != 0) {
+            LOG_ERROR(LOG_SUBSYS_SYSTEM, "Failed to start environment threads.");
+            env_vec_free(vec);
+            return false;
+        }
+    }
+    return true;
+}
+
+void env_vec_free(env_vec_t *vec) {
+    if (vec->threads > 1) {
+        pthread_mutex_lock(&vec->lock);
+        vec->stopping = true;
+        pthread_cond_broadcast(&vec->wake);
+        pthread_mutex_unlock(&vec->lock);
+        for (uint32_t t = 1; t < vec->threads; ++t) pthread_join(vec->workers[t], NULL);
+    }
+    pthread_mutex_destroy(&vec->lock);
+    pthread_cond_destroy(&vec->wake);
+    pthread_cond_destroy(&vec->idle);
+
+    for (uint32_t e = 0; e < vec->count; ++e) env_free(&vec->envs[e]);
+    free(vec->envs);
+    free(vec->workers);
+    memset(vec, 0, sizeof(env_vec_t));
+}
+
+void env_vec_reset(env_vec_t *vec, uint64_t *observations) {
+    vec->actions      = NULL;
+    vec->observations = observations;
+    env_vec_dispatch(vec);
+}
+
+void env_vec_step(env_vec_t *vec, const uint16_t *actions, uint32_t frameskip, uint64_t *observations,
+                  float *rewards, bool *dones) {
+    vec->actions      = actions;
+    vec->frameskip    = frameskip;
+    vec->observations = observations;
+    vec->rewards      = rewards;
+    vec->dones        = dones;
+    env_vec_dispatch(vec);
+}
+
+static uint32_t env_read_term(const chip8_t *chip8, const env_term_t *term) {
+    uint32_t value = 0;
+    for (uint8_t b = 0; b < term->size && b < 4; ++b) {
+        value = value << 8 | chip8->memory[(term->address + b) & chip8->address_mask];
+    }
+    return value;
+}
+
+static void env_observe(const env_t *env, uint64_t *observation) {
+    memcpy(observation, env->chip8.display, sizeof(uint64_t) * env_observation_words(env));
+}
+
+static void env_vec_run(env_vec_t *vec, uint32_t thread) {
+    uint32_t first = (uint64_t)vec->count * thread / vec->threads;
+    uint32_t last  = (uint64_t)vec->count * (thread + 1) / vec->threads;
+    size_t   words = vec->words;
+
+    for (uint32_t e = first; e < last; ++e) {
+        env_t    *env         = &vec->envs[e];
+        uint64_t *observation = &vec->observations[e * words];
+        if (!vec->actions) {
+            env_reset(env, observation);
+            continue;
+        }
+
+        vec->dones[e] = env_step(env, vec->actions[e], vec->frameskip, observation, &vec->rewards[e]);
+        if (vec->dones[e]) env_reset(env, observation);
+    }
+}
+
+static void *env_vec_worker(void *data) {
+    env_vec_t *vec = data;
+
+    // Workers start before the first batch, so no batch is missed
+    pthread_mutex_lock(&vec->lock);
+    uint32_t thread = ++vec->started;
+    uint64_t seen   = 0;
+    while (true) {
+        while (!vec->stopping && vec->generation == seen) pthread_cond_wait(&vec->wake, &vec->lock);
+        if (vec->stopping) break;
+        seen = vec->generation;
+        pthread_mutex_unlock(&vec->lock);
+
+        env_vec_run(vec, thread);
+
+        pthread_mutex_lock(&vec->lock);
+        if (--vec->busy == 0) pthread_cond_signal(&vec->idle);
+    }
+    pthread_mutex_unlock(&vec->lock);
+    return NULL;
+}
+
+static void env_vec_dispatch(env_vec_t *vec) {
+    if (vec->threads > 1) {
+        pthread_mutex_lock(&vec->lock);
+        vec->generation += 1;
+        vec->busy = vec->threads - 1;
+        pthread_cond_broadcast(&vec->wake);
+        pthread_mutex_unlock(&vec->lock);
+    }
+
+    env_vec_run(vec, 0);
+
+    if (vec->threads > 1) {
+        pthread_mutex_lock(&vec->lock);
+        while (vec->busy > 0) pthread_cond_wait(&vec->idle, &vec->lock);
+        pthread_mutex_unlock(&vec->lock);
+    }
+}
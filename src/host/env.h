@@ -0,0 +1,206 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chip8.h"
+#include "variant.h"
+
+#define ENV_MAX_REWARDS 4 // Memory values which can contribute to the reward
+
+// A value in memory, read as a big-endian unsigned integer.
+typedef struct {
+    uint16_t address; // Address of the most significant byte
+    uint8_t  size;    // Number of bytes, up to 4; 0 disables the term
+    float    weight;  // Reward per unit the value changes by; unused for the done term
+} env_term_t;
+
+// Game-specific configuration of an environment.
+typedef struct {
+    const uint8_t *rom;                      // Program to run; only read while initializing
+    size_t         rom_size;                 // Size of the program in bytes
+    variant_type_t variant;                  // Platform variant to emulate
+    uint8_t        quirks;                   // Bitmask of `chip8_quirk_t` to emulate
+    uint64_t       seed;                     // Seed of the first episode, incremented every episode
+    env_term_t     rewards[ENV_MAX_REWARDS]; // Values whose changes make up the reward
+    env_term_t     done;                     // Value which ends the episode once equal to `done_value`
+    uint32_t       done_value;               // Value of the done term ending the episode
+    uint32_t       max_frames;               // Frames after which episodes are cut off; 0 for no limit
+} env_config_t;
+
+// A single environment, running one CHIP-8 in episodes.
+typedef struct {
+    chip8_t      chip8;                   // The running emulator
+    chip8_t      baseline;                // State of the loaded program, restored on reset
+    env_config_t config;                  // Configuration of the environment
+    uint32_t     scores[ENV_MAX_REWARDS]; // Latest value of each reward term
+    uint32_t     frames;                  // Frames run in the current episode
+    uint64_t     episodes;                // Episodes started since initializing
+} env_t;
+
+// Environments stepped together, spread across a pool of threads.
+typedef struct {
+    env_t          *envs;         // All environments
+    uint32_t        count;        // Number of environments
+    size_t          words;        // Words of the observation of every environment
+    uint32_t        threads;      // Number of threads stepping, including the caller
+    pthread_t      *workers;      // Threads besides the caller
+    pthread_mutex_t lock;         // Guards the fields below
+    pthread_cond_t  wake;         // Signalled when a batch is ready for the workers
+    pthread_cond_t  idle;         // Signalled when the last worker finishes a batch
+    uint32_t        started;      // Workers which claimed their index
+    uint64_t        generation;   // Incremented for every batch
+    uint32_t        busy;         // Workers still running the current batch
+    bool            stopping;     // Set when the workers must exit
+    const uint16_t *actions;      // Action of every environment in the current batch, or NULL to reset
+    uint32_t        frameskip;    // Frames to run per step in the current batch
+    uint64_t       *observations; // Observations written by the current batch
+    float          *rewards;      // Rewards written by the current batch
+    bool           *dones;        // Done flags written by the current batch
+} env_vec_t;
+
+/**
+ * Initializes an environment with a program, and starts its first episode.
+ *
+ * The environment runs headless on the core alone, and must be released
+ * using `env_free` once it is no longer needed.
+ *
+ * @param env - The environment to initialize
+ * @param config - The configuration of the environment
+ * @returns If the program could be loaded
+ */
+bool env_init(env_t *env, const env_config_t *config);
+
+/**
+ * Releases the memory allocated for an environment.
+ *
+ * @param env - The environment to release
+ */
+void env_free(env_t *env);
+
+/**
+ * Gets the number of words in the observations of an environment.
+ *
+ * Observations are the packed display, a row of 64 pixels per word and one
+ * plane after the other, sized for the largest display mode of the variant.
+ *
+ * @param env - The environment
+ * @returns The number of words in a single observation
+ */
+size_t env_observation_words(const env_t *env);
+
+/**
+ * Starts a new episode from the state the program was loaded in.
+ *
+ * Episodes are reset by copying back only the memory and display changed
+ * during the episode, and are seeded with the next seed in turn.
+ *
+ * @param env - The environment to reset
+ * @param observation - Receives the first observation of the episode
+ */
+void env_reset(env_t *env, uint64_t *observation);
+
+/**
+ * Runs a number of frames while holding down the keys of an action.
+ *
+ * The reward is the weighted change of every reward term over the frames.
+ * The episode is done once the done term equals its value, an instruction
+ * fails, or the frame limit is reached, after which it must be reset.
+ *
+ * @param env - The environment to step
+ * @param action - The keys held down, with bit N set to hold key N
+ * @param frameskip - The number of frames to run; at least 1
+ * @param observation - Receives the observation after the last frame
+ * @param reward - Receives the reward of the step
+ * @returns If the episode is done
+ */
+bool env_step(env_t *env, uint16_t action, uint32_t frameskip, uint64_t *observation, float *reward);
+
+/**
+ * Initializes a number of environments with the same configuration, each
+ * seeded differently, and a pool of threads to step them with.
+ *
+ * @param vec - The environments to initialize
+ * @param config - The configuration shared by every environment
+ * @param count - The number of environments
+ * @param threads - The number of threads stepping the environments, including
+ * the caller; capped to the number of environments
+ * @returns If every environment and thread could be created
+ */
+bool env_vec_init(env_vec_t *vec, const env_config_t *config, uint32_t count, uint32_t threads);
+
+/**
+ * Stops the threads and releases every environment.
+ *
+ * @param vec - The environments to release
+ */
+void env_vec_free(env_vec_t *vec);
+
+/**
+ * Resets every environment.
+ *
+ * @param vec - The environments to reset
+ * @param observations - Receives the observation of every environment, one
+ * after the other
+ */
+void env_vec_reset(env_vec_t *vec, uint64_t *observations);
+
+/**
+ * Steps every environment with its own action in one call.
+ *
+ * Environments are split evenly across the threads, with the caller stepping
+ * its own share. Environments whose episode is done are reset right away, so
+ * their observation is the first one of the next episode.
+ *
+ * @param vec - The environments to step
+ * @param actions - The action of every environment
+ * @param frameskip - The number of frames to run; at least 1
+ * @param observations - Receives the observation of every environment
+ * @param rewards - Receives the reward of every environment
+ * @param dones - Receives if the episode of every environment was done
+ */
+void env_vec_step(env_vec_t *vec, const uint16_t *actions, uint32_t frameskip, uint64_t *observations,
+                  float *rewards, bool *dones);
+
+/**
+ * Reads the value of a term from memory.
+ *
+ * @param chip8 - The CHIP-8 to read from
+ * @param term - The term to read
+ * @returns The value of the term
+ */
+static uint32_t env_read_term(const chip8_t *chip8, const env_term_t *term);
+
+/**
+ * Copies the display into an observation.
+ *
+ * @param env - The environment to observe
+ * @param observation - Receives the observation
+ */
+static void env_observe(const env_t *env, uint64_t *observation);
+
+/**
+ * Runs the share of the current batch belonging to a thread.
+ *
+ * @param vec - The environments being stepped
+ * @param thread - The index of the thread; 0 for the caller
+ */
+static void env_vec_run(env_vec_t *vec, uint32_t thread);
+
+/**
+ * Waits for batches and runs its share of them until stopped.
+ *
+ * @param data - The `env_vec_t` the worker belongs to
+ * @returns Always NULL
+ */
+static void *env_vec_worker(void *data);
+
+/**
+ * Hands a batch to the workers, runs the share of the caller, and waits for
+ * the workers to finish.
+ *
+ * @param vec - The environments to run the batch on
+ */
+static void env_vec_dispatch(env_vec_t *vec);
@@ -0,0 +1,163 @@
+#include "export.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "log.h"
+
+bool export_create(export_t *export, const char *name) {
+    memset(export, 0, sizeof(export_t));
+    if (strlen(name) >= EXPORT_NAME_SIZE) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Shared memory name %s is too long.", name);
+        return false;
+    }
+
+    // Stale objects of a previous emulator are replaced instead of reused
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to create shared memory %s.", name);
+        return false;
+    }
+    if (ftruncate(fd, sizeof(export_ring_t)) != 0) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to size shared memory %s.", name);
+        close(fd);
+        shm_unlink(name);
+        return false;
+    }
+
+    // The mapping stays valid after closing the descriptor
+    void *data = mmap(NULL, sizeof(export_ring_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to map shared memory %s.", name);
+        shm_unlink(name);
+        return false;
+    }
+
+    // The object starts out zeroed, so every slot is empty until published,
+    // and the magic is written last so readers never see a partial header
+    export->ring   = data;
+    export->writer = true;
+    strcpy(export->name, name);
+    export->ring->version    = EXPORT_VERSION;
+    export->ring->frame_size = sizeof(export_frame_t);
+    __atomic_store_n(&export->ring->magic, EXPORT_MAGIC, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool export_attach(export_t *export, const char *name) {
+    memset(export, 0, sizeof(export_t));
+    if (strlen(name) >= EXPORT_NAME_SIZE) return false;
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(export_ring_t)) {
+        LOG_WARN(LOG_SUBSYS_MEMORY, "Shared memory %s has an unexpected size.", name);
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(NULL, sizeof(export_ring_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to map shared memory %s.", name);
+        return false;
+    }
+
+    export_ring_t *ring = data;
+    if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) != EXPORT_MAGIC || ring->version != EXPORT_VERSION ||
+        ring->frame_size != sizeof(export_frame_t)) {
+        LOG_WARN(LOG_SUBSYS_MEMORY, "Shared memory %s has an unsupported layout.", name);
+        munmap(data, sizeof(export_ring_t));
+        return false;
+    }
+
+    export->ring = ring;
+    strcpy(export->name, name);
+    return true;
+}
+
+void export_close(export_t *export) {
+    if (export->ring) munmap(export->ring, sizeof(export_ring_t));
+    if (export->writer) shm_unlink(export->name);
+    memset(export, 0, sizeof(export_t));
+}
+
+void export_publish(export_t *export, const chip8_t *chip8) {
+    export_ring_t        *ring     = export->ring;
+    uint64_t              number   = export->frames + 1;
+    export_frame_t       *slot     = &ring->slots[number % EXPORT_SLOTS];
+    const export_frame_t *previous = export->frames ? &ring->slots[export->frames % EXPORT_SLOTS] : NULL;
+
+    // Only this process writes, so the counter can be read back directly
+    uint64_t sequence = slot->sequence;
+    __atomic_store_n(&slot->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&slot->frame, number, __ATOMIC_RELAXED);
+    slot->cycles         = chip8->cycles;
+    slot->pc             = chip8->pc;
+    slot->i              = chip8->i;
+    slot->stack_pointer  = chip8->stack_pointer;
+    slot->delay_timer    = chip8->delay_timer;
+    slot->sound_timer    = chip8->sound_timer;
+    slot->planes         = chip8->planes;
+    slot->hires          = chip8->hires;
+    slot->display_width  = chip8->display_width;
+    slot->display_height = chip8->display_height;
+    slot->display_stride = chip8->display_stride;
+    slot->display_planes = chip8->display_planes;
+    slot->plane_size     = chip8->plane_size;
+    memcpy(slot->stack, chip8->stack, sizeof(slot->stack));
+    memcpy(slot->v, chip8->v, sizeof(slot->v));
+    memcpy(slot->display, chip8->display, sizeof(uint64_t) * chip8->plane_size * chip8->display_planes);
+    slot->dirty_rows = export_dirty_rows(slot, previous);
+
+    __atomic_store_n(&slot->sequence, sequence + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->head, number, __ATOMIC_RELEASE);
+    export->frames = number;
+}
+
+const export_frame_t *export_read(const export_ring_t *ring, uint64_t frame, uint64_t *sequence) {
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (frame == 0) frame = head;
+    if (frame == 0 || frame > head || head - frame >= EXPORT_SLOTS) return NULL;
+
+    // A slot being written, or already reused by a later frame, is not read
+    const export_frame_t *slot = &ring->slots[frame % EXPORT_SLOTS];
+    *sequence                  = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+    if (*sequence & 1 || __atomic_load_n(&slot->frame, __ATOMIC_RELAXED) != frame) return NULL;
+    return slot;
+}
+
+bool export_validate(const export_frame_t *frame, uint64_t sequence) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&frame->sequence, __ATOMIC_RELAXED) == sequence;
+}
+
+static uint64_t export_dirty_rows(const export_frame_t *frame, const export_frame_t *previous) {
+    uint64_t all = frame->display_height >= 64 ? ~0ULL : (1ULL << frame->display_height) - 1;
+    if (!previous || previous->hires != frame->hires || previous->plane_size != frame->plane_size ||
+        previous->display_planes != frame->display_planes) {
+        return all;
+    }
+
+    uint64_t dirty = 0;
+    for (uint8_t p = 0; p < frame->display_planes; ++p) {
+        const uint64_t *row = &frame->display[p * frame->plane_size];
+        const uint64_t *old = &previous->display[p * frame->plane_size];
+        for (uint8_t y = 0; y < frame->display_height; ++y) {
+            if (memcmp(&row[y * frame->display_stride], &old[y * frame->display_stride],
+                       sizeof(uint64_t) * frame->display_stride) != 0) {
+                dirty |= 1ULL << y;
+            }
+        }
+    }
+    return dirty;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chip8.h"
+
+#define EXPORT_MAGIC         0x5452505838504843ULL // "CHP8XPRT" in little-endian
+#define EXPORT_VERSION       1                     // Bumped whenever the layout changes
+#define EXPORT_SLOTS         8                     // Frames kept in the ring; a power of two
+#define EXPORT_NAME_SIZE     64                    // Longest name of a shared-memory object
+#define EXPORT_DISPLAY_WORDS (HIRES_DISPLAY_WIDTH / DISPLAY_ROW_BITS * HIRES_DISPLAY_HEIGHT * 4)
+
+// A single frame within the ring, guarded by its sequence counter.
+typedef struct {
+    uint64_t sequence;                      // Odd while the slot is written; accessed atomically
+    uint64_t frame;                         // Number of the frame, counting from 1
+    uint64_t cycles;                        // Instruction cycles run when the frame completed
+    uint64_t dirty_rows;                    // Bitmap of display rows changed since the previous frame
+    uint16_t pc;                            // Current memory address
+    uint16_t i;                             // Arbitrary address within memory
+    uint16_t stack[16];                     // Subroutine return addresses
+    uint8_t  v[16];                         // Arbitrary variable registers
+    int8_t   stack_pointer;                 // Current position within stack
+    uint8_t  delay_timer;                   // Value of delay timer
+    uint8_t  sound_timer;                   // Value of sound timer
+    uint8_t  planes;                        // Bitmask of planes selected for drawing
+    uint8_t  hires;                         // If the high resolution mode is active
+    uint8_t  display_width;                 // Width of the active display mode
+    uint8_t  display_height;                // Height of the active display mode
+    uint8_t  display_stride;                // Number of words making up a single row
+    uint8_t  display_planes;                // Number of planes in the display
+    uint16_t plane_size;                    // Number of words making up a single plane
+    uint64_t display[EXPORT_DISPLAY_WORDS]; // Packed rows of pixels per plane, as in `chip8_t`
+} export_frame_t;
+
+// Layout of the shared-memory object, written by a single emulator.
+typedef struct {
+    uint64_t       magic;               // Always `EXPORT_MAGIC`
+    uint32_t       version;             // Always `EXPORT_VERSION`
+    uint32_t       frame_size;          // Size of a single frame in bytes
+    uint64_t       head;                // Number of the latest complete frame; accessed atomically
+    export_frame_t slots[EXPORT_SLOTS]; // Frame N is kept in slot N % `EXPORT_SLOTS`
+} export_ring_t;
+
+// An open shared-memory object, either published into or read from.
+typedef struct {
+    export_ring_t *ring;                   // The mapped ring
+    bool           writer;                 // If the object was created to publish into
+    uint64_t       frames;                 // Frames published so far
+    char           name[EXPORT_NAME_SIZE]; // Name of the shared-memory object
+} export_t;
+
+/**
+ * Creates a shared-memory object to publish frames into.
+ *
+ * An existing object of the same name is replaced, so readers attached to a
+ * previous emulator must attach again. The object is removed again once
+ * closed with `export_close`.
+ *
+ * @param export - The exporter to create
+ * @param name - The name of the object, starting with a slash
+ * @returns If the object could be created and mapped
+ */
+bool export_create(export_t *export, const char *name);
+
+/**
+ * Attaches to a shared-memory object created by another process.
+ *
+ * The object is mapped read-only, so readers can never disturb the emulator.
+ *
+ * @param export - The reader to attach
+ * @param name - The name of the object, starting with a slash
+ * @returns If the object exists and has the expected layout
+ */
+bool export_attach(export_t *export, const char *name);
+
+/**
+ * Unmaps a shared-memory object, and removes it if it was created.
+ *
+ * @param export - The exporter or reader to close
+ */
+void export_close(export_t *export);
+
+/**
+ * Publishes a completed frame of the CHIP-8 into the next slot.
+ *
+ * Publishing never waits for readers. The sequence counter of the slot is
+ * odd while it is written, so readers can detect frames overwritten while
+ * reading them, and the head only advances once the frame is complete.
+ *
+ * @param export - The exporter to publish into
+ * @param chip8 - The CHIP-8 which completed a frame
+ */
+void export_publish(export_t *export, const chip8_t *chip8);
+
+/**
+ * Gets a frame directly within the ring, without copying it.
+ *
+ * The frame may be overwritten at any time, so anything read from it is only
+ * valid once `export_validate` confirms the slot was not written since.
+ *
+ * @param ring - The ring to read from
+ * @param frame - The number of the frame, or 0 for the latest one
+ * @param sequence - Receives the sequence counter to validate against
+ * @returns The frame, or NULL if it is not complete or no longer in the ring
+ */
+const export_frame_t *export_read(const export_ring_t *ring, uint64_t frame, uint64_t *sequence);
+
+/**
+ * Checks if a frame was not overwritten since getting it from the ring.
+ *
+ * @param frame - The frame returned by `export_read`
+ * @param sequence - The sequence counter returned by `export_read`
+ * @returns If everything read from the frame is consistent
+ */
+bool export_validate(const export_frame_t *frame, uint64_t sequence);
+
+/**
+ * Gets the rows of the display which changed between two displays.
+ *
+ * @param frame - The frame being published
+ * @param previous - The frame published before, or NULL for the first frame
+ * @returns Bitmap of the changed rows, with every row set on a mode change
+ */
+static uint64_t export_dirty_rows(const export_frame_t *frame, const export_frame_t *previous);
@@ -0,0 +1,112 @@
+#include "phosphor.h"
+
+#include <string.h>
+
+#if defined(ENABLE_SSE) && defined(__SSE2__)
+#include <emmintrin.h>
+#define PHOSPHOR_SSE
+#endif
+
+void phosphor_init(phosphor_t *phosphor, uint8_t frames) {
+    memset(phosphor, 0, sizeof(phosphor_t));
+    phosphor->decay = frames > 1 ? (PHOSPHOR_LIT + frames - 1) / frames : PHOSPHOR_LIT;
+}
+
+bool phosphor_update(phosphor_t *phosphor, const chip8_t *chip8, uint64_t rows) {
+    uint8_t width  = chip8->display_width;
+    uint8_t height = chip8->display_height;
+    if (width != phosphor->width || height != phosphor->height) {
+        // Pixels of the previous mode do not line up with the new one
+        memset(phosphor->intensity, 0, sizeof(phosphor->intensity));
+        memset(phosphor->pixels, 0, sizeof(phosphor->pixels));
+        phosphor->width       = width;
+        phosphor->height      = height;
+        phosphor->fading_rows = 0;
+        rows                  = ~0ULL;
+    }
+    uint64_t visible = height < 64 ? (1ULL << height) - 1 : ~0ULL;
+    rows &= visible;
+
+    uint64_t update = rows | phosphor->fading_rows;
+    if (!update) return false;
+
+    phosphor->fading_rows = 0;
+    while (rows) {
+        uint8_t y = __builtin_ctzll(rows);
+        phosphor_unpack_row(chip8, y, &phosphor->lit[y * width]);
+        rows &= rows - 1;
+    }
+
+    // Adjacent rows are blended as a single run
+    while (update) {
+        uint8_t first = __builtin_ctzll(update);
+        uint8_t count = ~(update >> first) ? __builtin_ctzll(~(update >> first)) : 64;
+        if (phosphor_blend(phosphor, first * width, count * width)) {
+            phosphor->fading_rows |= (count < 64 ? (1ULL << count) - 1 : ~0ULL) << first;
+        }
+        update &= count + first < 64 ? ~0ULL << (first + count) : 0;
+    }
+    return true;
+}
+
+static void phosphor_unpack_row(const chip8_t *chip8, uint8_t y, uint8_t *lit) {
+    uint8_t width = chip8->display_width;
+    memset(lit, 0, width);
+
+    for (uint8_t p = 0; p < chip8->display_planes; ++p) {
+        const uint64_t *row = &chip8->display[p * chip8->plane_size + y * chip8->display_stride];
+        for (uint8_t x = 0; x < width; ++x) {
+            uint64_t word = row[x / DISPLAY_ROW_BITS];
+            lit[x] |= ((word >> (DISPLAY_ROW_BITS - 1 - x % DISPLAY_ROW_BITS)) & 0x1) << p;
+        }
+    }
+}
+
+static bool phosphor_blend(phosphor_t *phosphor, uint32_t first, uint32_t count) {
+    uint8_t *lit       = &phosphor->lit[first];
+    uint8_t *intensity = &phosphor->intensity[first];
+    uint8_t *pixels    = &phosphor->pixels[first];
+    uint8_t  fading    = 0;
+    uint32_t i         = 0;
+
+#ifdef PHOSPHOR_SSE
+    const __m128i zero   = _mm_setzero_si128();
+    const __m128i loss   = _mm_set1_epi8((char)phosphor->decay);
+    const __m128i colors = _mm_set1_epi8(0x0F);
+    const __m128i fades  = _mm_set1_epi8((char)0xF0);
+    __m128i       faded  = zero;
+    for (; i + 16 <= count; i += 16) {
+        __m128i drawn = _mm_loadu_si128((const __m128i *)&lit[i]);
+        __m128i dark  = _mm_cmpeq_epi8(drawn, zero);
+
+        // Lit pixels are at full intensity, and take the color drawn
+        __m128i level = _mm_subs_epu8(_mm_loadu_si128((const __m128i *)&intensity[i]), loss);
+        level         = _mm_or_si128(level, _mm_andnot_si128(dark, _mm_cmpeq_epi8(zero, zero)));
+        __m128i color = _mm_and_si128(_mm_loadu_si128((const __m128i *)&pixels[i]), colors);
+        color         = _mm_or_si128(_mm_and_si128(dark, color), drawn);
+
+        __m128i out = _mm_or_si128(_mm_andnot_si128(level, fades), color);
+        out         = _mm_andnot_si128(_mm_cmpeq_epi8(level, zero), out);
+        faded       = _mm_or_si128(faded, _mm_and_si128(dark, level));
+        _mm_storeu_si128((__m128i *)&intensity[i], level);
+        _mm_storeu_si128((__m128i *)&pixels[i], out);
+    }
+    fading = _mm_movemask_epi8(_mm_cmpeq_epi8(faded, zero)) != 0xFFFF;
+#endif
+
+    // Selections are written as masks, so that compilers vectorize this on
+    // targets without SSE2 as well
+    uint8_t decay = phosphor->decay;
+    for (; i < count; ++i) {
+        uint8_t drawn = lit[i];
+        uint8_t dark  = drawn ? 0x00 : 0xFF;
+        uint8_t level = intensity[i] - (intensity[i] < decay ? intensity[i] : decay);
+        level         = (level & dark) | ~dark;
+        uint8_t color = (pixels[i] & 0x0F & dark) | drawn;
+
+        intensity[i] = level;
+        pixels[i]    = ((~level & 0xF0) | color) & (level ? 0xFF : 0x00);
+        fading |= level & dark;
+    }
+    return fading != 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "chip8.h"
+
+#define PHOSPHOR_PIXELS              (HIRES_DISPLAY_WIDTH * HIRES_DISPLAY_HEIGHT) // Pixels of the largest display mode
+#define PHOSPHOR_LIT                 0xFF                                         // Intensity of lit pixels
+#define PHOSPHOR_DEFAULT_PERSISTENCE 4                                            // Frames unlit pixels take to fade out by default
+
+// Display post-processing emulating the persistence of a phosphor screen, so
+// that sprites erased and redrawn across frames blend instead of flickering.
+//
+// Every pixel has an intensity, which is full while the pixel is lit, and
+// fades out over several frames once it is turned off. Only the rows drawn to
+// and the rows still fading are processed each frame.
+typedef struct {
+    uint8_t  width;                      // Width of the display mode
+    uint8_t  height;                     // Height of the display mode
+    uint8_t  decay;                      // Intensity lost per frame by unlit pixels
+    uint64_t fading_rows;                // Bitmap of rows with pixels still fading out
+    uint8_t  lit[PHOSPHOR_PIXELS];       // Palette index of every pixel as drawn
+    uint8_t  intensity[PHOSPHOR_PIXELS]; // Intensity of every pixel
+    uint8_t  pixels[PHOSPHOR_PIXELS];    // Blended palette index and fade of every pixel
+} phosphor_t;
+
+/**
+ * Initializes a phosphor screen with every pixel dark.
+ *
+ * @param phosphor - The screen to initialize
+ * @param frames - The number of frames unlit pixels take to fade out; 1 fades
+ * them out immediately, as without persistence
+ */
+void phosphor_init(phosphor_t *phosphor, uint8_t frames);
+
+/**
+ * Advances the screen by a frame, lighting the pixels set on the display and
+ * fading out the others.
+ *
+ * The display rows changed since the previous frame must be provided, such as
+ * those taken through `chip8_take_drawn_rows`, while changing the display
+ * mode redraws every row.
+ *
+ * The blended pixels hold the palette index of the color last lit in their
+ * low nibble, and how far the pixel faded out in their high nibble, from 0
+ * for full intensity to 15 for nearly dark, as expected by the platform.
+ *
+ * When built with `ENABLE_SSE` on a target supporting SSE2, 16 pixels are
+ * blended at once.
+ *
+ * @param phosphor - The screen to advance
+ * @param chip8 - The CHIP-8 to read the display of
+ * @param rows - The bitmap of display rows changed since the previous frame
+ * @returns If any row was blended, and its pixels may have changed
+ */
+bool phosphor_update(phosphor_t *phosphor, const chip8_t *chip8, uint64_t rows);
+
+/**
+ * Unpacks a display row into one palette index per pixel.
+ *
+ * @param chip8 - The CHIP-8 to read the display of
+ * @param y - The row to unpack
+ * @param lit - Receives the palette index of every pixel of the row
+ */
+static void phosphor_unpack_row(const chip8_t *chip8, uint8_t y, uint8_t *lit);
+
+/**
+ * Blends a run of pixels, lighting those set and fading out the others.
+ *
+ * @param phosphor - The screen to blend
+ * @param first - The index of the first pixel to blend
+ * @param count - The number of pixels to blend
+ * @returns If any pixel is still fading out
+ */
+static bool phosphor_blend(phosphor_t *phosphor, uint32_t first, uint32_t count);
@@ -0,0 +1,272 @@
+#include "recording.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "chip8.h"
+#include "log.h"
+
+static bool recording_allocate(recording_t *recording) {
+    size_t size        = sizeof(uint64_t) * recording->header.plane_size * recording->header.display_planes;
+    recording->display = calloc(1, size);
+    recording->delta   = malloc(size);
+    recording->payload = malloc(RECORDING_PAYLOAD_SIZE);
+    if (!recording->display || !recording->delta || !recording->payload) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to allocate recording buffers.");
+        return false;
+    }
+    return true;
+}
+
+bool recording_create(recording_t *recording, const chip8_t *chip8, const char *path) {
+    memset(recording, 0, sizeof(recording_t));
+    recording->writer                   = true;
+    recording->header.magic             = RECORDING_MAGIC;
+    recording->header.version           = RECORDING_VERSION;
+    recording->header.header_size       = sizeof(recording_header_t);
+    recording->header.frames_per_second = FRAMES_PER_SECOND;
+    recording->header.keyframe_interval = RECORDING_KEYFRAME_INTERVAL;
+    recording->header.plane_size        = chip8->plane_size;
+    recording->header.display_stride    = chip8->display_stride;
+    recording->header.display_planes    = chip8->display_planes;
+    if (!recording_allocate(recording)) {
+        recording_close(recording);
+        return false;
+    }
+
+    recording->file = fopen(path, "wb");
+    if (!recording->file || fwrite(&recording->header, sizeof(recording_header_t), 1, recording->file) != 1) {
+        LOG_ERROR(LOG_SUBSYS_SYSTEM, "Failed to create recording %s.", path);
+        recording_close(recording);
+        return false;
+    }
+    return true;
+}
+
+bool recording_write(recording_t *recording, const chip8_t *chip8) {
+    recording_header_t *header = &recording->header;
+    if (chip8->plane_size != header->plane_size || chip8->display_planes != header->display_planes) return false;
+
+    // Keyframes are stored against an empty display, which they replace
+    bool      keyframe = recording->frame % header->keyframe_interval == 0;
+    uint16_t  words    = header->plane_size * header->display_planes;
+    uint64_t *delta    = (uint64_t *)recording->delta;
+    for (uint16_t w = 0; w < words; ++w) {
+        delta[w]              = keyframe ? chip8->display[w] : chip8->display[w] ^ recording->display[w];
+        recording->display[w] = chip8->display[w];
+    }
+
+    if (keyframe) {
+        if (recording->keyframes == recording->capacity) {
+            uint64_t  capacity = recording->capacity ? recording->capacity * 2 : 64;
+            uint64_t *index    = realloc(recording->index, sizeof(uint64_t) * capacity);
+            if (!index) return false;
+            recording->index    = index;
+            recording->capacity = capacity;
+        }
+        recording->index[recording->keyframes++] = ftell(recording->file);
+    }
+
+    uint16_t length = recording_encode(recording->delta, sizeof(uint64_t) * words, recording->payload);
+
+    uint8_t record[RECORDING_FRAME_HEADER] = {
+        keyframe ? RECORDING_KEYFRAME : 0,
+        chip8->display_width,
+        chip8->display_height,
+        length & 0xFF,
+        length >> 8,
+    };
+    if (fwrite(record, 1, sizeof(record), recording->file) != sizeof(record) ||
+        fwrite(recording->payload, 1, length, recording->file) != length) {
+        LOG_ERROR(LOG_SUBSYS_SYSTEM, "Failed to write recording frame %llu.", (unsigned long long)recording->frame);
+        return false;
+    }
+    recording->display_width  = chip8->display_width;
+    recording->display_height = chip8->display_height;
+    recording->frame += 1;
+    return true;
+}
+
+static uint16_t recording_encode(const uint8_t *delta, uint16_t size, uint8_t *payload) {
+    uint16_t length = 0;
+    uint16_t b      = 0;
+    while (b < size) {
+        // Whole words are skipped at once, as most of a delta is unchanged
+        uint16_t skip = b;
+        while (skip % sizeof(uint64_t) && skip < size && delta[skip] == 0) ++skip;
+        while (skip + sizeof(uint64_t) <= size && *(const uint64_t *)&delta[skip] == 0) skip += sizeof(uint64_t);
+        while (skip < size && delta[skip] == 0) ++skip;
+        if (skip == size) break;
+
+        // Literals only end at two zero bytes, which are cheaper to skip
+        uint16_t end = skip;
+        while (end < size && (delta[end] || (end + 1 < size && delta[end + 1]))) ++end;
+
+        for (uint16_t value = skip - b;; value >>= 7) {
+            payload[length++] = (value & 0x7F) | (value > 0x7F ? 0x80 : 0);
+            if (value <= 0x7F) break;
+        }
+        for (uint16_t value = end - skip;; value >>= 7) {
+            payload[length++] = (value & 0x7F) | (value > 0x7F ? 0x80 : 0);
+            if (value <= 0x7F) break;
+        }
+        memcpy(&payload[length], &delta[skip], end - skip);
+        length += end - skip;
+        b = end;
+    }
+    return length;
+}
+
+bool recording_open(recording_t *recording, const char *path) {
+    memset(recording, 0, sizeof(recording_t));
+    recording->file = fopen(path, "rb");
+    if (!recording->file) {
+        LOG_ERROR(LOG_SUBSYS_SYSTEM, "Failed to open recording %s.", path);
+        return false;
+    }
+
+    recording_header_t *header = &recording->header;
+    bool                valid  = fread(header, sizeof(recording_header_t), 1, recording->file) == 1 &&
+                 header->magic == RECORDING_MAGIC && header->version == RECORDING_VERSION &&
+                 header->header_size == sizeof(recording_header_t) && header->keyframe_interval > 0 &&
+                 header->display_stride > 0 && header->display_planes > 0 &&
+                 header->plane_size % header->display_stride == 0 &&
+                 sizeof(uint64_t) * header->plane_size * header->display_planes <= RECORDING_DISPLAY_SIZE;
+    if (!valid || !recording_allocate(recording) || (header->index_offset && !recording_read_index(recording))) {
+        LOG_ERROR(LOG_SUBSYS_SYSTEM, "Invalid recording %s.", path);
+        recording_close(recording);
+        return false;
+    }
+    return fseek(recording->file, header->header_size, SEEK_SET) == 0;
+}
+
+static bool recording_read_index(recording_t *recording) {
+    recording_header_t *header = &recording->header;
+    recording->keyframes       = (header->frames + header->keyframe_interval - 1) / header->keyframe_interval;
+    recording->index           = malloc(sizeof(uint64_t) * (recording->keyframes ? recording->keyframes : 1));
+    if (!recording->index || fseek(recording->file, header->index_offset, SEEK_SET) != 0 ||
+        fread(recording->index, sizeof(uint64_t), recording->keyframes, recording->file) != recording->keyframes) {
+        return false;
+    }
+
+    for (uint64_t k = 0; k < recording->keyframes; ++k) {
+        if (recording->index[k] < header->header_size || recording->index[k] >= header->index_offset) return false;
+    }
+    return true;
+}
+
+bool recording_read(recording_t *recording) {
+    recording_header_t *header = &recording->header;
+    if (header->index_offset && recording->frame >= header->frames) return false;
+
+    uint8_t record[RECORDING_FRAME_HEADER];
+    if (fread(record, 1, sizeof(record), recording->file) != sizeof(record)) return false;
+
+    // Keyframes must sit exactly where the index puts them for seeking to work
+    bool     keyframe = record[0] & RECORDING_KEYFRAME;
+    uint16_t length   = record[3] | record[4] << 8;
+    if (length > RECORDING_PAYLOAD_SIZE || keyframe != (recording->frame % header->keyframe_interval == 0) ||
+        fread(recording->payload, 1, length, recording->file) != length) {
+        return false;
+    }
+
+    uint16_t size = sizeof(uint64_t) * header->plane_size * header->display_planes;
+    if (keyframe) memset(recording->display, 0, size);
+    if (!recording_decode(recording->payload, length, (uint8_t *)recording->display, size)) return false;
+
+    recording->display_width  = record[1];
+    recording->display_height = record[2];
+    recording->frame += 1;
+    return true;
+}
+
+static bool recording_decode(const uint8_t *payload, uint16_t length, uint8_t *display, uint16_t size) {
+    uint16_t p = 0;
+    uint32_t b = 0;
+    while (p < length) {
+        uint32_t skip  = 0;
+        uint32_t count = 0;
+        for (uint8_t shift = 0;; shift += 7) {
+            if (p == length || shift > 14) return false;
+            skip |= (payload[p] & 0x7F) << shift;
+            if (!(payload[p++] & 0x80)) break;
+        }
+        for (uint8_t shift = 0;; shift += 7) {
+            if (p == length || shift > 14) return false;
+            count |= (payload[p] & 0x7F) << shift;
+            if (!(payload[p++] & 0x80)) break;
+        }
+
+        b += skip;
+        if (b + count > size || p + count > length) return false;
+        for (uint32_t c = 0; c < count; ++c) display[b + c] ^= payload[p + c];
+        b += count;
+        p += count;
+    }
+    return true;
+}
+
+bool recording_seek(recording_t *recording, uint64_t frame) {
+    recording_header_t *header   = &recording->header;
+    uint64_t            keyframe = frame / header->keyframe_interval;
+    if (recording->frame == frame + 1) return true;
+
+    if (keyframe < recording->keyframes) {
+        if (fseek(recording->file, recording->index[keyframe], SEEK_SET) != 0) return false;
+        recording->frame = keyframe * header->keyframe_interval;
+    } else if (recording->frame > frame) {
+        if (fseek(recording->file, header->header_size, SEEK_SET) != 0) return false;
+        recording->frame = 0;
+    }
+
+    while (recording->frame <= frame) {
+        if (!recording_read(recording)) return false;
+    }
+    return true;
+}
+
+void recording_render(const recording_t *recording, uint8_t *buffer) {
+    const recording_header_t *header = &recording->header;
+    uint8_t                   width  = recording->display_width;
+    uint8_t                   height = recording->display_height;
+    memset(buffer, 0, width * height);
+
+    // Frames of a smaller display mode only cover the top left of the display
+    if (width > header->display_stride * DISPLAY_ROW_BITS || height > header->plane_size / header->display_stride) return;
+    for (uint8_t p = 0; p < header->display_planes; ++p) {
+        const uint64_t *plane = &recording->display[p * header->plane_size];
+        for (uint8_t y = 0; y < height; ++y) {
+            const uint64_t *row = &plane[y * header->display_stride];
+            uint8_t        *out = &buffer[y * width];
+            for (uint8_t x = 0; x < width; ++x) {
+                uint64_t word = row[x / DISPLAY_ROW_BITS];
+                out[x] |= ((word >> (DISPLAY_ROW_BITS - 1 - x % DISPLAY_ROW_BITS)) & 0x1) << p;
+            }
+        }
+    }
+}
+
+bool recording_close(recording_t *recording) {
+    bool success = true;
+    if (recording->file) {
+        if (recording->writer) {
+            // The index and the number of frames are only known once finished
+            recording_header_t *header = &recording->header;
+            header->frames             = recording->frame;
+            header->index_offset       = ftell(recording->file);
+            success &= fwrite(recording->index, sizeof(uint64_t), recording->keyframes, recording->file) ==
+                       recording->keyframes;
+            success &= fseek(recording->file, 0, SEEK_SET) == 0;
+            success &= fwrite(header, sizeof(recording_header_t), 1, recording->file) == 1;
+        }
+        success &= fclose(recording->file) == 0;
+        if (!success) LOG_ERROR(LOG_SUBSYS_SYSTEM, "Failed to finish recording.");
+    }
+
+    free(recording->display);
+    free(recording->delta);
+    free(recording->payload);
+    free(recording->index);
+    memset(recording, 0, sizeof(recording_t));
+    return success;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "chip8.h"
+
+#define RECORDING_MAGIC             0x4544495638504843ULL // "CHP8VIDE" in little-endian
+#define RECORDING_VERSION           1                     // Bumped whenever the layout changes
+#define RECORDING_KEYFRAME_INTERVAL 120                   // Frames from one keyframe to the next
+#define RECORDING_KEYFRAME          0x1                   // Flag of frames stored against an empty display
+#define RECORDING_FRAME_HEADER      5                     // Bytes in front of every frame: flags, width, height, size
+#define RECORDING_DISPLAY_SIZE      (HIRES_DISPLAY_WIDTH / 8 * HIRES_DISPLAY_HEIGHT * 4)
+#define RECORDING_PAYLOAD_SIZE      (RECORDING_DISPLAY_SIZE + 64) // Longest encoding of a single frame
+
+// Fixed header of a recording, directly followed by the frames, and by the
+// index of keyframes once the recording is finished.
+typedef struct {
+    uint64_t magic;             // Always `RECORDING_MAGIC`; also rejects foreign byte orders
+    uint32_t version;           // Always `RECORDING_VERSION`
+    uint32_t header_size;       // Size of this header in bytes
+    uint64_t frames;            // Frames in the recording; 0 until finished
+    uint64_t index_offset;      // Offset of the index of keyframes; 0 until finished
+    uint16_t frames_per_second; // Rate at which the frames were emulated
+    uint16_t keyframe_interval; // Frames from one keyframe to the next
+    uint16_t plane_size;        // Number of words making up a single plane
+    uint8_t  display_stride;    // Number of words making up a single row
+    uint8_t  display_planes;    // Number of planes in every frame
+} recording_header_t;
+
+// An open recording, either written or read.
+typedef struct {
+    FILE              *file;           // The recording
+    bool               writer;         // If the recording was created to write into
+    recording_header_t header;         // Header of the recording
+    uint64_t           frame;          // Frames written, or number of the next frame to read
+    uint64_t          *display;        // Display of the latest frame, as in `chip8_t`
+    uint8_t           *delta;          // Latest display XOR the one before it
+    uint8_t           *payload;        // Encoding of the latest frame
+    uint64_t          *index;          // Offset of every keyframe in the file
+    uint64_t           keyframes;      // Number of keyframes in the index
+    uint64_t           capacity;       // Number of offsets the index can hold
+    uint8_t            display_width;  // Width of the display mode of the latest frame
+    uint8_t            display_height; // Height of the display mode of the latest frame
+} recording_t;
+
+/**
+ * Creates a recording of the display of a CHIP-8, with its display layout.
+ *
+ * The file is written as frames arrive, so a recording that was never closed
+ * can still be read from the start, only without seeking by index.
+ *
+ * @param recording - The recording to create
+ * @param chip8 - The CHIP-8 to record
+ * @param path - The path of the recording
+ * @returns If the recording could be created
+ */
+bool recording_create(recording_t *recording, const chip8_t *chip8, const char *path);
+
+/**
+ * Appends the display of the CHIP-8 as the next frame.
+ *
+ * Every frame is stored as the XOR against the frame before it, with runs of
+ * unchanged bytes collapsed, so an unchanged frame costs only its header.
+ * Every `RECORDING_KEYFRAME_INTERVAL` frames, a keyframe is stored against an
+ * empty display instead, to be decoded without any of the frames before it.
+ *
+ * @param recording - The recording to append to
+ * @param chip8 - The CHIP-8 to record, with the same display layout as when created
+ * @returns If the frame was written
+ */
+bool recording_write(recording_t *recording, const chip8_t *chip8);
+
+/**
+ * Opens a recording to read its frames in order from the first one.
+ *
+ * @param recording - The recording to open
+ * @param path - The path of the recording
+ * @returns If the recording exists and has the expected layout
+ */
+bool recording_open(recording_t *recording, const char *path);
+
+/**
+ * Decodes the next frame into the display of the recording.
+ *
+ * @param recording - The recording to read
+ * @returns If there was a valid frame to read
+ */
+bool recording_read(recording_t *recording);
+
+/**
+ * Decodes a frame into the display of the recording, starting from the
+ * closest keyframe in front of it, so that reading continues after it.
+ *
+ * Recordings which were never closed have no index, so they are decoded from
+ * the first frame instead whenever seeking backwards.
+ *
+ * @param recording - The recording to read
+ * @param frame - The number of the frame, counting from 0
+ * @returns If the frame exists and could be decoded
+ */
+bool recording_seek(recording_t *recording, uint64_t frame);
+
+/**
+ * Unpacks the latest frame into one byte per pixel, as `chip8_render_display`.
+ *
+ * @param recording - The recording to read the display of
+ * @param buffer - The buffer to write to; must hold at least
+ * `display_width * display_height` bytes.
+ */
+void recording_render(const recording_t *recording, uint8_t *buffer);
+
+/**
+ * Closes a recording, finishing it with the index of keyframes if written.
+ *
+ * @param recording - The recording to close
+ * @returns If the recording was finished successfully
+ */
+bool recording_close(recording_t *recording);
+
+/**
+ * Allocates the buffers of a recording for its display layout.
+ *
+ * @param recording - The recording whose header is filled in
+ * @returns If the buffers could be allocated
+ */
+static bool recording_allocate(recording_t *recording);
+
+/**
+ * Collapses runs of zero bytes of a delta.
+ *
+ * The encoding is a sequence of pairs of LEB128 numbers: zero bytes to skip,
+ * followed by the number of literal bytes that follow the pair. Trailing zero
+ * bytes are left out entirely.
+ *
+ * @param delta - The delta to encode
+ * @param size - The size of the delta in bytes
+ * @param payload - Receives the encoding; must hold `RECORDING_PAYLOAD_SIZE` bytes
+ * @returns The size of the encoding in bytes
+ */
+static uint16_t recording_encode(const uint8_t *delta, uint16_t size, uint8_t *payload);
+
+/**
+ * Applies an encoded delta to a display with XOR.
+ *
+ * @param payload - The encoding of the delta
+ * @param length - The size of the encoding in bytes
+ * @param display - The display to apply the delta to
+ * @param size - The size of the display in bytes
+ * @returns If the encoding was valid for the display
+ */
+static bool recording_decode(const uint8_t *payload, uint16_t length, uint8_t *display, uint16_t size);
+
+/**
+ * Reads the index of keyframes of a finished recording.
+ *
+ * @param recording - The recording whose header was read
+ * @returns If the index is valid
+ */
+static bool recording_read_index(recording_t *recording);
@@ -0,0 +1,268 @@
+#include "rom_library.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chip8.h"
+#include "log.h"
+#include "variant.h"
+
+#define HASH_SEED       0x43484950382D3031ULL // "CHIP8-01"
+#define HASH_MULTIPLIER 0xC6A4A7935BD1E995ULL
+#define HASH_SHIFT      47
+
+uint64_t rom_hash(const uint8_t *data, size_t size) {
+    uint64_t hash = HASH_SEED ^ (size * HASH_MULTIPLIER);
+
+    size_t blocks = size / sizeof(uint64_t);
+    for (size_t b = 0; b < blocks; ++b) {
+        uint64_t k;
+        memcpy(&k, &data[b * sizeof(uint64_t)], sizeof(k));
+        k *= HASH_MULTIPLIER;
+        k ^= k >> HASH_SHIFT;
+        k *= HASH_MULTIPLIER;
+        hash ^= k;
+        hash *= HASH_MULTIPLIER;
+    }
+
+    // Fold the remaining bytes in little-endian order regardless of the host
+    const uint8_t *tail = &data[blocks * sizeof(uint64_t)];
+    size_t         rest = size % sizeof(uint64_t);
+    if (rest) {
+        for (size_t j = rest; j-- > 0;) {
+            hash ^= (uint64_t)tail[j] << (8 * j);
+        }
+        hash *= HASH_MULTIPLIER;
+    }
+
+    hash ^= hash >> HASH_SHIFT;
+    hash *= HASH_MULTIPLIER;
+    hash ^= hash >> HASH_SHIFT;
+    return hash;
+}
+
+bool rom_map(rom_file_t *rom, const char *path) {
+    memset(rom, 0, sizeof(rom_file_t));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to open ROM %s.", path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = (size_t)info.st_size;
+    if (size == 0 || size > XOCHIP_MEMORY_SIZE - PROGRAM_START) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "ROM %s has an unsupported size.", path);
+        close(fd);
+        return false;
+    }
+
+    // The mapping stays valid after closing the descriptor
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to map ROM %s.", path);
+        return false;
+    }
+
+    rom->data = data;
+    rom->size = size;
+    rom->hash = rom_hash(rom->data, rom->size);
+    return true;
+}
+
+void rom_unmap(rom_file_t *rom) {
+    if (rom->data) munmap((void *)rom->data, rom->size);
+    memset(rom, 0, sizeof(rom_file_t));
+}
+
+bool rom_load(chip8_t *chip8, const rom_file_t *rom, const rom_entry_t *entry) {
+    if (entry) {
+        if (chip8->variant != entry->variant && !chip8_set_variant(chip8, entry->variant)) {
+            return false;
+        }
+        chip8_set_quirks(chip8, entry->quirks);
+    }
+
+    return chip8_load_program(chip8, rom->data, (uint16_t)rom->size);
+}
+
+void rom_entry_init(rom_entry_t *entry, const rom_file_t *rom, const char *path) {
+    const char *name      = strrchr(path, '/');
+    const char *extension = strrchr(path, '.');
+    bool        extended  = rom->size > MEMORY_SIZE - PROGRAM_START ||
+                    (extension && strcasecmp(extension, ".xo8") == 0);
+
+    memset(entry, 0, sizeof(rom_entry_t));
+    entry->hash    = rom->hash;
+    entry->size    = (uint32_t)rom->size;
+    entry->variant = extended ? VARIANT_XOCHIP : VARIANT_CHIP8;
+    entry->quirks  = DEFAULT_QUIRKS;
+    snprintf(entry->name, sizeof(entry->name), "%s", name ? name + 1 : path);
+}
+
+bool rom_index_init(rom_index_t *index) {
+    index->entries  = calloc(ROM_INDEX_CAPACITY, sizeof(rom_entry_t));
+    index->capacity = index->entries ? ROM_INDEX_CAPACITY : 0;
+    index->count    = 0;
+    return index->entries != NULL;
+}
+
+void rom_index_free(rom_index_t *index) {
+    free(index->entries);
+    index->entries  = NULL;
+    index->capacity = 0;
+    index->count    = 0;
+}
+
+static rom_entry_t *rom_index_slot(rom_entry_t *entries, uint32_t capacity, uint64_t hash) {
+    uint32_t mask = capacity - 1;
+    for (uint32_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        if (entries[slot].size == 0 || entries[slot].hash == hash) return &entries[slot];
+    }
+}
+
+const rom_entry_t *rom_index_find(const rom_index_t *index, uint64_t hash) {
+    if (!index || index->capacity == 0) return NULL;
+
+    const rom_entry_t *slot = rom_index_slot(index->entries, index->capacity, hash);
+    return slot->size ? slot : NULL;
+}
+
+bool rom_index_put(rom_index_t *index, const rom_entry_t *entry) {
+    if (entry->size == 0) return false;
+
+    // Keep the load factor below 1/2 so probe sequences stay short
+    if ((index->count + 1) * 2 > index->capacity) {
+        uint32_t     capacity = index->capacity * 2;
+        rom_entry_t *entries  = calloc(capacity, sizeof(rom_entry_t));
+        if (!entries) return false;
+
+        for (uint32_t j = 0; j < index->capacity; ++j) {
+            if (index->entries[j].size == 0) continue;
+            *rom_index_slot(entries, capacity, index->entries[j].hash) = index->entries[j];
+        }
+
+        free(index->entries);
+        index->entries  = entries;
+        index->capacity = capacity;
+    }
+
+    rom_entry_t *slot = rom_index_slot(index->entries, index->capacity, entry->hash);
+    if (slot->size == 0) index->count++;
+    *slot = *entry;
+    return true;
+}
+
+bool rom_index_load(rom_index_t *index, const char *path) {
+    FILE *infile = fopen(path, "r");
+    if (!infile) return false;
+
+    char line[256];
+    while (fgets(line, sizeof(line), infile)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+
+        rom_entry_t  entry = {0};
+        char         variant[16];
+        unsigned int quirks;
+        int          parsed = sscanf(
+            line,
+            "%" SCNx64 " %" SCNu32 " %15s %x %63[^\n]",
+            &entry.hash,
+            &entry.size,
+            variant,
+            &quirks,
+            entry.name
+        );
+        if (parsed < 4) {
+            LOG_WARN(LOG_SUBSYS_SYSTEM, "Skipping malformed index line in %s.", path);
+            continue;
+        }
+
+        entry.variant = variant_by_name(variant);
+        entry.quirks  = quirks & QUIRK_ALL;
+        if (entry.variant == VARIANT_COUNT) continue;
+        if (!rom_index_put(index, &entry)) {
+            fclose(infile);
+            return false;
+        }
+    }
+
+    fclose(infile);
+    return true;
+}
+
+bool rom_index_save(const rom_index_t *index, const char *path) {
+    char temporary[4096];
+    int  length = snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    if (length < 0 || (size_t)length >= sizeof(temporary)) return false;
+
+    FILE *outfile = fopen(temporary, "w");
+    if (!outfile) return false;
+
+    fprintf(outfile, "%s\n", ROM_INDEX_HEADER);
+    fprintf(outfile, "# hash size variant quirks name\n");
+    for (uint32_t j = 0; j < index->capacity; ++j) {
+        const rom_entry_t *entry = &index->entries[j];
+        if (entry->size == 0) continue;
+        fprintf(
+            outfile,
+            "%016" PRIx64 " %" PRIu32 " %s %x %s\n",
+            entry->hash,
+            entry->size,
+            variant_get(entry->variant).name,
+            entry->quirks,
+            entry->name
+        );
+    }
+
+    bool failed = ferror(outfile);
+    if (fclose(outfile) != 0 || failed || rename(temporary, path) != 0) {
+        remove(temporary);
+        return false;
+    }
+    return true;
+}
+
+int rom_index_scan(rom_index_t *index, const char *directory) {
+    DIR *dir = opendir(directory);
+    if (!dir) return -1;
+
+    int            added = 0;
+    struct dirent *file;
+    while ((file = readdir(dir))) {
+        if (file->d_name[0] == '.') continue;
+
+        char path[4096];
+        int  length = snprintf(path, sizeof(path), "%s/%s", directory, file->d_name);
+        if (length < 0 || (size_t)length >= sizeof(path)) continue;
+
+        rom_file_t rom;
+        if (!rom_map(&rom, path)) continue;
+
+        if (!rom_index_find(index, rom.hash)) {
+            rom_entry_t entry;
+            rom_entry_init(&entry, &rom, path);
+            if (rom_index_put(index, &entry)) added++;
+        }
+
+        rom_unmap(&rom);
+    }
+
+    closedir(dir);
+    return added;
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chip8.h"
+#include "variant.h"
+
+#define ROM_NAME_SIZE      64  // Longest stored ROM name, including terminator
+#define ROM_INDEX_CAPACITY 256 // Initial number of slots in an index
+#define ROM_INDEX_HEADER   "# chip8 rom index v1"
+
+// A ROM mapped read-only into memory.
+typedef struct {
+    const uint8_t *data; // Contents of the ROM
+    size_t         size; // Size of the ROM in bytes
+    uint64_t       hash; // Content hash of the ROM
+} rom_file_t;
+
+// The settings required to correctly run a single ROM.
+typedef struct {
+    uint64_t       hash;                // Content hash of the ROM
+    uint32_t       size;                // Size of the ROM in bytes; 0 marks an empty slot
+    variant_type_t variant;             // Platform variant the ROM targets
+    uint8_t        quirks;              // Bitmask of `chip8_quirk_t` the ROM expects
+    char           name[ROM_NAME_SIZE]; // File name of the ROM
+} rom_entry_t;
+
+// An open-addressed hash table of ROM entries, keyed by content hash.
+typedef struct {
+    rom_entry_t *entries;  // Slots of the table
+    uint32_t     capacity; // Number of slots; always a power of two
+    uint32_t     count;    // Number of occupied slots
+} rom_index_t;
+
+/**
+ * Computes the content hash of a ROM.
+ *
+ * Consumes the ROM 8 bytes at a time using the MurmurHash64A mixing function,
+ * which is fast enough to hash an entire library on every scan.
+ *
+ * @param data - The contents of the ROM
+ * @param size - The size of the ROM
+ * @returns The 64-bit hash of the contents
+ */
+uint64_t rom_hash(const uint8_t *data, size_t size);
+
+/**
+ * Maps a ROM file into memory and computes its hash.
+ *
+ * Fails for empty files, and files too large to fit in the memory of any
+ * supported variant, so a successfully mapped ROM can always be loaded.
+ *
+ * @param rom - The ROM to map the file into
+ * @param path - The path of the ROM file
+ * @returns If the ROM was mapped successfully
+ */
+bool rom_map(rom_file_t *rom, const char *path);
+
+/**
+ * Unmaps a previously mapped ROM.
+ *
+ * @param rom - The ROM to unmap
+ */
+void rom_unmap(rom_file_t *rom);
+
+/**
+ * Loads a mapped ROM into the CHIP-8, applying its profile.
+ *
+ * If an entry is provided, the CHIP-8 is switched to the variant and quirks
+ * recorded within it before the ROM is loaded.
+ *
+ * @param chip8 - The CHIP-8 to load the ROM into
+ * @param rom - The ROM to load
+ * @param entry - The profile of the ROM, or NULL to keep the current settings
+ * @returns If the ROM was loaded successfully
+ */
+bool rom_load(chip8_t *chip8, const rom_file_t *rom, const rom_entry_t *entry);
+
+/**
+ * Creates the default profile for a ROM.
+ *
+ * The profile receives the default quirks, and the XO-CHIP variant if the
+ * ROM has an `.xo8` extension or does not fit in the memory of the classic
+ * CHIP-8.
+ *
+ * @param entry - The entry to initialize
+ * @param rom - The ROM to create the profile for
+ * @param path - The path of the ROM, of which the file name is stored
+ */
+void rom_entry_init(rom_entry_t *entry, const rom_file_t *rom, const char *path);
+
+/**
+ * Initializes an empty ROM index.
+ *
+ * @param index - The index to initialize
+ * @returns If the index could be allocated
+ */
+bool rom_index_init(rom_index_t *index);
+
+/**
+ * Releases the memory allocated for a ROM index.
+ *
+ * @param index - The index to release
+ */
+void rom_index_free(rom_index_t *index);
+
+/**
+ * Finds the entry of a ROM by its content hash.
+ *
+ * @param index - The index to search
+ * @param hash - The content hash of the ROM
+ * @returns The entry of the ROM, or NULL if the ROM is not indexed
+ */
+const rom_entry_t *rom_index_find(const rom_index_t *index, uint64_t hash);
+
+/**
+ * Inserts an entry into the index, replacing any entry with the same hash.
+ *
+ * @param index - The index to insert into
+ * @param entry - The entry to insert
+ * @returns If the entry was inserted successfully
+ */
+bool rom_index_put(rom_index_t *index, const rom_entry_t *entry);
+
+/**
+ * Reads entries from an index file into the index.
+ *
+ * @param index - The index to read the entries into
+ * @param path - The path of the index file
+ * @returns If the index file was read successfully
+ */
+bool rom_index_load(rom_index_t *index, const char *path);
+
+/**
+ * Writes all entries of the index to an index file.
+ *
+ * The file is written next to the destination and renamed over it, so a
+ * failed write never leaves a truncated index behind.
+ *
+ * @param index - The index to write
+ * @param path - The path of the index file
+ * @returns If the index file was written successfully
+ */
+bool rom_index_save(const rom_index_t *index, const char *path);
+
+/**
+ * Scans a directory for ROMs, adding any unknown ROM to the index.
+ *
+ * New ROMs receive their default profile, as created by `rom_entry_init`.
+ * Entries of already indexed ROMs are left untouched.
+ *
+ * @param index - The index to add the ROMs to
+ * @param directory - The path of the directory to scan
+ * @returns The number of added ROMs, or -1 if the directory could not be read
+ */
+int rom_index_scan(rom_index_t *index, const char *directory);
+
+/**
+ * Finds the slot for a hash using linear probing.
+ *
+ * @param entries - The slots of the table
+ * @param capacity - The number of slots; must be a power of two
+ * @param hash - The hash to search for
+ * @returns The slot holding the hash, or the empty slot it should go into
+ */
+static rom_entry_t *rom_index_slot(rom_entry_t *entries, uint32_t capacity, uint64_t hash);
@@ -0,0 +1,172 @@
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chip8.h"
+#include "font.h"
+#include "log.h"
+#include "rom_library.h"
+#include "variant.h"
+
+// Everything after the checksum is covered by it
+#define CHECKSUM_START (offsetof(snapshot_header_t, checksum) + sizeof(uint64_t))
+
+static uint64_t snapshot_checksum(const snapshot_header_t *header, const uint8_t *memory, const uint8_t *display) {
+    uint64_t hash = rom_hash((const uint8_t *)header + CHECKSUM_START, sizeof(snapshot_header_t) - CHECKSUM_START);
+    hash ^= rom_hash(memory, header->memory_size) * 3;
+    hash ^= rom_hash(display, header->display_size) * 5;
+    return hash;
+}
+
+bool snapshot_save(const chip8_t *chip8, uint64_t rom_hash, const char *path) {
+    // Padding is zeroed so that it hashes identically when resumed
+    snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic         = SNAPSHOT_MAGIC;
+    header.version       = SNAPSHOT_VERSION;
+    header.header_size   = sizeof(snapshot_header_t);
+    header.rom_hash      = rom_hash;
+    header.memory_size   = chip8->memory_size;
+    header.display_size  = sizeof(uint64_t) * chip8->plane_size * chip8->display_planes;
+    header.pc            = chip8->pc;
+    header.i             = chip8->i;
+    header.key_wait      = chip8->key_wait;
+    header.stack_pointer = chip8->stack_pointer;
+    header.delay_timer   = chip8->delay_timer;
+    header.sound_timer   = chip8->sound_timer;
+    header.planes        = chip8->planes;
+    header.pitch         = chip8->pitch;
+    header.hires         = chip8->hires;
+    header.variant       = chip8->variant;
+    header.quirks        = chip8->quirks;
+    header.font          = chip8->font;
+    header.playing_sound = chip8->playing_sound;
+    header.rng           = chip8->rng;
+    memcpy(header.stack, chip8->stack, sizeof(header.stack));
+    memcpy(header.v, chip8->v, sizeof(header.v));
+    memcpy(header.audio_pattern, chip8->audio_pattern, sizeof(header.audio_pattern));
+    header.checksum = snapshot_checksum(&header, chip8->memory, (const uint8_t *)chip8->display);
+
+    char temporary[4096];
+    int  length = snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    if (length < 0 || (size_t)length >= sizeof(temporary)) return false;
+
+    FILE *outfile = fopen(temporary, "wb");
+    if (!outfile) {
+        LOG_ERROR(LOG_SUBSYS_SYSTEM, "Failed to create snapshot %s.", path);
+        return false;
+    }
+
+    fwrite(&header, sizeof(header), 1, outfile);
+    fwrite(chip8->memory, 1, header.memory_size, outfile);
+    fwrite(chip8->display, 1, header.display_size, outfile);
+
+    bool failed = ferror(outfile);
+    if (fclose(outfile) != 0 || failed || rename(temporary, path) != 0) {
+        LOG_ERROR(LOG_SUBSYS_SYSTEM, "Failed to write snapshot %s.", path);
+        remove(temporary);
+        return false;
+    }
+    return true;
+}
+
+static bool snapshot_validate(const uint8_t *data, size_t size, uint64_t rom_hash) {
+    if (size < sizeof(snapshot_header_t)) return false;
+
+    snapshot_header_t header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION ||
+        header.header_size != sizeof(snapshot_header_t)) {
+        LOG_WARN(LOG_SUBSYS_SYSTEM, "Snapshot has an unsupported format.");
+        return false;
+    }
+    if (header.rom_hash != rom_hash) {
+        LOG_WARN(LOG_SUBSYS_SYSTEM, "Snapshot belongs to a different ROM.");
+        return false;
+    }
+
+    // Sizes must match the variant exactly, as they are restored verbatim
+    variant_data_t variant = header.variant < VARIANT_COUNT ? variant_get(header.variant) : (variant_data_t){0};
+    uint32_t       display = sizeof(uint64_t) * (variant.display_width / DISPLAY_ROW_BITS) *
+                       variant.display_height * variant.display_planes;
+    if (!variant.name || header.memory_size != variant.memory_size || header.display_size != display ||
+        size != (size_t)header.header_size + header.memory_size + header.display_size) {
+        LOG_WARN(LOG_SUBSYS_SYSTEM, "Snapshot does not match its variant.");
+        return false;
+    }
+    if (header.pc >= header.memory_size || header.stack_pointer < -1 || header.stack_pointer >= STACK_SIZE ||
+        header.font >= FONT_COUNT || (header.hires && header.variant != VARIANT_XOCHIP)) {
+        LOG_WARN(LOG_SUBSYS_SYSTEM, "Snapshot contains an invalid state.");
+        return false;
+    }
+
+    const uint8_t *memory = &data[header.header_size];
+    if (snapshot_checksum(&header, memory, &memory[header.memory_size]) != header.checksum) {
+        LOG_WARN(LOG_SUBSYS_SYSTEM, "Snapshot is corrupted.");
+        return false;
+    }
+    return true;
+}
+
+bool snapshot_resume(chip8_t *chip8, uint64_t rom_hash, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    // The mapping stays valid after closing the descriptor
+    size_t size = (size_t)info.st_size;
+    void  *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERROR(LOG_SUBSYS_SYSTEM, "Failed to map snapshot %s.", path);
+        return false;
+    }
+
+    bool restored = snapshot_validate(data, size, rom_hash);
+    if (restored) {
+        snapshot_header_t header;
+        memcpy(&header, data, sizeof(header));
+
+        // Switching variants only reallocates when the variant changed
+        restored = header.variant == chip8->variant || chip8_set_variant(chip8, header.variant);
+        if (restored) {
+            const uint8_t *memory = (const uint8_t *)data + header.header_size;
+            memcpy(chip8->memory, memory, header.memory_size);
+            memcpy(chip8->display, &memory[header.memory_size], header.display_size);
+            memcpy(chip8->stack, header.stack, sizeof(chip8->stack));
+            memcpy(chip8->v, header.v, sizeof(chip8->v));
+            memcpy(chip8->audio_pattern, header.audio_pattern, sizeof(chip8->audio_pattern));
+            memset(chip8->fusions, 0, sizeof(chip8->fusions));
+            chip8->pc             = header.pc;
+            chip8->i              = header.i;
+            chip8->key_wait       = header.key_wait;
+            chip8->stack_pointer  = header.stack_pointer;
+            chip8->delay_timer    = header.delay_timer;
+            chip8->sound_timer    = header.sound_timer;
+            chip8->planes         = header.planes;
+            chip8->pitch          = header.pitch;
+            chip8->hires          = header.hires;
+            chip8->display_width  = header.hires ? HIRES_DISPLAY_WIDTH : DISPLAY_WIDTH;
+            chip8->display_height = header.hires ? HIRES_DISPLAY_HEIGHT : DISPLAY_HEIGHT;
+            chip8->quirks         = header.quirks & QUIRK_ALL;
+            chip8->font           = header.font;
+            chip8->playing_sound  = header.playing_sound;
+            chip8->rng            = header.rng ? header.rng : DEFAULT_RNG_SEED;
+            chip8_rehash(chip8);
+        }
+    }
+
+    munmap(data, size);
+    return restored;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chip8.h"
+
+#define SNAPSHOT_MAGIC   0x50414E5338504843ULL // "CHP8SNAP" in little-endian
+#define SNAPSHOT_VERSION 2                     // Bumped whenever the layout changes
+
+// Fixed header of a snapshot file, directly followed by memory and display.
+typedef struct {
+    uint64_t magic;                             // Always `SNAPSHOT_MAGIC`; also rejects foreign byte orders
+    uint32_t version;                           // Always `SNAPSHOT_VERSION`
+    uint32_t header_size;                       // Size of this header in bytes
+    uint64_t checksum;                          // Hash of everything in the file after this field
+    uint64_t rom_hash;                          // Content hash of the ROM the state belongs to
+    uint32_t memory_size;                       // Size of the memory following the header
+    uint32_t display_size;                      // Size of the display following the memory
+    uint16_t pc;                                // Current memory address
+    uint16_t i;                                 // Arbitrary address within memory
+    uint16_t key_wait;                          // Keys pressed while waiting in 0xFX0A
+    uint16_t stack[16];                         // Subroutine return addresses
+    uint8_t  v[16];                             // Arbitrary variable registers
+    int8_t   stack_pointer;                     // Current position within stack
+    uint8_t  delay_timer;                       // Value of delay timer
+    uint8_t  sound_timer;                       // Value of sound timer
+    uint8_t  planes;                            // Bitmask of planes selected for drawing
+    uint8_t  pitch;                             // Playback rate of the audio pattern
+    uint8_t  hires;                             // If the high resolution mode is active
+    uint8_t  variant;                           // Active platform variant
+    uint8_t  quirks;                            // Bitmask of enabled quirks
+    uint8_t  font;                              // Active font
+    uint8_t  playing_sound;                     // If sound is currently being played
+    uint8_t  audio_pattern[AUDIO_PATTERN_SIZE]; // 1-bit audio samples
+    uint64_t rng;                               // State of the built-in random number generator
+} snapshot_header_t;
+
+/**
+ * Writes the full state of the CHIP-8 into a snapshot file.
+ *
+ * The file is written next to the destination and renamed over it, so a
+ * snapshot is never left half-written, even if the process is killed while
+ * saving. A random number generator installed through `chip8_set_rng` is not
+ * part of the snapshot.
+ *
+ * @param chip8 - The CHIP-8 to save
+ * @param rom_hash - The content hash of the loaded ROM
+ * @param path - The path of the snapshot file
+ * @returns If the snapshot was saved successfully
+ */
+bool snapshot_save(const chip8_t *chip8, uint64_t rom_hash, const char *path);
+
+/**
+ * Restores the CHIP-8 from a snapshot file.
+ *
+ * The file is mapped into memory and validated in full before the CHIP-8 is
+ * touched, so stale snapshots of another ROM or format version, and corrupted
+ * or truncated files, leave the CHIP-8 unchanged.
+ *
+ * @param chip8 - The initialized CHIP-8 to restore
+ * @param rom_hash - The content hash of the ROM the snapshot must belong to
+ * @param path - The path of the snapshot file
+ * @returns If the snapshot was restored successfully
+ */
+bool snapshot_resume(chip8_t *chip8, uint64_t rom_hash, const char *path);
+
+/**
+ * Checks if a mapped snapshot can be restored.
+ *
+ * @param data - The contents of the snapshot file
+ * @param size - The size of the snapshot file
+ * @param rom_hash - The content hash of the ROM the snapshot must belong to
+ * @returns If the snapshot is valid
+ */
+static bool snapshot_validate(const uint8_t *data, size_t size, uint64_t rom_hash);
+
+/**
+ * Hashes the contents of a snapshot covered by its checksum.
+ *
+ * @param header - The header of the snapshot
+ * @param memory - The memory of the snapshot
+ * @param display - The display of the snapshot
+ * @returns The checksum of the snapshot
+ */
+static uint64_t snapshot_checksum(const snapshot_header_t *header, const uint8_t *memory, const uint8_t *display);
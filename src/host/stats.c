@@ -0,0 +1,63 @@
+#include "stats.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+// The statistics last published, guarded by a sequence which is odd while
+// they are being written, so readers retry rather than wait
+static chip8_stats_t published;
+static uint32_t      published_sequence;
+
+static uint32_t stats_rate(uint64_t amount, uint64_t count) {
+    return count ? (uint32_t)((amount + count / 2) / count) : 0;
+}
+
+void stats_interval(chip8_stats_t *stats, chip8_stats_t *start) {
+    uint64_t elapsed  = stats->time - start->time;
+    uint64_t emulated = stats->frames_emulated - start->frames_emulated;
+
+    stats->ips           = stats_rate((stats->instructions - start->instructions) * STATS_SECOND, elapsed);
+    stats->fps           = stats_rate((stats->frames_presented - start->frames_presented) * STATS_SECOND, elapsed);
+    stats->frame_emulate = stats_rate(stats->emulate_time - start->emulate_time, emulated);
+    stats->frame_sleep   = stats_rate(stats->sleep_time - start->sleep_time, emulated);
+    stats->frame_render  = stats_rate(stats->render_time - start->render_time, stats->draw_calls - start->draw_calls);
+    *start               = *stats;
+}
+
+void stats_publish(const chip8_stats_t *stats) {
+    uint32_t sequence = __atomic_load_n(&published_sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&published_sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    published = *stats;
+    __atomic_store_n(&published_sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+bool stats_query(chip8_stats_t *stats) {
+    uint32_t sequence;
+    do {
+        sequence = __atomic_load_n(&published_sequence, __ATOMIC_ACQUIRE);
+        *stats   = published;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (sequence & 1 || sequence != __atomic_load_n(&published_sequence, __ATOMIC_RELAXED));
+    return sequence != 0;
+}
+
+size_t stats_format_line(const chip8_stats_t *stats, char *buffer, size_t size) {
+    int length = snprintf(buffer, size,
+                          "{\"time\":%" PRIu64 ",\"instructions\":%" PRIu64 ",\"ips\":%" PRIu32
+                          ",\"frames_emulated\":%" PRIu64 ",\"frames_presented\":%" PRIu64 ",\"frames_skipped\":%" PRIu64
+                          ",\"fps\":%" PRIu32 ",\"draw_calls\":%" PRIu64 ",\"emulate_us\":%" PRIu32
+                          ",\"render_us\":%" PRIu32 ",\"sleep_us\":%" PRIu32 ",\"audio_underruns\":%" PRIu64 "}\n",
+                          stats->time, stats->instructions, stats->ips, stats->frames_emulated, stats->frames_presented,
+                          stats->frames_skipped, stats->fps, stats->draw_calls, stats->frame_emulate,
+                          stats->frame_render, stats->frame_sleep, stats->audio_underruns);
+    return length > 0 ? (size_t)length : 0;
+}
+
+size_t stats_format_overlay(const chip8_stats_t *stats, char *buffer, size_t size) {
+    // Times are shown in milliseconds per frame, as frame budgets are
+    int length = snprintf(buffer, size, "%" PRIu32 " IPS %" PRIu32 " FPS\nEMU %.2f DRAW %.2f\nIDLE %.2f MS\nSKIP %" PRIu64 " XRUN %" PRIu64,
+                          stats->ips, stats->fps, stats->frame_emulate / 1000.0, stats->frame_render / 1000.0,
+                          stats->frame_sleep / 1000.0, stats->frames_skipped, stats->audio_underruns);
+    return length > 0 ? (size_t)length : 0;
+}
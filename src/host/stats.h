@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define STATS_SECOND    1000000 // 1 second in microseconds
+#define STATS_INTERVAL  1000000 // Microseconds over which the rates are derived
+#define STATS_LINE_SIZE 512     // Bytes a formatted line or overlay may take, including the terminator
+
+// Runtime statistics of an emulator. The totals are accumulated by the
+// emulation and the host loop, while the rates are derived from the totals
+// over the latest interval.
+typedef struct {
+    uint64_t time;             // Microseconds since the statistics were started
+    uint64_t instructions;     // Instructions executed, as counted by the core
+    uint64_t frames_emulated;  // Frames completed by the emulation
+    uint64_t frames_presented; // Completed frames taken up for presenting
+    uint64_t frames_skipped;   // Completed frames replaced by newer ones before being presented
+    uint64_t draw_calls;       // Frames drawn by the platform
+    uint64_t audio_underruns;  // Times the audio output ran out of samples
+    uint64_t emulate_time;     // Microseconds spent emulating
+    uint64_t render_time;      // Microseconds spent drawing
+    uint64_t sleep_time;       // Microseconds the emulation waited for its next slice
+    uint32_t ips;              // Instructions executed per second
+    uint32_t fps;              // Frames presented per second
+    uint32_t frame_emulate;    // Microseconds per emulated frame spent emulating
+    uint32_t frame_render;     // Microseconds per draw call spent drawing
+    uint32_t frame_sleep;      // Microseconds per emulated frame spent waiting
+} chip8_stats_t;
+
+/**
+ * Completes an interval, deriving the rates over it from the totals.
+ *
+ * @param stats - The statistics at the end of the interval, receiving the rates
+ * @param start - The statistics at the start of the interval, replaced with
+ * those at its end to start the next interval
+ */
+void stats_interval(chip8_stats_t *stats, chip8_stats_t *start);
+
+/**
+ * Publishes the statistics at the end of an interval, for querying from any
+ * thread. Only the host loop deriving the rates publishes them.
+ *
+ * @param stats - The statistics to publish
+ */
+void stats_publish(const chip8_stats_t *stats);
+
+/**
+ * Queries the statistics last published, without waiting for the host loop.
+ *
+ * @param stats - Receives the statistics
+ * @returns If any statistics were published yet
+ */
+bool stats_query(chip8_stats_t *stats);
+
+/**
+ * Formats the statistics as a single line of JSON, for monitoring.
+ *
+ * @param stats - The statistics to format
+ * @param buffer - Receives the line, ending with a line feed
+ * @param size - The size of the buffer in bytes
+ * @returns The length of the line, which was cut short if not less than the size
+ */
+size_t stats_format_line(const chip8_stats_t *stats, char *buffer, size_t size);
+
+/**
+ * Formats the rates of the statistics as a few short lines of text, for
+ * showing over the display.
+ *
+ * @param stats - The statistics to format
+ * @param buffer - Receives the text
+ * @param size - The size of the buffer in bytes
+ * @returns The length of the text, which was cut short if not less than the size
+ */
+size_t stats_format_overlay(const chip8_stats_t *stats, char *buffer, size_t size);
+
+/**
+ * Divides two totals accumulated over an interval, rounding to the nearest.
+ *
+ * @param amount - The amount accumulated
+ * @param count - The count to divide by
+ * @returns The quotient, or 0 if nothing was counted
+ */
+static uint32_t stats_rate(uint64_t amount, uint64_t count);
@@ -0,0 +1,323 @@
+#include "stream.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "log.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // Writes to closed connections are kept from raising SIGPIPE by SO_NOSIGPIPE instead
+#endif
+
+bool stream_server_open(stream_server_t *server, uint16_t port) {
+    memset(server, 0, sizeof(stream_server_t));
+    for (uint8_t c = 0; c < STREAM_MAX_CLIENTS; ++c) server->clients[c].socket = -1;
+
+    server->socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->socket < 0) {
+        LOG_ERROR(LOG_SUBSYS_SYSTEM, "Failed to create the server socket.");
+        return false;
+    }
+
+    // Restarting the server must not wait for connections of the previous one
+    int                enable  = 1;
+    struct sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_ANY)};
+    socklen_t          length  = sizeof(address);
+    setsockopt(server->socket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    if (bind(server->socket, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(server->socket, STREAM_MAX_CLIENTS) != 0 ||
+        getsockname(server->socket, (struct sockaddr *)&address, &length) != 0 ||
+        fcntl(server->socket, F_SETFL, O_NONBLOCK) != 0) {
+        LOG_ERROR(LOG_SUBSYS_SYSTEM, "Failed to listen on port %u.", port);
+        close(server->socket);
+        server->socket = -1;
+        return false;
+    }
+    server->port = ntohs(address.sin_port);
+    return true;
+}
+
+void stream_server_close(stream_server_t *server) {
+    for (uint8_t c = 0; c < STREAM_MAX_CLIENTS; ++c) {
+        stream_client_t *client = &server->clients[c];
+        if (client->socket < 0) continue;
+
+        // Whatever the connection still takes is written out before disconnecting
+        stream_flush(server, client);
+        if (client->socket >= 0) stream_disconnect(client);
+    }
+    if (server->socket >= 0) close(server->socket);
+    server->socket = -1;
+}
+
+void stream_server_poll(stream_server_t *server) {
+    int socket;
+    while ((socket = accept(server->socket, NULL, NULL)) >= 0) {
+        stream_client_t *client = NULL;
+        for (uint8_t c = 0; c < STREAM_MAX_CLIENTS && !client; ++c) {
+            if (server->clients[c].socket < 0) client = &server->clients[c];
+        }
+        if (!client) {
+            close(socket);
+            continue;
+        }
+
+        // Frames are tiny and latency matters, so they are never held back
+        // to be coalesced with later writes
+        int enable = 1;
+        fcntl(socket, F_SETFL, O_NONBLOCK);
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+#ifdef SO_NOSIGPIPE
+        setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+        client->socket   = socket;
+        client->blocked  = false;
+        client->stale    = true;
+        client->keys     = 0;
+        client->pending  = 0;
+        client->received = 0;
+
+        uint8_t hello[STREAM_HEADER_SIZE + 5] = {
+            STREAM_HELLO, 5, 0, STREAM_MAGIC & 0xFF, STREAM_MAGIC >> 8 & 0xFF, STREAM_MAGIC >> 16 & 0xFF,
+            STREAM_MAGIC >> 24, STREAM_VERSION,
+        };
+        uint8_t sound[STREAM_HEADER_SIZE + 1] = {STREAM_SOUND, 1, 0, server->playing};
+        stream_queue(client, hello, sizeof(hello));
+        stream_queue(client, sound, sizeof(sound));
+    }
+
+    server->keypad = 0;
+    for (uint8_t c = 0; c < STREAM_MAX_CLIENTS; ++c) {
+        stream_client_t *client = &server->clients[c];
+        if (client->socket >= 0) stream_receive(client);
+        if (client->socket >= 0) stream_flush(server, client);
+        if (client->socket >= 0) server->keypad |= client->keys;
+    }
+}
+
+void stream_server_frame(stream_server_t *server, const uint8_t *pixels, uint8_t width, uint8_t height) {
+    // Changing the display mode redraws every row
+    uint64_t rows = 0;
+    if (width != server->width || height != server->height) {
+        rows = height < 64 ? (1ULL << height) - 1 : ~0ULL;
+    } else {
+        for (uint8_t y = 0; y < height; ++y) {
+            if (memcmp(&pixels[y * width], &server->pixels[y * width], width) != 0) rows |= 1ULL << y;
+        }
+    }
+    memcpy(server->pixels, pixels, width * height);
+    server->width  = width;
+    server->height = height;
+    if (!rows) return;
+
+    size_t size = stream_encode_frame(server->message, pixels, width, height, rows);
+    for (uint8_t c = 0; c < STREAM_MAX_CLIENTS; ++c) {
+        stream_client_t *client = &server->clients[c];
+        if (client->socket < 0) continue;
+
+        if (client->blocked) client->stale = true;
+        if (!client->stale) stream_queue(client, server->message, size);
+        if (client->socket >= 0) stream_flush(server, client);
+    }
+}
+
+void stream_server_sound(stream_server_t *server, bool playing) {
+    if (playing == server->playing) return;
+    server->playing = playing;
+
+    uint8_t message[STREAM_HEADER_SIZE + 1] = {STREAM_SOUND, 1, 0, playing};
+    for (uint8_t c = 0; c < STREAM_MAX_CLIENTS; ++c) {
+        stream_client_t *client = &server->clients[c];
+        if (client->socket >= 0) stream_queue(client, message, sizeof(message));
+    }
+}
+
+size_t stream_encode_keys(uint16_t keys, uint8_t *message) {
+    message[0] = STREAM_KEYS;
+    message[1] = 2;
+    message[2] = 0;
+    message[3] = keys & 0xFF;
+    message[4] = keys >> 8;
+    return STREAM_HEADER_SIZE + 2;
+}
+
+static size_t stream_encode_frame(uint8_t *message, const uint8_t *pixels, uint8_t width, uint8_t height,
+                                  uint64_t rows) {
+    // Pixels take as few bits as the colors in the rows included require
+    uint8_t colors = 0;
+    for (uint8_t y = 0; y < height; ++y) {
+        if (!(rows >> y & 1)) continue;
+        for (uint8_t x = 0; x < width; ++x) colors |= pixels[y * width + x];
+    }
+    uint8_t depth = colors & 0xC ? 4 : colors & 0x2 ? 2 : 1;
+    uint8_t mask  = (1 << depth) - 1;
+
+    message[0] = STREAM_FRAME;
+    message[3] = width;
+    message[4] = height;
+    message[5] = depth;
+    for (uint8_t b = 0; b < 8; ++b) message[6 + b] = rows >> (b * 8) & 0xFF;
+
+    size_t size = STREAM_HEADER_SIZE + 11;
+    for (uint8_t y = 0; y < height; ++y) {
+        if (!(rows >> y & 1)) continue;
+
+        uint8_t byte   = 0;
+        uint8_t filled = 0;
+        for (uint8_t x = 0; x < width; ++x) {
+            byte = byte << depth | (pixels[y * width + x] & mask);
+            filled += depth;
+            if (filled == 8) {
+                message[size++] = byte;
+                byte            = 0;
+                filled          = 0;
+            }
+        }
+        if (filled) message[size++] = byte << (8 - filled);
+    }
+
+    uint16_t payload = size - STREAM_HEADER_SIZE;
+    message[1]       = payload & 0xFF;
+    message[2]       = payload >> 8;
+    return size;
+}
+
+bool stream_decode(stream_view_t *view, const uint8_t *data, size_t size, size_t *used) {
+    *used = 0;
+    if (size < STREAM_HEADER_SIZE) return true;
+    uint16_t length = data[1] | data[2] << 8;
+    if (size < STREAM_HEADER_SIZE + (size_t)length) return true;
+
+    const uint8_t *payload = &data[STREAM_HEADER_SIZE];
+    if (data[0] == STREAM_HELLO) {
+        if (length != 5) return false;
+        uint32_t magic = payload[0] | payload[1] << 8 | payload[2] << 16 | (uint32_t)payload[3] << 24;
+        if (magic != STREAM_MAGIC || payload[4] != STREAM_VERSION) return false;
+        view->connected = true;
+    } else if (!view->connected) {
+        return false;
+    } else if (data[0] == STREAM_SOUND) {
+        if (length != 1) return false;
+        view->playing = payload[0] != 0;
+    } else if (data[0] == STREAM_FRAME) {
+        if (length < 11) return false;
+        uint8_t  width  = payload[0];
+        uint8_t  height = payload[1];
+        uint8_t  depth  = payload[2];
+        uint64_t rows   = 0;
+        for (uint8_t b = 0; b < 8; ++b) rows |= (uint64_t)payload[3 + b] << (b * 8);
+
+        uint16_t row_size = (width * depth + 7) / 8;
+        if (width == 0 || width > HIRES_DISPLAY_WIDTH || height == 0 || height > HIRES_DISPLAY_HEIGHT ||
+            (depth != 1 && depth != 2 && depth != 4) || (height < 64 && rows >> height) ||
+            length != 11 + __builtin_popcountll(rows) * row_size) {
+            return false;
+        }
+
+        if (width != view->width || height != view->height) {
+            memset(view->pixels, 0, sizeof(view->pixels));
+            view->width  = width;
+            view->height = height;
+        }
+        const uint8_t *packed = &payload[11];
+        uint8_t        mask   = (1 << depth) - 1;
+        for (uint8_t y = 0; y < height; ++y) {
+            if (!(rows >> y & 1)) continue;
+            for (uint8_t x = 0; x < width; ++x) {
+                uint16_t bit                 = x * depth;
+                view->pixels[y * width + x] = packed[bit / 8] >> (8 - depth - bit % 8) & mask;
+            }
+            packed += row_size;
+        }
+        view->frames += 1;
+        view->dirty_rows = rows;
+    } else {
+        return false;
+    }
+
+    *used = STREAM_HEADER_SIZE + length;
+    return true;
+}
+
+static void stream_queue(stream_client_t *client, const uint8_t *data, size_t size) {
+    if (client->pending + size > STREAM_QUEUE_SIZE) {
+        LOG_WARN(LOG_SUBSYS_SYSTEM, "Dropping a client which stopped receiving.");
+        stream_disconnect(client);
+        return;
+    }
+    memcpy(&client->queue[client->pending], data, size);
+    client->pending += size;
+}
+
+static void stream_flush(stream_server_t *server, stream_client_t *client) {
+    for (;;) {
+        size_t sent = 0;
+        while (sent < client->pending) {
+            ssize_t written = send(client->socket, &client->queue[sent], client->pending - sent, MSG_NOSIGNAL);
+            if (written > 0) {
+                sent += written;
+            } else if (written < 0 && errno == EINTR) {
+                continue;
+            } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                stream_disconnect(client);
+                return;
+            }
+        }
+        memmove(client->queue, &client->queue[sent], client->pending - sent);
+        client->pending -= sent;
+        client->blocked = client->pending > 0;
+
+        // A client which caught up continues from the latest frame in full,
+        // encoded apart from the message still being sent to other clients
+        if (client->blocked || !client->stale || !server->width) return;
+        client->stale = false;
+        uint8_t  full[STREAM_FRAME_SIZE];
+        uint64_t rows = server->height < 64 ? (1ULL << server->height) - 1 : ~0ULL;
+        size_t   size = stream_encode_frame(full, server->pixels, server->width, server->height, rows);
+        stream_queue(client, full, size);
+        if (client->socket < 0) return;
+    }
+}
+
+static void stream_receive(stream_client_t *client) {
+    for (;;) {
+        ssize_t length = recv(client->socket, &client->input[client->received], STREAM_INPUT_SIZE - client->received, 0);
+        if (length < 0 && errno == EINTR) continue;
+        if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (length <= 0) {
+            stream_disconnect(client);
+            return;
+        }
+        client->received += length;
+
+        // Clients only ever send the keys they hold
+        size_t used = 0;
+        while (client->received - used >= STREAM_HEADER_SIZE) {
+            const uint8_t *message = &client->input[used];
+            if (message[0] != STREAM_KEYS || message[1] != 2 || message[2] != 0) {
+                stream_disconnect(client);
+                return;
+            }
+            if (client->received - used < STREAM_HEADER_SIZE + 2) break;
+            client->keys = message[3] | message[4] << 8;
+            used += STREAM_HEADER_SIZE + 2;
+        }
+        memmove(client->input, &client->input[used], client->received - used);
+        client->received -= used;
+    }
+}
+
+static void stream_disconnect(stream_client_t *client) {
+    close(client->socket);
+    client->socket   = -1;
+    client->keys     = 0;
+    client->pending  = 0;
+    client->received = 0;
+}
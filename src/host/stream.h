@@ -0,0 +1,180 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chip8.h"
+
+#define STREAM_MAGIC        0x54533843 // "C8ST" in little-endian, opening every stream
+#define STREAM_VERSION      1          // Bumped whenever the protocol changes
+#define STREAM_DEFAULT_PORT 5800       // Port listened on unless configured otherwise
+#define STREAM_MAX_CLIENTS  64         // Most clients connected at once
+#define STREAM_HEADER_SIZE  3          // Bytes in front of every message: type and payload size
+#define STREAM_QUEUE_SIZE   16384      // Bytes queued for a client before it is dropped
+#define STREAM_INPUT_SIZE   64         // Bytes of partial messages kept from a client
+#define STREAM_FRAME_SIZE   (STREAM_HEADER_SIZE + 11 + HIRES_DISPLAY_HEIGHT * HIRES_DISPLAY_WIDTH / 2)
+
+// Types of messages, each sent as its type, the size of its payload as a
+// 16-bit little-endian number and the payload itself
+typedef enum {
+    STREAM_HELLO = 1, // Server: magic (4 bytes) and version (1 byte), sent once on connecting
+    STREAM_FRAME = 2, // Server: width, height, bits per pixel, rows included (8 bytes) and their packed pixels
+    STREAM_SOUND = 3, // Server: if the sound is playing (1 byte)
+    STREAM_KEYS  = 4, // Client: bitmask of the keys held (2 bytes)
+} stream_message_t;
+
+// A client connected to the server.
+typedef struct {
+    int      socket;                   // Connection to the client, or -1 if unused
+    bool     blocked;                  // If the connection did not take everything queued
+    bool     stale;                    // If the client skipped frames and must receive a full frame
+    uint16_t keys;                     // Keys the client holds
+    uint8_t  queue[STREAM_QUEUE_SIZE]; // Messages not sent yet
+    size_t   pending;                  // Bytes of the queue not sent yet
+    uint8_t  input[STREAM_INPUT_SIZE]; // Bytes received which do not form a message yet
+    size_t   received;                 // Bytes of the input received so far
+} stream_client_t;
+
+// A server streaming the display and sound of a single emulator to any
+// number of clients, which share its keypad.
+typedef struct {
+    int             socket;                                             // Listening socket
+    uint16_t        port;                                               // Port listened on
+    uint16_t        keypad;                                             // Keys held by any client
+    bool            playing;                                            // If the sound is playing
+    uint8_t         width;                                              // Width of the latest frame
+    uint8_t         height;                                             // Height of the latest frame
+    uint8_t         pixels[HIRES_DISPLAY_WIDTH * HIRES_DISPLAY_HEIGHT]; // Pixels of the latest frame
+    uint8_t         message[STREAM_FRAME_SIZE];                         // Changes of the latest frame, encoded once for every client
+    stream_client_t clients[STREAM_MAX_CLIENTS];                        // Connected clients
+} stream_server_t;
+
+// State of the display and sound as seen by a client.
+typedef struct {
+    bool     connected;                                          // If the greeting was received
+    uint8_t  width;                                              // Width of the display
+    uint8_t  height;                                             // Height of the display
+    bool     playing;                                            // If the sound is playing
+    uint64_t frames;                                             // Frames received so far
+    uint64_t dirty_rows;                                         // Rows changed by the latest frame
+    uint8_t  pixels[HIRES_DISPLAY_WIDTH * HIRES_DISPLAY_HEIGHT]; // Palette index of every pixel
+} stream_view_t;
+
+/**
+ * Starts listening for clients on every interface.
+ *
+ * @param server - The server to start
+ * @param port - The port to listen on, or 0 for any free port
+ * @returns If the server is listening
+ */
+bool stream_server_open(stream_server_t *server, uint16_t port);
+
+/**
+ * Disconnects every client and stops listening.
+ *
+ * @param server - The server to stop
+ */
+void stream_server_close(stream_server_t *server);
+
+/**
+ * Accepts new clients, collects the keys held by every client and continues
+ * sending messages queued for clients without waiting for any of them.
+ *
+ * New clients are greeted with the latest frame and the state of the sound.
+ *
+ * @param server - The server to poll
+ */
+void stream_server_poll(stream_server_t *server);
+
+/**
+ * Sends a frame to every client, including only the rows which changed.
+ *
+ * The frame is encoded once for every client, and sent along with any other
+ * messages queued since the previous frame. Clients whose connection is still
+ * backed up skip frames until they caught up, and then receive the latest
+ * frame in full, so a slow client never delays the others or sees frames
+ * later than necessary. Unchanged frames are not sent at all.
+ *
+ * @param server - The server to send from
+ * @param pixels - The palette index of every pixel
+ * @param width - The width of the frame
+ * @param height - The height of the frame
+ */
+void stream_server_frame(stream_server_t *server, const uint8_t *pixels, uint8_t width, uint8_t height);
+
+/**
+ * Tells every client that the sound started or stopped.
+ *
+ * The message is only queued, to be sent along with the next frame or poll.
+ *
+ * @param server - The server to send from
+ * @param playing - If the sound is playing
+ */
+void stream_server_sound(stream_server_t *server, bool playing);
+
+/**
+ * Encodes the keys held on a client into a message for the server.
+ *
+ * @param keys - The bitmask of the keys held
+ * @param message - Receives the message; must hold `STREAM_HEADER_SIZE + 2` bytes
+ * @returns The size of the message in bytes
+ */
+size_t stream_encode_keys(uint16_t keys, uint8_t *message);
+
+/**
+ * Applies the next message received from the server to a view.
+ *
+ * @param view - The view to update
+ * @param data - The data received so far
+ * @param size - The size of the data in bytes
+ * @param used - Receives the size of the message applied, or 0 if the data
+ * does not hold a whole message yet
+ * @returns If the data is valid
+ */
+bool stream_decode(stream_view_t *view, const uint8_t *data, size_t size, size_t *used);
+
+/**
+ * Encodes the rows of a frame into a message.
+ *
+ * @param message - Receives the message; must hold `STREAM_FRAME_SIZE` bytes
+ * @param pixels - The palette index of every pixel
+ * @param width - The width of the frame
+ * @param height - The height of the frame
+ * @param rows - The bitmap of the rows to include
+ * @returns The size of the message in bytes
+ */
+static size_t stream_encode_frame(uint8_t *message, const uint8_t *pixels, uint8_t width, uint8_t height,
+                                  uint64_t rows);
+
+/**
+ * Queues messages for a client, dropping the client if they do not fit.
+ *
+ * @param client - The client to queue for
+ * @param data - The messages to queue
+ * @param size - The size of the messages in bytes
+ */
+static void stream_queue(stream_client_t *client, const uint8_t *data, size_t size);
+
+/**
+ * Sends as much of the queue of a client as the connection takes, and
+ * queues the latest frame in full once a stale client caught up.
+ *
+ * @param server - The server the client is connected to
+ * @param client - The client to send to
+ */
+static void stream_flush(stream_server_t *server, stream_client_t *client);
+
+/**
+ * Reads the messages a client sent.
+ *
+ * @param client - The client to read from
+ */
+static void stream_receive(stream_client_t *client);
+
+/**
+ * Disconnects a client, releasing the keys they held.
+ *
+ * @param client - The client to disconnect
+ */
+static void stream_disconnect(stream_client_t *client);
@@ -0,0 +1,47 @@
+#include "triple_buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+
+bool triple_buffer_init(triple_buffer_t *triple, size_t size) {
+    memset(triple, 0, sizeof(triple_buffer_t));
+    for (uint8_t b = 0; b < 3; ++b) {
+        triple->buffers[b] = calloc(1, size);
+        if (!triple->buffers[b]) {
+            LOG_ERROR(LOG_SUBSYS_MEMORY, "Failed to allocate triple buffer.");
+            triple_buffer_free(triple);
+            return false;
+        }
+    }
+    triple->back   = 0;
+    triple->middle = 1;
+    triple->front  = 2;
+    return true;
+}
+
+void triple_buffer_free(triple_buffer_t *triple) {
+    for (uint8_t b = 0; b < 3; ++b) free(triple->buffers[b]);
+    memset(triple, 0, sizeof(triple_buffer_t));
+}
+
+void *triple_buffer_back(triple_buffer_t *triple) {
+    return triple->buffers[triple->back];
+}
+
+void triple_buffer_publish(triple_buffer_t *triple) {
+    // Releases the contents of the back buffer to the reader, and acquires
+    // the reads of the reader from the buffer it gave up
+    uint8_t middle = __atomic_exchange_n(&triple->middle, triple->back | TRIPLE_BUFFER_FRESH, __ATOMIC_ACQ_REL);
+    triple->back   = middle & ~TRIPLE_BUFFER_FRESH;
+}
+
+const void *triple_buffer_front(triple_buffer_t *triple, bool *fresh) {
+    *fresh = __atomic_load_n(&triple->middle, __ATOMIC_RELAXED) & TRIPLE_BUFFER_FRESH;
+    if (*fresh) {
+        uint8_t middle = __atomic_exchange_n(&triple->middle, triple->front, __ATOMIC_ACQ_REL);
+        triple->front  = middle & ~TRIPLE_BUFFER_FRESH;
+    }
+    return triple->buffers[triple->front];
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRIPLE_BUFFER_FRESH 0x4 // Set in the shared index while its buffer was not taken yet
+
+// Three buffers handed between a single writer and a single reader without
+// locks: the writer fills the back buffer, the reader holds the front buffer,
+// and the latest complete buffer waits in the middle until either swaps it.
+typedef struct {
+    void   *buffers[3]; // The three buffers, all of the same size
+    uint8_t back;       // Index of the buffer being written; owned by the writer
+    uint8_t front;      // Index of the buffer being read; owned by the reader
+    uint8_t middle;     // Index of the latest complete buffer, and `TRIPLE_BUFFER_FRESH`; accessed atomically
+} triple_buffer_t;
+
+/**
+ * Allocates the three buffers, cleared to zero.
+ *
+ * @param triple - The triple buffer to initialize
+ * @param size - The size of each buffer in bytes
+ * @returns If the buffers could be allocated
+ */
+bool triple_buffer_init(triple_buffer_t *triple, size_t size);
+
+/**
+ * Releases the buffers.
+ *
+ * @param triple - The triple buffer to release
+ */
+void triple_buffer_free(triple_buffer_t *triple);
+
+/**
+ * Gets the buffer for the writer to fill.
+ *
+ * The buffer holds whatever was written into it before it was last handed
+ * over, so the writer must fill it completely before publishing it.
+ *
+ * @param triple - The triple buffer
+ * @returns The back buffer
+ */
+void *triple_buffer_back(triple_buffer_t *triple);
+
+/**
+ * Publishes the back buffer as the latest complete buffer, and takes the
+ * previous middle buffer as the next back buffer.
+ *
+ * Never waits for the reader, which is always left with a complete buffer.
+ *
+ * @param triple - The triple buffer
+ */
+void triple_buffer_publish(triple_buffer_t *triple);
+
+/**
+ * Gets the latest complete buffer for the reader.
+ *
+ * Takes the middle buffer if it was published since the last call, and
+ * otherwise keeps reading the same buffer as before.
+ *
+ * @param triple - The triple buffer
+ * @param fresh - Receives if the buffer was published since the last call
+ * @returns The front buffer
+ */
+const void *triple_buffer_front(triple_buffer_t *triple, bool *fresh);
@@ -1,65 +1,506 @@
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "chip8.h"
+#include "export.h"
+#include "phosphor.h"
 #include "platform.h"
+#include "recording.h"
+#include "rom_library.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "triple_buffer.h"
+#include "variant.h"
 
-#define SECOND 1000000 // 1 second in microseconds
+#define SECOND                1000000 // 1 second in microseconds
+#define INPUT_POLLS_PER_FRAME 4       // Slices of each frame, collecting input before each
+
+// A completed frame, handed from the emulation thread to the render thread
+typedef struct {
+    uint8_t       pixels[HIRES_DISPLAY_WIDTH * HIRES_DISPLAY_HEIGHT]; // Palette index of every pixel
+    uint8_t       width;                                              // Width of the display mode
+    uint8_t       height;                                             // Height of the display mode
+    uint32_t      display_version;                                    // Incremented whenever the display changes
+    uint32_t      audio_version;                                      // Incremented whenever the audio pattern changes
+    uint8_t       audio_pattern[AUDIO_PATTERN_SIZE];                  // 1-bit audio samples
+    uint8_t       pitch;                                              // Playback rate of the audio pattern
+    bool          playing_sound;                                      // If sound is currently being played
+    uint64_t      cycles;                                             // Cycles run when the frame completed
+    uint64_t      key_pressed_at[16];                                 // Cycle at which the program first saw each key pressed
+    chip8_stats_t stats;                                              // Statistics of the emulation when the frame completed
+} frame_t;
+
+// Input-to-photon latency of key presses, reported when CHIP8_LATENCY is set
+typedef struct {
+    bool     pending; // If a press is waiting to be shown
+    uint8_t  key;     // Key of the pending press
+    uint64_t cycle;   // Cycles run when the press was collected
+    uint64_t time;    // Time at which the press was collected
+    uint32_t presses; // Presses shown so far
+    uint64_t total;   // Sum of the latencies in microseconds
+    uint64_t worst;   // Longest latency in microseconds
+} latency_t;
+
+// Deviation of emulated frames from their period, reported when CHIP8_JITTER is set
+typedef struct {
+    uint64_t previous; // Time at which the previous frame completed
+    uint32_t frames;   // Frames measured so far
+    uint64_t total;    // Sum of the deviations in microseconds
+    uint64_t worst;    // Largest deviation in microseconds
+} jitter_t;
+
+// State of the emulation thread, only touched by the main thread once joined
+typedef struct {
+    chip8_t         *chip8;       // The emulated CHIP-8
+    triple_buffer_t *frames;      // Completed frames of type `frame_t`
+    export_t        *exporter;    // Exporter of the frames into shared memory, if enabled
+    recording_t     *recorder;    // Recording of the frames into a file, if enabled
+    phosphor_t      *phosphor;    // Persistence blended into the frames, if enabled
+    const char      *snapshot;    // Path of the snapshot, if enabled
+    uint64_t         hash;        // Hash of the running ROM
+    uint64_t         saved_state; // State hash of the latest snapshot
+    bool             measure;     // If the jitter is measured
+    jitter_t         jitter;      // Jitter of the emulated frames
+    chip8_stats_t    stats;       // Statistics of the emulation, published with every frame
+} emulation_t;
+
+static volatile sig_atomic_t running        = 1; // Cleared when asked to shut down
+static volatile sig_atomic_t save_requested = 0; // Set when asked to save a snapshot
+
+// Both flags are read by the emulation thread as well, wherever the signal lands
+static void handle_shutdown(int signal) {
+    (void)signal;
+    __atomic_store_n(&running, 0, __ATOMIC_RELAXED);
+}
+
+static void handle_save(int signal) {
+    (void)signal;
+    __atomic_store_n(&save_requested, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Saves a snapshot, unless the state is the same as in the latest one.
+ *
+ * @param chip8 - The CHIP-8 to save
+ * @param rom_hash - The hash of the running ROM
+ * @param path - The path of the snapshot
+ * @param saved - The state hash of the latest snapshot, updated once saved
+ */
+static void save_snapshot(const chip8_t *chip8, uint64_t rom_hash, const char *path, uint64_t *saved) {
+    uint64_t state = chip8_hash(chip8);
+    if (state != *saved && snapshot_save(chip8, rom_hash, path)) *saved = state;
+}
+
+/**
+ * Starts measuring the latency of a key press, unless one is being measured.
+ *
+ * @param latency - The latency measurement
+ * @param cycles - The cycles run by the latest frame, before which the
+ * program cannot have seen the press
+ * @param previous - The keys collected before
+ * @param keys - The keys collected now
+ * @param time - The time at which the keys were collected
+ */
+static void latency_collect(latency_t *latency, uint64_t cycles, uint16_t previous, uint16_t keys, uint64_t time) {
+    uint16_t pressed = keys & ~previous;
+    if (latency->pending || !pressed) return;
+
+    latency->pending = true;
+    latency->key     = __builtin_ctz(pressed);
+    latency->cycle   = cycles;
+    latency->time    = time;
+}
+
+/**
+ * Completes measuring the latency of a key press once a frame is shown after
+ * the program read the press.
+ *
+ * @param latency - The latency measurement
+ * @param frame - The frame which was shown
+ * @param time - The time at which the frame was shown
+ */
+static void latency_present(latency_t *latency, const frame_t *frame, uint64_t time) {
+    if (!latency->pending || frame->key_pressed_at[latency->key] < latency->cycle) return;
+
+    uint64_t elapsed = time - latency->time;
+    latency->pending = false;
+    latency->presses += 1;
+    latency->total += elapsed;
+    if (elapsed > latency->worst) latency->worst = elapsed;
+}
+
+/**
+ * Records how far the time between two emulated frames deviated from the
+ * period of a frame.
+ *
+ * @param jitter - The jitter measurement
+ * @param time - The time at which the latest frame completed
+ */
+static void jitter_record(jitter_t *jitter, uint64_t time) {
+    if (jitter->previous) {
+        uint64_t elapsed   = time - jitter->previous;
+        uint64_t period    = SECOND / FRAMES_PER_SECOND;
+        uint64_t deviation = elapsed > period ? elapsed - period : period - elapsed;
+        jitter->frames += 1;
+        jitter->total += deviation;
+        if (deviation > jitter->worst) jitter->worst = deviation;
+    }
+    jitter->previous = time;
+}
+
+/**
+ * Hands the state of a completed frame to the render thread.
+ *
+ * @param frames - The triple buffer of frames
+ * @param chip8 - The CHIP-8 which completed the frame
+ * @param phosphor - The blended display to publish instead of the display of
+ * the CHIP-8, if enabled
+ * @param stats - The statistics of the emulation
+ * @param display_version - The version of the display
+ * @param audio_version - The version of the audio pattern
+ */
+static void publish_frame(triple_buffer_t *frames, const chip8_t *chip8, const phosphor_t *phosphor,
+                          const chip8_stats_t *stats, uint32_t display_version, uint32_t audio_version) {
+    // The back buffer may already hold the latest display from two frames ago
+    frame_t *frame = triple_buffer_back(frames);
+    if (frame->display_version != display_version || frame->width != chip8->display_width) {
+        if (phosphor) {
+            memcpy(frame->pixels, phosphor->pixels, chip8->display_width * chip8->display_height);
+        } else {
+            chip8_render_display(chip8, frame->pixels);
+        }
+        frame->display_version = display_version;
+        frame->width           = chip8->display_width;
+        frame->height          = chip8->display_height;
+    }
+    memcpy(frame->audio_pattern, chip8->audio_pattern, sizeof(frame->audio_pattern));
+    memcpy(frame->key_pressed_at, chip8->key_pressed_at, sizeof(frame->key_pressed_at));
+    frame->audio_version = audio_version;
+    frame->pitch         = chip8->pitch;
+    frame->playing_sound = chip8->playing_sound;
+    frame->cycles        = chip8->cycles;
+    frame->stats         = *stats;
+    triple_buffer_publish(frames);
+}
+
+/**
+ * Runs the emulation on its own thread, so that stalls while rendering never
+ * delay instructions, publishing every completed frame.
+ *
+ * @param data - The `emulation_t` to run
+ * @returns Always NULL
+ */
+static void *emulate(void *data) {
+    emulation_t *emulation = data;
+    chip8_t     *chip8     = emulation->chip8;
+
+    uint64_t slice_time          = SECOND / FRAMES_PER_SECOND / INPUT_POLLS_PER_FRAME;
+    uint64_t cpu_ticks_per_frame = INSTRUCTIONS_PER_SECOND / FRAMES_PER_SECOND;
+
+    uint64_t next_slice      = platform_get_time();
+    uint64_t next_clock_tick = next_slice + SECOND / FRAMES_PER_SECOND;
+    uint32_t display_version = 1;
+    uint32_t audio_version   = 1;
+
+    chip8_stats_t *stats       = &emulation->stats;
+    uint64_t       frame_start = next_slice;
+    while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+        // CPU advances by x amount of instructions each frame, spread across
+        // slices so that input collected in between reaches the program
+        chip8_state_t state = {.status = CHIP8_OK};
+        uint64_t      time  = 0;
+        uint64_t      slept = 0;
+        for (uint8_t s = 0; s < INPUT_POLLS_PER_FRAME; ++s) {
+            time = platform_get_time();
+            if (time < next_slice) {
+                platform_sleep(next_slice - time);
+                slept += platform_get_time() - time;
+                time = next_slice;
+            } else if (time - next_slice > SECOND) {
+                next_slice = time; // Skips ahead instead of catching up after a stall
+            }
+            next_slice += slice_time;
+
+            chip8_state_t slice;
+            uint32_t      cycles = (s + 1) * cpu_ticks_per_frame / INPUT_POLLS_PER_FRAME -
+                              s * cpu_ticks_per_frame / INPUT_POLLS_PER_FRAME;
+            chip8_run_cycles(chip8, cycles, &slice);
+            state.frame_buffer_dirty |= slice.frame_buffer_dirty;
+            state.sound_timer_set |= slice.sound_timer_set;
+            state.audio_pattern_set |= slice.audio_pattern_set;
+        }
+
+        // Persistence keeps changing the display while pixels fade out, and
+        // only blends the rows drawn to since the previous frame
+        if (emulation->phosphor) {
+            if (phosphor_update(emulation->phosphor, chip8, chip8_take_drawn_rows(chip8))) display_version += 1;
+        } else if (state.frame_buffer_dirty) {
+            display_version += 1;
+        }
+        if (state.audio_pattern_set) audio_version += 1;
+        if (state.sound_timer_set) chip8->playing_sound = true;
+
+        // Timers tick once every frame, at 60 Hz per specification
+        if (time > next_clock_tick) {
+            chip8_update_timers(chip8);
+            if (chip8->playing_sound && chip8->sound_timer == 0) chip8->playing_sound = false;
+            next_clock_tick += SECOND / FRAMES_PER_SECOND;
+        }
+
+        // Everything besides waiting for the next slice counts as emulating,
+        // including the work of the previous frame after it was published
+        uint64_t now = platform_get_time();
+        stats->instructions = chip8->cycles;
+        stats->frames_emulated += 1;
+        stats->emulate_time += now - frame_start - slept;
+        stats->sleep_time += slept;
+        frame_start = now;
+
+        publish_frame(emulation->frames, chip8, emulation->phosphor, stats, display_version, audio_version);
+        if (emulation->exporter) export_publish(emulation->exporter, chip8);
+        if (emulation->recorder) recording_write(emulation->recorder, chip8);
+        if (emulation->measure) jitter_record(&emulation->jitter, platform_get_time());
+
+        if (__atomic_exchange_n(&save_requested, 0, __ATOMIC_RELAXED) && emulation->snapshot) {
+            save_snapshot(chip8, emulation->hash, emulation->snapshot, &emulation->saved_state);
+        }
+    }
+    return NULL;
+}
 
 int main(int argc, char **argv) {
-    uint64_t seed = platform_get_time();
-    platform_seed_rng(seed);
-    platform_init(DISPLAY_WIDTH, DISPLAY_HEIGHT, FRAMES_PER_SECOND);
+    if (argc < 2) {
+        printf("Usage: %s <rom> [variant]", argv[0]);
+        return 1;
+    }
 
-    uint8_t rom[MEMORY_SIZE - PROGRAM_START];
-    bool    loaded = platform_load_rom(rom, sizeof(rom), argc, argv);
-    if (!loaded) {
+    rom_file_t rom;
+    if (!rom_map(&rom, argv[1])) {
         printf("ERROR: Failed to load ROM.");
         return 1;
     }
 
+    // Settings are looked up from the ROM library when an index is provided
+    rom_entry_t profile = {.variant = VARIANT_CHIP8, .quirks = DEFAULT_QUIRKS};
+    rom_index_t library;
+    const char *path = getenv("CHIP8_ROM_INDEX");
+    if (path && rom_index_init(&library)) {
+        if (rom_index_load(&library, path)) {
+            const rom_entry_t *entry = rom_index_find(&library, rom.hash);
+            if (entry) profile = *entry;
+        }
+        rom_index_free(&library);
+    }
+
+    // The platform variant can optionally be selected after the ROM path,
+    // which takes precedence over the variant stored in the ROM library
+    if (argc > 2) profile.variant = variant_by_name(argv[2]);
+
+    variant_data_t data = variant_get(profile.variant);
+    if (!data.name) {
+        printf("ERROR: Unknown platform variant.");
+        return 1;
+    }
+
     chip8_t chip8;
-    chip8_init(&chip8, platform_rng);
-    chip8_load_program(&chip8, rom, sizeof(rom));
+    if (!chip8_init(&chip8)) {
+        printf("ERROR: Failed to initialize the emulator.");
+        return 1;
+    }
+
+    // A snapshot of the same ROM resumes where the previous process left off,
+    // skipping the boot sequence of the ROM entirely
+    uint64_t    hash     = rom.hash;
+    const char *snapshot = getenv("CHIP8_STATE");
+    bool        resumed  = snapshot && snapshot_resume(&chip8, hash, snapshot);
+    if (!resumed) {
+        if (!rom_load(&chip8, &rom, &profile)) {
+            printf("ERROR: Failed to load ROM.");
+            return 1;
+        }
+
+        // A fixed seed can be provided to reproduce a run exactly
+        const char *seed = getenv("CHIP8_SEED");
+        chip8_seed_rng(&chip8, seed ? strtoull(seed, NULL, 0) : platform_get_time());
+    }
+    rom_unmap(&rom);
+
+    // Snapshots are saved on shutdown, and on demand through SIGUSR1, but only
+    // if the state changed since the latest one
+    uint64_t saved_state = resumed ? chip8_hash(&chip8) : 0;
+    signal(SIGINT, handle_shutdown);
+    signal(SIGTERM, handle_shutdown);
+#ifdef SIGUSR1
+    signal(SIGUSR1, handle_save);
+#endif
+
+    data = variant_get(chip8.variant);
+    platform_init(data.display_width, data.display_height, FRAMES_PER_SECOND);
 
     // Draw the display once to ensure it is at a stable, empty state
-    platform_draw_display(chip8.display);
+    static uint8_t pixels[HIRES_DISPLAY_WIDTH * HIRES_DISPLAY_HEIGHT];
+    chip8_render_display(&chip8, pixels);
+    platform_draw_display(pixels, chip8.display_width, chip8.display_height);
 
-    uint64_t target_frame_time   = SECOND / FRAMES_PER_SECOND;
-    uint64_t cpu_ticks_per_frame = INSTRUCTIONS_PER_SECOND / FRAMES_PER_SECOND;
+    // Completed frames are handed to the main thread without locks, so that
+    // neither thread ever waits for the other
+    triple_buffer_t frames;
+    if (!triple_buffer_init(&frames, sizeof(frame_t))) {
+        printf("ERROR: Failed to allocate the frame buffers.");
+        return 1;
+    }
 
-    uint64_t last_time       = platform_get_time();
-    uint64_t next_clock_tick = last_time + SECOND;
+    // The keypad is read straight from the platform as instructions run, so
+    // input collected within a frame reaches the program within that frame
+    chip8_set_keypad_source(&chip8, platform_get_keypad);
+    latency_t latency = {0};
+    bool      measure = getenv("CHIP8_LATENCY") != NULL;
+    uint16_t  keys    = 0;
 
-    do {
-        uint64_t time       = platform_get_time();
-        uint64_t frame_time = time - last_time;
-        last_time           = time;
-        if (frame_time < target_frame_time) {
-            platform_sleep(target_frame_time - frame_time);
+    // Completed frames are published into shared memory for other processes
+    // when CHIP8_EXPORT names the object, such as /chip8
+    export_t    exporter;
+    const char *export_name = getenv("CHIP8_EXPORT");
+    bool        exporting   = export_name && export_create(&exporter, export_name);
+
+    // Every frame is recorded into a compact file when CHIP8_RECORD names it
+    recording_t recorder;
+    const char *record_path = getenv("CHIP8_RECORD");
+    bool        recording   = record_path && recording_create(&recorder, &chip8, record_path);
+
+    // Pixels fade out over several frames rather than flickering when
+    // CHIP8_PHOSPHOR is set, optionally to the number of frames
+    static phosphor_t phosphor;
+    const char       *persistence = getenv("CHIP8_PHOSPHOR");
+    if (persistence) {
+        // Longer persistence than a frame counter holds is clamped to it
+        unsigned long fade = strtoul(persistence, NULL, 10);
+        phosphor_init(&phosphor, fade == 0 ? PHOSPHOR_DEFAULT_PERSISTENCE : fade > UINT8_MAX ? UINT8_MAX : (uint8_t)fade);
+    }
+
+    emulation_t emulation = {
+        .chip8       = &chip8,
+        .frames      = &frames,
+        .exporter    = exporting ? &exporter : NULL,
+        .recorder    = recording ? &recorder : NULL,
+        .phosphor    = persistence ? &phosphor : NULL,
+        .snapshot    = snapshot,
+        .hash        = hash,
+        .saved_state = saved_state,
+        .measure     = getenv("CHIP8_JITTER") != NULL,
+    };
+    pthread_t emulator;
+    if (pthread_create(&emulator, NULL, emulate, &emulation) != 0) {
+        printf("ERROR: Failed to start the emulation thread.");
+        return 1;
+    }
+
+    // Statistics are always kept, shown on the overlay of the platform, and
+    // appended as lines of JSON to the file named by CHIP8_STATS
+    chip8_stats_t stats                    = {0};
+    chip8_stats_t interval                 = {0};
+    char          overlay[STATS_LINE_SIZE] = "";
+    const char   *stats_path               = getenv("CHIP8_STATS");
+    FILE         *stats_file               = stats_path ? fopen(stats_path, "a") : NULL;
+    uint64_t      stats_start              = platform_get_time();
+    uint64_t      next_stats               = stats_start + STATS_INTERVAL;
+
+    // The main thread owns the platform, collecting input several times per
+    // frame and presenting the latest frame as soon as it is published
+    uint64_t slice_time      = SECOND / FRAMES_PER_SECOND / INPUT_POLLS_PER_FRAME;
+    uint64_t next_poll       = platform_get_time();
+    uint32_t display_version = 0;
+    uint32_t audio_version   = 0;
+    bool     playing         = false;
+    while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+        uint64_t time = platform_get_time();
+        if (time < next_poll) {
+            platform_sleep(next_poll - time);
+            time = next_poll;
+        } else if (time - next_poll > slice_time) {
+            next_poll = time; // Skips ahead after rendering stalled
         }
+        next_poll += slice_time;
 
-        // CPU advances by x amount of instructions each frame
-        for (uint8_t i = 0; i < cpu_ticks_per_frame; ++i) {
-            chip8_state_t state = chip8_run_cycle(&chip8);
-            if (state.frame_buffer_dirty) platform_draw_display(chip8.display);
-            if (state.sound_timer_set) {
-                chip8.playing_sound = true;
-                platform_play_audio();
+        platform_poll_input();
+        uint16_t       polled = platform_get_keypad();
+        bool           fresh;
+        const frame_t *frame = triple_buffer_front(&frames, &fresh);
+        if (measure) latency_collect(&latency, frame->cycles, keys, polled, time);
+        keys = polled;
+
+        // Frames published since the previous one taken were never presented
+        if (fresh) {
+            stats.frames_skipped += frame->stats.frames_emulated - stats.frames_emulated - 1;
+            stats.frames_presented += 1;
+            stats.instructions    = frame->stats.instructions;
+            stats.frames_emulated = frame->stats.frames_emulated;
+            stats.emulate_time    = frame->stats.emulate_time;
+            stats.sleep_time      = frame->stats.sleep_time;
+        }
+        if (time >= next_stats) {
+            next_stats            = time + STATS_INTERVAL;
+            stats.time            = time - stats_start;
+            stats.audio_underruns = platform_get_audio_underruns();
+            stats_interval(&stats, &interval);
+            stats_publish(&stats);
+            stats_format_overlay(&stats, overlay, sizeof(overlay));
+            if (stats_file) {
+                char line[STATS_LINE_SIZE];
+                stats_format_line(&stats, line, sizeof(line));
+                fputs(line, stats_file);
+                fflush(stats_file);
             }
         }
 
-        // Clocks tick once every second
-        if (time > next_clock_tick) {
-            if (chip8.sound_timer > 0) chip8.sound_timer -= 1;
-            if (chip8.delay_timer > 0) chip8.delay_timer -= 1;
-            if (chip8.playing_sound && chip8.sound_timer == 0) {
-                chip8.playing_sound = false;
+        // The overlay is drawn along with the display, so changing it draws
+        // the latest frame again
+        bool redraw = platform_set_overlay(overlay) && frame->width;
+        if (!fresh && !redraw) continue;
+
+        if (frame->display_version != display_version || redraw) {
+            uint64_t start  = platform_get_time();
+            display_version = frame->display_version;
+            platform_draw_display(frame->pixels, frame->width, frame->height);
+
+            uint64_t shown = platform_get_time();
+            stats.draw_calls += 1;
+            stats.render_time += shown - start;
+            if (measure) latency_present(&latency, frame, shown);
+        }
+        if (frame->audio_version != audio_version) {
+            audio_version = frame->audio_version;
+            platform_set_audio_pattern(frame->audio_pattern, frame->pitch);
+        }
+        if (frame->playing_sound != playing) {
+            playing = frame->playing_sound;
+            if (playing) {
+                platform_play_audio();
+            } else {
                 platform_stop_audio();
             }
-            next_clock_tick += SECOND;
         }
-    } while (true);
+    }
+    pthread_join(emulator, NULL);
 
+    if (snapshot) save_snapshot(&chip8, hash, snapshot, &emulation.saved_state);
+    if (measure && latency.presses) {
+        printf("Input latency over %u presses: mean %.1fms, worst %.1fms\n", latency.presses,
+               latency.total / 1000.0 / latency.presses, latency.worst / 1000.0);
+    }
+    if (emulation.measure && emulation.jitter.frames) {
+        printf("Emulation jitter over %u frames: mean %.2fms, worst %.2fms\n", emulation.jitter.frames,
+               emulation.jitter.total / 1000.0 / emulation.jitter.frames, emulation.jitter.worst / 1000.0);
+    }
+    if (exporting) export_close(&exporter);
+    if (recording) recording_close(&recorder);
+    if (stats_file) fclose(stats_file);
+    triple_buffer_free(&frames);
+    chip8_free(&chip8);
     platform_close();
 }
@@ -1,26 +1,54 @@
 #include "audio.h"
 
 #include <math.h>
+#include <string.h>
 
+#include "platform.h"
 #include "raylib.h"
 
 Tone *p_tone;
 
 void init_tone(Tone *tone) {
-    p_tone          = tone;
-    tone->stream    = LoadAudioStream(SAMPLE_RATE, 32, 1);
-    tone->phase     = 0.0;
-    tone->increment = (2.0 * PI * FREQUENCY) / SAMPLE_RATE;
-    tone->active    = false;
+    p_tone                  = tone;
+    tone->stream            = LoadAudioStream(SAMPLE_RATE, 32, 1);
+    tone->phase             = 0.0;
+    tone->increment         = (2.0 * PI * FREQUENCY) / SAMPLE_RATE;
+    tone->active            = false;
+    tone->use_pattern       = false;
+    tone->pattern_phase     = 0.0;
+    tone->pattern_increment = 0.0;
+    tone->deadline          = 0;
+    tone->underruns         = 0;
     SetAudioStreamCallback(tone->stream, on_audio_stream_update);
 }
 
+void set_tone_pattern(Tone *tone, const uint8_t *pattern, uint8_t pitch) {
+    memcpy(tone->pattern, pattern, PATTERN_SIZE);
+    tone->pattern_increment = 4000.0 * pow(2.0, (pitch - 64) / 48.0) / SAMPLE_RATE;
+    tone->use_pattern       = true;
+}
+
 static void on_audio_stream_update(void *data, unsigned int frames) {
+    // Streams are double-buffered, so a callback filling one buffer only
+    // comes too late once the other buffer played out as well
+    uint64_t now = platform_get_time();
+    if (p_tone->deadline && now > p_tone->deadline) __atomic_add_fetch(&p_tone->underruns, 1, __ATOMIC_RELAXED);
+    p_tone->deadline = now + 2 * (uint64_t)frames * 1000000 / SAMPLE_RATE;
+
     float *buffer = (float *)data;
     for (unsigned int i = 0; i < frames; i++) {
         float amp = p_tone->active ? AMPLITUDE : 0.0f;
-        buffer[i] = sin(p_tone->phase) * amp;
-        p_tone->phase += p_tone->increment;
-        if (p_tone->phase > 2.0 * PI) p_tone->phase -= 2.0 * PI;
+        if (p_tone->use_pattern) {
+            // Patterns are played MSB first, looping over all 128 bits
+            unsigned int bit = (unsigned int)p_tone->pattern_phase;
+            bool         set = p_tone->pattern[bit / 8] & (0x80 >> (bit % 8));
+            buffer[i]        = set ? amp : -amp;
+            p_tone->pattern_phase += p_tone->pattern_increment;
+            if (p_tone->pattern_phase >= PATTERN_SIZE * 8) p_tone->pattern_phase -= PATTERN_SIZE * 8;
+        } else {
+            buffer[i] = sin(p_tone->phase) * amp;
+            p_tone->phase += p_tone->increment;
+            if (p_tone->phase > 2.0 * PI) p_tone->phase -= 2.0 * PI;
+        }
     }
 }
@@ -1,20 +1,31 @@
 #pragma once
 
+#include <stdint.h>
+
 #include "raylib.h"
 
-#define SAMPLE_RATE 44100
-#define FREQUENCY   220.0f
-#define AMPLITUDE   0.25f
-#define BUFFER_SIZE 512
+#define SAMPLE_RATE  44100
+#define FREQUENCY    220.0f
+#define AMPLITUDE    0.25f
+#define BUFFER_SIZE  512
+#define PATTERN_SIZE 16
 
 // A drone sound that loops a single frequency indefinitely.
 // Declaring it as an infinite audio stream allows us to not package a binary
 // audio file into the program, instead just declaring it programmatically.
+// When a pattern is set, the drone is replaced with the looping 1-bit samples
+// of the pattern, as used by XO-CHIP programs.
 typedef struct {
-    AudioStream stream;    // The audio stream to play back using Raylib
-    bool        active;    // If the audio stream should currently be playing
-    double      phase;     // The phase of the audio stream (how far along it is)
-    double      increment; // The rate at which the audio stream advances
+    AudioStream stream;                // The audio stream to play back using Raylib
+    bool        active;                // If the audio stream should currently be playing
+    double      phase;                 // The phase of the audio stream (how far along it is)
+    double      increment;             // The rate at which the audio stream advances
+    bool        use_pattern;           // If the pattern should be played instead of the drone
+    uint8_t     pattern[PATTERN_SIZE]; // The 1-bit samples making up the pattern
+    double      pattern_phase;         // The current sample within the pattern
+    double      pattern_increment;     // The rate at which the pattern advances
+    uint64_t    deadline;              // Time by which the next callback must come to not run out of samples
+    uint64_t    underruns;             // Times the stream ran out of samples; accessed atomically
 } Tone;
 
 // Pointer to a tone that is declared outside the scope of this header.
@@ -30,12 +41,23 @@ extern Tone *p_tone;
  */
 void init_tone(Tone *tone);
 
+/**
+ * Replace the drone of the tone with a looping audio pattern.
+ *
+ * @param tone - The tone to update
+ * @param pattern - The 1-bit samples making up the pattern
+ * @param pitch - The XO-CHIP pitch to play the pattern back at
+ */
+void set_tone_pattern(Tone *tone, const uint8_t *pattern, uint8_t pitch);
+
 /**
  * A callback that gets set on the audio stream (SetAudioStreamCallback).
  *
  * This callback is what ensures that the audio stream loops indefinitely
  * during the entire lifecycle of the program, as well as takes care of
  * toggling it's volume on/off based on the `active` property on the Tone.
+ * Callbacks coming too late for the stream to keep playing are counted as
+ * underruns.
  *
  * @param data - The audio stream buffer
  * @param frames - The number of frames that make up the audio stream
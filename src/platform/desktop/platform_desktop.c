@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #ifdef _WIN32
@@ -13,9 +14,51 @@
 #include "platform.h"
 #include "raylib.h"
 
-static uint8_t display_width;
-static uint8_t display_height;
-static Tone    tone;
+#define OVERLAY_SIZE 512    // Bytes of overlay text kept, including the terminator
+#define OVERLAY_FONT 10     // Font size of the overlay text
+#define OVERLAY_KEY  KEY_F3 // Key toggling the overlay
+
+static uint8_t  display_width;
+static uint8_t  display_height;
+static Tone     tone;
+static uint16_t keypad; // Published keypad; only accessed atomically
+
+// Text drawn over the display while toggled on
+static char overlay[OVERLAY_SIZE];
+static bool overlay_shown;   // If the user toggled the overlay on
+static bool overlay_drawn;   // If the overlay was drawn along with the latest frame
+static bool overlay_changed; // If the text changed since the latest frame
+
+// Keys of the keyboard mapped to each CHIP-8 key, keeping the layout of the
+// COSMAC VIP keypad on the left side of a QWERTY keyboard:
+//   1 2 3 C    1 2 3 4
+//   4 5 6 D    Q W E R
+//   7 8 9 E    A S D F
+//   A 0 B F    Z X C V
+static const KeyboardKey KEYMAP[16] = {
+    KEY_X, KEY_ONE, KEY_TWO, KEY_THREE, KEY_Q, KEY_W, KEY_E, KEY_A,
+    KEY_S, KEY_D,   KEY_Z,   KEY_C,     KEY_FOUR, KEY_R, KEY_F, KEY_V,
+};
+
+// Colors for every combination of the up to 4 display planes
+static const Color PALETTE[16] = {
+    BLACK,
+    RAYWHITE,
+    {0xAA, 0xAA, 0xAA, 0xFF},
+    {0x55, 0x55, 0x55, 0xFF},
+    RED,
+    GREEN,
+    BLUE,
+    YELLOW,
+    MAROON,
+    DARKGREEN,
+    DARKBLUE,
+    GOLD,
+    PURPLE,
+    SKYBLUE,
+    ORANGE,
+    PINK,
+};
 
 void platform_init(uint8_t width, uint8_t height, uint8_t fps) {
     display_width  = width;
@@ -57,43 +100,31 @@ uint64_t platform_get_time(void) {
 #endif
 }
 
-void platform_seed_rng(uint64_t seed) {
-    srand(seed);
-}
-
-uint8_t platform_rng(void) {
-    return (uint8_t)rand();
-}
-
-bool platform_load_rom(uint8_t *rom, size_t max_size, int argc, char **argv) {
-    if (argc < 2) return false;
-
-    char *path = argv[1];
-    if (!path) return false;
-
-    FILE *infile = fopen(path, "rb");
-    if (!infile) return false;
+void platform_draw_display(const uint8_t *buffer, uint8_t width, uint8_t height) {
+    // Lower resolution modes are scaled up to fill the entire window
+    uint8_t scale = display_width / width;
 
-    size_t result = fread(rom, sizeof(uint8_t), max_size, infile);
-
-    if (ferror(infile)) {
-        fclose(infile);
-        return false;
-    }
-
-    fclose(infile);
-    return true;
-}
-
-void platform_draw_display(bool *buffer) {
     BeginDrawing();
-    for (uint8_t x = 0; x < display_width; ++x) {
-        for (uint8_t y = 0; y < display_height; ++y) {
-            if (buffer[y * display_width + x]) {
-                DrawPixel(x, y, RAYWHITE);
+    ClearBackground(PALETTE[0]);
+    for (uint8_t x = 0; x < width; ++x) {
+        for (uint8_t y = 0; y < height; ++y) {
+            // Fading pixels are blended with the background they are drawn over
+            uint8_t pixel = buffer[y * width + x];
+            if (pixel & 0xF) {
+                DrawRectangle(x * scale, y * scale, scale, scale, Fade(PALETTE[pixel & 0xF], 1.0f - (pixel >> 4) / 16.0f));
             }
         }
     }
+
+    // The overlay is drawn on a dimmed backdrop to stay readable over any pixels
+    if (overlay_shown) {
+        uint8_t lines = 1;
+        for (const char *c = overlay; *c; ++c) lines += *c == '\n';
+        DrawRectangle(0, 0, MeasureText(overlay, OVERLAY_FONT) + 4, lines * OVERLAY_FONT + 4, Fade(BLACK, 0.6f));
+        DrawText(overlay, 2, 2, OVERLAY_FONT, YELLOW);
+    }
+    overlay_drawn   = overlay_shown;
+    overlay_changed = false;
     EndDrawing();
 }
 
@@ -105,7 +136,34 @@ void platform_stop_audio(void) {
     tone.active = false;
 }
 
+void platform_set_audio_pattern(const uint8_t *pattern, uint8_t pitch) {
+    set_tone_pattern(&tone, pattern, pitch);
+}
+
+uint64_t platform_get_audio_underruns(void) {
+    return __atomic_load_n(&tone.underruns, __ATOMIC_RELAXED);
+}
+
+bool platform_set_overlay(const char *text) {
+    if (strncmp(overlay, text, sizeof(overlay) - 1) != 0) {
+        snprintf(overlay, sizeof(overlay), "%s", text);
+        overlay_changed = true;
+    }
+    return overlay_shown != overlay_drawn || (overlay_shown && overlay_changed);
+}
+
+void platform_poll_input(void) {
+    // Events are otherwise only processed when a frame is drawn
+    PollInputEvents();
+    if (IsKeyPressed(OVERLAY_KEY)) overlay_shown = !overlay_shown;
+
+    uint16_t keys = 0;
+    for (uint8_t k = 0; k < 16; ++k) {
+        if (IsKeyDown(KEYMAP[k])) keys |= 1 << k;
+    }
+    __atomic_store_n(&keypad, keys, __ATOMIC_RELEASE);
+}
+
 uint16_t platform_get_keypad(void) {
-    // TODO: Add implementation.
-    return 0;
+    return __atomic_load_n(&keypad, __ATOMIC_ACQUIRE);
 }
@@ -35,52 +35,72 @@ void platform_sleep(uint64_t microseconds);
 uint64_t platform_get_time(void);
 
 /**
- * Seeds the random number generator.
+ * Draws a new frame buffer on the screen.
+ *
+ * Each pixel of the frame buffer is a single byte holding a palette index in
+ * its low nibble, which allows drawing up to 16 colors. The high nibble holds
+ * how far the pixel faded out when persistence is enabled, from 0 for full
+ * intensity to 15 for nearly dark, which should be blended towards the
+ * background where supported. The frame buffer may be smaller than
+ * the size provided when initializing the platform, in which case it should
+ * be scaled up to fill the display.
  *
- * @param seed - The seed to use for the generator.
+ * @param buffer - The frame buffer to display
+ * @param width - The width of the frame buffer
+ * @param height - The height of the frame buffer
  */
-void platform_seed_rng(uint64_t seed);
+void platform_draw_display(const uint8_t *buffer, uint8_t width, uint8_t height);
 
 /**
- * Generates a random number.
- *
- * Limited to 8 bits as the CHIP-8 does not require any more.
- *
- * @returns A random number
+ * Starts playing a sound if one is not already active.
+ */
+void platform_play_audio(void);
+
+/**
+ * Stops playing the active sounds.
  */
-uint8_t platform_rng(void);
+void platform_stop_audio(void);
 
 /**
- * Loads a ROM into the application's memory.
+ * Replaces the played sound with a looping 1-bit audio pattern.
  *
- * The last two input arguments match to those of `main` to allow loading a
- * ROM from a file which is provided via CLI arguments when starting the
- * application.
+ * The pattern consists of 128 samples, played back at a rate of
+ * `4000 * 2 ^ ((pitch - 64) / 48)` samples per second.
  *
- * @param rom - The loaded ROM
- * @param max_size - The maximum size permissible for a valid ROM
- * @param argc - The number of arguments provided to `main`
- * @param argv - The arguments provided to `main`
- * @returns If the ROM was loaded successfully
+ * @param pattern - The 16 bytes making up the audio pattern
+ * @param pitch - The pitch to play the pattern back at
  */
-bool platform_load_rom(uint8_t *rom, size_t max_size, int argc, char **argv);
+void platform_set_audio_pattern(const uint8_t *pattern, uint8_t pitch);
 
 /**
- * Draws a new frame buffer on the screen.
+ * Gets how many times the audio output ran out of samples to play, such as
+ * when the audio device was starved of CPU time.
  *
- * @param buffer - The frame buffer to display
+ * @returns The number of underruns since the platform was initialized
  */
-void platform_draw_display(bool *buffer);
+uint64_t platform_get_audio_underruns(void);
 
 /**
- * Starts playing a sound if one is not already active.
+ * Replaces the text shown over the display, such as runtime statistics.
+ *
+ * Platforms able to show an overlay let the user toggle it, and draw it along
+ * with the display. Since the display is only drawn when it changes, it must
+ * be drawn again whenever this reports that the overlay needs redrawing.
+ *
+ * @param text - The lines of text to show
+ * @returns If the display must be drawn again, as the text of the overlay
+ * shown changed, or the overlay was toggled since the display was drawn
  */
-void platform_play_audio(void);
+bool platform_set_overlay(const char *text);
 
 /**
- * Stops playing the active sounds.
+ * Collects pending input events and publishes the resulting keypad state.
+ *
+ * Should be called several times per frame, as input cannot reach the
+ * emulator any sooner than it is collected. Platforms that collect input on
+ * their own thread may publish it as events arrive, and do nothing here.
  */
-void platform_stop_audio(void);
+void platform_poll_input(void);
 
 /**
  * Get the current state of the keypad.
@@ -89,6 +109,9 @@ void platform_stop_audio(void);
  * with each bit indicating if the key is pressed or not. The bits are arranged
  * from 16 (MSB) to 0 (LSB).
  *
+ * The state is read atomically without locking, so this may be called from
+ * any thread, and is suited as the keypad source of the emulator.
+ *
  * @returns The current state of the keypad
  */
 uint16_t platform_get_keypad(void);
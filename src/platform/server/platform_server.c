@@ -0,0 +1,79 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "platform.h"
+#include "stream.h"
+
+static stream_server_t server;
+static uint16_t        keypad; // Published keypad; only accessed atomically
+
+void platform_init(uint8_t width, uint8_t height, uint8_t fps) {
+    (void)width;
+    (void)height;
+    (void)fps;
+
+    // Clients connect to a fixed port unless another one is configured
+    const char *port = getenv("CHIP8_PORT");
+    if (!stream_server_open(&server, port ? (uint16_t)strtoul(port, NULL, 10) : STREAM_DEFAULT_PORT)) {
+        fprintf(stderr, "ERROR: Failed to start the stream server.\n");
+        exit(1);
+    }
+    fprintf(stderr, "Streaming on port %u.\n", server.port);
+}
+
+void platform_close(void) {
+    stream_server_close(&server);
+}
+
+void platform_sleep(uint64_t microseconds) {
+    usleep(microseconds);
+}
+
+uint64_t platform_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)(ts.tv_nsec / 1000);
+}
+
+void platform_draw_display(const uint8_t *buffer, uint8_t width, uint8_t height) {
+    // Frames are sent at their own resolution, leaving any scaling to clients
+    stream_server_frame(&server, buffer, width, height);
+}
+
+void platform_play_audio(void) {
+    stream_server_sound(&server, true);
+}
+
+void platform_stop_audio(void) {
+    stream_server_sound(&server, false);
+}
+
+void platform_set_audio_pattern(const uint8_t *pattern, uint8_t pitch) {
+    (void)pattern;
+    (void)pitch;
+}
+
+uint64_t platform_get_audio_underruns(void) {
+    return 0;
+}
+
+bool platform_set_overlay(const char *text) {
+    // Clients only receive the display
+    (void)text;
+    return false;
+}
+
+void platform_poll_input(void) {
+    // Clients are accepted, read and written to between frames, which also
+    // sends any sound events queued since the latest frame
+    stream_server_poll(&server);
+    __atomic_store_n(&keypad, server.keypad, __ATOMIC_RELEASE);
+}
+
+uint16_t platform_get_keypad(void) {
+    return __atomic_load_n(&keypad, __ATOMIC_ACQUIRE);
+}
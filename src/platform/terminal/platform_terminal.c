@@ -0,0 +1,359 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "platform.h"
+
+#define KEY_HOLD      200000 // Microseconds a key stays held after each press without release events
+#define SEQUENCE_SIZE 32     // Longest escape sequence read from input
+#define CELL_OUTPUT   48     // Most bytes written for a single cell, including the cursor and colors
+#define EXTRA_OUTPUT  64     // Bytes written besides the cells, such as setting up the terminal
+
+// Characters mapped to each CHIP-8 key, keeping the layout of the COSMAC VIP
+// keypad on the left side of a QWERTY keyboard, as on the desktop
+static const char KEYMAP[16] = {'x', '1', '2', '3', 'q', 'w', 'e', 'a', 's', 'd', 'z', 'c', '4', 'r', 'f', 'v'};
+
+// Colors of the 256-color palette for every combination of the up to 4 display
+// planes; pixels of the first plane alone use the default foreground color
+static const uint8_t PALETTE[16] = {0, 15, 248, 240, 196, 46, 21, 226, 88, 22, 18, 220, 93, 117, 208, 218};
+
+static uint8_t  display_width;
+static uint8_t  display_height;
+static uint16_t keypad;      // Published keypad; only accessed atomically
+static bool     raw_input;   // If the terminal settings were changed and must be restored
+static int      input_mode;  // File status flags of the input before switching to non-blocking
+static int      output_mode; // File status flags of the output before switching to non-blocking
+static struct termios original;
+
+// Every cell is two pixels stacked on top of each other, stored as the palette
+// index of the top pixel in the high nibble, and of the bottom one in the low
+static uint8_t *cells;   // Cells of the latest frame drawn by the emulator
+static uint8_t *shown;   // Cells as they are once all written output arrives
+static bool     stale;   // If the latest frame has not been encoded yet
+static uint8_t  fg, bg;  // Colors last selected on the terminal
+static char    *output;  // Escape sequences waiting to be written
+static size_t   pending; // Bytes of the output not written yet
+static size_t   written; // Bytes of the output already written
+
+// Input state, with key releases only known when the terminal reports them
+static char     sequence[SEQUENCE_SIZE + 1];
+static uint8_t  sequence_length;
+static bool     releases;          // If the terminal reports key releases
+static uint16_t held;              // Keys held according to reported presses and releases
+static uint64_t pressed_until[16]; // Time until which each key counts as held without releases
+
+/**
+ * Gets the palette index a pixel is shown in, as the terminal cannot dim
+ * pixels which are fading out.
+ *
+ * @param pixel - The pixel of the frame buffer
+ * @returns The palette index of the pixel while it is at least a quarter as
+ * bright as lit, and 0 once darker
+ */
+static uint8_t shade(uint8_t pixel) {
+    return pixel >> 4 < 12 ? pixel & 0xF : 0;
+}
+
+/**
+ * Appends formatted text to the output.
+ *
+ * @param format - The format of the text, followed by its arguments
+ */
+static void emit(const char *format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    pending += vsprintf(&output[written + pending], format, arguments);
+    va_end(arguments);
+}
+
+/**
+ * Selects a color for the cells following on the terminal, if not selected.
+ *
+ * @param current - The selected color, updated once selected
+ * @param color - The palette index of the color to select
+ * @param background - If the background color is selected
+ */
+static void select_color(uint8_t *current, uint8_t color, bool background) {
+    if (*current == color) return;
+    *current = color;
+    if (color == 0 || (color == 1 && !background)) {
+        emit(background ? "\x1b[49m" : "\x1b[39m");
+    } else {
+        emit(background ? "\x1b[48;5;%dm" : "\x1b[38;5;%dm", PALETTE[color]);
+    }
+}
+
+/**
+ * Encodes the cells which changed since the shown frame into the output.
+ *
+ * The cursor is only moved across unchanged cells, and colors are only
+ * selected when they change, so static parts of the display cost nothing.
+ */
+static void encode_frame(void) {
+    uint16_t rows   = display_height / 2;
+    int32_t  cursor = -1; // Index of the cell the cursor is at, if known
+    for (uint16_t row = 0; row < rows; ++row) {
+        for (uint16_t column = 0; column < display_width; ++column) {
+            uint32_t index = row * display_width + column;
+            uint8_t  cell  = cells[index];
+            if (cell == shown[index]) continue;
+            shown[index] = cell;
+
+            if (cursor >= 0 && (uint32_t)cursor / display_width == row && (uint32_t)cursor < index) {
+                emit("\x1b[%dC", index - cursor);
+            } else if (cursor != (int32_t)index) {
+                emit("\x1b[%d;%dH", row + 1, column + 1);
+            }
+
+            // Half-blocks draw the lit half in the foreground color, leaving
+            // unlit halves in the default background
+            uint8_t top = cell >> 4, bottom = cell & 0xF;
+            if (top == bottom) {
+                select_color(&bg, 0, true);
+                if (top) select_color(&fg, top, false);
+                emit(top ? "\xe2\x96\x88" : " ");
+            } else if (top == 0 || bottom == 0) {
+                select_color(&bg, 0, true);
+                select_color(&fg, top | bottom, false);
+                emit(top ? "\xe2\x96\x80" : "\xe2\x96\x84");
+            } else {
+                select_color(&bg, bottom, true);
+                select_color(&fg, top, false);
+                emit("\xe2\x96\x80");
+            }
+
+            // Past the last column, the cursor waits to wrap into a row which
+            // is only the next one if the terminal is exactly as wide
+            cursor = column + 1 < display_width ? (int32_t)index + 1 : -1;
+        }
+    }
+}
+
+/**
+ * Writes as much pending output as the terminal accepts without blocking, and
+ * encodes the latest frame once everything before it was written.
+ *
+ * Frames drawn while the output is backed up, such as over a slow link, are
+ * never queued: only the latest one is encoded once the output drains.
+ */
+static void flush_output(void) {
+    while (true) {
+        while (pending > 0) {
+            ssize_t count = write(STDOUT_FILENO, &output[written], pending);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) pending = 0; // Output is gone
+                return;
+            }
+            written += count;
+            pending -= count;
+        }
+        written = 0;
+        if (!stale) return;
+
+        stale = false;
+        encode_frame();
+    }
+}
+
+/**
+ * Handles a key reported by the terminal.
+ *
+ * @param character - The character of the key
+ * @param event - 1 for presses, 2 for repeats, and 3 for releases
+ */
+static void handle_key(uint32_t character, uint8_t event) {
+    if (character >= 'A' && character <= 'Z') character += 'a' - 'A';
+    for (uint8_t k = 0; k < 16; ++k) {
+        if ((uint32_t)KEYMAP[k] != character) continue;
+
+        if (event == 3) {
+            held &= ~(1 << k);
+        } else {
+            held |= 1 << k;
+            pressed_until[k] = platform_get_time() + KEY_HOLD;
+        }
+    }
+}
+
+/**
+ * Handles a complete escape sequence read from the terminal.
+ *
+ * Only keys reported using the kitty keyboard protocol are handled, as
+ * `CSI code ; modifiers : event u`, which is the only way for a terminal to
+ * report key releases.
+ */
+static void handle_sequence(void) {
+    if (sequence_length < 3 || sequence[1] != '[' || sequence[sequence_length - 1] != 'u') return;
+    sequence[sequence_length] = '\0';
+
+    char    *end       = NULL;
+    uint32_t character = strtoul(&sequence[2], &end, 10);
+    uint32_t modifiers = 1;
+    uint8_t  event     = 1;
+    if (*end == ';') {
+        modifiers = strtoul(end + 1, &end, 10);
+        if (*end == ':') event = (uint8_t)strtoul(end + 1, &end, 10);
+    }
+    releases = true;
+
+    // Every key is reported as a sequence, so Ctrl+C no longer raises a signal
+    if (character == 'c' && ((modifiers - 1) & 0x4) && event != 3) {
+        raise(SIGINT);
+        return;
+    }
+    handle_key(character, event);
+}
+
+void platform_init(uint8_t width, uint8_t height, uint8_t fps) {
+    (void)fps;
+
+    display_width  = width;
+    display_height = height;
+
+    uint32_t count = width * (height / 2);
+    cells          = calloc(count, 1);
+    shown          = calloc(count, 1);
+    output         = malloc(count * CELL_OUTPUT + EXTRA_OUTPUT);
+    if (!cells || !shown || !output) {
+        fprintf(stderr, "ERROR: Failed to allocate the terminal display.\n");
+        exit(1);
+    }
+
+    // Keys are read as they are typed without echoing them, while keeping
+    // signals, so that Ctrl+C still shuts down the emulator
+    if (tcgetattr(STDIN_FILENO, &original) == 0) {
+        struct termios raw = original;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN]  = 0;
+        raw.c_cc[VTIME] = 0;
+        raw_input       = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+    }
+    input_mode  = fcntl(STDIN_FILENO, F_GETFL);
+    output_mode = fcntl(STDOUT_FILENO, F_GETFL);
+    fcntl(STDIN_FILENO, F_SETFL, input_mode | O_NONBLOCK);
+    fcntl(STDOUT_FILENO, F_SETFL, output_mode | O_NONBLOCK);
+
+    // Switches to the alternate screen, hides the cursor, and asks for key
+    // releases, which terminals without the kitty protocol ignore
+    emit("\x1b[?1049h\x1b[?25l\x1b[0m\x1b[2J\x1b[>11u");
+    fg = 1;
+    bg = 0;
+    flush_output();
+}
+
+void platform_close(void) {
+    // The rest of the output is written out before restoring the terminal
+    fcntl(STDOUT_FILENO, F_SETFL, output_mode & ~O_NONBLOCK);
+    flush_output();
+    emit("\x1b[<u\x1b[0m\x1b[?25h\x1b[?1049l");
+    flush_output();
+    fcntl(STDOUT_FILENO, F_SETFL, output_mode);
+    fcntl(STDIN_FILENO, F_SETFL, input_mode);
+    if (raw_input) tcsetattr(STDIN_FILENO, TCSANOW, &original);
+
+    free(cells);
+    free(shown);
+    free(output);
+}
+
+void platform_sleep(uint64_t microseconds) {
+    usleep(microseconds);
+}
+
+uint64_t platform_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)(ts.tv_nsec / 1000);
+}
+
+void platform_draw_display(const uint8_t *buffer, uint8_t width, uint8_t height) {
+    // Lower resolution modes are scaled up to fill the entire display, by the
+    // same factor in both directions
+    (void)height;
+    uint8_t scale = display_width / width;
+    for (uint16_t row = 0; row < display_height / 2; ++row) {
+        const uint8_t *top    = &buffer[(row * 2 / scale) * width];
+        const uint8_t *bottom = &buffer[((row * 2 + 1) / scale) * width];
+        uint8_t       *out    = &cells[row * display_width];
+        for (uint16_t column = 0; column < display_width; ++column) {
+            out[column] = shade(top[column / scale]) << 4 | shade(bottom[column / scale]);
+        }
+    }
+    stale = true;
+    flush_output();
+}
+
+void platform_play_audio(void) {
+    // The bell is the only sound a terminal can make, and is dropped while the
+    // output is backed up rather than piling up
+    if (pending > 0) return;
+    emit("\a");
+    flush_output();
+}
+
+void platform_stop_audio(void) {}
+
+void platform_set_audio_pattern(const uint8_t *pattern, uint8_t pitch) {
+    (void)pattern;
+    (void)pitch;
+}
+
+uint64_t platform_get_audio_underruns(void) {
+    return 0;
+}
+
+bool platform_set_overlay(const char *text) {
+    // The terminal has no room for text besides the display
+    (void)text;
+    return false;
+}
+
+void platform_poll_input(void) {
+    char    input[64];
+    ssize_t count;
+    while ((count = read(STDIN_FILENO, input, sizeof(input))) > 0) {
+        for (ssize_t b = 0; b < count; ++b) {
+            if (input[b] == '\x1b' || sequence_length > 0) {
+                if (sequence_length < SEQUENCE_SIZE) sequence[sequence_length++] = input[b];
+
+                // Sequences end with a final byte after the introducer
+                bool final = sequence_length > 2 && input[b] >= 0x40 && input[b] <= 0x7E;
+                if (final || sequence_length == SEQUENCE_SIZE || (sequence_length == 2 && input[b] != '[')) {
+                    handle_sequence();
+                    sequence_length = 0;
+                }
+            } else {
+                handle_key((uint8_t)input[b], 1);
+            }
+        }
+    }
+
+    // Without release events, keys count as held for a while after each press,
+    // which is bridged by the key repeat of the terminal while held down
+    uint16_t keys = held;
+    if (!releases) {
+        uint64_t now = platform_get_time();
+        keys         = 0;
+        for (uint8_t k = 0; k < 16; ++k) {
+            if (pressed_until[k] > now) keys |= 1 << k;
+        }
+    }
+    __atomic_store_n(&keypad, keys, __ATOMIC_RELEASE);
+
+    // Output backed up by a slow link continues draining between frames
+    flush_output();
+}
+
+uint16_t platform_get_keypad(void) {
+    return __atomic_load_n(&keypad, __ATOMIC_ACQUIRE);
+}
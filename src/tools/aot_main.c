@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "aot.h"
+#include "chip8.h"
+
+#define DEFAULT_FRAMES 600 // Ten seconds of emulation
+
+// Program linked into the runner by the recompiler
+extern const aot_program_t AOT_PROGRAM;
+
+static int usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-f frames] [-v]\n", name);
+    return 1;
+}
+
+/**
+ * Compares the observable state of two emulators.
+ *
+ * @param a - The first emulator
+ * @param b - The second emulator
+ * @returns If both emulators are in the same state
+ */
+static bool same_state(const chip8_t *a, const chip8_t *b) {
+    return a->pc == b->pc && a->i == b->i && a->stack_pointer == b->stack_pointer &&
+           a->delay_timer == b->delay_timer && a->sound_timer == b->sound_timer &&
+           memcmp(a->v, b->v, sizeof(a->v)) == 0 && memcmp(a->stack, b->stack, sizeof(a->stack)) == 0 &&
+           memcmp(a->memory, b->memory, a->memory_size) == 0 &&
+           memcmp(a->display, b->display, sizeof(uint64_t) * a->plane_size * a->display_planes) == 0;
+}
+
+static double elapsed(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv) {
+    uint32_t frames = DEFAULT_FRAMES;
+    bool     verify = false;
+
+    int option;
+    while ((option = getopt(argc, argv, "f:v")) != -1) {
+        switch (option) {
+            case 'f':
+                frames = strtoul(optarg, NULL, 10);
+                break;
+            case 'v':
+                verify = true;
+                break;
+            default:
+                return usage(argv[0]);
+        }
+    }
+    if (optind != argc || frames == 0) return usage(argv[0]);
+
+    // The reference interpreter runs the same program in lockstep when verifying
+    chip8_t chip8, reference;
+    if (!chip8_init(&chip8)) {
+        fprintf(stderr, "ERROR: Failed to initialize the emulator.\n");
+        return 1;
+    }
+    if (!aot_load(&chip8, &AOT_PROGRAM) || (verify && !chip8_clone(&reference, &chip8))) {
+        fprintf(stderr, "ERROR: Failed to load %s.\n", AOT_PROGRAM.name);
+        chip8_free(&chip8);
+        return 1;
+    }
+
+    uint32_t        cycles_per_frame = INSTRUCTIONS_PER_SECOND / FRAMES_PER_SECOND;
+    uint64_t        cycles           = 0;
+    int             status           = 0;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        chip8_state_t state;
+        uint32_t      run = aot_run(&chip8, &AOT_PROGRAM, cycles_per_frame, &state);
+        cycles += run;
+
+        if (verify) {
+            for (uint32_t c = 0; c < run; ++c) chip8_run_cycle(&reference);
+            chip8_update_timers(&reference);
+        }
+        chip8_update_timers(&chip8);
+
+        if (verify && !same_state(&chip8, &reference)) {
+            fprintf(stderr, "ERROR: Diverged from the interpreter in frame %u at 0x%04X.\n", frame, chip8.pc);
+            status = 1;
+            break;
+        }
+        if (state.status != CHIP8_OK) {
+            printf("Stopped in frame %u by opcode 0x%04X (status %d).\n", frame, state.opcode, state.status);
+            break;
+        }
+    }
+
+    double seconds = elapsed(&start);
+    printf("%s: %llu cycles in %.3fs (%.0f cycles/s)%s\n", AOT_PROGRAM.name, (unsigned long long)cycles, seconds,
+           seconds > 0 ? cycles / seconds : 0, verify && status == 0 ? ", matching the interpreter" : "");
+
+    if (verify) chip8_free(&reference);
+    chip8_free(&chip8);
+    return status;
+}
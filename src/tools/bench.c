@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "chip8.h"
+#include "rom_library.h"
+#include "variant.h"
+
+#define DEFAULT_FRAMES 6000 // 100 seconds of emulation
+
+// Names of the fused instruction pairs, in the order of `chip8_fusion_t`
+#define FUSION_NAME(name, first, second) #first " + " #second,
+static const char *FUSION_NAMES[FUSION_COUNT] = {CHIP8_FUSIONS(FUSION_NAME)};
+
+static int usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-f frames] [-c coverage] [-i] <rom> [variant]\n", name);
+    return 1;
+}
+
+#ifdef ENABLE_COVERAGE
+/**
+ * Writes the ranges of addresses set in a coverage bitmap, one per line.
+ *
+ * @param outfile - The file to write to
+ * @param label - The label preceding every range
+ * @param bitmap - The bitmap to write
+ * @param size - The number of addresses in the bitmap
+ */
+static void write_ranges(FILE *outfile, const char *label, const uint64_t *bitmap, uint32_t size) {
+    for (uint32_t address = 0; address < size; ++address) {
+        if (!chip8_covered(bitmap, address)) continue;
+
+        uint32_t start = address;
+        while (address + 1 < size && chip8_covered(bitmap, address + 1)) ++address;
+        fprintf(outfile, "%s 0x%04X 0x%04X\n", label, start, address);
+    }
+}
+
+/**
+ * Writes the coverage of a run in a line-based format.
+ *
+ * @param chip8 - The CHIP-8 which was run
+ * @param path - The path of the file to write
+ * @returns If the file was written successfully
+ */
+static bool write_coverage(const chip8_t *chip8, const char *path) {
+    FILE *outfile = fopen(path, "w");
+    if (!outfile) return false;
+
+    fprintf(outfile, "# chip8 coverage v1\n");
+    fprintf(outfile, "# executed|written <first> <last>, smc <writes> <first address>\n");
+    write_ranges(outfile, "executed", chip8->executed, chip8->memory_size);
+    write_ranges(outfile, "written", chip8->written, chip8->memory_size);
+    fprintf(outfile, "smc %u 0x%04X\n", chip8->smc_writes, chip8->smc_address);
+
+    bool failed = ferror(outfile);
+    return fclose(outfile) == 0 && !failed;
+}
+#endif
+
+int main(int argc, char **argv) {
+    uint32_t    frames   = DEFAULT_FRAMES;
+    const char *coverage = NULL;
+    bool        idle     = false;
+
+    int arg = 1;
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+        if (strcmp(argv[arg], "-i") == 0) {
+            idle = true;
+            --arg;
+        } else if (strcmp(argv[arg], "-f") == 0) {
+            frames = (uint32_t)strtoul(argv[arg + 1], NULL, 10);
+        } else if (strcmp(argv[arg], "-c") == 0) {
+            coverage = argv[arg + 1];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (argc - arg < 1 || argc - arg > 2 || frames == 0) return usage(argv[0]);
+#ifndef ENABLE_COVERAGE
+    if (coverage) {
+        fprintf(stderr, "ERROR: Coverage requires building with ENABLE_COVERAGE.\n");
+        return 1;
+    }
+#endif
+
+    rom_file_t rom;
+    if (!rom_map(&rom, argv[arg])) {
+        fprintf(stderr, "ERROR: Failed to read %s.\n", argv[arg]);
+        return 1;
+    }
+
+    rom_entry_t entry;
+    rom_entry_init(&entry, &rom, argv[arg]);
+    if (argc - arg > 1) entry.variant = variant_by_name(argv[arg + 1]);
+    if (entry.variant >= VARIANT_COUNT) {
+        fprintf(stderr, "ERROR: Unknown platform variant.\n");
+        rom_unmap(&rom);
+        return 1;
+    }
+
+    chip8_t chip8;
+    if (!chip8_init(&chip8) || !rom_load(&chip8, &rom, &entry)) {
+        fprintf(stderr, "ERROR: Failed to load %s.\n", argv[arg]);
+        rom_unmap(&rom);
+        return 1;
+    }
+    rom_unmap(&rom);
+
+    // Runs headlessly as fast as possible, ticking the timers once per frame
+    uint32_t        cycles_per_frame = INSTRUCTIONS_PER_SECOND / FRAMES_PER_SECOND;
+    uint64_t        cycles           = 0;
+    chip8_state_t   state            = {.status = CHIP8_OK};
+    uint64_t        previous         = chip8_hash(&chip8);
+    uint32_t        idle_frames      = 0;
+    uint32_t        first_idle       = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t frame = 0; frame < frames && state.status == CHIP8_OK; ++frame) {
+        cycles += chip8_run_cycles(&chip8, cycles_per_frame, &state);
+        chip8_update_timers(&chip8);
+
+        // Frames which end in the state they started in are spent idling,
+        // such as in a jump to itself
+        if (idle) {
+            uint64_t current = chip8_hash(&chip8);
+            if (current == previous && idle_frames++ == 0) first_idle = frame;
+            previous = current;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%s: %llu cycles in %.3fs (%.0f cycles/s)\n", entry.name, (unsigned long long)cycles, seconds,
+           seconds > 0 ? cycles / seconds : 0);
+    if (state.status != CHIP8_OK) {
+        printf("Stopped by opcode 0x%04X (status %d).\n", state.opcode, state.status);
+    }
+    if (idle_frames > 0) printf("Idle for %u frames, first in frame %u.\n", idle_frames, first_idle);
+
+    // Each fused pair covers two cycles that only needed a single dispatch
+    uint64_t fused = 0;
+    for (uint8_t f = 0; f < FUSION_COUNT; ++f) {
+        printf("  %-22s %10u\n", FUSION_NAMES[f], chip8.fusions[f]);
+        fused += chip8.fusions[f];
+    }
+    printf("  %-22s %9.1f%%\n", "Fused cycles", cycles ? 200.0 * fused / cycles : 0);
+
+#ifdef ENABLE_COVERAGE
+    // Code which is never written after executing is safe to predecode
+    uint32_t executed = 0, written = 0;
+    for (uint32_t address = 0; address < chip8.memory_size; ++address) {
+        executed += chip8_covered(chip8.executed, address);
+        written += chip8_covered(chip8.written, address);
+    }
+    printf("Coverage: %u bytes executed, %u bytes written\n", executed, written);
+    if (chip8.smc_writes) {
+        printf("Self-modifying code: %u writes, first at 0x%04X\n", chip8.smc_writes, chip8.smc_address);
+    } else {
+        printf("Self-modifying code: none\n");
+    }
+    if (coverage && !write_coverage(&chip8, coverage)) {
+        fprintf(stderr, "ERROR: Failed to write %s.\n", coverage);
+    }
+#endif
+
+    chip8_free(&chip8);
+    return 0;
+}
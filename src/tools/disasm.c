@@ -0,0 +1,56 @@
+#include <stdio.h>
+
+#include "chip8.h"
+#include "opcodes.h"
+#include "rom_library.h"
+#include "variant.h"
+
+static int usage(const char *name) {
+    fprintf(stderr, "Usage: %s <rom> [variant]\n", name);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) return usage(argv[0]);
+
+    rom_file_t rom;
+    if (!rom_map(&rom, argv[1])) {
+        fprintf(stderr, "ERROR: Failed to read %s.\n", argv[1]);
+        return 1;
+    }
+
+    // Like the emulator, the variant is guessed from the ROM unless provided
+    rom_entry_t entry;
+    rom_entry_init(&entry, &rom, argv[1]);
+    if (argc > 2) entry.variant = variant_by_name(argv[2]);
+    if (entry.variant >= VARIANT_COUNT) {
+        fprintf(stderr, "ERROR: Unknown platform variant.\n");
+        rom_unmap(&rom);
+        return 1;
+    }
+
+    // Disassembly is linear, so data embedded in the program is decoded as
+    // instructions when it happens to match one
+    char   assembly[32];
+    size_t offset = 0;
+    while (offset + 1 < rom.size) {
+        uint16_t opcode  = (rom.data[offset] << 8) | rom.data[offset + 1];
+        uint16_t operand = offset + 3 < rom.size ? (rom.data[offset + 2] << 8) | rom.data[offset + 3] : 0;
+        uint8_t  size    = opcode_size(opcode, entry.variant);
+        if (offset + size > rom.size) size = 2;
+
+        opcode_disassemble(assembly, sizeof(assembly), opcode, operand, entry.variant, entry.quirks);
+        if (size == 4) {
+            printf("0x%04zX: %04X %04X  %s\n", PROGRAM_START + offset, opcode, operand, assembly);
+        } else {
+            printf("0x%04zX: %04X       %s\n", PROGRAM_START + offset, opcode, assembly);
+        }
+        offset += size;
+    }
+    if (offset < rom.size) {
+        printf("0x%04zX: %02X         DB 0x%02X\n", PROGRAM_START + offset, rom.data[offset], rom.data[offset]);
+    }
+
+    rom_unmap(&rom);
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "env.h"
+#include "rom_library.h"
+
+#define DEFAULT_ENVS      64      // Environments stepped together
+#define DEFAULT_THREADS   1       // Threads stepping, including the main thread
+#define DEFAULT_FRAMESKIP 4       // Frames per step, as commonly used for agents
+#define DEFAULT_STEPS     2000    // Batches of steps to run
+#define ACTION_SEED       0xAC7   // Seed of the random actions
+
+static int usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-n envs] [-j threads] [-k frameskip] [-s steps] <rom>\n", name);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    uint32_t envs      = DEFAULT_ENVS;
+    uint32_t threads   = DEFAULT_THREADS;
+    uint32_t frameskip = DEFAULT_FRAMESKIP;
+    uint32_t steps     = DEFAULT_STEPS;
+
+    int option;
+    while ((option = getopt(argc, argv, "n:j:k:s:")) != -1) {
+        switch (option) {
+            case 'n':
+                envs = strtoul(optarg, NULL, 10);
+                break;
+            case 'j':
+                threads = strtoul(optarg, NULL, 10);
+                break;
+            case 'k':
+                frameskip = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                steps = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                return usage(argv[0]);
+        }
+    }
+    if (argc - optind != 1 || envs == 0 || frameskip == 0) return usage(argv[0]);
+
+    rom_file_t  rom;
+    rom_entry_t entry;
+    if (!rom_map(&rom, argv[optind])) {
+        fprintf(stderr, "ERROR: Failed to read %s.\n", argv[optind]);
+        return 1;
+    }
+    rom_entry_init(&entry, &rom, argv[optind]);
+
+    // Without game-specific terms, episodes only end when the program fails
+    env_config_t config = {
+        .rom      = rom.data,
+        .rom_size = rom.size,
+        .variant  = entry.variant,
+        .quirks   = entry.quirks,
+        .seed     = rom.hash,
+    };
+    env_vec_t vec;
+    bool      created = env_vec_init(&vec, &config, envs, threads);
+    rom_unmap(&rom);
+    if (!created) {
+        fprintf(stderr, "ERROR: Failed to create the environments.\n");
+        return 1;
+    }
+
+    size_t    words        = vec.words;
+    uint64_t *observations = malloc(sizeof(uint64_t) * words * envs);
+    uint16_t *actions      = malloc(sizeof(uint16_t) * envs);
+    float    *rewards      = malloc(sizeof(float) * envs);
+    bool     *dones        = malloc(sizeof(bool) * envs);
+    if (!observations || !actions || !rewards || !dones) {
+        fprintf(stderr, "ERROR: Failed to allocate the batches.\n");
+        free(observations);
+        free(actions);
+        free(rewards);
+        free(dones);
+        env_vec_free(&vec);
+        return 1;
+    }
+
+    // Holds down a single random key, or none, in every step
+    uint64_t        seed     = ACTION_SEED;
+    uint64_t        episodes = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    env_vec_reset(&vec, observations);
+    for (uint32_t s = 0; s < steps; ++s) {
+        for (uint32_t e = 0; e < envs; ++e) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            actions[e] = (uint16_t)(1 << (seed % 17) & 0xFFFF);
+        }
+        env_vec_step(&vec, actions, frameskip, observations, rewards, dones);
+        for (uint32_t e = 0; e < envs; ++e) episodes += dones[e];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double   seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    uint64_t total   = (uint64_t)steps * envs;
+    printf("%s: %llu steps of %u frames in %.3fs (%.0f steps/s, %.0f frames/s) on %u threads\n", entry.name,
+           (unsigned long long)total, frameskip, seconds, seconds > 0 ? total / seconds : 0,
+           seconds > 0 ? total * frameskip / seconds : 0, vec.threads);
+    printf("Episodes ended: %llu\n", (unsigned long long)episodes);
+
+    free(observations);
+    free(actions);
+    free(rewards);
+    free(dones);
+    env_vec_free(&vec);
+    return 0;
+}
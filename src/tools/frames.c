@@ -0,0 +1,122 @@
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "export.h"
+
+#define DEFAULT_NAME "/chip8" // Object the emulator publishes into by default
+#define POLL_DELAY   1000     // Microseconds to wait for the next frame
+
+static volatile sig_atomic_t running = 1; // Cleared when asked to shut down
+
+static void handle_shutdown(int signal) {
+    (void)signal;
+    running = 0;
+}
+
+static int usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-n frames] [-d] [name]\n", name);
+    return 1;
+}
+
+/**
+ * Draws the display of a frame as text, straight from shared memory.
+ *
+ * @param frame - The frame to draw
+ * @param text - Receives the drawn lines, one character per pixel
+ */
+static void draw_frame(const export_frame_t *frame, char *text) {
+    uint8_t width  = frame->display_width <= HIRES_DISPLAY_WIDTH ? frame->display_width : HIRES_DISPLAY_WIDTH;
+    uint8_t height = frame->display_height <= HIRES_DISPLAY_HEIGHT ? frame->display_height : HIRES_DISPLAY_HEIGHT;
+    uint8_t planes = frame->display_planes <= 4 ? frame->display_planes : 4;
+    for (uint8_t y = 0; y < height; ++y) {
+        for (uint8_t x = 0; x < width; ++x) {
+            uint64_t mask  = 0x8000000000000000ULL >> (x % DISPLAY_ROW_BITS);
+            uint32_t index = y * frame->display_stride + x / DISPLAY_ROW_BITS;
+            uint8_t  pixel = 0;
+            for (uint8_t p = 0; p < planes && index + p * frame->plane_size < EXPORT_DISPLAY_WORDS; ++p) {
+                if (frame->display[index + p * frame->plane_size] & mask) pixel |= 1 << p;
+            }
+            *text++ = " #+*"[pixel & 0x3];
+        }
+        *text++ = '\n';
+    }
+    *text = '\0';
+}
+
+int main(int argc, char **argv) {
+    uint64_t limit = 0;
+    bool     draw  = false;
+
+    int option;
+    while ((option = getopt(argc, argv, "n:d")) != -1) {
+        switch (option) {
+            case 'n':
+                limit = strtoull(optarg, NULL, 10);
+                break;
+            case 'd':
+                draw = true;
+                break;
+            default:
+                return usage(argv[0]);
+        }
+    }
+    if (argc - optind > 1) return usage(argv[0]);
+
+    const char *name = optind < argc ? argv[optind] : DEFAULT_NAME;
+    export_t    reader;
+    if (!export_attach(&reader, name)) {
+        fprintf(stderr, "ERROR: Failed to attach to %s.\n", name);
+        return 1;
+    }
+    signal(SIGINT, handle_shutdown);
+    signal(SIGTERM, handle_shutdown);
+
+    // Follows the frames in order, starting from the latest one, and skips
+    // ahead whenever the emulator laps the reader
+    static char text[(HIRES_DISPLAY_WIDTH + 1) * HIRES_DISPLAY_HEIGHT + 1];
+    uint64_t    next    = 0;
+    uint64_t    read    = 0;
+    uint64_t    dropped = 0;
+    uint64_t    retried = 0;
+    while (running && (limit == 0 || read < limit)) {
+        uint64_t head = __atomic_load_n(&reader.ring->head, __ATOMIC_ACQUIRE);
+        if (head == 0 || head < next) {
+            usleep(POLL_DELAY);
+            continue;
+        }
+        if (next == 0) next = head;
+        if (head - next >= EXPORT_SLOTS) {
+            dropped += head - next;
+            next = head;
+        }
+
+        uint64_t              sequence;
+        const export_frame_t *frame = export_read(reader.ring, next, &sequence);
+        if (!frame) {
+            ++retried;
+            continue;
+        }
+        uint64_t cycles = frame->cycles;
+        uint16_t pc     = frame->pc;
+        uint16_t i      = frame->i;
+        int      dirty  = __builtin_popcountll(frame->dirty_rows);
+        if (draw) draw_frame(frame, text);
+        if (!export_validate(frame, sequence)) {
+            ++retried;
+            continue;
+        }
+
+        printf("Frame %llu: cycles %llu, PC 0x%04X, I 0x%04X, %d dirty rows\n", (unsigned long long)next,
+               (unsigned long long)cycles, pc, i, dirty);
+        if (draw && dirty) fputs(text, stdout);
+        ++next;
+        ++read;
+    }
+
+    printf("Read %llu frames, dropped %llu, retried %llu\n", (unsigned long long)read, (unsigned long long)dropped,
+           (unsigned long long)retried);
+    export_close(&reader);
+    return 0;
+}
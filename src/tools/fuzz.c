@@ -0,0 +1,185 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "chip8.h"
+#include "variant.h"
+
+#define FUZZ_CYCLES     1000     // Longest run of a single input
+#define FUZZ_EXECS      1000000  // Default number of inputs of the standalone driver
+#define FUZZ_INPUT_SIZE 4096     // Largest input of the standalone driver
+#define FUZZ_SEED       0x5EED   // Seed of the standalone driver
+
+// One emulator per variant, each reset to its own baseline before every input
+static chip8_t emulators[VARIANT_COUNT];
+static chip8_t baselines[VARIANT_COUNT];
+static bool    initialized = false;
+static bool    full_reset  = false; // Reloads the program instead, for comparison
+
+/**
+ * Prepares the emulators and their baselines on first use.
+ *
+ * @returns If every emulator is ready
+ */
+static bool fuzz_init(void) {
+    if (initialized) return true;
+    for (uint8_t v = 0; v < VARIANT_COUNT; ++v) {
+        if (!chip8_init(&emulators[v]) || !chip8_set_variant(&emulators[v], v) ||
+            !chip8_capture(&baselines[v], &emulators[v])) {
+            return false;
+        }
+    }
+    initialized = true;
+    return true;
+}
+
+/**
+ * Runs a single input, in the form expected by libFuzzer.
+ *
+ * The lowest bit of the first byte selects the variant, and the remaining
+ * bytes are loaded as the program, which runs until it fails or exhausts its
+ * cycles. Timers tick at the same rate as in the emulator.
+ *
+ * @param data - The input to run
+ * @param size - The size of the input
+ * @returns Always 0
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size == 0 || !fuzz_init()) return 0;
+
+    chip8_t *chip8   = &emulators[data[0] & 0x1];
+    size_t   program = size - 1;
+    if (program > chip8->memory_size - PROGRAM_START) program = chip8->memory_size - PROGRAM_START;
+
+    if (full_reset) {
+        chip8_load_program(chip8, &data[1], (uint16_t)program);
+    } else {
+        chip8_restore(chip8, &baselines[data[0] & 0x1]);
+        chip8_patch_memory(chip8, PROGRAM_START, &data[1], program);
+    }
+
+    uint32_t cycles_per_frame = INSTRUCTIONS_PER_SECOND / FRAMES_PER_SECOND;
+    for (uint32_t c = 1; c <= FUZZ_CYCLES; ++c) {
+        if (chip8_run_cycle(chip8).status != CHIP8_OK) break;
+        if (c % cycles_per_frame == 0) chip8_update_timers(chip8);
+    }
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+static uint64_t rng = FUZZ_SEED;
+
+static uint64_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+/**
+ * Mutates an input by flipping, replacing or duplicating a few bytes.
+ *
+ * @param input - The input to mutate
+ * @param size - The size of the input
+ * @param capacity - The largest size the input may grow to
+ * @returns The new size of the input
+ */
+static size_t mutate(uint8_t *input, size_t size, size_t capacity) {
+    uint8_t mutations = 1 + next_random() % 4;
+    for (uint8_t m = 0; m < mutations; ++m) {
+        size_t at = next_random() % size;
+        switch (next_random() % 3) {
+            case 0:
+                input[at] ^= 1 << (next_random() % 8);
+                break;
+            case 1:
+                input[at] = (uint8_t)next_random();
+                break;
+            default:
+                if (size + 2 <= capacity) {
+                    memmove(&input[at + 2], &input[at], size - at);
+                    size += 2;
+                }
+                break;
+        }
+    }
+    return size;
+}
+
+static int usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-n execs] [-r] [rom...]\n", name);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    uint64_t execs = FUZZ_EXECS;
+
+    int option;
+    while ((option = getopt(argc, argv, "n:r")) != -1) {
+        switch (option) {
+            case 'n':
+                execs = strtoull(optarg, NULL, 10);
+                break;
+            case 'r':
+                full_reset = true;
+                break;
+            default:
+                return usage(argv[0]);
+        }
+    }
+    int arg = optind;
+
+    if (!fuzz_init()) {
+        fprintf(stderr, "ERROR: Failed to initialize the emulators.\n");
+        return 1;
+    }
+
+    // ROMs seed the corpus; without them inputs start out as random bytes
+    size_t   seeds  = argc > arg ? (size_t)(argc - arg) : 1;
+    uint8_t *corpus = calloc(seeds, FUZZ_INPUT_SIZE);
+    size_t  *sizes  = calloc(seeds, sizeof(size_t));
+    uint8_t *input  = malloc(FUZZ_INPUT_SIZE);
+    if (!corpus || !sizes || !input) return 1;
+    for (size_t s = 0; s < seeds; ++s) {
+        uint8_t *seed = &corpus[s * FUZZ_INPUT_SIZE];
+        FILE    *file = arg + (int)s < argc ? fopen(argv[arg + s], "rb") : NULL;
+        if (file) {
+            sizes[s] = 1 + fread(&seed[1], 1, FUZZ_INPUT_SIZE - 1, file);
+            seed[0]  = strstr(argv[arg + s], ".xo8") ? VARIANT_XOCHIP : VARIANT_CHIP8;
+            fclose(file);
+        } else {
+            sizes[s] = 64;
+            for (size_t j = 0; j < sizes[s]; ++j) seed[j] = (uint8_t)next_random();
+        }
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t e = 0; e < execs; ++e) {
+        size_t s    = next_random() % seeds;
+        size_t size = sizes[s];
+        memcpy(input, &corpus[s * FUZZ_INPUT_SIZE], size);
+        size = mutate(input, size, FUZZ_INPUT_SIZE);
+        LLVMFuzzerTestOneInput(input, size);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%llu execs in %.3fs (%.0f execs/s) using %s\n", (unsigned long long)execs, seconds,
+           seconds > 0 ? execs / seconds : 0, full_reset ? "full reloads" : "baseline restores");
+
+    for (uint8_t v = 0; v < VARIANT_COUNT; ++v) {
+        chip8_free(&emulators[v]);
+        chip8_free(&baselines[v]);
+    }
+    free(corpus);
+    free(sizes);
+    free(input);
+    return 0;
+}
+#endif
@@ -0,0 +1,102 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chip8.h"
+#include "rom_library.h"
+#include "variant.h"
+
+static int usage(const char *name) {
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "  %s scan <directory> <index>\n", name);
+    fprintf(stderr, "  %s list <index>\n", name);
+    fprintf(stderr, "  %s set <index> <rom> <variant> <quirks>\n", name);
+    return 1;
+}
+
+static int scan(const char *directory, const char *path) {
+    rom_index_t index;
+    if (!rom_index_init(&index)) return 1;
+
+    // A missing index is not an error, as the scan will create it
+    rom_index_load(&index, path);
+
+    int added = rom_index_scan(&index, directory);
+    if (added < 0) {
+        fprintf(stderr, "ERROR: Failed to scan %s.\n", directory);
+        rom_index_free(&index);
+        return 1;
+    }
+
+    bool saved = rom_index_save(&index, path);
+    printf("Added %d ROMs, %" PRIu32 " indexed.\n", added, index.count);
+    rom_index_free(&index);
+    return saved ? 0 : 1;
+}
+
+static int list(const char *path) {
+    rom_index_t index;
+    if (!rom_index_init(&index)) return 1;
+    if (!rom_index_load(&index, path)) {
+        fprintf(stderr, "ERROR: Failed to read %s.\n", path);
+        rom_index_free(&index);
+        return 1;
+    }
+
+    for (uint32_t j = 0; j < index.capacity; ++j) {
+        const rom_entry_t *entry = &index.entries[j];
+        if (entry->size == 0) continue;
+        printf(
+            "%016" PRIx64 " %6" PRIu32 " %-8s %c%c%c %s\n",
+            entry->hash,
+            entry->size,
+            variant_get(entry->variant).name,
+            entry->quirks & QUIRK_OFFSET_JUMP ? 'j' : '-',
+            entry->quirks & QUIRK_MEMORY ? 'm' : '-',
+            entry->quirks & QUIRK_SHIFT ? 's' : '-',
+            entry->name
+        );
+    }
+
+    rom_index_free(&index);
+    return 0;
+}
+
+static int set(const char *path, const char *rom_path, const char *variant_name, const char *quirks) {
+    variant_type_t variant = variant_by_name(variant_name);
+    if (variant == VARIANT_COUNT) {
+        fprintf(stderr, "ERROR: Unknown variant %s.\n", variant_name);
+        return 1;
+    }
+
+    rom_file_t rom;
+    if (!rom_map(&rom, rom_path)) {
+        fprintf(stderr, "ERROR: Failed to read %s.\n", rom_path);
+        return 1;
+    }
+
+    rom_index_t index;
+    if (!rom_index_init(&index)) {
+        rom_unmap(&rom);
+        return 1;
+    }
+    rom_index_load(&index, path);
+
+    rom_entry_t entry;
+    rom_entry_init(&entry, &rom, rom_path);
+    entry.variant = variant;
+    entry.quirks  = (uint8_t)strtoul(quirks, NULL, 16) & QUIRK_ALL;
+
+    bool saved = rom_index_put(&index, &entry) && rom_index_save(&index, path);
+    rom_index_free(&index);
+    rom_unmap(&rom);
+    return saved ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 4 && strcmp(argv[1], "scan") == 0) return scan(argv[2], argv[3]);
+    if (argc == 3 && strcmp(argv[1], "list") == 0) return list(argv[2]);
+    if (argc == 6 && strcmp(argv[1], "set") == 0) return set(argv[2], argv[3], argv[4], argv[5]);
+    return usage(argv[0]);
+}
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "chip8.h"
+#include "lockstep.h"
+#include "opcodes.h"
+#include "rom_library.h"
+#include "variant.h"
+
+#define DEFAULT_ENGINE   "fused"
+#define DEFAULT_INTERVAL 1000    // Cycles between comparisons of the state hashes
+#define DEFAULT_CYCLES   600000  // Cycles run per ROM; about 14 minutes of emulation
+#define DEFAULT_STREAMS  1000    // Random programs run without any ROMs
+#define STREAM_CYCLES    10000   // Cycles run per random program
+#define STREAM_SIZE      256     // Size of random programs in bytes
+#define STREAM_SEED      0x5EED  // Default seed of the random programs
+
+static int usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-e engine] [-n interval] [-c cycles] [-s streams] [-r seed] [rom...]\n", name);
+    return 1;
+}
+
+/**
+ * Prints the state from which two engines diverge, so that the divergence
+ * can be reproduced from scratch.
+ *
+ * @param result - The result of the diverging comparison
+ * @param engine - The name of the compared engine
+ */
+static void print_repro(const lockstep_result_t *result, const char *engine) {
+    const chip8_t *repro = &result->repro;
+    printf("Diverged within %u cycles after cycle %llu: reference 0x%016llX, %s 0x%016llX\n", result->length,
+           (unsigned long long)result->cycles, (unsigned long long)result->hashes[0], engine,
+           (unsigned long long)result->hashes[1]);
+    printf("Repro (%s, quirks 0x%X%s):\n", variant_get(repro->variant).name, repro->quirks,
+           result->minimized ? ", minimized" : "");
+    printf("  PC 0x%04X  I 0x%04X  SP %d  DT %u  ST %u  RNG 0x%016llX%s\n", repro->pc, repro->i,
+           repro->stack_pointer, repro->delay_timer, repro->sound_timer, (unsigned long long)repro->rng,
+           repro->hires ? "  HIRES" : "");
+    printf("  V0-VF");
+    for (uint8_t x = 0; x < 16; ++x) printf(" %02X", repro->v[x]);
+    printf("\n");
+    if (repro->stack_pointer >= 0) {
+        printf("  Stack");
+        for (int8_t s = 0; s <= repro->stack_pointer; ++s) printf(" %04X", repro->stack[s]);
+        printf("\n");
+    }
+
+    // The instructions leading into the divergence, as far as they are linear
+    uint16_t address = repro->pc;
+    for (uint32_t c = 0; c <= result->length && address + 1u < repro->memory_size; ++c) {
+        uint16_t opcode  = repro->memory[address] << 8 | repro->memory[address + 1];
+        uint16_t operand = 0;
+        if (address + 3u < repro->memory_size) operand = repro->memory[address + 2] << 8 | repro->memory[address + 3];
+
+        char assembly[32];
+        opcode_disassemble(assembly, sizeof(assembly), opcode, operand, repro->variant, repro->quirks);
+        printf("  %04X: %04X  %s\n", address, opcode, assembly);
+        address += opcode_size(opcode, repro->variant);
+    }
+
+    // Every non-zero line of memory which was needed to diverge
+    for (uint32_t line = 0; line < repro->memory_size; line += 16) {
+        bool empty = true;
+        for (uint8_t b = 0; b < 16; ++b) empty &= repro->memory[line + b] == 0;
+        if (empty) continue;
+
+        printf("  [%04X]", line);
+        for (uint8_t b = 0; b < 16; ++b) printf(" %02X", repro->memory[line + b]);
+        printf("\n");
+    }
+}
+
+/**
+ * Compares the engines over a program, printing a repro on divergence.
+ *
+ * @param chip8 - The CHIP-8 with the program loaded
+ * @param name - The name of the program
+ * @param engine - The name of the compared engine
+ * @param cycles - The most cycles to run
+ * @param interval - The number of cycles between comparisons
+ * @returns If the engines agreed on the program
+ */
+static bool compare(const chip8_t *chip8, const char *name, const char *engine, uint64_t cycles, uint32_t interval) {
+    lockstep_result_t result;
+    if (!lockstep_compare(&result, chip8, lockstep_run_reference, lockstep_engine_by_name(engine), cycles,
+                          interval)) {
+        fprintf(stderr, "ERROR: Failed to run %s.\n", name);
+        return false;
+    }
+    if (!result.diverged) return true;
+
+    printf("%s: ", name);
+    print_repro(&result, engine);
+    lockstep_free(&result);
+    return false;
+}
+
+int main(int argc, char **argv) {
+    const char *engine   = DEFAULT_ENGINE;
+    uint32_t    interval = DEFAULT_INTERVAL;
+    uint64_t    cycles   = 0;
+    uint32_t    streams  = DEFAULT_STREAMS;
+    uint64_t    seed     = STREAM_SEED;
+
+    int option;
+    while ((option = getopt(argc, argv, "e:n:c:s:r:")) != -1) {
+        switch (option) {
+            case 'e':
+                engine = optarg;
+                break;
+            case 'n':
+                interval = strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                cycles = strtoull(optarg, NULL, 10);
+                break;
+            case 's':
+                streams = strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                seed = strtoull(optarg, NULL, 0);
+                break;
+            default:
+                return usage(argv[0]);
+        }
+    }
+    if (interval == 0 || seed == 0) return usage(argv[0]);
+    if (!lockstep_engine_by_name(engine)) {
+        fprintf(stderr, "ERROR: Unknown engine %s.\n", engine);
+        return 1;
+    }
+
+    chip8_t chip8;
+    if (!chip8_init(&chip8)) {
+        fprintf(stderr, "ERROR: Failed to initialize the emulator.\n");
+        return 1;
+    }
+
+    uint32_t failures = 0;
+    for (int arg = optind; arg < argc; ++arg) {
+        rom_file_t  rom;
+        rom_entry_t entry;
+        if (!rom_map(&rom, argv[arg])) {
+            fprintf(stderr, "ERROR: Failed to read %s.\n", argv[arg]);
+            ++failures;
+            continue;
+        }
+        rom_entry_init(&entry, &rom, argv[arg]);
+        bool loaded = rom_load(&chip8, &rom, &entry);
+        rom_unmap(&rom);
+
+        if (!loaded || !compare(&chip8, entry.name, engine, cycles ? cycles : DEFAULT_CYCLES, interval)) ++failures;
+    }
+
+    // Without ROMs, random programs of every variant are compared instead
+    if (optind == argc) {
+        uint8_t program[STREAM_SIZE];
+        for (uint32_t s = 0; s < streams; ++s) {
+            char name[32];
+            snprintf(name, sizeof(name), "Stream %u", s);
+
+            variant_type_t variant = s % VARIANT_COUNT;
+            lockstep_random_program(program, sizeof(program), variant, &seed);
+            if (!chip8_set_variant(&chip8, variant) || !chip8_load_program(&chip8, program, sizeof(program)) ||
+                !compare(&chip8, name, engine, cycles ? cycles : STREAM_CYCLES, interval)) {
+                ++failures;
+            }
+        }
+    }
+
+    uint32_t total = optind == argc ? streams : (uint32_t)(argc - optind);
+    printf("%s: %u of %u programs matched the reference\n", engine, total - failures, total);
+
+    chip8_free(&chip8);
+    return failures > 0;
+}
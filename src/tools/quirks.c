@@ -0,0 +1,293 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "chip8.h"
+#include "rom_library.h"
+#include "variant.h"
+
+#define DEFAULT_FRAMES     600             // 10 seconds of emulated time
+#define RNG_SEED           0x2545F491      // Shared by all runs for a fair comparison
+#define COMBINATIONS       (QUIRK_ALL + 1) // Every subset of the quirks
+#define PENALTY_FAILURE    1000.0          // Cost of any fatal error during a run
+#define WEIGHT_SURVIVAL    100.0           // Reward for running the entire budget
+#define WEIGHT_ENTROPY     10.0            // Reward per bit of display entropy
+#define ENTROPY_PLAUSIBLE  4.0             // Entropy above which the display looks like noise
+#define SCORE_TOLERANCE    1e-9            // Scores closer than this are considered tied
+
+// A single speculative run of a ROM using one combination of quirks.
+typedef struct {
+    const chip8_t *initial;         // Shared starting state of all runs of the ROM
+    uint8_t        quirks;          // Quirks used for this run
+    uint32_t       frames;          // Frame budget of the run
+    uint32_t       frames_run;      // Frames completed before the run ended
+    uint32_t       invalid_opcodes; // Opcodes that do not resolve to an instruction
+    uint32_t       stack_errors;    // Stack overflows and underflows
+    uint32_t       range_errors;    // Accesses past the end of memory
+    double         entropy;         // Mean display entropy over all frames
+    double         score;           // Plausibility of the run; higher is better
+} run_t;
+
+// Work shared between the worker threads.
+typedef struct {
+    run_t           *runs;  // All runs of all ROMs
+    size_t           count; // Number of runs
+    size_t           next;  // Next run to be claimed by a worker
+    pthread_mutex_t  lock;  // Guards claiming runs
+} queue_t;
+
+/**
+ * Computes the Shannon entropy of the display, byte by byte.
+ *
+ * @param chip8 - The CHIP-8 to measure the display of
+ * @returns The entropy in bits per byte
+ */
+static double display_entropy(const chip8_t *chip8) {
+    uint32_t       histogram[256] = {0};
+    const uint8_t *bytes          = (const uint8_t *)chip8->display;
+    size_t         size           = sizeof(uint64_t) * chip8->plane_size * chip8->display_planes;
+    for (size_t j = 0; j < size; ++j) {
+        histogram[bytes[j]]++;
+    }
+
+    double entropy = 0.0;
+    for (uint32_t j = 0; j < 256; ++j) {
+        if (!histogram[j]) continue;
+        double p = (double)histogram[j] / size;
+        entropy -= p * log2(p);
+    }
+    return entropy;
+}
+
+/**
+ * Runs a ROM with a single combination of quirks and scores the run.
+ *
+ * The run ends early on the first fatal error. Accesses past the end of
+ * memory would safely wrap around, but rarely happen with the right quirks,
+ * so they are caught before executing the instruction and end the run.
+ *
+ * @param run - The run to execute
+ */
+static void execute_run(run_t *run) {
+    chip8_t chip8;
+    if (!chip8_clone(&chip8, run->initial)) {
+        run->score = -INFINITY;
+        return;
+    }
+    chip8_set_quirks(&chip8, run->quirks);
+    chip8_seed_rng(&chip8, RNG_SEED);
+
+    uint32_t cycles_per_frame = INSTRUCTIONS_PER_SECOND / FRAMES_PER_SECOND;
+    bool     failed           = false;
+    double   entropy          = 0.0;
+
+    while (!failed && run->frames_run < run->frames) {
+        for (uint32_t c = 0; c < cycles_per_frame && !failed; ++c) {
+            if ((uint32_t)chip8.pc + 1 >= chip8.memory_size) {
+                run->range_errors++;
+                failed = true;
+                break;
+            }
+
+            uint16_t opcode = (chip8.memory[chip8.pc] << 8) | chip8.memory[chip8.pc + 1];
+            uint32_t length = chip8_access_length(&chip8, opcode);
+            if (length && (uint32_t)chip8.i + length > chip8.memory_size) {
+                run->range_errors++;
+                failed = true;
+                break;
+            }
+
+            chip8_state_t state = chip8_run_cycle(&chip8);
+            switch (state.status) {
+                case CHIP8_OK:
+                    break;
+                case CHIP8_STACK_EMPTY:
+                case CHIP8_STACK_FULL:
+                    run->stack_errors++;
+                    failed = true;
+                    break;
+                default:
+                    run->invalid_opcodes++;
+                    failed = true;
+                    break;
+            }
+        }
+
+        chip8_update_timers(&chip8);
+        entropy += display_entropy(&chip8);
+        run->frames_run++;
+    }
+
+    run->entropy = run->frames_run ? entropy / run->frames_run : 0.0;
+
+    // Plausible displays are rewarded, while noise is rewarded less the
+    // more random it gets
+    double plausibility = run->entropy <= ENTROPY_PLAUSIBLE ? run->entropy : 2 * ENTROPY_PLAUSIBLE - run->entropy;
+    uint32_t failures   = run->invalid_opcodes + run->stack_errors + run->range_errors;
+    run->score          = WEIGHT_SURVIVAL * run->frames_run / run->frames +
+                 WEIGHT_ENTROPY * plausibility -
+                 PENALTY_FAILURE * failures;
+
+    chip8_free(&chip8);
+}
+
+static void *worker(void *data) {
+    queue_t *queue = data;
+
+    while (true) {
+        pthread_mutex_lock(&queue->lock);
+        size_t claimed = queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+        if (claimed >= queue->count) return NULL;
+
+        execute_run(&queue->runs[claimed]);
+    }
+}
+
+/**
+ * Picks the most plausible combination of quirks for a single ROM.
+ *
+ * Ties are common, since most ROMs never reach the affected instructions, so
+ * they are broken in favor of the quirks closest to the current profile.
+ *
+ * @param runs - The runs of every combination for the ROM
+ * @param current - The quirks currently stored for the ROM
+ * @returns The winning run
+ */
+static const run_t *pick_winner(const run_t *runs, uint8_t current) {
+    const run_t *winner = &runs[current];
+    for (uint8_t q = 0; q < COMBINATIONS; ++q) {
+        const run_t *run = &runs[q];
+        if (run->score > winner->score + SCORE_TOLERANCE) {
+            winner = run;
+        } else if (fabs(run->score - winner->score) <= SCORE_TOLERANCE) {
+            int distance        = __builtin_popcount(run->quirks ^ current);
+            int winner_distance = __builtin_popcount(winner->quirks ^ current);
+            if (distance < winner_distance) winner = run;
+        }
+    }
+    return winner;
+}
+
+static int usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-f frames] [-j threads] <index> <rom>...\n", name);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    uint32_t frames  = DEFAULT_FRAMES;
+    long     threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    int arg = 1;
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+        if (strcmp(argv[arg], "-f") == 0) {
+            frames = (uint32_t)strtoul(argv[arg + 1], NULL, 10);
+        } else if (strcmp(argv[arg], "-j") == 0) {
+            threads = strtol(argv[arg + 1], NULL, 10);
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (argc - arg < 2 || frames == 0) return usage(argv[0]);
+    if (threads < 1) threads = 1;
+
+    const char *path  = argv[arg++];
+    size_t      count = (size_t)(argc - arg);
+
+    // A missing index is not an error, as the results will create it
+    rom_index_t library;
+    if (!rom_index_init(&library)) return 1;
+    rom_index_load(&library, path);
+
+    rom_entry_t *entries  = calloc(count, sizeof(rom_entry_t));
+    chip8_t     *initials = calloc(count, sizeof(chip8_t));
+    run_t       *runs     = calloc(count * COMBINATIONS, sizeof(run_t));
+    bool        *loaded   = calloc(count, sizeof(bool));
+    if (!entries || !initials || !runs || !loaded) return 1;
+
+    // Every ROM is loaded once, then forked into every combination of quirks,
+    // queueing the runs of the loaded ROMs one after another
+    size_t queued = 0;
+    for (size_t r = 0; r < count; ++r) {
+        rom_file_t rom;
+        if (!rom_map(&rom, argv[arg + r])) {
+            fprintf(stderr, "ERROR: Failed to read %s.\n", argv[arg + r]);
+            continue;
+        }
+
+        const rom_entry_t *entry = rom_index_find(&library, rom.hash);
+        if (entry) {
+            entries[r] = *entry;
+        } else {
+            rom_entry_init(&entries[r], &rom, argv[arg + r]);
+        }
+
+        loaded[r] = chip8_init(&initials[r]);
+        if (loaded[r] && !rom_load(&initials[r], &rom, &entries[r])) {
+            chip8_free(&initials[r]);
+            loaded[r] = false;
+        }
+        rom_unmap(&rom);
+        if (!loaded[r]) {
+            fprintf(stderr, "ERROR: Failed to load %s.\n", argv[arg + r]);
+            continue;
+        }
+
+        for (uint8_t q = 0; q < COMBINATIONS; ++q) {
+            run_t *run   = &runs[queued * COMBINATIONS + q];
+            run->initial = &initials[r];
+            run->quirks  = q;
+            run->frames  = frames;
+        }
+        queued += 1;
+    }
+
+    queue_t queue = {.runs = runs, .count = queued * COMBINATIONS, .next = 0};
+    pthread_mutex_init(&queue.lock, NULL);
+
+    pthread_t *workers = calloc((size_t)threads, sizeof(pthread_t));
+    for (long t = 0; t < threads; ++t) {
+        pthread_create(&workers[t], NULL, worker, &queue);
+    }
+    for (long t = 0; t < threads; ++t) {
+        pthread_join(workers[t], NULL);
+    }
+    pthread_mutex_destroy(&queue.lock);
+
+    const run_t *rom_runs = runs;
+    for (size_t r = 0; r < count; ++r) {
+        if (!loaded[r]) continue;
+
+        const run_t *winner = pick_winner(rom_runs, entries[r].quirks);
+        rom_runs += COMBINATIONS;
+        printf(
+            "%s: %c%c%c (score %.2f, %u/%u frames, entropy %.2f)\n",
+            entries[r].name,
+            winner->quirks & QUIRK_OFFSET_JUMP ? 'j' : '-',
+            winner->quirks & QUIRK_MEMORY ? 'm' : '-',
+            winner->quirks & QUIRK_SHIFT ? 's' : '-',
+            winner->score,
+            winner->frames_run,
+            frames,
+            winner->entropy
+        );
+
+        entries[r].quirks = winner->quirks;
+        rom_index_put(&library, &entries[r]);
+        chip8_free(&initials[r]);
+    }
+
+    bool saved = rom_index_save(&library, path);
+    if (!saved) fprintf(stderr, "ERROR: Failed to write %s.\n", path);
+
+    free(workers);
+    free(loaded);
+    free(runs);
+    free(initials);
+    free(entries);
+    rom_index_free(&library);
+    return saved ? 0 : 1;
+}
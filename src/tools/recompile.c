@@ -0,0 +1,455 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bitmask.h"
+#include "chip8.h"
+#include "opcodes.h"
+#include "rom_library.h"
+#include "variant.h"
+
+// Longest block in instructions; short blocks still fit in a frame's budget
+#define MAX_BLOCK_LENGTH 8
+
+typedef struct {
+    const rom_file_t *rom;       // ROM being recompiled
+    variant_type_t    variant;   // Variant the ROM is recompiled for
+    uint32_t          mask;      // Wraps addresses into the memory of the variant
+    bool             *reachable; // Offsets at which an instruction was recovered
+    bool             *leader;    // Offsets at which a block must start
+    uint16_t         *pending;   // Offsets still to be followed
+    size_t            count;     // Number of pending offsets
+} program_t;
+
+static int usage(const char *name) {
+    fprintf(stderr, "Usage: %s <rom> <output.c> [variant]\n", name);
+    return 1;
+}
+
+/**
+ * Checks if a range of the program lies within the ROM.
+ *
+ * @param program - The program being recompiled
+ * @param address - The address of the range
+ * @param size - The size of the range in bytes
+ * @returns If every byte of the range was loaded from the ROM
+ */
+static bool in_rom(const program_t *program, uint32_t address, uint32_t size) {
+    return address >= PROGRAM_START && address - PROGRAM_START + size <= program->rom->size;
+}
+
+/**
+ * Reads a word of the program as it was loaded from the ROM.
+ *
+ * @param program - The program being recompiled
+ * @param address - The address to read; must lie within the ROM
+ * @returns The word at the address
+ */
+static uint16_t read_word(const program_t *program, uint32_t address) {
+    const uint8_t *data = &program->rom->data[address - PROGRAM_START];
+    return (data[0] << 8) | data[1];
+}
+
+/**
+ * Checks if an instruction is left to the interpreter.
+ *
+ * Indirect jumps and key input depend on state that is only known at runtime,
+ * and skips are only compiled when the instruction they skip is known.
+ *
+ * @param program - The program being recompiled
+ * @param address - The address of the instruction
+ * @returns If the instruction may not be part of a block
+ */
+static bool is_fallback(const program_t *program, uint32_t address) {
+    uint16_t      opcode = read_word(program, address);
+    opcode_type_t type   = opcode_decode(opcode, program->variant);
+    switch (type) {
+        case OPCODE_SYS:
+        case OPCODE_JP_OFFSET:
+        case OPCODE_SKP:
+        case OPCODE_SKNP:
+        case OPCODE_LD_KEY:
+        case OPCODE_COUNT:
+            return true;
+        case OPCODE_SE_BYTE:
+        case OPCODE_SNE_BYTE:
+        case OPCODE_SE_REG:
+        case OPCODE_SE_REG_XO:
+        case OPCODE_SNE_REG:
+            return !in_rom(program, address + 2, 2);
+        default:
+            return !in_rom(program, address, opcode_size(opcode, program->variant));
+    }
+}
+
+/**
+ * Checks if an instruction ends the block containing it.
+ *
+ * Besides control flow, writes to memory end a block, as they may modify the
+ * instructions which follow.
+ *
+ * @param program - The program being recompiled
+ * @param address - The address of the instruction
+ * @returns If no further instructions may follow in the block
+ */
+static bool is_terminator(const program_t *program, uint32_t address) {
+    opcode_data_t data = opcode_get(opcode_decode(read_word(program, address), program->variant));
+    return data.flags & (OPCODE_BRANCHES | OPCODE_WRITES_MEMORY);
+}
+
+/**
+ * Marks an address as the start of a block, and follows it if not yet known.
+ *
+ * @param program - The program being recompiled
+ * @param address - The address to mark
+ */
+static void mark_leader(program_t *program, uint32_t address) {
+    if (!in_rom(program, address, 2)) return;
+    uint32_t offset = address - PROGRAM_START;
+    if (!program->leader[offset] && !program->reachable[offset]) {
+        program->pending[program->count++] = offset;
+    }
+    program->leader[offset] = true;
+}
+
+/**
+ * Recovers the instructions reachable from the start of the program.
+ *
+ * Control flow is followed through direct jumps, calls and both outcomes of
+ * skips. Targets of indirect jumps are unknown, and are left to the
+ * interpreter when reached at runtime.
+ *
+ * @param program - The program to recover the instructions of
+ */
+static void discover(program_t *program) {
+    mark_leader(program, PROGRAM_START);
+    while (program->count > 0) {
+        uint32_t address = PROGRAM_START + program->pending[--program->count];
+        while (in_rom(program, address, 2) && !program->reachable[address - PROGRAM_START]) {
+            program->reachable[address - PROGRAM_START] = true;
+
+            uint16_t      opcode = read_word(program, address);
+            opcode_type_t type   = opcode_decode(opcode, program->variant);
+            uint32_t      next   = address + opcode_size(opcode, program->variant);
+            if (is_fallback(program, address)) {
+                // Interpreted instructions are never part of a block
+                mark_leader(program, address);
+                mark_leader(program, next);
+            } else if (is_terminator(program, address)) {
+                mark_leader(program, next);
+            }
+
+            switch (type) {
+                case OPCODE_JP:
+                    mark_leader(program, MA(opcode));
+                    break;
+                case OPCODE_CALL:
+                    mark_leader(program, MA(opcode));
+                    address = next;
+                    continue;
+                case OPCODE_SE_BYTE:
+                case OPCODE_SNE_BYTE:
+                case OPCODE_SE_REG:
+                case OPCODE_SE_REG_XO:
+                case OPCODE_SNE_REG:
+                case OPCODE_SKP:
+                case OPCODE_SKNP:
+                    if (in_rom(program, next, 2)) {
+                        mark_leader(program, next + opcode_size(read_word(program, next), program->variant));
+                    }
+                    address = next;
+                    continue;
+                case OPCODE_RET:
+                case OPCODE_SYS:
+                case OPCODE_JP_OFFSET:
+                case OPCODE_COUNT:
+                    break;
+                default:
+                    address = next;
+                    continue;
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * Writes the C equivalent of an instruction which does not branch.
+ *
+ * Simple instructions are written inline with the same semantics as their
+ * interpreter handlers, while everything else calls into the interpreter.
+ *
+ * @param out - The file to write to
+ * @param opcode - The opcode of the instruction
+ * @param type - The decoded type of the instruction
+ * @param address - The address of the instruction
+ * @param n - The number of instructions in the block up to this one
+ * @returns If the instruction was left to the interpreter, which sets PC
+ */
+static bool emit_instruction(FILE *out, uint16_t opcode, opcode_type_t type, uint32_t address, uint32_t n) {
+    unsigned x  = N2(opcode);
+    unsigned y  = N3(opcode);
+    unsigned nn = B2(opcode);
+
+    switch (type) {
+        case OPCODE_LD_BYTE:
+            fprintf(out, "    V(0x%X) = 0x%02X;\n", x, nn);
+            break;
+        case OPCODE_ADD_BYTE:
+            fprintf(out, "    V(0x%X) += 0x%02X;\n", x, nn);
+            break;
+        case OPCODE_LD_REG:
+            fprintf(out, "    V(0x%X) = V(0x%X);\n", x, y);
+            break;
+        case OPCODE_OR:
+            fprintf(out, "    V(0x%X) |= V(0x%X);\n", x, y);
+            break;
+        case OPCODE_AND:
+            fprintf(out, "    V(0x%X) &= V(0x%X);\n", x, y);
+            break;
+        case OPCODE_XOR:
+            fprintf(out, "    V(0x%X) ^= V(0x%X);\n", x, y);
+            break;
+        case OPCODE_ADD_REG:
+            fprintf(out, "    if (V(0x%X) > UINT8_MAX - V(0x%X)) V(0xF) = 0x1;\n", x, y);
+            fprintf(out, "    V(0x%X) += V(0x%X);\n", x, y);
+            break;
+        case OPCODE_SUB:
+            fprintf(out, "    if (V(0x%X) > V(0x%X)) V(0xF) = 0x1;\n", x, y);
+            fprintf(out, "    V(0x%X) = V(0x%X) - V(0x%X);\n", x, x, y);
+            break;
+        case OPCODE_SUBN:
+            fprintf(out, "    if (V(0x%X) > V(0x%X)) V(0xF) = 0x1;\n", y, x);
+            fprintf(out, "    V(0x%X) = V(0x%X) - V(0x%X);\n", x, y, x);
+            break;
+        case OPCODE_SHR:
+            fprintf(out, "    if (chip8->quirks & QUIRK_SHIFT) V(0x%X) = V(0x%X);\n", x, y);
+            fprintf(out, "    V(0xF) = V(0x%X) & 0x1;\n", x);
+            fprintf(out, "    V(0x%X) >>= 0x1;\n", x);
+            break;
+        case OPCODE_SHL:
+            fprintf(out, "    if (chip8->quirks & QUIRK_SHIFT) V(0x%X) = V(0x%X);\n", x, y);
+            fprintf(out, "    V(0xF) = (V(0x%X) >> 7) & 0x1;\n", x);
+            fprintf(out, "    V(0x%X) <<= 0x1;\n", x);
+            break;
+        case OPCODE_LD_I:
+            fprintf(out, "    chip8->i = 0x%03X;\n", MA(opcode));
+            break;
+        case OPCODE_ADD_I:
+            fprintf(out, "    chip8->i += V(0x%X);\n", x);
+            break;
+        case OPCODE_LD_FONT:
+            fprintf(out, "    chip8->i = FONT_START + 5 * (V(0x%X) & 0xF);\n", x);
+            break;
+        case OPCODE_LD_DT_READ:
+            fprintf(out, "    V(0x%X) = chip8->delay_timer;\n", x);
+            break;
+        case OPCODE_LD_DT:
+            fprintf(out, "    chip8->delay_timer = V(0x%X);\n", x);
+            break;
+        default:
+            // The interpreter expects PC to point past the opcode
+            fprintf(out, "    chip8->pc = 0x%04X;\n", address + 2);
+            fprintf(out, "    if (!chip8_execute_opcode(chip8, 0x%04X, result)) return %u;\n", opcode, n);
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Writes the C function for the block starting at an address.
+ *
+ * The block starts by verifying that its instructions are still those of the
+ * ROM, and returns 0 without executing anything if they were modified.
+ *
+ * @param out - The file to write to
+ * @param program - The program being recompiled
+ * @param start - The address of the first instruction in the block
+ * @returns The number of instructions in the block
+ */
+static uint32_t emit_block(FILE *out, program_t *program, uint32_t start) {
+    // Find the extent of the block first, as the guard precedes its code
+    uint32_t address = start;
+    uint32_t length  = 0;
+    uint32_t guarded = 0;
+    bool     ended   = false;
+    while (!ended) {
+        uint16_t      opcode = read_word(program, address);
+        opcode_type_t type   = opcode_decode(opcode, program->variant);
+        uint32_t      next   = address + opcode_size(opcode, program->variant);
+        ++length;
+
+        // Skips additionally depend on the size of the instruction they skip
+        guarded = next - start;
+        if (type == OPCODE_SE_BYTE || type == OPCODE_SNE_BYTE || type == OPCODE_SE_REG || type == OPCODE_SE_REG_XO ||
+            type == OPCODE_SNE_REG) {
+            guarded += 2;
+        }
+
+        ended = is_terminator(program, address) || length == MAX_BLOCK_LENGTH || !in_rom(program, next, 2) ||
+                !program->reachable[next - PROGRAM_START] || program->leader[next - PROGRAM_START];
+        address = next;
+    }
+    if (in_rom(program, address, 2)) program->leader[address - PROGRAM_START] = true;
+
+    fprintf(out, "static uint32_t block_%04X(chip8_t *chip8, chip8_state_t *result) {\n", start);
+    fprintf(out, "    if (memcmp(&chip8->memory[0x%04X], &ROM[0x%04X], %u) != 0) return 0;\n", start,
+            start - PROGRAM_START, guarded);
+
+    address = start;
+    for (uint32_t n = 1; n <= length; ++n) {
+        uint16_t      opcode = read_word(program, address);
+        opcode_type_t type   = opcode_decode(opcode, program->variant);
+        uint32_t      next   = address + opcode_size(opcode, program->variant);
+        fprintf(out, "    // 0x%04X: %04X\n", address, opcode);
+
+        switch (type) {
+            case OPCODE_JP:
+                fprintf(out, "    chip8->pc = 0x%04X;\n", MA(opcode));
+                break;
+            case OPCODE_SE_BYTE:
+            case OPCODE_SNE_BYTE:
+            case OPCODE_SE_REG:
+            case OPCODE_SE_REG_XO:
+            case OPCODE_SNE_REG: {
+                uint32_t skipped = next + opcode_size(read_word(program, next), program->variant);
+                char     operand[16];
+                if (type == OPCODE_SE_BYTE || type == OPCODE_SNE_BYTE) {
+                    snprintf(operand, sizeof(operand), "0x%02X", B2(opcode));
+                } else {
+                    snprintf(operand, sizeof(operand), "V(0x%X)", N3(opcode));
+                }
+                const char *compare = type == OPCODE_SNE_BYTE || type == OPCODE_SNE_REG ? "!=" : "==";
+                fprintf(out, "    chip8->pc = V(0x%X) %s %s ? 0x%04X : 0x%04X;\n", N2(opcode), compare, operand,
+                        skipped & program->mask, next);
+                break;
+            }
+            default: {
+                bool interpreted = emit_instruction(out, opcode, type, address, n);
+                if (n == length && !(interpreted && (opcode_get(type).flags & OPCODE_BRANCHES || next == address + 2))) {
+                    fprintf(out, "    chip8->pc = 0x%04X;\n", next & program->mask);
+                }
+                break;
+            }
+        }
+        if (n == length) {
+            fprintf(out, "    result->opcode = 0x%04X;\n", opcode);
+            fprintf(out, "    return %u;\n", length);
+        }
+        address = next;
+    }
+    fprintf(out, "}\n\n");
+    return length;
+}
+
+/**
+ * Writes the recompiled program as a C source file.
+ *
+ * @param out - The file to write to
+ * @param program - The program to write
+ * @param name - The name of the recompiled ROM
+ * @returns The number of blocks that were written
+ */
+static uint32_t emit_program(FILE *out, program_t *program, const char *name) {
+    const rom_file_t *rom = program->rom;
+
+    fprintf(out, "// Recompiled from %s; do not edit\n", name);
+    fprintf(out, "#include <stdint.h>\n#include <string.h>\n\n#include \"aot.h\"\n\n");
+    fprintf(out, "#define V(x) chip8->v[x]\n\n");
+    fprintf(out, "static const uint8_t ROM[%zu] = {", rom->size);
+    for (size_t j = 0; j < rom->size; ++j) {
+        fprintf(out, "%s0x%02X,", j % 16 == 0 ? "\n    " : " ", rom->data[j]);
+    }
+    fprintf(out, "\n};\n\n");
+
+    uint16_t *lengths = calloc(rom->size, sizeof(uint16_t));
+    uint32_t  blocks  = 0;
+    for (size_t offset = 0; offset < rom->size && lengths; ++offset) {
+        uint32_t address = PROGRAM_START + offset;
+        if (!program->reachable[offset] || !program->leader[offset] || is_fallback(program, address)) continue;
+        lengths[offset] = emit_block(out, program, address);
+        ++blocks;
+    }
+
+    fprintf(out, "static const aot_block_t BLOCKS[%zu] = {\n", rom->size);
+    for (size_t offset = 0; offset < rom->size && lengths; ++offset) {
+        if (lengths[offset]) fprintf(out, "    [0x%04zX] = block_%04zX,\n", offset, PROGRAM_START + offset);
+    }
+    fprintf(out, "};\n\n");
+    fprintf(out, "static const uint16_t LENGTHS[%zu] = {\n", rom->size);
+    for (size_t offset = 0; offset < rom->size && lengths; ++offset) {
+        if (lengths[offset]) fprintf(out, "    [0x%04zX] = %u,\n", offset, lengths[offset]);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "const aot_program_t AOT_PROGRAM = {\n");
+    fprintf(out, "    .name    = \"");
+    for (const char *c = name; *c; ++c) fprintf(out, *c == '"' || *c == '\\' ? "\\%c" : "%c", *c);
+    fprintf(out, "\",\n");
+    fprintf(out, "    .variant = %d,\n", program->variant);
+    fprintf(out, "    .rom     = ROM,\n");
+    fprintf(out, "    .size    = %zu,\n", rom->size);
+    fprintf(out, "    .blocks  = BLOCKS,\n");
+    fprintf(out, "    .lengths = LENGTHS,\n");
+    fprintf(out, "};\n");
+
+    free(lengths);
+    return blocks;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3 || argc > 4) return usage(argv[0]);
+
+    rom_file_t rom;
+    if (!rom_map(&rom, argv[1])) {
+        fprintf(stderr, "ERROR: Failed to read %s.\n", argv[1]);
+        return 1;
+    }
+
+    // Like the emulator, the variant is guessed from the ROM unless provided
+    rom_entry_t entry;
+    rom_entry_init(&entry, &rom, argv[1]);
+    if (argc > 3) entry.variant = variant_by_name(argv[3]);
+    if (entry.variant >= VARIANT_COUNT) {
+        fprintf(stderr, "ERROR: Unknown platform variant.\n");
+        rom_unmap(&rom);
+        return 1;
+    }
+    if (rom.size < 2 || rom.size > variant_get(entry.variant).memory_size - PROGRAM_START) {
+        fprintf(stderr, "ERROR: %s does not fit in memory.\n", argv[1]);
+        rom_unmap(&rom);
+        return 1;
+    }
+
+    program_t program = {
+        .rom       = &rom,
+        .variant   = entry.variant,
+        .mask      = variant_get(entry.variant).memory_size - 1,
+        .reachable = calloc(rom.size, sizeof(bool)),
+        .leader    = calloc(rom.size, sizeof(bool)),
+        .pending   = calloc(rom.size, sizeof(uint16_t)),
+    };
+    FILE *out = fopen(argv[2], "w");
+    if (!program.reachable || !program.leader || !program.pending || !out) {
+        fprintf(stderr, "ERROR: Failed to write %s.\n", argv[2]);
+        if (out) fclose(out);
+        free(program.reachable);
+        free(program.leader);
+        free(program.pending);
+        rom_unmap(&rom);
+        return 1;
+    }
+
+    discover(&program);
+    uint32_t blocks = emit_program(out, &program, entry.name);
+
+    size_t recovered = 0;
+    for (size_t offset = 0; offset < rom.size; ++offset) recovered += program.reachable[offset];
+    printf("Recompiled %zu instructions into %u blocks.\n", recovered, blocks);
+
+    fclose(out);
+    free(program.reachable);
+    free(program.leader);
+    free(program.pending);
+    rom_unmap(&rom);
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <netdb.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stream.h"
+
+#define DEFAULT_HOST "localhost" // Host connected to by default
+#define PORT_SIZE    6           // Characters in the longest port, including the terminator
+
+static volatile sig_atomic_t running = 1; // Cleared when asked to shut down
+
+static void handle_shutdown(int signal) {
+    (void)signal;
+    running = 0;
+}
+
+static int usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-n frames] [-d] [-k keys] [host[:port]]\n", name);
+    return 1;
+}
+
+/**
+ * Gets the current time from a monotonic clock.
+ *
+ * @returns The current time in microseconds
+ */
+static uint64_t get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)(ts.tv_nsec / 1000);
+}
+
+/**
+ * Connects to a streaming server.
+ *
+ * @param address - The host of the server, optionally followed by a colon and
+ * its port
+ * @returns The connected socket, or -1 if no connection could be made
+ */
+static int connect_server(const char *address) {
+    char        host[256];
+    char        port[PORT_SIZE];
+    const char *colon = strrchr(address, ':');
+    size_t      size  = colon ? (size_t)(colon - address) : strlen(address);
+    if (size >= sizeof(host)) return -1;
+    memcpy(host, address, size);
+    host[size] = '\0';
+    snprintf(port, sizeof(port), "%s", colon ? colon + 1 : "");
+    if (!colon) snprintf(port, sizeof(port), "%u", STREAM_DEFAULT_PORT);
+
+    struct addrinfo  hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+    struct addrinfo *found = NULL;
+    if (getaddrinfo(host, port, &hints, &found) != 0) return -1;
+
+    int connection = -1;
+    for (struct addrinfo *candidate = found; candidate && connection < 0; candidate = candidate->ai_next) {
+        connection = socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+        if (connection >= 0 && connect(connection, candidate->ai_addr, candidate->ai_addrlen) != 0) {
+            close(connection);
+            connection = -1;
+        }
+    }
+    freeaddrinfo(found);
+    return connection;
+}
+
+/**
+ * Draws the display of a view as text.
+ *
+ * @param view - The view to draw
+ */
+static void draw_view(const stream_view_t *view) {
+    for (uint8_t y = 0; y < view->height; ++y) {
+        for (uint8_t x = 0; x < view->width; ++x) putchar(" #+*"[view->pixels[y * view->width + x] & 0x3]);
+        putchar('\n');
+    }
+}
+
+int main(int argc, char **argv) {
+    uint64_t limit = 0;
+    bool     draw  = false;
+    uint16_t keys  = 0;
+
+    int option;
+    while ((option = getopt(argc, argv, "n:dk:")) != -1) {
+        switch (option) {
+            case 'n':
+                limit = strtoull(optarg, NULL, 10);
+                break;
+            case 'd':
+                draw = true;
+                break;
+            case 'k':
+                keys = (uint16_t)strtoul(optarg, NULL, 16);
+                break;
+            default:
+                return usage(argv[0]);
+        }
+    }
+    if (argc - optind > 1) return usage(argv[0]);
+
+    const char *address    = optind < argc ? argv[optind] : DEFAULT_HOST;
+    int         connection = connect_server(address);
+    if (connection < 0) {
+        fprintf(stderr, "ERROR: Failed to connect to %s.\n", address);
+        return 1;
+    }
+    signal(SIGINT, handle_shutdown);
+    signal(SIGTERM, handle_shutdown);
+
+    // The keys are held for as long as the client stays connected
+    uint8_t message[STREAM_HEADER_SIZE + 2];
+    if (keys && send(connection, message, stream_encode_keys(keys, message), 0) < 0) {
+        fprintf(stderr, "ERROR: Failed to send the keys.\n");
+        close(connection);
+        return 1;
+    }
+
+    static stream_view_t view;
+    static uint8_t       data[STREAM_QUEUE_SIZE];
+    size_t               size   = 0;
+    uint64_t             bytes  = 0;
+    uint64_t             start  = get_time();
+    uint64_t             last   = start;
+    bool                 failed = false;
+    while (running && !failed && (limit == 0 || view.frames < limit)) {
+        ssize_t length = recv(connection, &data[size], sizeof(data) - size, 0);
+        if (length <= 0) break;
+        size += length;
+
+        size_t used;
+        while (!failed && (limit == 0 || view.frames < limit)) {
+            failed = !stream_decode(&view, data, size, &used);
+            if (failed || !used) break;
+
+            if (data[0] == STREAM_FRAME) {
+                uint64_t now = get_time();
+                bytes += used;
+                printf("Frame %llu: %ux%u, %d dirty rows, %zu bytes, %.1fms after the previous\n",
+                       (unsigned long long)view.frames, view.width, view.height, __builtin_popcountll(view.dirty_rows),
+                       used, (now - last) / 1000.0);
+                if (draw) draw_view(&view);
+                last = now;
+            } else if (data[0] == STREAM_SOUND) {
+                printf("Sound %s\n", view.playing ? "started" : "stopped");
+            }
+            memmove(data, &data[used], size - used);
+            size -= used;
+        }
+    }
+    if (failed) fprintf(stderr, "ERROR: The server sent invalid data.\n");
+
+    double seconds = (get_time() - start) / 1000000.0;
+    printf("Received %llu frames in %.1fs, %.1f bytes per frame\n", (unsigned long long)view.frames, seconds,
+           view.frames ? (double)bytes / view.frames : 0.0);
+    close(connection);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,406 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "recording.h"
+
+#define DEFAULT_SCALE 4    // Size of every pixel in the output by default
+#define PATH_SIZE     4096 // Longest path of a single image
+#define GIF_CLEAR     16   // Code resetting the dictionary of a GIF with 16 colors
+#define GIF_END       17   // Code ending the image data of a GIF with 16 colors
+#define GIF_CODES     4096 // Codes in a full dictionary of a GIF
+
+typedef enum {
+    FORMAT_RAW, // Raw RGB24 video, to be piped into an encoder
+    FORMAT_PNG, // A PNG image per frame
+    FORMAT_GIF, // A single animated GIF
+} format_t;
+
+// Bits of LZW codes packed into the sub-blocks of a GIF
+typedef struct {
+    FILE    *file;       // The GIF being written
+    uint8_t  block[255]; // Bytes of the sub-block being filled
+    uint8_t  length;     // Bytes in the sub-block so far
+    uint32_t bits;       // Bits not forming a whole byte yet
+    uint8_t  count;      // Number of bits not forming a whole byte yet
+} gif_writer_t;
+
+// Colors for every combination of the up to 4 display planes, as on the desktop
+static const uint8_t PALETTE[16][3] = {
+    {0x00, 0x00, 0x00},
+    {0xF5, 0xF5, 0xF5},
+    {0xAA, 0xAA, 0xAA},
+    {0x55, 0x55, 0x55},
+    {0xE6, 0x29, 0x37},
+    {0x00, 0xE4, 0x30},
+    {0x00, 0x79, 0xF1},
+    {0xFD, 0xF9, 0x00},
+    {0xBE, 0x21, 0x37},
+    {0x00, 0x75, 0x2C},
+    {0x00, 0x52, 0xAC},
+    {0xFF, 0xCB, 0x00},
+    {0xC8, 0x7A, 0xFF},
+    {0x66, 0xBF, 0xFF},
+    {0xFF, 0xA1, 0x00},
+    {0xFF, 0x6D, 0xC2},
+};
+
+static uint16_t gif_children[GIF_CODES][16]; // Code extending each code by each color, or 0
+static uint32_t crc_table[256];              // CRC-32 of every byte, as used by PNG
+
+static int usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-f raw|png|gif] [-s first] [-n frames] [-x scale] recording output\n", name);
+    return 1;
+}
+
+/**
+ * Draws the latest frame of a recording onto the canvas, scaling smaller
+ * display modes up to fill it.
+ *
+ * @param recording - The recording to draw the latest frame of
+ * @param pixels - Scratch space for the unscaled frame
+ * @param canvas - Receives the palette index of every pixel of the canvas
+ * @param width - The width of the canvas
+ * @param height - The height of the canvas
+ */
+static void draw_frame(const recording_t *recording, uint8_t *pixels, uint8_t *canvas, uint32_t width,
+                       uint32_t height) {
+    uint8_t frame_width  = recording->display_width;
+    uint8_t frame_height = recording->display_height;
+    if (frame_width == 0 || frame_height == 0) {
+        memset(canvas, 0, width * height);
+        return;
+    }
+
+    recording_render(recording, pixels);
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t *row = &pixels[(y * frame_height / height) * frame_width];
+        for (uint32_t x = 0; x < width; ++x) canvas[y * width + x] = row[x * frame_width / width] & 0xF;
+    }
+}
+
+/**
+ * Updates a CRC-32 with more data.
+ *
+ * @param crc - The CRC-32 so far, starting from 0
+ * @param data - The data to add
+ * @param size - The size of the data in bytes
+ * @returns The updated CRC-32
+ */
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t size) {
+    if (crc_table[1] == 0) {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (uint8_t k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            crc_table[n] = c;
+        }
+    }
+
+    crc = ~crc;
+    for (size_t b = 0; b < size; ++b) crc = crc_table[(crc ^ data[b]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+/**
+ * Writes a big-endian 32-bit number into a buffer.
+ *
+ * @param buffer - The buffer to write to
+ * @param value - The number to write
+ */
+static void put_u32(uint8_t *buffer, uint32_t value) {
+    buffer[0] = value >> 24;
+    buffer[1] = value >> 16;
+    buffer[2] = value >> 8;
+    buffer[3] = value;
+}
+
+/**
+ * Writes a chunk of a PNG, with its length and checksum.
+ *
+ * @param file - The PNG being written
+ * @param type - The four-letter type of the chunk
+ * @param data - The contents of the chunk
+ * @param size - The size of the contents in bytes
+ */
+static void write_png_chunk(FILE *file, const char *type, const uint8_t *data, uint32_t size) {
+    uint8_t length[4];
+    uint8_t crc[4];
+    put_u32(length, size);
+    put_u32(crc, crc32_update(crc32_update(0, (const uint8_t *)type, 4), data, size));
+    fwrite(length, 1, 4, file);
+    fwrite(type, 1, 4, file);
+    fwrite(data, 1, size, file);
+    fwrite(crc, 1, 4, file);
+}
+
+/**
+ * Writes the canvas as a PNG with a palette.
+ *
+ * The image data is stored without compression, as the images are small and
+ * this avoids depending on zlib.
+ *
+ * @param path - The path of the PNG
+ * @param canvas - The palette index of every pixel
+ * @param width - The width of the canvas
+ * @param height - The height of the canvas
+ * @returns If the PNG was written
+ */
+static bool write_png(const char *path, const uint8_t *canvas, uint32_t width, uint32_t height) {
+    // Every row starts with its filter type, and the rows are split into
+    // stored deflate blocks of at most 65535 bytes
+    uint32_t raw_size = height * (width + 1);
+    uint32_t blocks   = raw_size / 65535 + 1;
+    uint8_t *raw      = malloc(raw_size);
+    uint8_t *data     = malloc(2 + blocks * 5 + raw_size + 4);
+    FILE    *file     = fopen(path, "wb");
+    if (!raw || !data || !file) {
+        free(raw);
+        free(data);
+        if (file) fclose(file);
+        return false;
+    }
+
+    uint32_t a = 1, b = 0;
+    for (uint32_t y = 0; y < height; ++y) {
+        raw[y * (width + 1)] = 0;
+        memcpy(&raw[y * (width + 1) + 1], &canvas[y * width], width);
+    }
+    for (uint32_t i = 0; i < raw_size; ++i) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+
+    uint32_t size = 0;
+    data[size++]  = 0x78;
+    data[size++]  = 0x01;
+    for (uint32_t offset = 0; offset < raw_size; offset += 65535) {
+        uint16_t length = raw_size - offset < 65535 ? raw_size - offset : 65535;
+        data[size++]    = offset + length == raw_size;
+        data[size++]    = length & 0xFF;
+        data[size++]    = length >> 8;
+        data[size++]    = ~length & 0xFF;
+        data[size++]    = (uint16_t)~length >> 8;
+        memcpy(&data[size], &raw[offset], length);
+        size += length;
+    }
+    put_u32(&data[size], b << 16 | a);
+    size += 4;
+
+    uint8_t header[13];
+    put_u32(&header[0], width);
+    put_u32(&header[4], height);
+    header[8]  = 8; // Bits per palette index
+    header[9]  = 3; // Indexed colors
+    header[10] = 0;
+    header[11] = 0;
+    header[12] = 0;
+
+    fwrite("\x89PNG\r\n\x1a\n", 1, 8, file);
+    write_png_chunk(file, "IHDR", header, sizeof(header));
+    write_png_chunk(file, "PLTE", &PALETTE[0][0], sizeof(PALETTE));
+    write_png_chunk(file, "IDAT", data, size);
+    write_png_chunk(file, "IEND", NULL, 0);
+
+    bool failed = ferror(file);
+    free(raw);
+    free(data);
+    return fclose(file) == 0 && !failed;
+}
+
+/**
+ * Appends an LZW code to the image data of a GIF.
+ *
+ * @param writer - The image data being written
+ * @param code - The code to append
+ * @param size - The number of bits of the code
+ */
+static void gif_put_code(gif_writer_t *writer, uint16_t code, uint8_t size) {
+    writer->bits |= (uint32_t)code << writer->count;
+    writer->count += size;
+    while (writer->count >= 8) {
+        writer->block[writer->length++] = writer->bits & 0xFF;
+        writer->bits >>= 8;
+        writer->count -= 8;
+        if (writer->length == sizeof(writer->block)) {
+            fputc(writer->length, writer->file);
+            fwrite(writer->block, 1, writer->length, writer->file);
+            writer->length = 0;
+        }
+    }
+}
+
+/**
+ * Writes the canvas as the next image of an animated GIF.
+ *
+ * @param file - The GIF being written
+ * @param canvas - The palette index of every pixel
+ * @param width - The width of the canvas
+ * @param height - The height of the canvas
+ * @param delay - How long the image is shown in hundredths of a second
+ */
+static void write_gif_frame(FILE *file, const uint8_t *canvas, uint16_t width, uint16_t height, uint16_t delay) {
+    uint8_t control[8]     = {0x21, 0xF9, 0x04, 0x00, delay & 0xFF, delay >> 8, 0x00, 0x00};
+    uint8_t descriptor[11] = {0x2C, 0, 0, 0, 0, width & 0xFF, width >> 8, height & 0xFF, height >> 8, 0x00, 4};
+    fwrite(control, 1, sizeof(control), file);
+    fwrite(descriptor, 1, sizeof(descriptor), file);
+
+    // The dictionary grows a code per new sequence of colors, widening the
+    // codes as it does, and starts over once full
+    gif_writer_t writer    = {.file = file};
+    uint16_t     next      = GIF_END + 1;
+    uint8_t      code_size = 5;
+    memset(gif_children, 0, sizeof(gif_children));
+    gif_put_code(&writer, GIF_CLEAR, code_size);
+
+    uint16_t prefix = canvas[0];
+    for (uint32_t p = 1; p < (uint32_t)width * height; ++p) {
+        uint8_t color = canvas[p];
+        if (gif_children[prefix][color]) {
+            prefix = gif_children[prefix][color];
+            continue;
+        }
+
+        gif_put_code(&writer, prefix, code_size);
+        if (next < GIF_CODES) {
+            gif_children[prefix][color] = next;
+            if (next == 1 << code_size) code_size += 1;
+            next += 1;
+        } else {
+            gif_put_code(&writer, GIF_CLEAR, code_size);
+            memset(gif_children, 0, sizeof(gif_children));
+            next      = GIF_END + 1;
+            code_size = 5;
+        }
+        prefix = color;
+    }
+    gif_put_code(&writer, prefix, code_size);
+    gif_put_code(&writer, GIF_END, code_size);
+    if (writer.count) gif_put_code(&writer, 0, 8 - writer.count);
+    if (writer.length) {
+        fputc(writer.length, file);
+        fwrite(writer.block, 1, writer.length, file);
+    }
+    fputc(0, file);
+}
+
+int main(int argc, char **argv) {
+    format_t format = FORMAT_RAW;
+    uint64_t first  = 0;
+    uint64_t limit  = 0;
+    uint32_t scale  = DEFAULT_SCALE;
+
+    int option;
+    while ((option = getopt(argc, argv, "f:s:n:x:")) != -1) {
+        switch (option) {
+            case 'f':
+                if (strcmp(optarg, "raw") == 0) {
+                    format = FORMAT_RAW;
+                } else if (strcmp(optarg, "png") == 0) {
+                    format = FORMAT_PNG;
+                } else if (strcmp(optarg, "gif") == 0) {
+                    format = FORMAT_GIF;
+                } else {
+                    return usage(argv[0]);
+                }
+                break;
+            case 's':
+                first = strtoull(optarg, NULL, 10);
+                break;
+            case 'n':
+                limit = strtoull(optarg, NULL, 10);
+                break;
+            case 'x':
+                scale = strtoul(optarg, NULL, 10);
+                if (scale == 0 || scale > 16) return usage(argv[0]);
+                break;
+            default:
+                return usage(argv[0]);
+        }
+    }
+    if (argc - optind != 2) return usage(argv[0]);
+
+    recording_t recording;
+    if (!recording_open(&recording, argv[optind])) {
+        fprintf(stderr, "ERROR: Failed to open recording %s.\n", argv[optind]);
+        return 1;
+    }
+    if (!recording_seek(&recording, first)) {
+        fprintf(stderr, "ERROR: Recording has no frame %llu.\n", (unsigned long long)first);
+        recording_close(&recording);
+        return 1;
+    }
+
+    // The canvas covers the largest display mode of the recorded variant
+    const recording_header_t *header   = &recording.header;
+    uint32_t                  width    = header->display_stride * DISPLAY_ROW_BITS * scale;
+    uint32_t                  height   = header->plane_size / header->display_stride * scale;
+    uint32_t                  fps      = header->frames_per_second ? header->frames_per_second : FRAMES_PER_SECOND;
+    uint8_t                  *pixels   = malloc(HIRES_DISPLAY_WIDTH * HIRES_DISPLAY_HEIGHT);
+    uint8_t                  *canvas   = malloc(width * height);
+    uint8_t                  *shown    = malloc(width * height);
+    uint8_t                  *rgb      = malloc(width * height * 3);
+    const char               *output   = argv[optind + 1];
+    FILE                     *file     = NULL;
+    uint64_t                  written  = 0;
+    uint64_t                  shown_at = first;
+    bool                      failed   = !pixels || !canvas || !shown || !rgb;
+
+    if (!failed && format == FORMAT_RAW) {
+        file = strcmp(output, "-") == 0 ? stdout : fopen(output, "wb");
+        fprintf(stderr, "Raw RGB24 video, %ux%u at %u fps\n", width, height, fps);
+    } else if (!failed && format == FORMAT_GIF) {
+        // Global palette of 16 colors, looping forever
+        file = fopen(output, "wb");
+        if (file) {
+            uint8_t screen[7] = {width & 0xFF, width >> 8, height & 0xFF, height >> 8, 0xF3, 0x00, 0x00};
+            fwrite("GIF89a", 1, 6, file);
+            fwrite(screen, 1, sizeof(screen), file);
+            fwrite(PALETTE, 1, sizeof(PALETTE), file);
+            fwrite("\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00", 1, 19, file);
+        }
+    }
+    if (format != FORMAT_PNG && !file) failed = true;
+    if (format == FORMAT_GIF && (width > 0xFFFF || height > 0xFFFF)) failed = true;
+
+    // Frames are read in order from the first one sought
+    for (bool more = !failed; more && (limit == 0 || written < limit); more = recording_read(&recording)) {
+        uint64_t number = recording.frame - 1;
+        draw_frame(&recording, pixels, canvas, width, height);
+
+        if (format == FORMAT_RAW) {
+            for (uint32_t p = 0; p < width * height; ++p) memcpy(&rgb[p * 3], PALETTE[canvas[p]], 3);
+            failed |= fwrite(rgb, 3, width * height, file) != width * height;
+        } else if (format == FORMAT_PNG) {
+            char path[PATH_SIZE];
+            snprintf(path, sizeof(path), "%s%06llu.png", output, (unsigned long long)number);
+            failed |= !write_png(path, canvas, width, height);
+        } else if (number == first) {
+            memcpy(shown, canvas, width * height);
+        } else if (memcmp(shown, canvas, width * height) != 0) {
+            // Unchanged frames extend the delay of the image before them
+            uint16_t delay = number * 100 / fps - shown_at * 100 / fps;
+            write_gif_frame(file, shown, width, height, delay);
+            memcpy(shown, canvas, width * height);
+            shown_at = number;
+        }
+        if (failed) break;
+        ++written;
+    }
+
+    if (format == FORMAT_GIF && file && written) {
+        uint16_t delay = (first + written) * 100 / fps - shown_at * 100 / fps;
+        write_gif_frame(file, shown, width, height, delay ? delay : 1);
+        fputc(0x3B, file);
+    }
+    if (file && file != stdout) failed |= fclose(file) != 0;
+    if (file == stdout) fflush(stdout);
+
+    fprintf(stderr, "Converted %llu frames\n", (unsigned long long)written);
+    free(pixels);
+    free(canvas);
+    free(shown);
+    free(rgb);
+    recording_close(&recording);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "aot.h"
+#include "chip8.h"
+#include "unity_fixture.h"
+
+TEST_GROUP(Aot);
+
+static chip8_t chip8;
+
+// 0x200: LD V0, 0x05; ADD V0, 0x01; JP 0x200
+static const uint8_t rom[] = {0x60, 0x05, 0x70, 0x01, 0x12, 0x00};
+
+// Hand-written equivalent of what the recompiler emits for the program
+static uint32_t block_0200(chip8_t *chip8, chip8_state_t *result) {
+    if (memcmp(&chip8->memory[0x200], rom, sizeof(rom)) != 0) return 0;
+    chip8->v[0x0] = 0x05;
+    chip8->v[0x0] += 0x01;
+    chip8->pc      = 0x200;
+    result->opcode = 0x1200;
+    return 3;
+}
+
+static const aot_block_t   blocks[sizeof(rom)]  = {[0] = block_0200};
+static const uint16_t      lengths[sizeof(rom)] = {[0] = 3};
+static const aot_program_t program = {
+    .name    = "test",
+    .variant = VARIANT_CHIP8,
+    .rom     = rom,
+    .size    = sizeof(rom),
+    .blocks  = blocks,
+    .lengths = lengths,
+};
+
+TEST_SETUP(Aot) {
+    chip8_init(&chip8);
+    aot_load(&chip8, &program);
+}
+
+TEST_TEAR_DOWN(Aot) {
+    chip8_free(&chip8);
+}
+
+TEST(Aot, RunBlock) {
+    chip8_state_t state;
+    uint32_t      run = aot_run(&chip8, &program, 3, &state);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(3, run, "Should run every instruction of the block.");
+    TEST_ASSERT_EQUAL_MESSAGE(CHIP8_OK, state.status, "Running the block should succeed.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x200, chip8.pc, "The block should jump back to its start.");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x06, chip8.v[0x0], "The block should execute its instructions.");
+}
+
+TEST(Aot, RespectsBudget) {
+    chip8_state_t state;
+    uint32_t      run = aot_run(&chip8, &program, 2, &state);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, run, "Should not run past the budget.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x204, chip8.pc, "Should interpret blocks which do not fit the budget.");
+
+    run = aot_run(&chip8, &program, 4, &state);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(4, run, "Should continue from within the block.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x200, chip8.pc, "Should resume the block once back at its start.");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x06, chip8.v[0x0], "Both engines should produce the same state.");
+}
+
+TEST(Aot, SelfModifiedCode) {
+    // ADD V0, 0x01 becomes ADD V0, 0x02
+    chip8.memory[0x203] = 0x02;
+
+    chip8_state_t state;
+    aot_run(&chip8, &program, 3, &state);
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x07, chip8.v[0x0], "Modified code should be interpreted.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x1200, state.opcode, "Should report the last interpreted opcode.");
+}
+
+TEST(Aot, StopsOnFailure) {
+    // RET with an empty stack fails
+    chip8.memory[0x204] = 0x00;
+    chip8.memory[0x205] = 0xEE;
+
+    chip8_state_t state;
+    uint32_t      run = aot_run(&chip8, &program, 10, &state);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(3, run, "Should stop at the failing instruction.");
+    TEST_ASSERT_EQUAL_MESSAGE(CHIP8_STACK_EMPTY, state.status, "Should report the status of the failure.");
+}
+
+TEST(Aot, ExecuteOpcode) {
+    chip8_state_t result = {.status = CHIP8_OK};
+    chip8.pc             = 0x202;
+    bool success         = chip8_execute_opcode(&chip8, 0x2300, &result);
+    TEST_ASSERT_TRUE_MESSAGE(success, "Executing a valid opcode should succeed.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x300, chip8.pc, "The opcode should be executed.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x202, chip8.stack[0], "Should use PC as the address past the opcode.");
+}
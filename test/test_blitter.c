@@ -0,0 +1,75 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "blitter.h"
+#include "unity_fixture.h"
+
+#define ROW_WORDS 2  // Words per row of the test display
+#define ROWS      16 // Rows of the test display
+
+TEST_GROUP(Blitter);
+
+static uint64_t display[ROWS * ROW_WORDS];
+
+TEST_SETUP(Blitter) {
+    memset(display, 0, sizeof(display));
+}
+
+TEST_TEAR_DOWN(Blitter) {}
+
+TEST(Blitter, DrawAligned) {
+    uint64_t sprite[3] = {0xF0ULL << 56, 0x90ULL << 56, 0xF0ULL << 56};
+
+    bool collision = blitter_draw_sprite(display, ROW_WORDS, ROW_WORDS, 4, sprite, 3);
+    TEST_ASSERT_FALSE_MESSAGE(collision, "Drawing on an empty display should not collide.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0x0FULL << 56, display[0], "Should shift the first row into place.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0x09ULL << 56, display[ROW_WORDS], "Should advance rows by the stride.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0x0FULL << 56, display[2 * ROW_WORDS], "Should draw every row.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0x0, display[1], "Should not touch the next word.");
+
+    collision = blitter_draw_sprite(display, ROW_WORDS, ROW_WORDS, 4, sprite, 3);
+    TEST_ASSERT_TRUE_MESSAGE(collision, "Redrawing the sprite should collide.");
+    TEST_ASSERT_EACH_EQUAL_HEX64_MESSAGE(0x0, display, ROWS * ROW_WORDS, "Redrawing the sprite should erase it.");
+}
+
+TEST(Blitter, DrawStraddling) {
+    uint64_t sprite[1] = {0xFFFFULL << 48};
+
+    blitter_draw_sprite(display, ROW_WORDS, ROW_WORDS, 60, sprite, 1);
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0xFULL, display[0], "Should draw the left part into the first word.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0xFFFULL << 52, display[1], "Should draw the overflow into the next word.");
+
+    bool collision = blitter_draw_sprite(display, ROW_WORDS, ROW_WORDS, 64, sprite, 1);
+    TEST_ASSERT_TRUE_MESSAGE(collision, "Overlapping the overflow should collide.");
+}
+
+TEST(Blitter, ClipRight) {
+    uint64_t sprite[1] = {0xFFULL << 56};
+
+    blitter_draw_sprite(display, ROW_WORDS, 1, 60, sprite, 1);
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0xFULL, display[0], "Should draw the visible part.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0x0, display[1], "Should clip past the visible words.");
+
+    blitter_draw_sprite(display, ROW_WORDS, ROW_WORDS, 124, sprite, 1);
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0xFULL, display[1], "Should clip past the last word.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0x0, display[2], "Should not draw into the next row.");
+}
+
+TEST(Blitter, DrawManyRows) {
+    // Odd row counts and packed rows exercise both the paired and single rows
+    uint64_t sprite[15];
+    for (uint8_t j = 0; j < 15; ++j) {
+        sprite[j] = (uint64_t)(j + 1) << 56;
+    }
+
+    bool collision = blitter_draw_sprite(display, 1, 1, 8, sprite, 15);
+    TEST_ASSERT_FALSE_MESSAGE(collision, "Drawing on an empty display should not collide.");
+    for (uint8_t j = 0; j < 15; ++j) {
+        TEST_ASSERT_EQUAL_HEX64_MESSAGE((uint64_t)(j + 1) << 48, display[j], "Should draw every packed row.");
+    }
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0x0, display[15], "Should not draw past the last row.");
+
+    uint64_t single[1] = {0x1ULL << 56};
+    collision          = blitter_draw_sprite(&display[14], 1, 1, 8, single, 1);
+    TEST_ASSERT_TRUE_MESSAGE(collision, "Should detect collision in the last row.");
+}
@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "chip8.h"
 #include "font.h"
@@ -10,15 +11,77 @@ TEST_GROUP(CHIP8);
 static chip8_t chip8;
 
 static uint8_t generate_random_number() {
-    return (uint8_t)rand();
+    return 0xFF;
 }
 
+static uint16_t source_keys;
+
+static uint16_t read_source_keys() {
+    return source_keys;
+}
+
+#ifdef ENABLE_HOOKS
+// Events reported through the hooks
+typedef struct {
+    uint8_t  draws;
+    uint8_t  region[4];
+    uint8_t  sound_starts;
+    uint8_t  sound_stops;
+    uint8_t  key_waits;
+    uint8_t  key_register;
+    uint8_t  invalid_opcodes;
+    uint16_t invalid_address;
+    uint16_t invalid_opcode;
+    uint8_t  memory_writes;
+    uint16_t written_address;
+    uint8_t  written[4];
+} hook_events_t;
+
+static void record_draw(void *context, uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    hook_events_t *events = context;
+    events->draws += 1;
+    events->region[0] = x;
+    events->region[1] = y;
+    events->region[2] = width;
+    events->region[3] = height;
+}
+
+static void record_sound_start(void *context) {
+    ((hook_events_t *)context)->sound_starts += 1;
+}
+
+static void record_sound_stop(void *context) {
+    ((hook_events_t *)context)->sound_stops += 1;
+}
+
+static void record_key_wait(void *context, uint8_t x) {
+    hook_events_t *events = context;
+    events->key_waits += 1;
+    events->key_register = x;
+}
+
+static void record_invalid_opcode(void *context, uint16_t address, uint16_t opcode) {
+    hook_events_t *events = context;
+    events->invalid_opcodes += 1;
+    events->invalid_address = address;
+    events->invalid_opcode  = opcode;
+}
+
+static void record_memory_write(void *context, uint16_t address, uint8_t value) {
+    hook_events_t *events = context;
+    if (events->memory_writes == 0) events->written_address = address;
+    if (events->memory_writes < sizeof(events->written)) events->written[events->memory_writes] = value;
+    events->memory_writes += 1;
+}
+#endif
+
 TEST_SETUP(CHIP8) {
-    srand(1);
-    chip8_init(&chip8, generate_random_number);
+    chip8_init(&chip8);
 }
 
-TEST_TEAR_DOWN(CHIP8) {}
+TEST_TEAR_DOWN(CHIP8) {
+    chip8_free(&chip8);
+}
 
 TEST(CHIP8, LoadValidFont) {
     // chip8_init loads the default font, which can be configured when
@@ -122,6 +185,22 @@ TEST(CHIP8, StoreAndLoad) {
     TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(values, &chip8.v, sizeof(values), "Variables should be loaded from memory.");
 }
 
+TEST(CHIP8, StoreQuirk) {
+    uint8_t program[4] = {0xF2, 0x55, 0xF2, 0x55};
+    bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.i = 0x300;
+    chip8_set_quirks(&chip8, QUIRK_MEMORY);
+    chip8_state_t legacy_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, legacy_result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x303, chip8.i, "Should increment I with legacy behavior.");
+
+    chip8_set_quirks(&chip8, QUIRK_NONE);
+    chip8_state_t modern_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, modern_result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x303, chip8.i, "Should not modify I with modern behavior.");
+}
+
 TEST(CHIP8, ExecuteSubroutine) {
     uint8_t program[6] = {0x22, 0x04, 0x00, 0xE0, 0x00, 0xEE};
     bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
@@ -150,9 +229,8 @@ TEST(CHIP8, Jump) {
     TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x123, chip8.pc, "Should jump PC to provided address.");
 }
 
-// TODO: Add test for legacy/modern offset testing when it is configurable at runtime.
-// Currently, since it depends on a compiler flag, we test with a setup that makes
-// both versions behave the same so that neither behavior can change test results.
+// Uses a setup that makes both versions behave the same, so that the configured
+// default quirks cannot change test results.
 TEST(CHIP8, JumpWithOffset) {
     uint8_t program[2] = {0xB3, 0x00};
     bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
@@ -166,6 +244,25 @@ TEST(CHIP8, JumpWithOffset) {
     TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x360, chip8.pc, "Should jump PC to calculated address.");
 }
 
+TEST(CHIP8, JumpWithOffsetQuirk) {
+    uint8_t program[2] = {0xB3, 0x00};
+    bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.v[0] = 0x10;
+    chip8.v[3] = 0x60;
+
+    chip8_set_quirks(&chip8, QUIRK_OFFSET_JUMP);
+    chip8_state_t legacy_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, legacy_result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x310, chip8.pc, "Should offset by V0 with legacy behavior.");
+
+    chip8.pc = PROGRAM_START;
+    chip8_set_quirks(&chip8, QUIRK_NONE);
+    chip8_state_t modern_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, modern_result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x360, chip8.pc, "Should offset by VX with modern behavior.");
+}
+
 TEST(CHIP8, SetVariable) {
     uint8_t       program[2] = {0x61, 0x23};
     bool          loaded     = chip8_load_program(&chip8, program, sizeof(program));
@@ -263,9 +360,8 @@ TEST(CHIP8, SkipVariablesNotEqual) {
     TEST_ASSERT_EQUAL_UINT16_MESSAGE(PROGRAM_START + 6, chip8.pc, "Should skip, should advance PC twice.");
 }
 
-// TODO: Add test for legacy/modern shift testing when it is configurable at runtime.
-// Currently, since it depends on a compiler flag, we test with both variables
-// set to the same register so that neither behavior can change test results.
+// Uses both variables set to the same register, so that the configured default
+// quirks cannot change test results.
 TEST(CHIP8, Shift) {
     uint8_t program[4] = {0x80, 0x06, 0x80, 0x0E};
     bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
@@ -283,6 +379,26 @@ TEST(CHIP8, Shift) {
     TEST_ASSERT_EQUAL_UINT8_MESSAGE(0b00001000, chip8.v[0], "Should shift V0 left.");
 }
 
+TEST(CHIP8, ShiftQuirk) {
+    uint8_t program[4] = {0x80, 0x16, 0x80, 0x16};
+    bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.v[0] = 0b00001000;
+    chip8.v[1] = 0b00000011;
+
+    chip8_set_quirks(&chip8, QUIRK_SHIFT);
+    chip8_state_t legacy_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, legacy_result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0b00000001, chip8.v[0], "Should shift V1 into V0 with legacy behavior.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(1, chip8.v[0xF], "Should set VF to the shifted out bit.");
+
+    chip8.v[0] = 0b00001000;
+    chip8_set_quirks(&chip8, QUIRK_NONE);
+    chip8_state_t modern_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, modern_result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0b00000100, chip8.v[0], "Should shift V0 in place with modern behavior.");
+}
+
 TEST(CHIP8, SetIndex) {
     uint8_t       program[2] = {0xA1, 0x23};
     bool          loaded     = chip8_load_program(&chip8, program, sizeof(program));
@@ -350,8 +466,8 @@ TEST(CHIP8, DrawSprite) {
     TEST_ASSERT_EQUAL_UINT16_MESSAGE(0xD015, result.opcode, "Should create \"Draw Sprite\".");
     TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, result.status, "Should be implemented.");
     TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, chip8.v[0xF], "Should not set VF.");
-    TEST_ASSERT_TRUE_MESSAGE(chip8.display[(2 * DISPLAY_WIDTH) + 1], "Top-left pixel of sprite should be ON.");
-    TEST_ASSERT_TRUE_MESSAGE(chip8.display[(6 * DISPLAY_WIDTH) + 4], "Bottom-right pixel of sprite should be ON.");
+    TEST_ASSERT_TRUE_MESSAGE(chip8_get_pixel(&chip8, 1, 2), "Top-left pixel of sprite should be ON.");
+    TEST_ASSERT_TRUE_MESSAGE(chip8_get_pixel(&chip8, 4, 6), "Bottom-right pixel of sprite should be ON.");
 }
 
 TEST(CHIP8, ClearScreen) {
@@ -363,6 +479,19 @@ TEST(CHIP8, ClearScreen) {
     TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, result.status, "Should be implemented.");
 }
 
+TEST(CHIP8, TakeDrawnRows) {
+    uint8_t program[2] = {0xD0, 0x13};
+    chip8_load_program(&chip8, program, sizeof(program));
+    chip8.i    = 0x300;
+    chip8.v[1] = 2;
+
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(~0ULL, chip8_take_drawn_rows(&chip8), "Should draw every row after a reset.");
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0x1CULL, chip8_take_drawn_rows(&chip8), "Should take the rows drawn to.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0, chip8_take_drawn_rows(&chip8), "Should clear the rows once taken.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0x1CULL, chip8.dirty_rows, "Should leave the rows to restore.");
+}
+
 TEST(CHIP8, Timers) {
     uint8_t program[6] = {0xF0, 0x15, 0xF1, 0x07, 0xF1, 0x18};
     bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
@@ -384,3 +513,721 @@ TEST(CHIP8, Timers) {
     TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, third_result.status, "Should be implemented.");
     TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x20, chip8.sound_timer, "Should set sound timer to V1.");
 }
+
+TEST(CHIP8, DrawSpriteClipped) {
+    uint8_t program[4] = {0xD0, 0x11, 0xD0, 0x11};
+    bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.i             = 0x300;
+    chip8.v[0]          = DISPLAY_WIDTH - 4;
+    chip8.v[1]          = 0;
+    chip8.memory[0x300] = 0xFF;
+
+    chip8_state_t first_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, first_result.status, "Should be implemented.");
+    TEST_ASSERT_TRUE_MESSAGE(chip8_get_pixel(&chip8, DISPLAY_WIDTH - 1, 0), "Rightmost pixel of sprite should be ON.");
+    TEST_ASSERT_FALSE_MESSAGE(chip8_get_pixel(&chip8, 0, 0), "Sprite should not wrap across the screen.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, chip8.v[0xF], "Should not set VF.");
+
+    chip8_state_t second_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, second_result.status, "Should be implemented.");
+    TEST_ASSERT_FALSE_MESSAGE(chip8_get_pixel(&chip8, DISPLAY_WIDTH - 1, 0), "Redrawn sprite should turn pixels OFF.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(1, chip8.v[0xF], "Should set VF on collision.");
+}
+
+TEST(CHIP8, ClassicFootprint) {
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(VARIANT_CHIP8, chip8.variant, "Should default to the classic variant.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(MEMORY_SIZE, chip8.memory_size, "Should only allocate classic memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(1, chip8.display_planes, "Should only allocate a single plane.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(DISPLAY_HEIGHT, chip8.plane_size, "Should pack a row into a single word.");
+}
+
+TEST(CHIP8, FetchWrapsMemory) {
+    chip8.pc                   = ADDRESS_SIZE;
+    chip8.memory[ADDRESS_SIZE] = 0x60;
+    chip8.memory[0x000]        = 0x12;
+
+    chip8_state_t result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x6012, result.opcode, "Should fetch across the end of memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x12, chip8.v[0], "Should execute the wrapped instruction.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x001, chip8.pc, "PC should wrap to the start of memory.");
+}
+
+TEST(CHIP8, StoreAndLoadWrapMemory) {
+    uint8_t program[4] = {0xF3, 0x55, 0xF3, 0x65};
+    chip8_load_program(&chip8, program, sizeof(program));
+    chip8_set_quirks(&chip8, 0);
+
+    chip8.i = ADDRESS_SIZE - 1;
+    for (uint8_t j = 0; j < 4; ++j) {
+        chip8.v[j] = 0xA0 + j;
+    }
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0xA1, chip8.memory[ADDRESS_SIZE], "Should store up to the end of memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0xA2, chip8.memory[0x000], "Should wrap store to the start of memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0xA3, chip8.memory[0x001], "Should continue store after wrapping.");
+
+    memset(chip8.v, 0, sizeof(chip8.v));
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0xA2, chip8.v[2], "Should wrap load to the start of memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0xA3, chip8.v[3], "Should continue load after wrapping.");
+}
+
+TEST(CHIP8, DecimalConversionWrapsMemory) {
+    uint8_t program[2] = {0xF0, 0x33};
+    chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.i    = ADDRESS_SIZE;
+    chip8.v[0] = 123;
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(1, chip8.memory[ADDRESS_SIZE], "Should store hundreds at the end of memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(2, chip8.memory[0x000], "Should wrap tens to the start of memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(3, chip8.memory[0x001], "Should wrap ones to the start of memory.");
+}
+
+TEST(CHIP8, DrawSpriteWrapsMemory) {
+    uint8_t program[2] = {0xD0, 0x02};
+    chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.i                    = ADDRESS_SIZE;
+    chip8.memory[ADDRESS_SIZE] = 0x80;
+    chip8.memory[0x000]        = 0x40;
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(1, chip8_get_pixel(&chip8, 0, 0), "Should draw row from the end of memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(1, chip8_get_pixel(&chip8, 1, 1), "Should draw row wrapped to the start of memory.");
+}
+
+TEST(CHIP8, JumpWithOffsetWrapsMemory) {
+    uint8_t program[2] = {0xBF, 0xFF};
+    chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.v[0]   = 0xFF;
+    chip8.v[0xF] = 0xFF;
+    chip8_set_quirks(&chip8, QUIRK_OFFSET_JUMP);
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x0FE, chip8.pc, "Should wrap the jump with V0 to the start of memory.");
+
+    chip8.pc = PROGRAM_START;
+    chip8_set_quirks(&chip8, QUIRK_NONE);
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x0FE, chip8.pc, "Should wrap the jump with VX to the start of memory.");
+}
+
+TEST(CHIP8, EdgeAddresses) {
+    // Every I-relative instruction at every address near the end of memory,
+    // as well as indices past it, must stay within the allocated memory
+    uint16_t opcodes[4] = {0xFF55, 0xFF65, 0xF033, 0xD01F};
+    for (uint8_t o = 0; o < 4; ++o) {
+        for (uint32_t address = ADDRESS_SIZE - 0x20; address <= 0xFFFF; ++address) {
+            uint16_t pc                           = address & ADDRESS_SIZE;
+            chip8.memory[pc]                      = opcodes[o] >> 8;
+            chip8.memory[(pc + 1) & ADDRESS_SIZE] = opcodes[o] & 0xFF;
+            chip8.pc                              = pc;
+            chip8.i                               = address;
+
+            chip8_state_t result = chip8_run_cycle(&chip8);
+            TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, result.status, "Edge addresses should execute.");
+            TEST_ASSERT_TRUE_MESSAGE(chip8.pc <= ADDRESS_SIZE, "PC should stay within memory.");
+        }
+    }
+}
+
+TEST(CHIP8, Clone) {
+    uint8_t program[2] = {0x61, 0x23};
+    bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8_t clone;
+    TEST_ASSERT_TRUE_MESSAGE(chip8_clone(&clone, &chip8), "Cloning should not fail.");
+    TEST_ASSERT_TRUE_MESSAGE(clone.memory != chip8.memory, "Clone should own its memory.");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(program, &clone.memory[PROGRAM_START], sizeof(program), "Clone should copy memory.");
+
+    chip8_state_t result = chip8_run_cycle(&clone);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, result.status, "Clone should be runnable.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x23, clone.v[1], "Clone should update its own state.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x00, chip8.v[1], "Original should not be affected.");
+    chip8_free(&clone);
+}
+
+TEST(CHIP8, CaptureAndRestore) {
+    // Stores V0 over the data at 0x300, then clears the screen and draws it
+    uint8_t program[14] = {0x60, 0xAA, 0xA3, 0x00, 0xF0, 0x55, 0x00, 0xE0, 0xA3, 0x00, 0xD1, 0x11, 0x12, 0x0C};
+    chip8_load_program(&chip8, program, sizeof(program));
+    chip8.memory[0x300] = 0x12;
+    chip8.v[1]          = 0x08;
+
+    chip8_t baseline;
+    TEST_ASSERT_TRUE_MESSAGE(chip8_capture(&baseline, &chip8), "Capturing should not fail.");
+    for (uint8_t c = 0; c < 6; ++c) chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0xAA, chip8.memory[0x300], "Program should write to memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(1, chip8_get_pixel(&chip8, 8, 8), "Program should draw.");
+
+    TEST_ASSERT_TRUE_MESSAGE(chip8_restore(&chip8, &baseline), "Restoring should not fail.");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x12, chip8.memory[0x300], "Should restore written memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, chip8_get_pixel(&chip8, 8, 8), "Should restore the display.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(PROGRAM_START, chip8.pc, "Should restore registers.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x00, chip8.v[0], "Should restore variable registers.");
+    TEST_ASSERT_TRUE_MESSAGE(chip8.memory != baseline.memory, "Should keep its own memory.");
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(baseline.memory, chip8.memory, chip8.memory_size, "Should match the baseline.");
+
+    // Only pages written since the last reset are copied back
+    baseline.memory[0x800] = 0xFF;
+    chip8_restore(&chip8, &baseline);
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x00, chip8.memory[0x800], "Should not rewrite clean pages.");
+    chip8_free(&baseline);
+}
+
+TEST(CHIP8, RestoreOtherVariant) {
+    chip8_t baseline;
+    chip8_capture(&baseline, &chip8);
+    chip8_set_variant(&chip8, VARIANT_XOCHIP);
+    TEST_ASSERT_FALSE_MESSAGE(chip8_restore(&chip8, &baseline), "Should reject baselines of other variants.");
+    chip8_free(&baseline);
+}
+
+TEST(CHIP8, PatchMemory) {
+    chip8_t baseline;
+    chip8_capture(&baseline, &chip8);
+
+    uint8_t data[4] = {0x60, 0x01, 0x61, 0x02};
+    TEST_ASSERT_TRUE_MESSAGE(chip8_patch_memory(&chip8, 0x2FE, data, sizeof(data)), "Patching should not fail.");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(data, &chip8.memory[0x2FE], sizeof(data), "Should write the data.");
+    TEST_ASSERT_FALSE_MESSAGE(chip8_patch_memory(&chip8, chip8.memory_size - 2, data, sizeof(data)),
+                              "Should reject patches out of bounds.");
+
+    // Both pages spanned by the patch are restored
+    chip8_restore(&chip8, &baseline);
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x00, chip8.memory[0x2FF], "Should restore the first page.");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x00, chip8.memory[0x300], "Should restore the second page.");
+    chip8_free(&baseline);
+}
+
+TEST(CHIP8, HashFollowsState) {
+    // Stores V0 and V1 at 0x300, draws them, clears the screen and stores zeroes back
+    uint8_t program[18] = {0x60, 0xAA, 0x61, 0x55, 0xA3, 0x00, 0xF1, 0x55, 0xD0, 0x12,
+                           0x00, 0xE0, 0x60, 0x00, 0x61, 0x00, 0xF1, 0x55};
+    chip8_load_program(&chip8, program, sizeof(program));
+    chip8_set_quirks(&chip8, QUIRK_NONE);
+    chip8.i          = 0x300;
+    uint64_t initial = chip8_hash(&chip8);
+
+    for (uint8_t c = 0; c < 5; ++c) chip8_run_cycle(&chip8);
+    uint64_t drawn = chip8_hash(&chip8);
+    TEST_ASSERT_TRUE_MESSAGE(drawn != initial, "Should change with the state.");
+
+    // The maintained hash must match one computed from scratch
+    chip8_rehash(&chip8);
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(drawn, chip8_hash(&chip8), "Should maintain the hash on every write.");
+
+    for (uint8_t c = 0; c < 4; ++c) chip8_run_cycle(&chip8);
+    chip8.pc = PROGRAM_START;
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(initial, chip8_hash(&chip8), "Should return to the hash of the same state.");
+}
+
+TEST(CHIP8, HashIgnoresStatistics) {
+    chip8_t clone;
+    chip8_clone(&clone, &chip8);
+    clone.fusions[FUSION_SPRITE] = 10;
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(chip8_hash(&chip8), chip8_hash(&clone), "Should ignore statistics.");
+
+    clone.v[0x3] = 0x01;
+    TEST_ASSERT_TRUE_MESSAGE(chip8_hash(&chip8) != chip8_hash(&clone), "Should not ignore registers.");
+    chip8_free(&clone);
+}
+
+TEST(CHIP8, UpdateTimers) {
+    chip8.delay_timer = 2;
+    chip8.sound_timer = 1;
+
+    chip8_update_timers(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(1, chip8.delay_timer, "Should decrement delay timer.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, chip8.sound_timer, "Should decrement sound timer.");
+
+    chip8_update_timers(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, chip8.sound_timer, "Should not decrement past zero.");
+}
+
+TEST(CHIP8, SeededRandom) {
+    uint8_t program[8] = {0xC0, 0xFF, 0xC1, 0xFF, 0xC2, 0xFF, 0xC3, 0x0F};
+    chip8_load_program(&chip8, program, sizeof(program));
+    chip8_seed_rng(&chip8, 42);
+
+    chip8_t clone;
+    chip8_clone(&clone, &chip8);
+    for (uint8_t j = 0; j < 4; ++j) {
+        chip8_run_cycle(&chip8);
+        chip8_run_cycle(&clone);
+    }
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(chip8.v, clone.v, 4, "Equal seeds should produce equal sequences.");
+    TEST_ASSERT_FALSE_MESSAGE(chip8.v[0] == chip8.v[1] && chip8.v[1] == chip8.v[2], "Sequence should not be constant.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x00, chip8.v[3] & 0xF0, "Should mask random number.");
+    chip8_free(&clone);
+
+    chip8_seed_rng(&chip8, 0);
+    TEST_ASSERT_TRUE_MESSAGE(chip8.rng != 0, "Zero seed should not stall the generator.");
+}
+
+TEST(CHIP8, RandomOverride) {
+    uint8_t program[4] = {0xC0, 0x3C, 0xC1, 0x3C};
+    chip8_load_program(&chip8, program, sizeof(program));
+    chip8_seed_rng(&chip8, 42);
+
+    // The built-in generator draws the same number from the same seed
+    chip8_t reference;
+    chip8_clone(&reference, &chip8);
+    chip8_run_cycle(&reference);
+
+    chip8_set_rng(&chip8, generate_random_number);
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x3C, chip8.v[0], "Should use generator callback.");
+
+    chip8_set_rng(&chip8, NULL);
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(reference.v[0], chip8.v[1], "Should restore built-in generator.");
+    chip8_free(&reference);
+}
+
+TEST(CHIP8, SkipIfKey) {
+    // LD V0, 0x05; SKP V0; LD V1, 0x01; SKNP V0; LD V2, 0x01
+    uint8_t program[10] = {0x60, 0x05, 0xE0, 0x9E, 0x61, 0x01, 0xE0, 0xA1, 0x62, 0x01};
+    chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8_set_keypad(&chip8, 1 << 0x5);
+    for (uint8_t c = 0; c < 4; ++c) chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x00, chip8.v[1], "Should skip while the key is pressed.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x01, chip8.v[2], "Should not skip while the key is pressed.");
+
+    chip8_load_program(&chip8, program, sizeof(program));
+    chip8_set_keypad(&chip8, 1 << 0x4);
+    for (uint8_t c = 0; c < 4; ++c) chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x01, chip8.v[1], "Should not skip while the key is released.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x20A, chip8.pc, "Should skip while the key is released.");
+}
+
+TEST(CHIP8, WaitForKey) {
+    // LD V3, K
+    uint8_t program[2] = {0xF3, 0x0A};
+    chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(PROGRAM_START, chip8.pc, "Should wait without a key.");
+
+    chip8_set_keypad(&chip8, 1 << 0x7);
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(PROGRAM_START, chip8.pc, "Should wait while the key is pressed.");
+
+    chip8_set_keypad(&chip8, 0);
+    chip8_state_t state = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, state.status, "Waiting should succeed.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(PROGRAM_START + 2, chip8.pc, "Should continue once the key is released.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x7, chip8.v[3], "Should store the released key.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0, chip8.key_wait, "Should stop waiting.");
+}
+
+TEST(CHIP8, KeypadSourceEdges) {
+    // SKP V0; JP 0x200; JP 0x204
+    uint8_t program[6] = {0xE0, 0x9E, 0x12, 0x00, 0x12, 0x04};
+    chip8_load_program(&chip8, program, sizeof(program));
+    chip8_set_keypad_source(&chip8, read_source_keys);
+
+    source_keys = 0;
+    chip8_state_t state;
+    chip8_run_cycles(&chip8, 4, &state);
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(4, chip8.cycles, "Should count the cycles run.");
+
+    source_keys = 1 << 0x0;
+    chip8_set_keypad(&chip8, 0);
+    chip8_run_cycles(&chip8, 2, &state);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x204, chip8.pc, "Should read the keypad from the source.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(4, chip8.key_pressed_at[0x0], "Should stamp the cycle of the press.");
+
+    source_keys = 0;
+    chip8.pc    = PROGRAM_START;
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(6, chip8.key_released_at[0x0], "Should stamp the cycle of the release.");
+
+    chip8_set_keypad_source(&chip8, NULL);
+}
+
+TEST(CHIP8, RunCyclesFusesPairs) {
+    // LD V0, 0x05; ADD V0, 0x01; SE V0, 0x06; JP 0x200; LD V1, 0x01
+    uint8_t program[10] = {0x60, 0x05, 0x70, 0x01, 0x30, 0x06, 0x12, 0x00, 0x61, 0x01};
+    chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8_state_t state;
+    uint32_t      run = chip8_run_cycles(&chip8, 4, &state);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(4, run, "Should run every cycle.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, state.status, "Running the cycles should succeed.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x20A, chip8.pc, "The fused skip should skip the jump.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x01, chip8.v[1], "Should continue after the fused pair.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, chip8.fusions[FUSION_COUNTER], "Should count the fused pair.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x6101, state.opcode, "Should report the last opcode.");
+}
+
+TEST(CHIP8, RunCyclesRespectsBudget) {
+    uint8_t program[4] = {0x60, 0x05, 0x61, 0x06};
+    chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8_state_t state;
+    uint32_t      run = chip8_run_cycles(&chip8, 1, &state);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, run, "Should not run past the budget.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x00, chip8.v[1], "Should not fuse past the budget.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, chip8.fusions[FUSION_LOAD_PAIR], "Should not count unfused pairs.");
+}
+
+TEST(CHIP8, RunCyclesJumpIntoPair) {
+    // JP 0x206; LD V0, 0x05; LD V1, 0x06; JP 0x206
+    uint8_t program[8] = {0x12, 0x04, 0x60, 0x05, 0x61, 0x06, 0x12, 0x06};
+    chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8_state_t state;
+    chip8_run_cycles(&chip8, 3, &state);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x00, chip8.v[0], "Should not run the first instruction of the pair.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x06, chip8.v[1], "Should run the jump target on its own.");
+}
+
+TEST(CHIP8, RunCyclesModifiedPair) {
+    // LD I, 0x202; LD [I], V0; LD V0, 0x05; LD V1, 0x06
+    uint8_t program[8] = {0xA2, 0x06, 0xF0, 0x55, 0x60, 0x05, 0x61, 0x06};
+    chip8_load_program(&chip8, program, sizeof(program));
+    chip8.v[0] = 0x71; // LD V1, 0x06 becomes ADD V1, 0x06
+    chip8.v[1] = 0x05;
+
+    chip8_state_t state;
+    chip8_run_cycles(&chip8, 4, &state);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x0B, chip8.v[1], "Should run the modified instruction.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, chip8.fusions[FUSION_LOAD_PAIR], "Should not fuse the modified pair.");
+}
+
+TEST(CHIP8, RunUntilLimit) {
+    // LD V0, 0x05; ADD V0, 0x01; SE V0, 0x06; JP 0x200; JP 0x208
+    uint8_t program[10] = {0x60, 0x05, 0x70, 0x01, 0x30, 0x06, 0x12, 0x00, 0x12, 0x08};
+    chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8_stop_t stop;
+    uint32_t     run = chip8_run_until(&chip8, 10, &stop);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(10, run, "Should run every cycle without breakpoints.");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CHIP8_STOP_LIMIT, stop.reason, "Should stop at the limit.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, chip8.fusions[FUSION_COUNTER], "Should run the fused loop.");
+}
+
+TEST(CHIP8, RunUntilBreakpoint) {
+    // LD V0, 0x05; ADD V0, 0x01; SE V0, 0x06; JP 0x200; JP 0x208
+    uint8_t program[10] = {0x60, 0x05, 0x70, 0x01, 0x30, 0x06, 0x12, 0x00, 0x12, 0x08};
+    chip8_load_program(&chip8, program, sizeof(program));
+    TEST_ASSERT_TRUE_MESSAGE(chip8_set_breakpoint(&chip8, 0x204, true), "Setting a breakpoint should not fail.");
+    TEST_ASSERT_FALSE_MESSAGE(chip8_set_breakpoint(&chip8, chip8.memory_size, true),
+                              "Should reject breakpoints out of bounds.");
+
+    chip8_stop_t stop;
+    uint32_t     run = chip8_run_until(&chip8, 10, &stop);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CHIP8_STOP_BREAKPOINT, stop.reason, "Should stop at the breakpoint.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x204, stop.address, "Should report the breakpoint.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x204, chip8.pc, "Should stop before the instruction.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, run, "Should run up to the breakpoint.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, chip8.fusions[FUSION_COUNTER], "Should not fuse past breakpoints.");
+
+    // Resuming steps over the breakpoint it stopped at
+    run = chip8_run_until(&chip8, 10, &stop);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CHIP8_STOP_LIMIT, stop.reason, "Should resume past the breakpoint.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(10, run, "Should run every cycle once resumed.");
+
+    chip8_set_breakpoint(&chip8, 0x204, false);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, chip8.breakpoint_count, "Should count cleared breakpoints.");
+}
+
+TEST(CHIP8, RunUntilWatchpoint) {
+    // LD I, 0x300; LD V2, [I]; LD [I], V2; JP 0x206
+    uint8_t program[8] = {0xA3, 0x00, 0xF2, 0x65, 0xF2, 0x55, 0x12, 0x06};
+    chip8_load_program(&chip8, program, sizeof(program));
+    chip8_set_quirks(&chip8, QUIRK_NONE);
+    chip8_set_watchpoint(&chip8, 0x302, CHIP8_WATCH_WRITE, true);
+
+    chip8_stop_t stop;
+    chip8_run_until(&chip8, 10, &stop);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CHIP8_STOP_WRITE, stop.reason, "Should stop at the write.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x302, stop.address, "Should report the watched address.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x204, chip8.pc, "Should stop before the write.");
+
+    chip8.pc = PROGRAM_START;
+    chip8_set_watchpoint(&chip8, 0x301, CHIP8_WATCH_READ | CHIP8_WATCH_WRITE, true);
+    chip8_run_until(&chip8, 10, &stop);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CHIP8_STOP_READ, stop.reason, "Should stop at the read.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x301, stop.address, "Should report the first watched address.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(3, chip8.watchpoint_count, "Should count every watchpoint.");
+
+    chip8_t clone;
+    chip8_clone(&clone, &chip8);
+    TEST_ASSERT_NULL_MESSAGE(clone.breakpoints, "Should not copy breakpoints into clones.");
+    chip8_free(&clone);
+
+    chip8_clear_breakpoints(&chip8);
+    chip8_run_until(&chip8, 10, &stop);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CHIP8_STOP_LIMIT, stop.reason, "Should not stop once cleared.");
+}
+
+TEST(CHIP8, CoverageAndSelfModifyingCode) {
+#ifdef ENABLE_COVERAGE
+    // LD I, 0x300; LD [I], V0; LD I, 0x203; LD [I], V0
+    uint8_t program[8] = {0xA3, 0x00, 0xF0, 0x55, 0xA2, 0x03, 0xF0, 0x55};
+    chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8_run_cycle(&chip8);
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_TRUE_MESSAGE(chip8_covered(chip8.executed, 0x202), "Should mark the executed opcode.");
+    TEST_ASSERT_TRUE_MESSAGE(chip8_covered(chip8.executed, 0x203), "Should mark both bytes of the opcode.");
+    TEST_ASSERT_FALSE_MESSAGE(chip8_covered(chip8.executed, 0x204), "Should not mark unexecuted code.");
+    TEST_ASSERT_TRUE_MESSAGE(chip8_covered(chip8.written, 0x300), "Should mark the written address.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, chip8.smc_writes, "Writing data is not self-modification.");
+
+    // The second store writes over the operand of the first
+    chip8_run_cycle(&chip8);
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, chip8.smc_writes, "Should detect writes into executed code.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x203, chip8.smc_address, "Should record the first modified address.");
+
+    chip8_load_program(&chip8, program, sizeof(program));
+    TEST_ASSERT_FALSE_MESSAGE(chip8_covered(chip8.executed, 0x200), "Loading a program should clear coverage.");
+#else
+    TEST_IGNORE_MESSAGE("Coverage requires building with ENABLE_COVERAGE.");
+#endif
+}
+
+TEST(CHIP8, Hooks) {
+#ifdef ENABLE_HOOKS
+    hook_events_t events = {0};
+
+    chip8_hooks_t hooks = {
+        .context           = &events,
+        .on_draw           = record_draw,
+        .on_sound_start    = record_sound_start,
+        .on_sound_stop     = record_sound_stop,
+        .on_key_wait       = record_key_wait,
+        .on_invalid_opcode = record_invalid_opcode,
+        .on_memory_write   = record_memory_write,
+    };
+    TEST_ASSERT_TRUE_MESSAGE(chip8_set_hooks(&chip8, &hooks), "Should install hooks when built with them.");
+
+    // LD V1, 62; LD V2, 30; DRW V1, V2, 5; CLS; LD V3, 2; LD ST, V3; LD ST, V3;
+    // LD I, 0x300; LD [I], V3; LD V4, K
+    uint8_t program[20] = {0x61, 0x3E, 0x62, 0x1E, 0xD1, 0x25, 0x00, 0xE0, 0x63, 0x02,
+                           0xF3, 0x18, 0xF3, 0x18, 0xA3, 0x00, 0xF3, 0x55, 0xF4, 0x0A};
+    chip8_load_program(&chip8, program, sizeof(program));
+    chip8_state_t state;
+    chip8_run_cycles(&chip8, 3, &state);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(1, events.draws, "Should report every sprite drawn.");
+    uint8_t clipped[4] = {62, 30, 2, 2};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(clipped, events.region, 4, "Should report the region clipped to the display.");
+
+    chip8_run_cycles(&chip8, 1, &state);
+    uint8_t full[4] = {0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(full, events.region, 4, "Should report the whole display when clearing it.");
+
+    chip8_run_cycles(&chip8, 3, &state);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(1, events.sound_starts, "Should report the sound starting only while expired.");
+
+    chip8_run_cycles(&chip8, 2, &state);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(4, events.memory_writes, "Should report every byte written.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x300, events.written_address, "Should report the written addresses.");
+    uint8_t stored[4] = {0x00, 62, 30, 2};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(stored, events.written, 4, "Should report the written values.");
+
+    chip8_run_cycles(&chip8, 3, &state);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(3, events.key_waits, "Should report every cycle spent waiting for a key.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(4, events.key_register, "Should report the register receiving the key.");
+
+    chip8_update_timers(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, events.sound_stops, "Should not report the sound stopping early.");
+    chip8_update_timers(&chip8);
+    chip8_update_timers(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(1, events.sound_stops, "Should report the sound timer expiring once.");
+
+    // An opcode which no instruction resolves
+    uint8_t invalid[4] = {0x00, 0xE0, 0xE0, 0xFF};
+    chip8_load_program(&chip8, invalid, sizeof(invalid));
+    chip8_run_cycles(&chip8, 2, &state);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CHIP8_INSTRUCTION_INVALID, state.status, "Should still report the failure.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(1, events.invalid_opcodes, "Should report invalid opcodes.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x202, events.invalid_address, "Should report the address of the invalid opcode.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0xE0FF, events.invalid_opcode, "Should report the invalid opcode.");
+
+    // Clones do not call the hooks of the original
+    chip8_t clone;
+    chip8_clone(&clone, &chip8);
+    chip8_load_program(&clone, program, sizeof(program));
+    chip8_run_cycles(&clone, 3, &state);
+    chip8_free(&clone);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(3, events.draws, "Should not call hooks from clones.");
+
+    chip8_set_hooks(&chip8, NULL);
+    chip8_load_program(&chip8, program, sizeof(program));
+    chip8_run_cycles(&chip8, 3, &state);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(3, events.draws, "Should not call removed hooks.");
+#else
+    chip8_hooks_t hooks = {0};
+    TEST_ASSERT_FALSE_MESSAGE(chip8_set_hooks(&chip8, &hooks), "Should not install hooks without ENABLE_HOOKS.");
+#endif
+}
+
+TEST_GROUP(XOCHIP);
+
+TEST_SETUP(XOCHIP) {
+    chip8_init(&chip8);
+    chip8_set_variant(&chip8, VARIANT_XOCHIP);
+}
+
+TEST_TEAR_DOWN(XOCHIP) {
+    chip8_free(&chip8);
+}
+
+TEST(XOCHIP, Allocation) {
+    uint8_t program[XOCHIP_MEMORY_SIZE - PROGRAM_START] = {0x00, 0xE0};
+    program[sizeof(program) - 1]                         = 0xAB;
+
+    bool success = chip8_load_program(&chip8, program, sizeof(program));
+    TEST_ASSERT_TRUE_MESSAGE(success, "Loading program spanning 64KB should not fail.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0xAB, chip8.memory[XOCHIP_ADDRESS_SIZE], "Program should reach the end of memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(4, chip8.display_planes, "Should allocate four planes.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x1, chip8.planes, "Should select the first plane.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(DEFAULT_PITCH, chip8.pitch, "Should reset the pitch.");
+}
+
+TEST(XOCHIP, LongIndex) {
+    uint8_t program[4] = {0xF0, 0x00, 0xAB, 0xCD};
+    bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8_state_t result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0xF000, result.opcode, "Should create \"Set Index to Long Address\".");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0xABCD, chip8.i, "Should load 16-bit address into I.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(PROGRAM_START + 4, chip8.pc, "Should advance PC past the address.");
+}
+
+TEST(XOCHIP, SkipLongIndex) {
+    uint8_t program[6] = {0x30, 0x00, 0xF0, 0x00, 0xAB, 0xCD};
+    bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8_state_t result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(PROGRAM_START + 6, chip8.pc, "Should skip the entire long instruction.");
+}
+
+TEST(XOCHIP, SaveAndLoadRange) {
+    uint8_t program[4] = {0x53, 0x12, 0x51, 0x33};
+    uint8_t values[3]  = {0x30, 0x20, 0x10};
+    bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.i    = 0x300;
+    chip8.v[1] = 0x10;
+    chip8.v[2] = 0x20;
+    chip8.v[3] = 0x30;
+
+    chip8_state_t save_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x5312, save_result.opcode, "Should create \"Save Variable Range\".");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, save_result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(values, &chip8.memory[0x300], sizeof(values), "Variables should be written in reverse order.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x300, chip8.i, "Should not modify I.");
+
+    chip8.v[1] = 0x0;
+    chip8.v[2] = 0x0;
+    chip8.v[3] = 0x0;
+
+    chip8_state_t load_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x5133, load_result.opcode, "Should create \"Load Variable Range\".");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, load_result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(values, &chip8.v[1], sizeof(values), "Variables should be loaded in order.");
+}
+
+TEST(XOCHIP, RangeWrapsMemory) {
+    uint8_t program[6] = {0x50, 0x12, 0xA0, 0x00, 0xF0, 0x02};
+    chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.i    = XOCHIP_ADDRESS_SIZE;
+    chip8.v[0] = 0x10;
+    chip8.v[1] = 0x20;
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x10, chip8.memory[XOCHIP_ADDRESS_SIZE], "Should save up to the end of memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x20, chip8.memory[0x0000], "Should wrap range to the start of memory.");
+
+    chip8_run_cycle(&chip8);
+    chip8.i = XOCHIP_ADDRESS_SIZE;
+    chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x10, chip8.audio_pattern[0], "Should load pattern from the end of memory.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x20, chip8.audio_pattern[1], "Should wrap pattern to the start of memory.");
+}
+
+TEST(XOCHIP, DrawPlanes) {
+    uint8_t program[4] = {0xF3, 0x01, 0xD0, 0x01};
+    bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.i             = 0x300;
+    chip8.memory[0x300] = 0x80; // First plane
+    chip8.memory[0x301] = 0xC0; // Second plane
+
+    chip8_state_t plane_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0xF301, plane_result.opcode, "Should create \"Select Planes\".");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, plane_result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x3, chip8.planes, "Should select both planes.");
+
+    chip8_state_t draw_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, draw_result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x3, chip8_get_pixel(&chip8, 0, 0), "First pixel should be set in both planes.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x2, chip8_get_pixel(&chip8, 1, 0), "Second pixel should be set in the second plane.");
+}
+
+TEST(XOCHIP, DrawHires) {
+    uint8_t program[4] = {0x00, 0xFF, 0xD0, 0x10};
+    bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.i    = 0x300;
+    chip8.v[0] = 60;
+    chip8.v[1] = 63;
+    memset(&chip8.memory[0x300], 0xFF, 32);
+
+    chip8_state_t hires_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, hires_result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(HIRES_DISPLAY_WIDTH, chip8.display_width, "Should switch to high resolution.");
+
+    chip8_state_t draw_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, draw_result.status, "Should be implemented.");
+    TEST_ASSERT_TRUE_MESSAGE(chip8_get_pixel(&chip8, 60, 63), "Sprite should start at the requested position.");
+    TEST_ASSERT_TRUE_MESSAGE(chip8_get_pixel(&chip8, 75, 63), "Wide sprite should span across words.");
+    TEST_ASSERT_FALSE_MESSAGE(chip8_get_pixel(&chip8, 76, 63), "Sprite should end after 16 pixels.");
+    TEST_ASSERT_FALSE_MESSAGE(chip8_get_pixel(&chip8, 60, 0), "Sprite should not wrap across the screen.");
+}
+
+TEST(XOCHIP, AudioPattern) {
+    uint8_t program[4] = {0xF0, 0x02, 0xF1, 0x3A};
+    bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.i    = 0x300;
+    chip8.v[1] = 0x70;
+    memset(&chip8.memory[0x300], 0xAA, AUDIO_PATTERN_SIZE);
+
+    chip8_state_t pattern_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0xF002, pattern_result.opcode, "Should create \"Load Audio Pattern\".");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, pattern_result.status, "Should be implemented.");
+    TEST_ASSERT_TRUE_MESSAGE(pattern_result.audio_pattern_set, "Should signal the pattern change.");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(&chip8.memory[0x300], chip8.audio_pattern, AUDIO_PATTERN_SIZE, "Should copy the pattern from I.");
+
+    chip8_state_t pitch_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0xF13A, pitch_result.opcode, "Should create \"Set Pitch\".");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, pitch_result.status, "Should be implemented.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x70, chip8.pitch, "Should set pitch to V1.");
+}
+
+TEST(XOCHIP, ScrollDown) {
+    uint8_t program[4] = {0xD0, 0x01, 0x00, 0xC2};
+    bool    loaded     = chip8_load_program(&chip8, program, sizeof(program));
+
+    chip8.i             = 0x300;
+    chip8.memory[0x300] = 0x80;
+
+    chip8_state_t draw_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, draw_result.status, "Should draw the pixel to scroll.");
+
+    chip8_state_t scroll_result = chip8_run_cycle(&chip8);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(0x00C2, scroll_result.opcode, "Should create \"Scroll Down\".");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(CHIP8_OK, scroll_result.status, "Should be implemented.");
+    TEST_ASSERT_FALSE_MESSAGE(chip8_get_pixel(&chip8, 0, 0), "Original pixel should be scrolled away.");
+    TEST_ASSERT_TRUE_MESSAGE(chip8_get_pixel(&chip8, 0, 2), "Pixel should be scrolled down.");
+}
@@ -0,0 +1,103 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "env.h"
+#include "unity_fixture.h"
+
+TEST_GROUP(Env);
+
+// LD V0, 0x05; LD V1, 0x00; LD F, V0; DRW V2, V2, 5; SKNP V0; ADD V1, 0x01;
+// LD I, 0x300; LD [I], V1; JP 0x208
+static const uint8_t rom[] = {0x60, 0x05, 0x61, 0x00, 0xF0, 0x29, 0xD2, 0x25, 0xE0,
+                              0xA1, 0x71, 0x01, 0xA3, 0x00, 0xF1, 0x55, 0x12, 0x08};
+
+static env_config_t config;
+static env_t        env;
+static uint64_t     observation[32];
+
+TEST_SETUP(Env) {
+    // Holding key 5 counts up at 0x301 until it reaches 10
+    memset(&config, 0, sizeof(config));
+    config.rom        = rom;
+    config.rom_size   = sizeof(rom);
+    config.variant    = VARIANT_CHIP8;
+    config.rewards[0] = (env_term_t){.address = 0x301, .size = 1, .weight = 1.0f};
+    config.done       = (env_term_t){.address = 0x301, .size = 1};
+    config.done_value = 10;
+    env_init(&env, &config);
+}
+
+TEST_TEAR_DOWN(Env) {
+    env_free(&env);
+}
+
+TEST(Env, Reset) {
+    TEST_ASSERT_EQUAL_size_t_MESSAGE(32, env_observation_words(&env), "Should observe every row of the display.");
+
+    float reward;
+    env_step(&env, 1 << 5, 3, observation, &reward);
+    env_reset(&env, observation);
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(PROGRAM_START, env.chip8.pc, "Should restart the program.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, env.frames, "Should restart the frame count.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(2, env.episodes, "Should start another episode.");
+    for (uint8_t row = 0; row < 32; ++row) {
+        TEST_ASSERT_EQUAL_HEX64_MESSAGE(0, observation[row], "Should observe the cleared display.");
+    }
+}
+
+TEST(Env, Step) {
+    float reward;
+    TEST_ASSERT_FALSE_MESSAGE(env_step(&env, 0, 1, observation, &reward), "Should not be done yet.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0xF000000000000000ULL, observation[0], "Should observe the drawn sprite.");
+
+    float released = reward;
+    env_step(&env, 1 << 5, 2, observation, &reward);
+    TEST_ASSERT_TRUE_MESSAGE(reward > released, "Should reward counting up while the key is held.");
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE((float)env.chip8.memory[0x301], released + reward,
+                                    "Should reward every unit the term changed by.");
+}
+
+TEST(Env, Done) {
+    float reward;
+    bool  done = false;
+    for (uint8_t s = 0; s < 10 && !done; ++s) done = env_step(&env, 1 << 5, 1, observation, &reward);
+    TEST_ASSERT_TRUE_MESSAGE(done, "Should be done once the term reaches its value.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(10, env.chip8.memory[0x301], "Should stop at the done value.");
+
+    env_free(&env);
+    config.done.size  = 0;
+    config.max_frames = 4;
+    env_init(&env, &config);
+    TEST_ASSERT_FALSE_MESSAGE(env_step(&env, 0, 3, observation, &reward), "Should not be cut off early.");
+    TEST_ASSERT_TRUE_MESSAGE(env_step(&env, 0, 3, observation, &reward), "Should be cut off at the frame limit.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(4, env.frames, "Should not run past the frame limit.");
+}
+
+TEST(Env, Vectorized) {
+    env_vec_t vec;
+    TEST_ASSERT_TRUE_MESSAGE(env_vec_init(&vec, &config, 5, 3), "Initializing should not fail.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(3, vec.threads, "Should start the requested threads.");
+
+    uint64_t observations[5 * 32];
+    uint16_t actions[5] = {0, 1 << 5, 0, 1 << 5, 1 << 4};
+    float    rewards[5];
+    bool     dones[5];
+    env_vec_reset(&vec, observations);
+    for (uint8_t s = 0; s < 3; ++s) {
+        float reward;
+        env_vec_step(&vec, actions, 1, observations, rewards, dones);
+        env_step(&env, 1 << 5, 1, observation, &reward);
+        TEST_ASSERT_EQUAL_FLOAT_MESSAGE(reward, rewards[3], "Should step like a single environment.");
+        TEST_ASSERT_FALSE_MESSAGE(dones[3], "Should not be done yet.");
+    }
+    TEST_ASSERT_EQUAL_HEX64_ARRAY_MESSAGE(observation, &observations[3 * 32], 32, "Should observe alike.");
+    TEST_ASSERT_TRUE_MESSAGE(rewards[1] > rewards[0], "Should step every environment with its own action.");
+
+    // The done environments start their next episode right away
+    for (uint8_t s = 0; s < 2; ++s) env_vec_step(&vec, actions, 1, observations, rewards, dones);
+    TEST_ASSERT_TRUE_MESSAGE(dones[1] && dones[3], "Should report done environments.");
+    TEST_ASSERT_FALSE_MESSAGE(dones[0] || dones[2] || dones[4], "Should only report done environments.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, vec.envs[1].frames, "Should reset done environments.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, observations[32], "Should observe the next episode.");
+    env_vec_free(&vec);
+}
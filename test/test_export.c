@@ -0,0 +1,78 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "chip8.h"
+#include "export.h"
+#include "unity_fixture.h"
+
+TEST_GROUP(Export);
+
+static chip8_t  chip8;
+static export_t writer;
+static export_t reader;
+static char     name[EXPORT_NAME_SIZE];
+
+TEST_SETUP(Export) {
+    // LD V0, 0x05; LD F, V0; DRW V1, V1, 5; JP 0x206
+    uint8_t program[8] = {0x60, 0x05, 0xF0, 0x29, 0xD1, 0x15, 0x12, 0x06};
+    chip8_init(&chip8);
+    chip8_load_program(&chip8, program, sizeof(program));
+
+    // Every test process gets an object of its own
+    snprintf(name, sizeof(name), "/chip8_test_export_%d", (int)getpid());
+    export_create(&writer, name);
+    export_attach(&reader, name);
+}
+
+TEST_TEAR_DOWN(Export) {
+    export_close(&reader);
+    export_close(&writer);
+    chip8_free(&chip8);
+}
+
+TEST(Export, Attach) {
+    TEST_ASSERT_NOT_NULL_MESSAGE(writer.ring, "Creating should not fail.");
+    TEST_ASSERT_NOT_NULL_MESSAGE(reader.ring, "Attaching should not fail.");
+
+    uint64_t sequence;
+    TEST_ASSERT_NULL_MESSAGE(export_read(reader.ring, 0, &sequence), "Should not read frames before publishing.");
+
+    export_t missing;
+    TEST_ASSERT_FALSE_MESSAGE(export_attach(&missing, "/chip8_test_export_missing"),
+                              "Should not attach to missing objects.");
+}
+
+TEST(Export, Publish) {
+    export_publish(&writer, &chip8);
+    for (uint8_t c = 0; c < 3; ++c) chip8_run_cycle(&chip8);
+    export_publish(&writer, &chip8);
+
+    uint64_t              sequence;
+    const export_frame_t *frame = export_read(reader.ring, 0, &sequence);
+    TEST_ASSERT_NOT_NULL_MESSAGE(frame, "Should read the latest frame.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(2, frame->frame, "Should number the frames.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x206, frame->pc, "Should snapshot the registers.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x05, frame->v[0], "Should snapshot the registers.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(3, frame->cycles, "Should snapshot the cycles run.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0x1F, frame->dirty_rows, "Should flag the rows drawn into.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(chip8.display[4], frame->display[4], "Should copy the display.");
+    TEST_ASSERT_TRUE_MESSAGE(export_validate(frame, sequence), "Should validate unchanged frames.");
+
+    frame = export_read(reader.ring, 1, &sequence);
+    TEST_ASSERT_NOT_NULL_MESSAGE(frame, "Should read earlier frames.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(0xFFFFFFFFULL, frame->dirty_rows, "Should flag every row of the first frame.");
+}
+
+TEST(Export, Overwritten) {
+    export_publish(&writer, &chip8);
+
+    uint64_t              sequence;
+    const export_frame_t *frame = export_read(reader.ring, 1, &sequence);
+    for (uint8_t f = 0; f < EXPORT_SLOTS; ++f) export_publish(&writer, &chip8);
+    TEST_ASSERT_FALSE_MESSAGE(export_validate(frame, sequence), "Should detect frames overwritten while reading.");
+    TEST_ASSERT_NULL_MESSAGE(export_read(reader.ring, 1, &sequence), "Should not read frames no longer kept.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, export_read(reader.ring, 0, &sequence)->dirty_rows,
+                                     "Should not flag rows of unchanged frames.");
+}
@@ -0,0 +1,116 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "chip8.h"
+#include "lockstep.h"
+#include "unity_fixture.h"
+
+TEST_GROUP(Lockstep);
+
+static chip8_t chip8;
+
+// 0x200: LD V0..V5, 0x01..0x06; ADD V0, 0x01; JP 0x200
+static const uint8_t rom[] = {0x60, 0x01, 0x61, 0x02, 0x62, 0x03, 0x63, 0x04,
+                              0x64, 0x05, 0x65, 0x06, 0x70, 0x01, 0x12, 0x00};
+
+// Overwrites VF after executing LD V5, 0x06
+static uint32_t run_broken(chip8_t *chip8, uint32_t cycles, chip8_state_t *state) {
+    uint32_t run = 0;
+    while (run < cycles) {
+        *state = chip8_run_cycle(chip8);
+        ++run;
+        if (state->opcode == 0x6506) chip8->v[0xF] = 0xAA;
+        if (state->status != CHIP8_OK) break;
+    }
+    return run;
+}
+
+// Overwrites VF only when running the instructions at 0x204 and 0x206 at once
+static uint32_t run_broken_pair(chip8_t *chip8, uint32_t cycles, chip8_state_t *state) {
+    uint32_t run = 0;
+    while (run < cycles) {
+        if (chip8->pc == 0x204 && cycles - run >= 2) {
+            run += lockstep_run_reference(chip8, 2, state);
+            chip8->v[0xF] = 0xAA;
+        } else {
+            run += lockstep_run_reference(chip8, 1, state);
+        }
+        if (state->status != CHIP8_OK) break;
+    }
+    return run;
+}
+
+TEST_SETUP(Lockstep) {
+    chip8_init(&chip8);
+    chip8_load_program(&chip8, rom, sizeof(rom));
+}
+
+TEST_TEAR_DOWN(Lockstep) {
+    chip8_free(&chip8);
+}
+
+TEST(Lockstep, EngineByName) {
+    TEST_ASSERT_TRUE_MESSAGE(lockstep_engine_by_name("fused") == chip8_run_cycles, "Should find engines by name.");
+    TEST_ASSERT_NULL_MESSAGE(lockstep_engine_by_name("unknown"), "Should not find unknown engines.");
+}
+
+TEST(Lockstep, SameEngines) {
+    lockstep_result_t result;
+    TEST_ASSERT_TRUE_MESSAGE(lockstep_compare(&result, &chip8, lockstep_run_reference, chip8_run_cycles, 5000, 100),
+                             "Comparing should not fail.");
+    TEST_ASSERT_FALSE_MESSAGE(result.diverged, "Fused execution should match the reference.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(5000, result.cycles, "Should run every cycle.");
+    TEST_ASSERT_EQUAL_HEX64_MESSAGE(result.hashes[0], result.hashes[1], "Should report matching hashes.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(PROGRAM_START, chip8.pc, "Should not change the initial state.");
+}
+
+TEST(Lockstep, StopsOnFailure) {
+    chip8.memory[0x20C] = 0x00; // SYS 0x001
+    chip8.memory[0x20D] = 0x01;
+
+    lockstep_result_t result;
+    lockstep_compare(&result, &chip8, lockstep_run_reference, chip8_run_cycles, 5000, 100);
+    TEST_ASSERT_FALSE_MESSAGE(result.diverged, "Engines failing alike should not diverge.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(7, result.cycles, "Should stop at the failing instruction.");
+}
+
+TEST(Lockstep, BisectsDivergence) {
+    lockstep_result_t result;
+    lockstep_compare(&result, &chip8, lockstep_run_reference, run_broken, 5000, 1000);
+    TEST_ASSERT_TRUE_MESSAGE(result.diverged, "Should detect the divergence.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(5, result.cycles, "Should find the first diverging instruction.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, result.length, "Should diverge in a single instruction.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x20A, result.repro.pc, "Should start the repro at the instruction.");
+    TEST_ASSERT_TRUE_MESSAGE(result.hashes[0] != result.hashes[1], "Should report differing hashes.");
+
+    // The font is not needed to diverge, but the instruction is
+    TEST_ASSERT_TRUE_MESSAGE(result.minimized, "Should minimize the repro.");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x00, result.repro.memory[0x050], "Should clear unneeded memory.");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x65, result.repro.memory[0x20A], "Should keep needed memory.");
+    lockstep_free(&result);
+}
+
+TEST(Lockstep, WidensWindow) {
+    lockstep_result_t result;
+    lockstep_compare(&result, &chip8, lockstep_run_reference, run_broken_pair, 5000, 1000);
+    TEST_ASSERT_TRUE_MESSAGE(result.diverged, "Should detect the divergence.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, result.length, "Should include both instructions of the pair.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x204, result.repro.pc, "Should start the repro at the pair.");
+    lockstep_free(&result);
+}
+
+TEST(Lockstep, RandomPrograms) {
+    uint64_t seed = 0x5EED;
+    uint8_t  program[256];
+    for (uint8_t s = 0; s < 32; ++s) {
+        variant_type_t variant = s % VARIANT_COUNT;
+        lockstep_random_program(program, sizeof(program), variant, &seed);
+        chip8_set_variant(&chip8, variant);
+        chip8_load_program(&chip8, program, sizeof(program));
+
+        lockstep_result_t result;
+        lockstep_compare(&result, &chip8, lockstep_run_reference, chip8_run_cycles, 2000, 100);
+        TEST_ASSERT_FALSE_MESSAGE(result.diverged, "Fused execution should match random programs.");
+        lockstep_free(&result);
+    }
+}
@@ -0,0 +1,93 @@
+#include <string.h>
+
+#include "chip8.h"
+#include "opcodes.h"
+#include "unity_fixture.h"
+
+TEST_GROUP(Opcodes);
+
+TEST_SETUP(Opcodes) {}
+
+TEST_TEAR_DOWN(Opcodes) {}
+
+TEST(Opcodes, Get) {
+    opcode_data_t data = opcode_get(OPCODE_DRW);
+    TEST_ASSERT_EQUAL_HEX16(0xD000, data.pattern);
+    TEST_ASSERT_EQUAL_HEX16(0xF000, data.mask);
+    TEST_ASSERT_EQUAL_STRING("DRW", data.mnemonic);
+    TEST_ASSERT_TRUE(data.flags & OPCODE_DRAWS);
+    TEST_ASSERT_TRUE(data.flags & OPCODE_READS_MEMORY);
+
+    opcode_data_t invalid = opcode_get(OPCODE_COUNT);
+    TEST_ASSERT_NULL(invalid.mnemonic);
+}
+
+TEST(Opcodes, TableIsConsistent) {
+    // Every pattern must be decodable into its own instruction on some variant
+    for (uint8_t type = 0; type < OPCODE_COUNT; ++type) {
+        opcode_data_t  data    = opcode_get((opcode_type_t)type);
+        variant_type_t variant = data.variants & (1 << VARIANT_CHIP8) ? VARIANT_CHIP8 : VARIANT_XOCHIP;
+        TEST_ASSERT_EQUAL_HEX16_MESSAGE(data.pattern, data.pattern & data.mask, "Pattern should fit its mask.");
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(type, opcode_decode(data.pattern, variant), data.mnemonic);
+    }
+}
+
+TEST(Opcodes, Decode) {
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_CLS, opcode_decode(0x00E0, VARIANT_CHIP8));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_SYS, opcode_decode(0x0123, VARIANT_CHIP8));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_SHL, opcode_decode(0x812E, VARIANT_CHIP8));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_LD_LOAD, opcode_decode(0xF565, VARIANT_CHIP8));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_COUNT, opcode_decode(0x8128, VARIANT_CHIP8));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_COUNT, opcode_decode(0xE1FF, VARIANT_CHIP8));
+}
+
+TEST(Opcodes, DecodeVariant) {
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_SYS, opcode_decode(0x00FF, VARIANT_CHIP8));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_HIGH, opcode_decode(0x00FF, VARIANT_XOCHIP));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_SE_REG, opcode_decode(0x5122, VARIANT_CHIP8));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_SAVE, opcode_decode(0x5122, VARIANT_XOCHIP));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_SE_REG_XO, opcode_decode(0x5120, VARIANT_XOCHIP));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_COUNT, opcode_decode(0x5121, VARIANT_XOCHIP));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_COUNT, opcode_decode(0x512F, VARIANT_XOCHIP));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_SYS, opcode_decode(0x01E0, VARIANT_CHIP8));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_SCD, opcode_decode(0x00C7, VARIANT_XOCHIP));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_COUNT, opcode_decode(0xF102, VARIANT_XOCHIP));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_COUNT, opcode_decode(0xF000, VARIANT_CHIP8));
+    TEST_ASSERT_EQUAL_UINT8(OPCODE_LD_I_LONG, opcode_decode(0xF000, VARIANT_XOCHIP));
+}
+
+TEST(Opcodes, Size) {
+    TEST_ASSERT_EQUAL_UINT8(2, opcode_size(0xF000, VARIANT_CHIP8));
+    TEST_ASSERT_EQUAL_UINT8(4, opcode_size(0xF000, VARIANT_XOCHIP));
+    TEST_ASSERT_EQUAL_UINT8(2, opcode_size(0xA123, VARIANT_XOCHIP));
+}
+
+TEST(Opcodes, Disassemble) {
+    char buffer[32];
+
+    opcode_disassemble(buffer, sizeof(buffer), 0x00E0, 0, VARIANT_CHIP8, QUIRK_NONE);
+    TEST_ASSERT_EQUAL_STRING("CLS", buffer);
+    opcode_disassemble(buffer, sizeof(buffer), 0xD12F, 0, VARIANT_CHIP8, QUIRK_NONE);
+    TEST_ASSERT_EQUAL_STRING("DRW V1, V2, 0xF", buffer);
+    opcode_disassemble(buffer, sizeof(buffer), 0x6A0B, 0, VARIANT_CHIP8, QUIRK_NONE);
+    TEST_ASSERT_EQUAL_STRING("LD VA, 0x0B", buffer);
+    opcode_disassemble(buffer, sizeof(buffer), 0x2345, 0, VARIANT_CHIP8, QUIRK_NONE);
+    TEST_ASSERT_EQUAL_STRING("CALL 0x345", buffer);
+    opcode_disassemble(buffer, sizeof(buffer), 0xF365, 0, VARIANT_CHIP8, QUIRK_NONE);
+    TEST_ASSERT_EQUAL_STRING("LD V3, [I]", buffer);
+    opcode_disassemble(buffer, sizeof(buffer), 0xF000, 0xABCD, VARIANT_XOCHIP, QUIRK_NONE);
+    TEST_ASSERT_EQUAL_STRING("LD I, 0xABCD", buffer);
+    opcode_disassemble(buffer, sizeof(buffer), 0x8128, 0, VARIANT_CHIP8, QUIRK_NONE);
+    TEST_ASSERT_EQUAL_STRING("DW 0x8128", buffer);
+    opcode_disassemble(buffer, sizeof(buffer), 0xB2F0, 0, VARIANT_CHIP8, QUIRK_OFFSET_JUMP);
+    TEST_ASSERT_EQUAL_STRING("JP V0, 0x2F0", buffer);
+    opcode_disassemble(buffer, sizeof(buffer), 0xB2F0, 0, VARIANT_CHIP8, QUIRK_NONE);
+    TEST_ASSERT_EQUAL_STRING("JP V2, 0x2F0", buffer);
+}
+
+TEST(Opcodes, DisassembleTruncated) {
+    char   buffer[8];
+    size_t length = opcode_disassemble(buffer, sizeof(buffer), 0xD12F, 0, VARIANT_CHIP8, QUIRK_NONE);
+    TEST_ASSERT_EQUAL_UINT32(strlen("DRW V1, V2, 0xF"), length);
+    TEST_ASSERT_EQUAL_STRING("DRW V1,", buffer);
+}
@@ -0,0 +1,101 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "chip8.h"
+#include "phosphor.h"
+#include "unity_fixture.h"
+
+#define TEST_ROW 3 // Row the tests draw into
+
+TEST_GROUP(Phosphor);
+
+static chip8_t    chip8;
+static phosphor_t phosphor;
+
+/**
+ * Sets a pixel of the test row in a plane of the display.
+ *
+ * @param x - The column of the pixel
+ * @param plane - The plane to set the pixel in
+ * @param set - If the pixel is set or cleared
+ */
+static void set_pixel(uint8_t x, uint8_t plane, bool set) {
+    uint64_t *word = &chip8.display[plane * chip8.plane_size + TEST_ROW * chip8.display_stride + x / 64];
+    uint64_t  bit  = 0x8000000000000000ULL >> (x % 64);
+    *word          = set ? *word | bit : *word & ~bit;
+}
+
+TEST_SETUP(Phosphor) {
+    chip8_init(&chip8);
+    phosphor_init(&phosphor, PHOSPHOR_DEFAULT_PERSISTENCE);
+    phosphor_update(&phosphor, &chip8, 0);
+}
+
+TEST_TEAR_DOWN(Phosphor) {
+    chip8_free(&chip8);
+}
+
+TEST(Phosphor, Fade) {
+    uint32_t index = TEST_ROW * DISPLAY_WIDTH + 10;
+    set_pixel(10, 0, true);
+    TEST_ASSERT_TRUE_MESSAGE(phosphor_update(&phosphor, &chip8, 1ULL << TEST_ROW), "Should blend the drawn row.");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x01, phosphor.pixels[index], "Should light drawn pixels at full intensity.");
+
+    // Once cleared, the pixel gets darker every frame until it is dark
+    set_pixel(10, 0, false);
+    uint8_t fade = 0;
+    phosphor_update(&phosphor, &chip8, 1ULL << TEST_ROW);
+    for (uint8_t f = 1; f < PHOSPHOR_DEFAULT_PERSISTENCE; ++f) {
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x01, phosphor.pixels[index] & 0x0F, "Should keep the color while fading.");
+        TEST_ASSERT_GREATER_THAN_UINT8_MESSAGE(fade, phosphor.pixels[index] >> 4, "Should fade out every frame.");
+        fade = phosphor.pixels[index] >> 4;
+        phosphor_update(&phosphor, &chip8, 0);
+    }
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x00, phosphor.pixels[index], "Should fade out completely.");
+    TEST_ASSERT_FALSE_MESSAGE(phosphor_update(&phosphor, &chip8, 0), "Should stop blending once faded out.");
+}
+
+TEST(Phosphor, Flicker) {
+    uint32_t index = TEST_ROW * DISPLAY_WIDTH + 20;
+    for (uint8_t f = 0; f < 10; ++f) {
+        // A sprite erased in one frame and drawn again in the next
+        set_pixel(20, 0, f % 2 == 0);
+        phosphor_update(&phosphor, &chip8, 1ULL << TEST_ROW);
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x01, phosphor.pixels[index] & 0x0F, "Should not go dark between frames.");
+        TEST_ASSERT_LESS_THAN_UINT8_MESSAGE(8, phosphor.pixels[index] >> 4, "Should stay bright between frames.");
+    }
+}
+
+TEST(Phosphor, DirtyRows) {
+    set_pixel(30, 0, true);
+    TEST_ASSERT_FALSE_MESSAGE(phosphor_update(&phosphor, &chip8, 0), "Should not blend rows without changes.");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x00, phosphor.pixels[TEST_ROW * DISPLAY_WIDTH + 30], "Should not read rows without changes.");
+
+    phosphor_update(&phosphor, &chip8, ~0ULL);
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x01, phosphor.pixels[TEST_ROW * DISPLAY_WIDTH + 30], "Should read changed rows.");
+}
+
+TEST(Phosphor, Planes) {
+    chip8_set_variant(&chip8, VARIANT_XOCHIP);
+    uint32_t index = TEST_ROW * chip8.display_width + 5;
+    set_pixel(5, 1, true);
+    phosphor_update(&phosphor, &chip8, 1ULL << TEST_ROW);
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x02, phosphor.pixels[index], "Should light pixels in the color of their planes.");
+
+    // Drawing over a fading pixel takes the new color at full intensity
+    set_pixel(5, 1, false);
+    phosphor_update(&phosphor, &chip8, 1ULL << TEST_ROW);
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x02, phosphor.pixels[index] & 0x0F, "Should fade out in the color last lit.");
+    set_pixel(5, 0, true);
+    phosphor_update(&phosphor, &chip8, 1ULL << TEST_ROW);
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x01, phosphor.pixels[index], "Should take the color drawn.");
+}
+
+TEST(Phosphor, Instant) {
+    phosphor_init(&phosphor, 1);
+    set_pixel(40, 0, true);
+    phosphor_update(&phosphor, &chip8, 1ULL << TEST_ROW);
+    set_pixel(40, 0, false);
+    phosphor_update(&phosphor, &chip8, 1ULL << TEST_ROW);
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x00, phosphor.pixels[TEST_ROW * DISPLAY_WIDTH + 40], "Should not persist at all.");
+}
@@ -0,0 +1,112 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "chip8.h"
+#include "recording.h"
+#include "unity_fixture.h"
+
+#define TEST_RECORDING_PATH "test_recording.tmp"
+#define TEST_FRAMES         300 // Frames recorded, spanning several keyframes
+
+TEST_GROUP(Recording);
+
+static chip8_t     chip8;
+static recording_t writer;
+static recording_t reader;
+static uint64_t    expected[TEST_FRAMES][DISPLAY_HEIGHT];
+
+/**
+ * Records frames which each change a few rows of the display.
+ *
+ * @param frames - The number of frames to record
+ */
+static void record_frames(uint16_t frames) {
+    for (uint16_t f = 0; f < frames; ++f) {
+        chip8.display[f % DISPLAY_HEIGHT] ^= 0x0123456789ABCDEFULL * (f + 1);
+        chip8.display[(f * 7) % DISPLAY_HEIGHT] ^= 0xF000000000000000ULL >> (f % 60);
+        memcpy(expected[f], chip8.display, sizeof(expected[f]));
+        recording_write(&writer, &chip8);
+    }
+}
+
+TEST_SETUP(Recording) {
+    chip8_init(&chip8);
+    recording_create(&writer, &chip8, TEST_RECORDING_PATH);
+}
+
+TEST_TEAR_DOWN(Recording) {
+    recording_close(&reader);
+    recording_close(&writer);
+    chip8_free(&chip8);
+    remove(TEST_RECORDING_PATH);
+}
+
+TEST(Recording, RoundTrip) {
+    record_frames(TEST_FRAMES);
+    TEST_ASSERT_TRUE_MESSAGE(recording_close(&writer), "Finishing should not fail.");
+    TEST_ASSERT_TRUE_MESSAGE(recording_open(&reader, TEST_RECORDING_PATH), "Opening should not fail.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(TEST_FRAMES, reader.header.frames, "Should count the frames.");
+
+    for (uint16_t f = 0; f < TEST_FRAMES; ++f) {
+        TEST_ASSERT_TRUE_MESSAGE(recording_read(&reader), "Should read every frame.");
+        TEST_ASSERT_EQUAL_HEX64_ARRAY_MESSAGE(expected[f], reader.display, DISPLAY_HEIGHT, "Should decode the display.");
+    }
+    TEST_ASSERT_FALSE_MESSAGE(recording_read(&reader), "Should stop after the last frame.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(DISPLAY_WIDTH, reader.display_width, "Should keep the display mode.");
+}
+
+TEST(Recording, Seek) {
+    record_frames(TEST_FRAMES);
+    recording_close(&writer);
+    recording_open(&reader, TEST_RECORDING_PATH);
+
+    uint16_t targets[4] = {250, 5, 6, TEST_FRAMES - 1};
+    for (uint8_t t = 0; t < 4; ++t) {
+        TEST_ASSERT_TRUE_MESSAGE(recording_seek(&reader, targets[t]), "Seeking should not fail.");
+        TEST_ASSERT_EQUAL_HEX64_ARRAY_MESSAGE(expected[targets[t]], reader.display, DISPLAY_HEIGHT,
+                                              "Should decode the frame sought.");
+    }
+    TEST_ASSERT_FALSE_MESSAGE(recording_seek(&reader, TEST_FRAMES), "Should not seek past the last frame.");
+}
+
+TEST(Recording, Unchanged) {
+    for (uint8_t f = 0; f < 10; ++f) recording_write(&writer, &chip8);
+    recording_close(&writer);
+
+    FILE *file = fopen(TEST_RECORDING_PATH, "rb");
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+
+    // An empty keyframe and unchanged frames need nothing besides their headers
+    long headers = sizeof(recording_header_t) + 10 * RECORDING_FRAME_HEADER + sizeof(uint64_t);
+    TEST_ASSERT_EQUAL_INT64_MESSAGE(headers, size, "Should store unchanged frames as headers alone.");
+}
+
+TEST(Recording, Unfinished) {
+    record_frames(130);
+    fflush(writer.file);
+
+    TEST_ASSERT_TRUE_MESSAGE(recording_open(&reader, TEST_RECORDING_PATH), "Should open while still written.");
+    TEST_ASSERT_TRUE_MESSAGE(recording_seek(&reader, 129), "Should read through to the latest frame.");
+    TEST_ASSERT_EQUAL_HEX64_ARRAY_MESSAGE(expected[129], reader.display, DISPLAY_HEIGHT, "Should decode the latest frame.");
+    TEST_ASSERT_FALSE_MESSAGE(recording_read(&reader), "Should stop at the end of the file.");
+
+    TEST_ASSERT_TRUE_MESSAGE(recording_seek(&reader, 3), "Should seek backwards from the first frame.");
+    TEST_ASSERT_EQUAL_HEX64_ARRAY_MESSAGE(expected[3], reader.display, DISPLAY_HEIGHT, "Should decode the frame sought.");
+}
+
+TEST(Recording, Corrupted) {
+    record_frames(10);
+    recording_close(&writer);
+
+    FILE *file = fopen(TEST_RECORDING_PATH, "r+b");
+    fseek(file, sizeof(recording_header_t) + 3, SEEK_SET);
+    fputc(0xFF, file);
+    fputc(0xFF, file);
+    fclose(file);
+
+    recording_open(&reader, TEST_RECORDING_PATH);
+    TEST_ASSERT_FALSE_MESSAGE(recording_read(&reader), "Should reject frames longer than the display.");
+}
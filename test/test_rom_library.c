@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "chip8.h"
+#include "rom_library.h"
+#include "unity_fixture.h"
+
+#define TEST_INDEX_PATH "test_rom_index.tmp"
+#define TEST_ROM_PATH   "test_rom.tmp"
+
+TEST_GROUP(ROMLibrary);
+
+static rom_index_t library;
+
+TEST_SETUP(ROMLibrary) {
+    rom_index_init(&library);
+}
+
+TEST_TEAR_DOWN(ROMLibrary) {
+    rom_index_free(&library);
+    remove(TEST_INDEX_PATH);
+    remove(TEST_ROM_PATH);
+}
+
+TEST(ROMLibrary, Hash) {
+    uint8_t first[11]  = {0x00, 0xE0, 0xA2, 0x2A, 0x60, 0x0C, 0x61, 0x08, 0xD0, 0x1F, 0x70};
+    uint8_t second[11] = {0x00, 0xE0, 0xA2, 0x2A, 0x60, 0x0C, 0x61, 0x08, 0xD0, 0x1F, 0x71};
+
+    TEST_ASSERT_TRUE_MESSAGE(rom_hash(first, sizeof(first)) == rom_hash(first, sizeof(first)), "Hash should be deterministic.");
+    TEST_ASSERT_FALSE_MESSAGE(rom_hash(first, sizeof(first)) == rom_hash(second, sizeof(second)), "Changing a trailing byte should change the hash.");
+    TEST_ASSERT_FALSE_MESSAGE(rom_hash(first, 8) == rom_hash(first, 9), "Changing the size should change the hash.");
+}
+
+TEST(ROMLibrary, PutAndFind) {
+    rom_entry_t entry = {.hash = 0x1234, .size = 100, .variant = VARIANT_XOCHIP, .quirks = QUIRK_SHIFT};
+    TEST_ASSERT_TRUE_MESSAGE(rom_index_put(&library, &entry), "Inserting an entry should not fail.");
+
+    const rom_entry_t *found = rom_index_find(&library, 0x1234);
+    TEST_ASSERT_NOT_NULL_MESSAGE(found, "Inserted entry should be found.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(VARIANT_XOCHIP, found->variant, "Should store the variant.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(QUIRK_SHIFT, found->quirks, "Should store the quirks.");
+    TEST_ASSERT_NULL_MESSAGE(rom_index_find(&library, 0x4321), "Unknown hash should not be found.");
+
+    entry.quirks = QUIRK_MEMORY;
+    rom_index_put(&library, &entry);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, library.count, "Inserting the same hash should replace the entry.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(QUIRK_MEMORY, rom_index_find(&library, 0x1234)->quirks, "Should replace the quirks.");
+}
+
+TEST(ROMLibrary, Grow) {
+    for (uint64_t j = 1; j <= ROM_INDEX_CAPACITY * 2; ++j) {
+        rom_entry_t entry = {.hash = j * ROM_INDEX_CAPACITY, .size = (uint32_t)j};
+        TEST_ASSERT_TRUE_MESSAGE(rom_index_put(&library, &entry), "Inserting an entry should not fail.");
+    }
+
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(ROM_INDEX_CAPACITY * 2, library.count, "Should store every entry.");
+    for (uint64_t j = 1; j <= ROM_INDEX_CAPACITY * 2; ++j) {
+        const rom_entry_t *found = rom_index_find(&library, j * ROM_INDEX_CAPACITY);
+        TEST_ASSERT_NOT_NULL_MESSAGE(found, "Entries should survive growing the table.");
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(j, found->size, "Entries should keep their data.");
+    }
+}
+
+TEST(ROMLibrary, SaveAndLoad) {
+    rom_entry_t entry = {.hash = 0xDEADBEEFCAFEF00DULL, .size = 478, .variant = VARIANT_XOCHIP, .quirks = QUIRK_ALL};
+    snprintf(entry.name, sizeof(entry.name), "%s", "Space Invaders.ch8");
+    rom_index_put(&library, &entry);
+    TEST_ASSERT_TRUE_MESSAGE(rom_index_save(&library, TEST_INDEX_PATH), "Saving the library should not fail.");
+
+    rom_index_t loaded;
+    rom_index_init(&loaded);
+    TEST_ASSERT_TRUE_MESSAGE(rom_index_load(&loaded, TEST_INDEX_PATH), "Loading the index should not fail.");
+
+    const rom_entry_t *found = rom_index_find(&loaded, entry.hash);
+    TEST_ASSERT_NOT_NULL_MESSAGE(found, "Saved entry should be found after loading.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(478, found->size, "Should restore the size.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(VARIANT_XOCHIP, found->variant, "Should restore the variant.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(QUIRK_ALL, found->quirks, "Should restore the quirks.");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("Space Invaders.ch8", found->name, "Should restore names containing spaces.");
+    rom_index_free(&loaded);
+}
+
+TEST(ROMLibrary, MapAndLoad) {
+    uint8_t program[4] = {0x61, 0x23, 0x12, 0x00};
+    FILE   *outfile    = fopen(TEST_ROM_PATH, "wb");
+    fwrite(program, 1, sizeof(program), outfile);
+    fclose(outfile);
+
+    rom_file_t rom;
+    TEST_ASSERT_TRUE_MESSAGE(rom_map(&rom, TEST_ROM_PATH), "Mapping a ROM should not fail.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(sizeof(program), rom.size, "Should map the exact size of the file.");
+    TEST_ASSERT_TRUE_MESSAGE(rom_hash(program, sizeof(program)) == rom.hash, "Should hash the contents.");
+
+    chip8_t     chip8;
+    rom_entry_t entry = {.hash = rom.hash, .size = 4, .variant = VARIANT_XOCHIP, .quirks = QUIRK_MEMORY};
+    chip8_init(&chip8);
+    TEST_ASSERT_TRUE_MESSAGE(rom_load(&chip8, &rom, &entry), "Loading a mapped ROM should not fail.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(VARIANT_XOCHIP, chip8.variant, "Should apply the variant.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(QUIRK_MEMORY, chip8.quirks, "Should apply the quirks.");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(program, &chip8.memory[PROGRAM_START], sizeof(program), "Should load the program.");
+
+    chip8_free(&chip8);
+    rom_unmap(&rom);
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "chip8.h"
+#include "snapshot.h"
+#include "unity_fixture.h"
+
+#define TEST_SNAPSHOT_PATH "test_snapshot.tmp"
+#define TEST_ROM_HASH      0x1234
+
+TEST_GROUP(Snapshot);
+
+static chip8_t chip8;
+static chip8_t resumed;
+
+TEST_SETUP(Snapshot) {
+    // LD V0, 0x05; CALL 0x208; ...; LD I, 0x300; DRW V0, V0, 5
+    uint8_t program[12] = {0x60, 0x05, 0x22, 0x08, 0x00, 0x00, 0x00, 0x00, 0xA3, 0x00, 0xD0, 0x05};
+    chip8_init(&chip8);
+    chip8_init(&resumed);
+    chip8_load_program(&chip8, program, sizeof(program));
+    memset(&chip8.memory[0x300], 0x80, 5);
+    chip8_rehash(&chip8);
+    chip8_seed_rng(&chip8, 42);
+    for (uint8_t j = 0; j < 4; ++j) chip8_run_cycle(&chip8);
+    chip8.delay_timer = 0x10;
+    chip8.key_wait    = 1 << 0x5;
+}
+
+TEST_TEAR_DOWN(Snapshot) {
+    chip8_free(&chip8);
+    chip8_free(&resumed);
+    remove(TEST_SNAPSHOT_PATH);
+}
+
+TEST(Snapshot, SaveAndResume) {
+    TEST_ASSERT_TRUE_MESSAGE(snapshot_save(&chip8, TEST_ROM_HASH, TEST_SNAPSHOT_PATH), "Saving should not fail.");
+    TEST_ASSERT_TRUE_MESSAGE(snapshot_resume(&resumed, TEST_ROM_HASH, TEST_SNAPSHOT_PATH), "Resuming should not fail.");
+
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(chip8.pc, resumed.pc, "Should restore PC.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(chip8.i, resumed.i, "Should restore I.");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(chip8.v, resumed.v, sizeof(chip8.v), "Should restore the registers.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(chip8.stack[0], resumed.stack[0], "Should restore the stack.");
+    TEST_ASSERT_EQUAL_INT8_MESSAGE(chip8.stack_pointer, resumed.stack_pointer, "Should restore the stack pointer.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0x10, resumed.delay_timer, "Should restore the timers.");
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(chip8.key_wait, resumed.key_wait, "Should restore the keys pressed while waiting.");
+    TEST_ASSERT_TRUE_MESSAGE(chip8.rng == resumed.rng, "Should restore the random number generator.");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(chip8.memory, resumed.memory, chip8.memory_size, "Should restore memory.");
+    TEST_ASSERT_TRUE_MESSAGE(chip8_get_pixel(&resumed, 5, 5), "Should restore the display.");
+    TEST_ASSERT_TRUE_MESSAGE(chip8_hash(&chip8) == chip8_hash(&resumed), "Should restore the hashed state.");
+
+    chip8_state_t original = chip8_run_cycle(&chip8);
+    chip8_state_t result   = chip8_run_cycle(&resumed);
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(original.opcode, result.opcode, "Should continue where the original left off.");
+}
+
+TEST(Snapshot, ResumeVariant) {
+    chip8_set_variant(&chip8, VARIANT_XOCHIP);
+    chip8.memory[0xFFFF] = 0xAB;
+    chip8.hires          = true;
+    chip8.display_width  = HIRES_DISPLAY_WIDTH;
+    chip8.display_height = HIRES_DISPLAY_HEIGHT;
+    snapshot_save(&chip8, TEST_ROM_HASH, TEST_SNAPSHOT_PATH);
+
+    TEST_ASSERT_TRUE_MESSAGE(snapshot_resume(&resumed, TEST_ROM_HASH, TEST_SNAPSHOT_PATH), "Resuming should not fail.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(VARIANT_XOCHIP, resumed.variant, "Should switch to the variant of the snapshot.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0xAB, resumed.memory[0xFFFF], "Should restore the full memory of the variant.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(HIRES_DISPLAY_WIDTH, resumed.display_width, "Should restore the display mode.");
+}
+
+TEST(Snapshot, RejectOtherRom) {
+    snapshot_save(&chip8, TEST_ROM_HASH, TEST_SNAPSHOT_PATH);
+
+    uint16_t pc = resumed.pc;
+    TEST_ASSERT_FALSE_MESSAGE(snapshot_resume(&resumed, TEST_ROM_HASH + 1, TEST_SNAPSHOT_PATH), "Should reject snapshots of other ROMs.");
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(pc, resumed.pc, "Rejected snapshots should not change the emulator.");
+}
+
+TEST(Snapshot, RejectCorrupted) {
+    snapshot_save(&chip8, TEST_ROM_HASH, TEST_SNAPSHOT_PATH);
+
+    // Flip a byte of memory
+    FILE *file = fopen(TEST_SNAPSHOT_PATH, "r+b");
+    fseek(file, sizeof(snapshot_header_t) + PROGRAM_START, SEEK_SET);
+    fputc(0xFF, file);
+    fclose(file);
+    TEST_ASSERT_FALSE_MESSAGE(snapshot_resume(&resumed, TEST_ROM_HASH, TEST_SNAPSHOT_PATH), "Should reject corrupted snapshots.");
+}
+
+TEST(Snapshot, RejectVersion) {
+    snapshot_save(&chip8, TEST_ROM_HASH, TEST_SNAPSHOT_PATH);
+
+    uint32_t version = SNAPSHOT_VERSION + 1;
+    FILE    *file    = fopen(TEST_SNAPSHOT_PATH, "r+b");
+    fseek(file, offsetof(snapshot_header_t, version), SEEK_SET);
+    fwrite(&version, sizeof(version), 1, file);
+    fclose(file);
+    TEST_ASSERT_FALSE_MESSAGE(snapshot_resume(&resumed, TEST_ROM_HASH, TEST_SNAPSHOT_PATH), "Should reject other format versions.");
+}
+
+TEST(Snapshot, RejectTruncated) {
+    snapshot_save(&chip8, TEST_ROM_HASH, TEST_SNAPSHOT_PATH);
+    truncate(TEST_SNAPSHOT_PATH, sizeof(snapshot_header_t) + 16);
+    TEST_ASSERT_FALSE_MESSAGE(snapshot_resume(&resumed, TEST_ROM_HASH, TEST_SNAPSHOT_PATH), "Should reject truncated snapshots.");
+    TEST_ASSERT_FALSE_MESSAGE(snapshot_resume(&resumed, TEST_ROM_HASH, "missing.tmp"), "Should reject missing snapshots.");
+}
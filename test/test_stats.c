@@ -0,0 +1,93 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "stats.h"
+#include "unity_fixture.h"
+
+TEST_GROUP(Stats);
+
+static chip8_stats_t stats;
+static chip8_stats_t start;
+
+TEST_SETUP(Stats) {
+    memset(&stats, 0, sizeof(stats));
+    memset(&start, 0, sizeof(start));
+}
+
+TEST_TEAR_DOWN(Stats) {}
+
+TEST(Stats, Rates) {
+    // Half a second at 700 instructions per second and 60 frames per second
+    stats.time             = STATS_SECOND / 2;
+    stats.instructions     = 350;
+    stats.frames_emulated  = 30;
+    stats.frames_presented = 30;
+    stats.emulate_time     = 30 * 2000;
+    stats.sleep_time       = 30 * 14000;
+    stats.render_time      = 20 * 500;
+    stats.draw_calls       = 20;
+    stats_interval(&stats, &start);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(700, stats.ips, "Should derive the instructions per second.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(60, stats.fps, "Should derive the frames presented per second.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(2000, stats.frame_emulate, "Should derive the emulation time per frame.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(14000, stats.frame_sleep, "Should derive the waiting time per frame.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(500, stats.frame_render, "Should derive the drawing time per draw call.");
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&stats, &start, sizeof(stats), "Should start the next interval at the end of this one.");
+
+    // Only the next interval counts towards its rates
+    stats.time += STATS_SECOND;
+    stats.instructions += 1000;
+    stats_interval(&stats, &start);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1000, stats.ips, "Should derive the rates over the latest interval.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, stats.fps, "Should not count frames of earlier intervals.");
+}
+
+TEST(Stats, Idle) {
+    // Nothing happened at all, such as while paused
+    stats_interval(&stats, &start);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, stats.ips, "Should not divide by an empty interval.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, stats.frame_emulate, "Should not divide by zero frames.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, stats.frame_render, "Should not divide by zero draw calls.");
+}
+
+TEST(Stats, Line) {
+    char line[STATS_LINE_SIZE];
+    stats.time            = 1000000;
+    stats.instructions    = 700;
+    stats.ips             = 700;
+    stats.frames_skipped  = 2;
+    stats.audio_underruns = 3;
+    size_t length         = stats_format_line(&stats, line, sizeof(line));
+    TEST_ASSERT_EQUAL_size_t_MESSAGE(strlen(line), length, "Should return the length of the line.");
+    TEST_ASSERT_EQUAL_CHAR_MESSAGE('{', line[0], "Should format an object.");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("}\n", line + length - 2, "Should end the line after the object.");
+    TEST_ASSERT_NOT_NULL_MESSAGE(strstr(line, "\"time\":1000000,"), "Should include the time.");
+    TEST_ASSERT_NOT_NULL_MESSAGE(strstr(line, "\"ips\":700,"), "Should include the rates.");
+    TEST_ASSERT_NOT_NULL_MESSAGE(strstr(line, "\"frames_skipped\":2,"), "Should include the skipped frames.");
+    TEST_ASSERT_NOT_NULL_MESSAGE(strstr(line, "\"audio_underruns\":3}"), "Should include the audio underruns.");
+
+    // A short buffer cuts the line short but reports its full length
+    char   short_line[16];
+    size_t full = stats_format_line(&stats, short_line, sizeof(short_line));
+    TEST_ASSERT_EQUAL_size_t_MESSAGE(length, full, "Should report the full length when cut short.");
+    TEST_ASSERT_EQUAL_size_t_MESSAGE(sizeof(short_line) - 1, strlen(short_line), "Should stay within the buffer.");
+}
+
+TEST(Stats, Overlay) {
+    char text[STATS_LINE_SIZE];
+    stats.ips           = 700;
+    stats.fps           = 60;
+    stats.frame_emulate = 1500;
+    stats_format_overlay(&stats, text, sizeof(text));
+    TEST_ASSERT_NOT_NULL_MESSAGE(strstr(text, "700 IPS 60 FPS\n"), "Should show the rates first.");
+    TEST_ASSERT_NOT_NULL_MESSAGE(strstr(text, "EMU 1.50"), "Should show times in milliseconds.");
+}
+
+TEST(Stats, Query) {
+    chip8_stats_t queried;
+    stats.instructions = 700;
+    stats.ips          = 700;
+    stats_publish(&stats);
+    TEST_ASSERT_TRUE_MESSAGE(stats_query(&queried), "Should report the statistics as published.");
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&stats, &queried, sizeof(stats), "Should query the statistics last published.");
+}
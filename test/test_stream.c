@@ -0,0 +1,212 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "stream.h"
+#include "unity_fixture.h"
+
+#define TEST_CLIENTS 8   // Spectators connected at once
+#define TEST_TIMEOUT 50  // Milliseconds to wait for more data from the server
+
+TEST_GROUP(Stream);
+
+// A client of the server, with the data received but not applied yet
+typedef struct {
+    int           socket;                  // Connection to the server
+    stream_view_t view;                    // State of the display and sound
+    uint8_t       data[STREAM_QUEUE_SIZE]; // Data not forming a whole message yet
+    size_t        size;                    // Bytes of the data
+} test_client_t;
+
+static stream_server_t server;
+static uint8_t         pixels[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+static test_client_t   clients[TEST_CLIENTS];
+
+/**
+ * Connects a client to the server on localhost, and lets the server accept it.
+ *
+ * @param client - The client to connect
+ */
+static void connect_client(test_client_t *client) {
+    struct sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(server.port)};
+    address.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+
+    memset(client, 0, sizeof(test_client_t));
+    client->socket = socket(AF_INET, SOCK_STREAM, 0);
+    connect(client->socket, (struct sockaddr *)&address, sizeof(address));
+    stream_server_poll(&server);
+}
+
+/**
+ * Applies everything the server sent to the view of a client, until it
+ * stops sending.
+ *
+ * @param client - The client to receive
+ * @returns The number of bytes received
+ */
+static size_t receive(test_client_t *client) {
+    size_t        total = 0;
+    struct pollfd ready = {.fd = client->socket, .events = POLLIN};
+    while (poll(&ready, 1, TEST_TIMEOUT) > 0) {
+        ssize_t length = recv(client->socket, &client->data[client->size], sizeof(client->data) - client->size, 0);
+        if (length <= 0) break;
+        client->size += length;
+        total += length;
+
+        size_t used;
+        while (stream_decode(&client->view, client->data, client->size, &used) && used) {
+            memmove(client->data, &client->data[used], client->size - used);
+            client->size -= used;
+        }
+    }
+    return total;
+}
+
+TEST_SETUP(Stream) {
+    stream_server_open(&server, 0);
+    memset(pixels, 0, sizeof(pixels));
+}
+
+TEST_TEAR_DOWN(Stream) {
+    stream_server_close(&server);
+    for (uint8_t c = 0; c < TEST_CLIENTS; ++c) {
+        if (clients[c].socket > 0) close(clients[c].socket);
+        clients[c].socket = 0;
+    }
+}
+
+TEST(Stream, Spectate) {
+    TEST_ASSERT_TRUE_MESSAGE(server.port != 0, "Should listen on a free port.");
+    test_client_t *client = &clients[0];
+    connect_client(client);
+
+    for (uint16_t p = 0; p < sizeof(pixels); p += 3) pixels[p] = 1;
+    stream_server_frame(&server, pixels, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    receive(client);
+    TEST_ASSERT_TRUE_MESSAGE(client->view.connected, "Should greet the client.");
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(DISPLAY_WIDTH, client->view.width, "Should send the display mode.");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(pixels, client->view.pixels, sizeof(pixels), "Should send the full frame.");
+
+    // A single changed row is all that is sent for the next frame
+    pixels[5 * DISPLAY_WIDTH + 8] = 1;
+    stream_server_frame(&server, pixels, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    size_t size = receive(client);
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(1ULL << 5, client->view.dirty_rows, "Should only send the changed row.");
+    TEST_ASSERT_EQUAL_size_t_MESSAGE(STREAM_HEADER_SIZE + 11 + DISPLAY_WIDTH / 8, size, "Should pack the row in bits.");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(pixels, client->view.pixels, sizeof(pixels), "Should apply the changed row.");
+
+    stream_server_frame(&server, pixels, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    TEST_ASSERT_EQUAL_size_t_MESSAGE(0, receive(client), "Should not send unchanged frames.");
+}
+
+TEST(Stream, Spectators) {
+    for (uint8_t c = 0; c < TEST_CLIENTS; ++c) connect_client(&clients[c]);
+
+    for (uint16_t p = 0; p < sizeof(pixels); ++p) pixels[p] = p % 7 == 0 ? 3 : 0;
+    stream_server_frame(&server, pixels, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    for (uint8_t c = 0; c < TEST_CLIENTS; ++c) {
+        receive(&clients[c]);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(pixels, clients[c].view.pixels, sizeof(pixels), "Should send every spectator the frame.");
+    }
+}
+
+TEST(Stream, SlowSpectator) {
+    test_client_t *client = &clients[0];
+    int            size   = 4096;
+    connect_client(client);
+    setsockopt(client->socket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    setsockopt(server.clients[0].socket, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+    // Frames keep changing every row while the client is not reading
+    for (uint16_t f = 0; f < 2000; ++f) {
+        for (uint16_t p = 0; p < sizeof(pixels); ++p) pixels[p] = (p + f) % 3 == 0;
+        stream_server_frame(&server, pixels, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    }
+    TEST_ASSERT_TRUE_MESSAGE(server.clients[0].socket >= 0, "Should keep the client connected.");
+    TEST_ASSERT_TRUE_MESSAGE(server.clients[0].pending < STREAM_FRAME_SIZE, "Should not queue skipped frames.");
+
+    // The connection drains slowly once the window of the client closed
+    for (uint8_t p = 0; p < 100 && memcmp(pixels, client->view.pixels, sizeof(pixels)) != 0; ++p) {
+        stream_server_poll(&server);
+        receive(client);
+    }
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(pixels, client->view.pixels, sizeof(pixels), "Should catch up to the latest frame.");
+    TEST_ASSERT_LESS_THAN_UINT64_MESSAGE(2000, client->view.frames, "Should skip frames for the client.");
+}
+
+TEST(Stream, SlowSpectatorFirst) {
+    test_client_t *slow = &clients[0];
+    test_client_t *fast = &clients[1];
+    int            size = 4096;
+    connect_client(slow);
+    connect_client(fast);
+    setsockopt(slow->socket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    setsockopt(server.clients[0].socket, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+    // Only the fast spectator reads while every row keeps changing
+    for (uint16_t f = 0; f < 200; ++f) {
+        for (uint16_t p = 0; p < sizeof(pixels); ++p) pixels[p] = (p + f) % 3 == 0;
+        stream_server_frame(&server, pixels, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+        if (f % 20 == 0) receive(fast);
+    }
+    TEST_ASSERT_TRUE_MESSAGE(server.clients[0].blocked, "Should block the slow spectator.");
+
+    // The slow spectator catches up while a frame is sent to both, and is
+    // sent the full frame before the fast one is sent the changed row
+    for (uint8_t f = 0; f < 100 && memcmp(pixels, slow->view.pixels, sizeof(pixels)) != 0; ++f) {
+        pixels[f % DISPLAY_HEIGHT * DISPLAY_WIDTH] ^= 1;
+        stream_server_frame(&server, pixels, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+        receive(slow);
+        receive(fast);
+    }
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(pixels, slow->view.pixels, sizeof(pixels), "Should catch up to the latest frame.");
+    TEST_ASSERT_EQUAL_size_t_MESSAGE(0, fast->size, "Should only send whole messages to the fast spectator.");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(pixels, fast->view.pixels, sizeof(pixels), "Should keep the fast spectator in sync.");
+}
+
+TEST(Stream, LateJoin) {
+    pixels[0] = 1;
+    stream_server_frame(&server, pixels, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    stream_server_sound(&server, true);
+
+    test_client_t *client = &clients[0];
+    connect_client(client);
+    receive(client);
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(1, client->view.frames, "Should send the latest frame on joining.");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(pixels, client->view.pixels, sizeof(pixels), "Should send the latest frame in full.");
+    TEST_ASSERT_TRUE_MESSAGE(client->view.playing, "Should send the state of the sound on joining.");
+
+    stream_server_sound(&server, false);
+    stream_server_poll(&server);
+    receive(client);
+    TEST_ASSERT_FALSE_MESSAGE(client->view.playing, "Should send when the sound stops.");
+}
+
+TEST(Stream, Keys) {
+    uint8_t message[STREAM_HEADER_SIZE + 2];
+    connect_client(&clients[0]);
+    connect_client(&clients[1]);
+
+    send(clients[0].socket, message, stream_encode_keys(0x0011, message), 0);
+    send(clients[1].socket, message, stream_encode_keys(0x0100, message), 0);
+    usleep(10000);
+    stream_server_poll(&server);
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x0111, server.keypad, "Should combine the keys of every client.");
+
+    close(clients[1].socket);
+    clients[1].socket = 0;
+    usleep(10000);
+    stream_server_poll(&server);
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0x0011, server.keypad, "Should release the keys of clients leaving.");
+
+    // Anything but keys is a protocol violation
+    uint8_t garbage[STREAM_HEADER_SIZE] = {STREAM_FRAME, 0, 0};
+    send(clients[0].socket, garbage, sizeof(garbage), 0);
+    usleep(10000);
+    stream_server_poll(&server);
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(0, server.keypad, "Should drop clients sending anything else.");
+}
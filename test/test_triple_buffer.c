@@ -0,0 +1,91 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "triple_buffer.h"
+#include "unity_fixture.h"
+
+#define TEST_WORDS  256    // Words in every buffer, all holding the same value
+#define TEST_FRAMES 100000 // Buffers published by the concurrent writer
+
+TEST_GROUP(TripleBuffer);
+
+static triple_buffer_t triple;
+
+/**
+ * Publishes buffers filled with increasing numbers as fast as possible.
+ *
+ * @param data - Unused
+ * @returns Always NULL
+ */
+static void *write_frames(void *data) {
+    (void)data;
+    for (uint64_t frame = 1; frame <= TEST_FRAMES; ++frame) {
+        uint64_t *words = triple_buffer_back(&triple);
+        for (uint16_t w = 0; w < TEST_WORDS; ++w) words[w] = frame;
+        triple_buffer_publish(&triple);
+    }
+    return NULL;
+}
+
+TEST_SETUP(TripleBuffer) {
+    triple_buffer_init(&triple, sizeof(uint64_t) * TEST_WORDS);
+}
+
+TEST_TEAR_DOWN(TripleBuffer) {
+    triple_buffer_free(&triple);
+}
+
+TEST(TripleBuffer, Handover) {
+    bool            fresh;
+    const uint64_t *front = triple_buffer_front(&triple, &fresh);
+    TEST_ASSERT_FALSE_MESSAGE(fresh, "Should not be fresh before publishing.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, front[0], "Should start out cleared.");
+
+    uint64_t *back = triple_buffer_back(&triple);
+    back[0]        = 1;
+    triple_buffer_publish(&triple);
+    TEST_ASSERT_TRUE_MESSAGE(triple_buffer_back(&triple) != back, "Should write into another buffer.");
+
+    front = triple_buffer_front(&triple, &fresh);
+    TEST_ASSERT_TRUE_MESSAGE(fresh, "Should take the published buffer.");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(1, front[0], "Should read the published buffer.");
+
+    TEST_ASSERT_TRUE_MESSAGE(triple_buffer_front(&triple, &fresh) == front, "Should keep reading the same buffer.");
+    TEST_ASSERT_FALSE_MESSAGE(fresh, "Should not take the same buffer twice.");
+}
+
+TEST(TripleBuffer, LatestWins) {
+    for (uint64_t frame = 1; frame <= 3; ++frame) {
+        uint64_t *back = triple_buffer_back(&triple);
+        back[0]        = frame;
+        triple_buffer_publish(&triple);
+    }
+
+    bool            fresh;
+    const uint64_t *front = triple_buffer_front(&triple, &fresh);
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(3, front[0], "Should skip to the latest buffer.");
+}
+
+TEST(TripleBuffer, Concurrent) {
+    pthread_t writer;
+    pthread_create(&writer, NULL, write_frames, NULL);
+
+    // Every buffer read must be complete, and newer than the one before
+    uint64_t latest = 0;
+    bool     torn   = false;
+    bool     older  = false;
+    while (latest < TEST_FRAMES) {
+        bool            fresh;
+        const uint64_t *front = triple_buffer_front(&triple, &fresh);
+        if (!fresh) continue;
+
+        for (uint16_t w = 1; w < TEST_WORDS; ++w) torn |= front[w] != front[0];
+        older |= front[0] <= latest;
+        latest = front[0];
+    }
+    pthread_join(writer, NULL);
+
+    TEST_ASSERT_FALSE_MESSAGE(torn, "Should never read a buffer while it is written.");
+    TEST_ASSERT_FALSE_MESSAGE(older, "Should only read newer buffers.");
+}
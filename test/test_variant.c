@@ -0,0 +1,53 @@
+#include <string.h>
+
+#include "unity_fixture.h"
+#include "variant.h"
+
+TEST_GROUP(Variant);
+
+TEST_SETUP(Variant) {}
+
+TEST_TEAR_DOWN(Variant) {}
+
+TEST(Variant, GetChip8) {
+    variant_data_t variant = variant_get(VARIANT_CHIP8);
+    TEST_ASSERT_NOT_NULL(variant.name);
+    TEST_ASSERT_EQUAL_UINT32(4 * 1024, variant.memory_size);
+    TEST_ASSERT_EQUAL_UINT8(64, variant.display_width);
+    TEST_ASSERT_EQUAL_UINT8(32, variant.display_height);
+    TEST_ASSERT_EQUAL_UINT8(1, variant.display_planes);
+
+    char   *name_expected        = "CHIP-8";
+    uint8_t name_length_expected = strlen(name_expected);
+    TEST_ASSERT_EQUAL_CHAR_ARRAY(name_expected, variant.name, name_length_expected);
+}
+
+TEST(Variant, GetXoChip) {
+    variant_data_t variant = variant_get(VARIANT_XOCHIP);
+    TEST_ASSERT_NOT_NULL(variant.name);
+    TEST_ASSERT_EQUAL_UINT32(64 * 1024, variant.memory_size);
+    TEST_ASSERT_EQUAL_UINT8(128, variant.display_width);
+    TEST_ASSERT_EQUAL_UINT8(64, variant.display_height);
+    TEST_ASSERT_EQUAL_UINT8(4, variant.display_planes);
+
+    char   *name_expected        = "XO-CHIP";
+    uint8_t name_length_expected = strlen(name_expected);
+    TEST_ASSERT_EQUAL_CHAR_ARRAY(name_expected, variant.name, name_length_expected);
+}
+
+TEST(Variant, GetInvalid) {
+    variant_data_t variant = variant_get(VARIANT_COUNT);
+    TEST_ASSERT_NULL(variant.name);
+    TEST_ASSERT_EQUAL_UINT32(0, variant.memory_size);
+}
+
+TEST(Variant, ByName) {
+    variant_type_t chip8_expected = variant_by_name("chip-8");
+    TEST_ASSERT_EQUAL_UINT8(chip8_expected, VARIANT_CHIP8);
+
+    variant_type_t xochip_expected = variant_by_name("XO-CHIP");
+    TEST_ASSERT_EQUAL_UINT8(xochip_expected, VARIANT_XOCHIP);
+
+    variant_type_t invalid_expected = variant_by_name("Invalid");
+    TEST_ASSERT_EQUAL_UINT8(invalid_expected, VARIANT_COUNT);
+}